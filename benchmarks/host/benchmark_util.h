@@ -0,0 +1,82 @@
+#pragma once
+
+// Shared scaffolding for the host-side benchmarks.
+//
+// Every benchmark draws into an in-memory Rgb565 offscreen (the most common
+// native format of SPI displays), through a CountingOutput. Besides wall time,
+// each benchmark reports per-iteration counters of the primitive operations
+// that reached the device, and of the estimated bus traffic, so that changes
+// that reduce the number of transactions show up even when the host CPU hides
+// the difference.
+
+#include "benchmark/benchmark.h"
+#include "roo_display.h"
+#include "roo_display/core/offscreen.h"
+#include "roo_display/filter/counting_output.h"
+
+namespace roo_display {
+namespace benchmarks {
+
+constexpr int16_t kScreenWidth = 320;
+constexpr int16_t kScreenHeight = 240;
+
+class BenchmarkTarget {
+ public:
+  BenchmarkTarget(int16_t width = kScreenWidth, int16_t height = kScreenHeight,
+                  Color background = color::Black)
+      : offscreen_(width, height, background), counting_(offscreen_.output()) {}
+
+  /// The output to draw to. Counts everything that reaches the offscreen.
+  DisplayOutput& output() { return counting_; }
+
+  /// The underlying (uncounted) offscreen.
+  Offscreen<Rgb565>& offscreen() { return offscreen_; }
+
+  Box extents() const { return offscreen_.extents(); }
+
+  /// Draws the drawable to `output`, clipped to the target extents.
+  void draw(DisplayOutput& output, const Drawable& drawable, int16_t dx = 0,
+            int16_t dy = 0, FillMode fill_mode = FillMode::kVisible,
+            BlendingMode blending_mode = BlendingMode::kSourceOver,
+            Color bgcolor = color::Transparent) {
+    output.begin();
+    Surface s(output, dx, dy, extents(), false, bgcolor, fill_mode,
+              blending_mode);
+    s.drawObject(drawable);
+    output.end();
+  }
+
+  /// Draws the drawable to the counting output.
+  void draw(const Drawable& drawable, int16_t dx = 0, int16_t dy = 0,
+            FillMode fill_mode = FillMode::kVisible,
+            BlendingMode blending_mode = BlendingMode::kSourceOver,
+            Color bgcolor = color::Transparent) {
+    draw(counting_, drawable, dx, dy, fill_mode, blending_mode, bgcolor);
+  }
+
+  /// Publishes the counters, averaged per iteration, and the pixel throughput.
+  void report(benchmark::State& state) {
+    const CountingOutput::Counters& c = counting_.counters();
+    auto avg = benchmark::Counter::kAvgIterations;
+    state.counters["set_address"] =
+        benchmark::Counter(c.set_address_calls, avg);
+    state.counters["write"] = benchmark::Counter(c.write_calls, avg);
+    state.counters["fill"] = benchmark::Counter(c.fill_calls, avg);
+    state.counters["write_rects"] =
+        benchmark::Counter(c.write_rects_calls, avg);
+    state.counters["fill_rects"] = benchmark::Counter(c.fill_rects_calls, avg);
+    state.counters["pixel_calls"] = benchmark::Counter(
+        c.write_pixels_calls + c.fill_pixels_calls, avg);
+    state.counters["windows"] = benchmark::Counter(c.address_windows, avg);
+    state.counters["bus_bytes"] = benchmark::Counter(c.bus_bytes, avg);
+    state.counters["pixels/s"] =
+        benchmark::Counter(c.pixels, benchmark::Counter::kIsRate);
+  }
+
+ private:
+  Offscreen<Rgb565> offscreen_;
+  CountingOutput counting_;
+};
+
+}  // namespace benchmarks
+}  // namespace roo_display
@@ -0,0 +1,104 @@
+// Host benchmarks for StreamableStack and RasterizableStack compositions.
+
+#include "benchmark_util.h"
+#include "roo_display/composition/parallel_rasterizable.h"
+#include "roo_display/composition/rasterizable_stack.h"
+#include "roo_display/composition/streamable_stack.h"
+#include "roo_display/shape/smooth.h"
+
+namespace roo_display {
+namespace benchmarks {
+namespace {
+
+// A handful of overlapping, semi-transparent layers, as typically found in a
+// gauge or a button with an icon.
+struct Layers {
+  Layers()
+      : panel(SmoothFilledRoundRect(0.5f, 0.5f, 199.5f, 119.5f, 12,
+                                    Color(0xFF203040))),
+        ring(SmoothThickArc({100, 60}, 50, 10, -2.4f, 2.4f, color::Orange)),
+        dot(SmoothFilledCircle({100, 60}, 20, Color(0xC0FFFFFF))),
+        needle(SmoothThickLine({100, 60}, {140, 30}, 3, color::Red)) {}
+
+  SmoothShape panel;
+  SmoothShape ring;
+  SmoothShape dot;
+  SmoothShape needle;
+};
+
+void BM_StreamableStack(benchmark::State& state) {
+  BenchmarkTarget target;
+  Layers layers;
+  StreamableStack stack(Box(0, 0, 199, 119));
+  stack.addInput(&layers.panel);
+  stack.addInput(&layers.ring);
+  stack.addInput(&layers.dot);
+  stack.addInput(&layers.needle);
+  for (auto _ : state) {
+    target.draw(stack, 60, 60, FillMode::kExtents, BlendingMode::kSourceOver,
+                color::Black);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_StreamableStack);
+
+// Animated overlay: the stack is rebuilt every frame, with the top layer
+// moving, so that only the top layer needs to be recompiled.
+void BM_StreamableStackMovingOverlay(benchmark::State& state) {
+  BenchmarkTarget target;
+  Layers layers;
+  StreamableStack stack(Box(0, 0, 199, 119));
+  int16_t frame = 0;
+  for (auto _ : state) {
+    stack.clearInputs();
+    stack.addInput(&layers.panel);
+    stack.addInput(&layers.ring);
+    stack.addInput(&layers.dot);
+    stack.addInput(&layers.needle, frame % 20, 0);
+    target.draw(stack, 60, 60, FillMode::kExtents, BlendingMode::kSourceOver,
+                color::Black);
+    ++frame;
+  }
+  target.report(state);
+}
+BENCHMARK(BM_StreamableStackMovingOverlay);
+
+void BM_RasterizableStack(benchmark::State& state) {
+  BenchmarkTarget target;
+  Layers layers;
+  RasterizableStack stack(Box(0, 0, 199, 119));
+  stack.addInput(&layers.panel);
+  stack.addInput(&layers.ring);
+  stack.addInput(&layers.dot);
+  stack.addInput(&layers.needle);
+  for (auto _ : state) {
+    target.draw(stack, 60, 60, FillMode::kExtents, BlendingMode::kSourceOver,
+                color::Black);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_RasterizableStack);
+
+// Same as above, with the pixels evaluated by the specified number of worker
+// threads (plus the calling thread).
+void BM_ParallelRasterizableStack(benchmark::State& state) {
+  BenchmarkTarget target;
+  Layers layers;
+  RasterizableStack stack(Box(0, 0, 199, 119));
+  stack.addInput(&layers.panel);
+  stack.addInput(&layers.ring);
+  stack.addInput(&layers.dot);
+  stack.addInput(&layers.needle);
+  RenderWorkerPool pool(state.range(0));
+  ParallelRasterizable parallel(stack, pool);
+  for (auto _ : state) {
+    target.draw(parallel, 60, 60, FillMode::kExtents,
+                BlendingMode::kSourceOver, color::Black);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_ParallelRasterizableStack)->Arg(1)->Arg(3)->UseRealTime();
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace roo_display
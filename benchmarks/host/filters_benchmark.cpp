@@ -0,0 +1,114 @@
+// Host benchmarks for the BackgroundFillOptimizer, ClipMaskFilter, and
+// RectBatchingOutput.
+
+#include <memory>
+
+#include "benchmark_util.h"
+#include "roo_display/filter/background_fill_optimizer.h"
+#include "roo_display/filter/clip_mask.h"
+#include "roo_display/filter/rect_batching_output.h"
+#include "roo_display/shape/basic.h"
+#include "roo_display/shape/smooth.h"
+
+namespace roo_display {
+namespace benchmarks {
+namespace {
+
+// Repeatedly clears the screen to the background, and redraws a small
+// widget. After the first iteration, the optimizer should be able to skip
+// most of the background fill.
+void BM_BackgroundFillOptimizer(benchmark::State& state) {
+  BenchmarkTarget target;
+  BackgroundFillOptimizer::FrameBuffer frame_buffer(kScreenWidth,
+                                                    kScreenHeight);
+  BackgroundFillOptimizer optimizer(target.output(), frame_buffer);
+  optimizer.setPalette({color::Black});
+  FilledRect background(0, 0, kScreenWidth - 1, kScreenHeight - 1,
+                        color::Black);
+  auto widget = SmoothFilledCircle({160, 120}, 30, color::Red);
+  for (auto _ : state) {
+    target.draw(optimizer, background);
+    target.draw(optimizer, widget);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_BackgroundFillOptimizer);
+
+// Baseline for BM_BackgroundFillOptimizer, without the optimizer.
+void BM_BackgroundFillUnoptimized(benchmark::State& state) {
+  BenchmarkTarget target;
+  FilledRect background(0, 0, kScreenWidth - 1, kScreenHeight - 1,
+                        color::Black);
+  auto widget = SmoothFilledCircle({160, 120}, 30, color::Red);
+  for (auto _ : state) {
+    target.draw(background);
+    target.draw(widget);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_BackgroundFillUnoptimized);
+
+// Draws a full-screen rectangle through a clip mask of 8x8 checkerboard
+// tiles.
+void BM_ClipMaskFilter(benchmark::State& state) {
+  BenchmarkTarget target;
+  constexpr int kRowBytes = kScreenWidth / 8;
+  std::unique_ptr<roo::byte[]> data(new roo::byte[kRowBytes * kScreenHeight]);
+  for (int y = 0; y < kScreenHeight; ++y) {
+    for (int i = 0; i < kRowBytes; ++i) {
+      data[y * kRowBytes + i] =
+          ((y / 8 + i) % 2 == 0) ? roo::byte{0xFF} : roo::byte{0x00};
+    }
+  }
+  ClipMask mask(data.get(), target.extents());
+  ClipMaskFilter filter(target.output(), &mask);
+  FilledRect rect(0, 0, kScreenWidth - 1, kScreenHeight - 1, color::Red);
+  for (auto _ : state) {
+    target.draw(filter, rect);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_ClipMaskFilter);
+
+// Draws a table of 20x15 cells, 16x16 pixels each, with 1-pixel borders, as
+// separate rectangles for each cell's background and borders.
+void DrawTable(DisplayOutput& output) {
+  output.begin();
+  output.fillRect(BlendingMode::kSource, 0, 0, kScreenWidth - 1,
+                  kScreenHeight - 1, color::Black);
+  for (int16_t y = 0; y < kScreenHeight; y += 16) {
+    for (int16_t x = 0; x < kScreenWidth; x += 16) {
+      output.fillRect(BlendingMode::kSourceOver, x, y, x + 14, y + 14,
+                      color::White);
+      output.fillRect(BlendingMode::kSourceOver, x + 15, y, x + 15, y + 15,
+                      color::Gray);
+      output.fillRect(BlendingMode::kSourceOver, x, y + 15, x + 14, y + 15,
+                      color::Gray);
+    }
+  }
+  output.end();
+}
+
+void BM_RectBatchingOutputTable(benchmark::State& state) {
+  BenchmarkTarget target;
+  RectBatchingOutput batching(target.output());
+  for (auto _ : state) {
+    DrawTable(batching);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_RectBatchingOutputTable);
+
+// Baseline for BM_RectBatchingOutputTable, without batching.
+void BM_RectBatchingOutputTableUnbatched(benchmark::State& state) {
+  BenchmarkTarget target;
+  for (auto _ : state) {
+    DrawTable(target.output());
+  }
+  target.report(state);
+}
+BENCHMARK(BM_RectBatchingOutputTableUnbatched);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace roo_display
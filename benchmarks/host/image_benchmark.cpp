@@ -0,0 +1,104 @@
+// Host benchmarks for PNG and JPEG decoding.
+//
+// The tiny images exercise the per-image overhead; the 320x240 ones are
+// representative of full-screen content (a photo, a flat-colored UI, and a
+// translucent overlay). Images are read from test/testdata into memory up front, so that only the
+// decoding and drawing is measured. Run via bazel (or from the repository
+// root), so that the relative paths resolve.
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "roo_display/image/jpeg/jpeg.h"
+#include "roo_display/image/png/png.h"
+#include "roo_io/memory/memory_resource.h"
+
+namespace roo_display {
+namespace benchmarks {
+namespace {
+
+std::vector<roo::byte> ReadFile(const char* path) {
+  std::ifstream in(path, std::ios::binary);
+  std::vector<char> data((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+  return std::vector<roo::byte>((const roo::byte*)data.data(),
+                                (const roo::byte*)data.data() + data.size());
+}
+
+// Extra arguments, if any, are passed to the image constructor.
+template <typename Decoder, typename Image, typename... Args>
+void DrawImage(benchmark::State& state, const char* path, Args... args) {
+  std::vector<roo::byte> data = ReadFile(path);
+  if (data.empty()) {
+    state.SkipWithError("Unable to read the image file");
+    return;
+  }
+  BenchmarkTarget target;
+  Decoder decoder;
+  roo_io::MemoryResource<const roo::byte*> resource(data.data(),
+                                                    data.data() + data.size());
+  Image image(decoder, resource, args...);
+  for (auto _ : state) {
+    target.draw(image);
+  }
+  target.report(state);
+}
+
+void BM_PngPalette(benchmark::State& state) {
+  DrawImage<PngDecoder, PngImage>(state,
+                                  "test/testdata/palette_opaque_8x4.png");
+}
+BENCHMARK(BM_PngPalette);
+
+void BM_PngRgba(benchmark::State& state) {
+  DrawImage<PngDecoder, PngImage>(state, "test/testdata/rgba_alpha_8x4.png");
+}
+BENCHMARK(BM_PngRgba);
+
+// Decodes with downscaling by 2^arg.
+void BM_PngRgbaScaled(benchmark::State& state) {
+  DrawImage<PngDecoder, PngImage>(state, "test/testdata/rgba_alpha_8x4.png",
+                                  (uint8_t)state.range(0));
+}
+BENCHMARK(BM_PngRgbaScaled)->DenseRange(0, 3);
+
+void BM_PngPaletteFullScreen(benchmark::State& state) {
+  DrawImage<PngDecoder, PngImage>(state,
+                                  "test/testdata/palette_ui_320x240.png");
+}
+BENCHMARK(BM_PngPaletteFullScreen);
+
+void BM_PngRgbaFullScreen(benchmark::State& state) {
+  DrawImage<PngDecoder, PngImage>(state,
+                                  "test/testdata/rgba_overlay_320x240.png");
+}
+BENCHMARK(BM_PngRgbaFullScreen);
+
+void BM_JpegColor(benchmark::State& state) {
+  DrawImage<JpegDecoder, JpegImage>(state,
+                                    "test/testdata/color_blocks_9x9.jpg");
+}
+BENCHMARK(BM_JpegColor);
+
+void BM_JpegGrayscale(benchmark::State& state) {
+  DrawImage<JpegDecoder, JpegImage>(state,
+                                    "test/testdata/grayscale_blocks_9x9.jpg");
+}
+BENCHMARK(BM_JpegGrayscale);
+
+void BM_JpegColorFullScreen(benchmark::State& state) {
+  DrawImage<JpegDecoder, JpegImage>(state, "test/testdata/photo_320x240.jpg");
+}
+BENCHMARK(BM_JpegColorFullScreen);
+
+void BM_JpegGrayscaleFullScreen(benchmark::State& state) {
+  DrawImage<JpegDecoder, JpegImage>(
+      state, "test/testdata/photo_grayscale_320x240.jpg");
+}
+BENCHMARK(BM_JpegGrayscaleFullScreen);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace roo_display
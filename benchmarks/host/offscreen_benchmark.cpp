@@ -0,0 +1,89 @@
+// Host benchmarks for writing to an offscreen in each of the 8 orientations.
+//
+// Devices mounted in portrait (or upside down) draw to their framebuffers in
+// a rotated orientation; these benchmarks show how much that costs, compared
+// to the default RightDown orientation.
+
+#include "benchmark_util.h"
+
+namespace roo_display {
+namespace benchmarks {
+namespace {
+
+// The benchmarks take the orientation index as the argument.
+Orientation OrientationArg(int64_t arg) {
+  static const Orientation orientations[] = {
+      Orientation::RightDown(), Orientation::DownRight(),
+      Orientation::LeftDown(),  Orientation::DownLeft(),
+      Orientation::RightUp(),   Orientation::UpRight(),
+      Orientation::LeftUp(),    Orientation::UpLeft()};
+  return orientations[arg];
+}
+
+// Writes the entire screen through a single address window, in chunks of
+// 64 pixels, like streamed images do.
+void BM_OffscreenWrite(benchmark::State& state) {
+  Offscreen<Rgb565> offscreen(kScreenWidth, kScreenHeight, color::Black);
+  OffscreenDevice<Rgb565>& device = offscreen.output();
+  Orientation orientation = OrientationArg(state.range(0));
+  device.setOrientation(orientation);
+  state.SetLabel(orientation.asString());
+  int16_t w = device.effective_width();
+  int16_t h = device.effective_height();
+  Color colors[64];
+  for (int i = 0; i < 64; ++i) {
+    colors[i] = Color(0xFF000000 | (i * 0x030201));
+  }
+  uint32_t pixel_count = (uint32_t)w * h;
+  for (auto _ : state) {
+    device.setAddress(0, 0, w - 1, h - 1, BlendingMode::kSource);
+    for (uint32_t i = 0; i < pixel_count; i += 64) {
+      device.write(colors, 64);
+    }
+  }
+  state.counters["pixels/s"] = benchmark::Counter(
+      (double)pixel_count * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_OffscreenWrite)->DenseRange(0, 7);
+
+// Fills the entire screen through a single address window.
+void BM_OffscreenFill(benchmark::State& state) {
+  Offscreen<Rgb565> offscreen(kScreenWidth, kScreenHeight, color::Black);
+  OffscreenDevice<Rgb565>& device = offscreen.output();
+  Orientation orientation = OrientationArg(state.range(0));
+  device.setOrientation(orientation);
+  state.SetLabel(orientation.asString());
+  int16_t w = device.effective_width();
+  int16_t h = device.effective_height();
+  uint32_t pixel_count = (uint32_t)w * h;
+  for (auto _ : state) {
+    device.setAddress(0, 0, w - 1, h - 1, BlendingMode::kSource);
+    device.fill(color::Red, pixel_count);
+  }
+  state.counters["pixels/s"] = benchmark::Counter(
+      (double)pixel_count * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_OffscreenFill)->DenseRange(0, 7);
+
+// Blends a translucent fill over the entire screen.
+void BM_OffscreenFillSourceOver(benchmark::State& state) {
+  Offscreen<Rgb565> offscreen(kScreenWidth, kScreenHeight, color::Black);
+  OffscreenDevice<Rgb565>& device = offscreen.output();
+  Orientation orientation = OrientationArg(state.range(0));
+  device.setOrientation(orientation);
+  state.SetLabel(orientation.asString());
+  int16_t w = device.effective_width();
+  int16_t h = device.effective_height();
+  uint32_t pixel_count = (uint32_t)w * h;
+  for (auto _ : state) {
+    device.setAddress(0, 0, w - 1, h - 1, BlendingMode::kSourceOver);
+    device.fill(Color(0x40FF0000), pixel_count);
+  }
+  state.counters["pixels/s"] = benchmark::Counter(
+      (double)pixel_count * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_OffscreenFillSourceOver)->DenseRange(0, 7);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace roo_display
@@ -0,0 +1,142 @@
+// Host benchmarks for basic and anti-aliased shapes.
+
+#include "benchmark_util.h"
+#include "roo_display/color/gradient.h"
+#include "roo_display/shape/basic.h"
+#include "roo_display/shape/smooth.h"
+
+namespace roo_display {
+namespace benchmarks {
+namespace {
+
+// Benchmarks of smooth shapes take the rasterization as the last argument:
+// 0 for tiled, 1 for scanline.
+SmoothShape::Rasterization RasterizationArg(int64_t arg) {
+  return arg == 0 ? SmoothShape::Rasterization::kTiled
+                  : SmoothShape::Rasterization::kScanline;
+}
+
+void BM_FilledRect(benchmark::State& state) {
+  BenchmarkTarget target;
+  FilledRect rect(10, 10, 309, 229, color::Red);
+  for (auto _ : state) {
+    target.draw(rect);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_FilledRect);
+
+void BM_FilledCircle(benchmark::State& state) {
+  BenchmarkTarget target;
+  auto circle = FilledCircle::ByRadius(160, 120, state.range(0), color::Red);
+  for (auto _ : state) {
+    target.draw(circle);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_FilledCircle)->Arg(10)->Arg(50)->Arg(110);
+
+void BM_SmoothFilledCircle(benchmark::State& state) {
+  BenchmarkTarget target;
+  auto circle =
+      SmoothFilledCircle({159.5f, 119.5f}, state.range(0), Color(0xC0FF4040));
+  circle.setRasterization(RasterizationArg(state.range(1)));
+  for (auto _ : state) {
+    target.draw(circle);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_SmoothFilledCircle)
+    ->ArgsProduct({{10, 50, 110}, {0, 1}});
+
+void BM_SmoothFilledRoundRect(benchmark::State& state) {
+  BenchmarkTarget target;
+  auto rect =
+      SmoothFilledRoundRect(20.5f, 20.5f, 299.5f, 219.5f, 16, color::Navy);
+  rect.setRasterization(RasterizationArg(state.range(0)));
+  for (auto _ : state) {
+    target.draw(rect);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_SmoothFilledRoundRect)->Arg(0)->Arg(1);
+
+void BM_SmoothThickLine(benchmark::State& state) {
+  BenchmarkTarget target;
+  auto line = SmoothThickLine({10, 20}, {310, 220}, 5, color::White);
+  for (auto _ : state) {
+    target.draw(line);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_SmoothThickLine);
+
+void BM_SmoothThickArc(benchmark::State& state) {
+  BenchmarkTarget target;
+  auto arc = SmoothThickArc({160, 120}, 100, 12, -2.5f, 2.5f, color::Orange);
+  arc.setRasterization(RasterizationArg(state.range(0)));
+  for (auto _ : state) {
+    target.draw(arc);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_SmoothThickArc)->Arg(0)->Arg(1);
+
+// Full-screen gradient backgrounds. The argument is the size of the gradient
+// lookup table (0 for exact evaluation).
+
+ColorGradient BackgroundGradient(float v0, float v1, uint16_t lut_size) {
+  return ColorGradient({{v0, color::Navy},
+                        {v0 + (v1 - v0) * 0.4f, color::Purple},
+                        {v0 + (v1 - v0) * 0.7f, color::Orange},
+                        {v1, color::Black}},
+                       ColorGradient::Boundary::kExtended, lut_size);
+}
+
+void BM_LinearGradient(benchmark::State& state) {
+  BenchmarkTarget target;
+  LinearGradient gradient({0, 0}, 0.6f, 0.4f,
+                          BackgroundGradient(0, 300, state.range(0)));
+  for (auto _ : state) {
+    target.draw(gradient);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_LinearGradient)->Arg(0)->Arg(256)->Arg(1024);
+
+void BM_RadialGradient(benchmark::State& state) {
+  BenchmarkTarget target;
+  RadialGradient gradient({160, 120},
+                          BackgroundGradient(0, 150, state.range(0)));
+  for (auto _ : state) {
+    target.draw(gradient);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_RadialGradient)->Arg(0)->Arg(256)->Arg(1024);
+
+void BM_RadialGradientSq(benchmark::State& state) {
+  BenchmarkTarget target;
+  RadialGradientSq gradient({160, 120},
+                            BackgroundGradient(0, 150 * 150, state.range(0)));
+  for (auto _ : state) {
+    target.draw(gradient);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_RadialGradientSq)->Arg(0)->Arg(256)->Arg(1024);
+
+void BM_AngularGradient(benchmark::State& state) {
+  BenchmarkTarget target;
+  AngularGradient gradient({160, 120},
+                           BackgroundGradient(-M_PI, M_PI, state.range(0)));
+  for (auto _ : state) {
+    target.draw(gradient);
+  }
+  target.report(state);
+}
+BENCHMARK(BM_AngularGradient)->Arg(0)->Arg(256)->Arg(1024);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace roo_display
@@ -0,0 +1,52 @@
+// Host benchmarks for smooth font rendering.
+
+#include "benchmark_util.h"
+#include "roo_display/font/glyph_cache.h"
+#include "roo_display/font/smooth_font_v2.h"
+#include "roo_display/ui/text_label.h"
+#include "roo_fonts/NotoSerif_Italic/12.h"
+
+namespace roo_display {
+namespace benchmarks {
+namespace {
+
+constexpr char kText[] = "The quick brown fox jumps over the lazy dog 0123";
+
+// Draws a line of text in the given fill mode; if `cache_bytes` is positive,
+// with a glyph cache of that size installed.
+void DrawText(benchmark::State& state, FillMode fill_mode, size_t cache_bytes) {
+  BenchmarkTarget target;
+  GlyphCache cache(cache_bytes > 0 ? cache_bytes : 1);
+  if (cache_bytes > 0) SmoothFontV2::SetGlyphCache(&cache);
+  TextLabel label(kText, font_NotoSerif_Italic_12(), color::White, fill_mode);
+  for (auto _ : state) {
+    target.draw(label, 4, 20, fill_mode, BlendingMode::kSourceOver,
+                color::Black);
+  }
+  SmoothFontV2::SetGlyphCache(nullptr);
+  target.report(state);
+}
+
+void BM_TextVisible(benchmark::State& state) {
+  DrawText(state, FillMode::kVisible, 0);
+}
+BENCHMARK(BM_TextVisible);
+
+void BM_TextExtents(benchmark::State& state) {
+  DrawText(state, FillMode::kExtents, 0);
+}
+BENCHMARK(BM_TextExtents);
+
+void BM_TextVisibleCached(benchmark::State& state) {
+  DrawText(state, FillMode::kVisible, 8 * 1024);
+}
+BENCHMARK(BM_TextVisibleCached);
+
+void BM_TextExtentsCached(benchmark::State& state) {
+  DrawText(state, FillMode::kExtents, 8 * 1024);
+}
+BENCHMARK(BM_TextExtentsCached);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace roo_display
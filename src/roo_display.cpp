@@ -175,6 +175,7 @@ void DrawingContext::drawPixels(
 
 void DrawingContext::drawInternal(const Drawable& object, int16_t dx,
                                   int16_t dy, Color bgcolor) {
+  StreamArena::Scope arena_scope(stream_arena_);
   DisplayOutput& out = front_to_back_writer_.get() != nullptr
                            ? *front_to_back_writer_
                            : output();
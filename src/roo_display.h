@@ -7,6 +7,7 @@
 
 #include "roo_display/core/device.h"
 #include "roo_display/core/drawable.h"
+#include "roo_display/core/stream_arena.h"
 #include "roo_display/core/streamable.h"
 #include "roo_display/filter/background.h"
 #include "roo_display/filter/background_fill_optimizer.h"
@@ -99,6 +100,17 @@ class Display {
   /// sets that color as the default background hint.
   void init(Color bgcolor);
 
+  /// Starts rendering a new frame. On multi-buffered devices, subsequent
+  /// drawing goes to a back buffer. See `DisplayDevice::beginFrame()`.
+  void beginFrame() { display_device_.beginFrame(); }
+
+  /// Presents the frame rendered since `beginFrame()`, without waiting for it
+  /// to become visible. See `DisplayDevice::presentFrame()`.
+  void presentFrame() { display_device_.presentFrame(); }
+
+  /// Blocks until the most recently presented frame is visible.
+  void awaitFrame() { display_device_.awaitFrame(); }
+
   /// Sets the display orientation. Resets the clip box to the max display area.
   void setOrientation(Orientation orientation);
 
@@ -389,6 +401,17 @@ class DrawingContext {
   /// the output pixels with the background color.
   void erase(const Drawable& object, Alignment alignment);
 
+  /// Returns the allocation statistics of the pixel streams created by the
+  /// draws in this context. A non-zero `heap_allocations` means that the
+  /// stream arena (ROO_DISPLAY_STREAM_ARENA_SIZE bytes) was too small. To get
+  /// per-frame counts, reset the stats at the beginning of each frame.
+  const StreamArena::Stats& streamStats() const {
+    return stream_arena_.stats();
+  }
+
+  /// Resets the stream allocation statistics.
+  void resetStreamStats() { stream_arena_.resetStats(); }
+
  private:
   DisplayOutput& output() { return output_; }
   const DisplayOutput& output() const { return output_; }
@@ -432,6 +455,9 @@ class DrawingContext {
   Color bgcolor_;
   bool transformed_;
   Transformation transformation_;
+
+  /// Serves the pixel streams created while drawing.
+  StreamArenaWithStorage<ROO_DISPLAY_STREAM_ARENA_SIZE> stream_arena_;
 };
 
 /**
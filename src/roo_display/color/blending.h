@@ -572,6 +572,187 @@ inline Color AlphaBlendOverOpaque(Color bgc, Color fgc) {
   return BlendOp<BlendingMode::kSourceOverOpaque>().blend(bgc, fgc);
 }
 
+// Batch kernels for source-over blending.
+//
+// Alpha-compositing of anti-aliased content is dominated by blending over
+// opaque destinations. The kernels below blend two color channels at once,
+// using SWAR (SIMD-within-a-register) arithmetic on 32-bit words: the word is
+// split into two 16-bit lanes (0x00RR00BB and 0x00AA00GG), each wide enough to
+// hold a product of two 8-bit values. The results are bit-exact with
+// BlendOp<kSourceOverOpaque>, since the rounded division by 255 is computed
+// per lane as (t + (t >> 8)) >> 8, where t = x + 128, which is equivalent to
+// __div_255_rounded(x) for all x <= 255 * 255.
+//
+// The kernels also short-circuit fully transparent and fully opaque sources,
+// which typically account for most of the pixels of anti-aliased shapes and
+// glyphs.
+
+namespace internal {
+
+static constexpr uint32_t kSwarLaneMask = 0x00FF00FF;
+static constexpr uint32_t kSwarLaneRounding = 0x00800080;
+
+// Rounded division by 255 of both 16-bit lanes of `x`, where each lane holds
+// the blended sum plus 128. The R and B results are returned in the low bytes
+// of the lanes, and the A and G results in the high bytes of the lanes, so that
+// they can be or-ed together.
+inline uint32_t __swar_div_255_rb(uint32_t x) {
+  return ((x + ((x >> 8) & kSwarLaneMask)) >> 8) & kSwarLaneMask;
+}
+
+inline uint32_t __swar_div_255_ag(uint32_t x) {
+  return (x + ((x >> 8) & kSwarLaneMask)) & ~kSwarLaneMask;
+}
+
+// Blends `src` over an opaque `dst`. Equivalent to
+// BlendOp<BlendingMode::kSourceOverOpaque>().blend(dst, src).
+inline uint32_t SourceOverOpaqueSwar(uint32_t dst, uint32_t src) {
+  uint32_t a = src >> 24;
+  uint32_t ia = a ^ 0xFF;
+  uint32_t rb = (src & kSwarLaneMask) * a + (dst & kSwarLaneMask) * ia +
+                kSwarLaneRounding;
+  uint32_t ag = ((src >> 8) & kSwarLaneMask) * a +
+                ((dst >> 8) & kSwarLaneMask) * ia + kSwarLaneRounding;
+  return 0xFF000000 | __swar_div_255_ag(ag) | __swar_div_255_rb(rb);
+}
+
+// Pre-computed source terms for blending a single color over many opaque
+// destination pixels.
+class SourceOverOpaqueSwarUniform {
+ public:
+  SourceOverOpaqueSwarUniform(Color src)
+      : ia_(src.a() ^ 0xFF),
+        rb_((src.asArgb() & kSwarLaneMask) * src.a() + kSwarLaneRounding),
+        ag_(((src.asArgb() >> 8) & kSwarLaneMask) * src.a() +
+            kSwarLaneRounding) {}
+
+  inline uint32_t blend(uint32_t dst) const {
+    uint32_t rb = rb_ + (dst & kSwarLaneMask) * ia_;
+    uint32_t ag = ag_ + ((dst >> 8) & kSwarLaneMask) * ia_;
+    return 0xFF000000 | __swar_div_255_ag(ag) | __swar_div_255_rb(rb);
+  }
+
+ private:
+  uint32_t ia_;
+  uint32_t rb_;
+  uint32_t ag_;
+};
+
+}  // namespace internal
+
+/// Blends the `src` array over the `dst` array, assuming that all `dst`
+/// pixels are opaque, writing back to `dst`. Equivalent to applying
+/// `AlphaBlendOverOpaque()` to each pair of pixels.
+inline void AlphaBlendSpanOverOpaque(Color* dst, const Color* src,
+                                     uint32_t count) {
+  while (count-- > 0) {
+    uint32_t s = src->asArgb();
+    if (s >= 0xFF000000) {
+      *dst = Color(s);
+    } else if (s >= 0x01000000) {
+      *dst = Color(internal::SourceOverOpaqueSwar(dst->asArgb(), s));
+    } else {
+      *dst = dst->toOpaque();
+    }
+    ++dst;
+    ++src;
+  }
+}
+
+/// Blends a single `src` color over the `dst` array, assuming that all `dst`
+/// pixels are opaque, writing back to `dst`.
+inline void AlphaBlendSpanOverOpaque(Color* dst, Color src, uint32_t count) {
+  if (src.a() == 0xFF) {
+    FillColor(dst, count, src);
+    return;
+  }
+  if (src.a() == 0) {
+    while (count-- > 0) {
+      *dst = dst->toOpaque();
+      ++dst;
+    }
+    return;
+  }
+  internal::SourceOverOpaqueSwarUniform op(src);
+  while (count-- > 0) {
+    *dst = Color(op.blend(dst->asArgb()));
+    ++dst;
+  }
+}
+
+/// Blends the `src` array over the `dst` array, writing back to `dst`.
+/// Equivalent to applying `AlphaBlend()` to each pair of pixels.
+inline void AlphaBlendSpan(Color* dst, const Color* src, uint32_t count) {
+  BlendOp<BlendingMode::kSourceOver> op;
+  while (count-- > 0) {
+    uint32_t s = src->asArgb();
+    if (s >= 0xFF000000) {
+      *dst = Color(s);
+    } else if (s >= 0x01000000) {
+      uint32_t d = dst->asArgb();
+      if (d >= 0xFF000000) {
+        *dst = Color(internal::SourceOverOpaqueSwar(d, s));
+      } else if (d < 0x01000000) {
+        *dst = Color(s);
+      } else {
+        *dst = op.blend(Color(d), Color(s));
+      }
+    }
+    ++dst;
+    ++src;
+  }
+}
+
+/// Blends a single `src` color over the `dst` array, writing back to `dst`.
+inline void AlphaBlendSpan(Color* dst, Color src, uint32_t count) {
+  if (src.a() == 0xFF) {
+    FillColor(dst, count, src);
+    return;
+  }
+  if (src.a() == 0) return;
+  internal::SourceOverOpaqueSwarUniform opaque_op(src);
+  BlendOp<BlendingMode::kSourceOver> op;
+  while (count-- > 0) {
+    uint32_t d = dst->asArgb();
+    if (d >= 0xFF000000) {
+      *dst = Color(opaque_op.blend(d));
+    } else if (d < 0x01000000) {
+      *dst = src;
+    } else {
+      *dst = op.blend(Color(d), src);
+    }
+    ++dst;
+  }
+}
+
+/// Blends the `src` array over a single `dst` color, writing back to `src`.
+inline void AlphaBlendSpanOverBackground(Color dst, Color* src,
+                                         uint32_t count) {
+  uint32_t d = dst.asArgb();
+  if (dst.a() == 0) {
+    while (count-- > 0) {
+      if (src->a() == 0) *src = dst;
+      ++src;
+    }
+    return;
+  }
+  if (dst.a() == 0xFF) {
+    while (count-- > 0) {
+      uint32_t s = src->asArgb();
+      if (s < 0xFF000000) {
+        *src = Color(s < 0x01000000 ? d : internal::SourceOverOpaqueSwar(d, s));
+      }
+      ++src;
+    }
+    return;
+  }
+  BlendOp<BlendingMode::kSourceOver> op;
+  while (count-- > 0) {
+    *src = op.blend(dst, *src);
+    ++src;
+  }
+}
+
 template <BlendingMode mode>
 struct Blender {
   inline Color apply(Color dst, Color src) {
@@ -579,26 +760,38 @@ struct Blender {
   }
 
   inline void applyInPlace(Color* dst, const Color* src, int16_t count) {
-    BlendOp<mode> op;
-    while (count-- > 0) {
-      *dst = op.blend(*dst, *src);
-      ++dst;
-      ++src;
+    if constexpr (mode == BlendingMode::kSourceOver) {
+      if (count > 0) AlphaBlendSpan(dst, src, count);
+    } else if constexpr (mode == BlendingMode::kSourceOverOpaque) {
+      if (count > 0) AlphaBlendSpanOverOpaque(dst, src, count);
+    } else {
+      BlendOp<mode> op;
+      while (count-- > 0) {
+        *dst = op.blend(*dst, *src);
+        ++dst;
+        ++src;
+      }
     }
   }
 
   inline void applySingleSourceInPlace(Color* dst, Color src, int16_t count) {
-    BlendOp<mode> op;
-    if (src.a() == 0) {
+    if constexpr (mode == BlendingMode::kSourceOver) {
+      if (count > 0) AlphaBlendSpan(dst, src, count);
+    } else if constexpr (mode == BlendingMode::kSourceOverOpaque) {
+      if (count > 0) AlphaBlendSpanOverOpaque(dst, src, count);
+    } else {
+      BlendOp<mode> op;
+      if (src.a() == 0) {
+        while (count-- > 0) {
+          *dst = op.blendTransparentSrc(*dst, src);
+          ++dst;
+        }
+        return;
+      }
       while (count-- > 0) {
-        *dst = op.blendTransparentSrc(*dst, src);
+        *dst = op.blend(*dst, src);
         ++dst;
       }
-      return;
-    }
-    while (count-- > 0) {
-      *dst = op.blend(*dst, src);
-      ++dst;
     }
   }
 
@@ -614,17 +807,21 @@ struct Blender {
 
   /// Symmetrical to applySingleSourceInPlace.
   inline void applyOverBackground(Color bg, Color* src, int16_t count) {
-    BlendOp<mode> op;
-    if (bg.a() == 0) {
+    if constexpr (mode == BlendingMode::kSourceOver) {
+      if (count > 0) AlphaBlendSpanOverBackground(bg, src, count);
+    } else {
+      BlendOp<mode> op;
+      if (bg.a() == 0) {
+        while (count-- > 0) {
+          *src = op.blendTransparentDst(bg, *src);
+          ++src;
+        }
+        return;
+      }
       while (count-- > 0) {
-        *src = op.blendTransparentDst(bg, *src);
+        *src = op.blend(bg, *src);
         ++src;
       }
-      return;
-    }
-    while (count-- > 0) {
-      *src = op.blend(bg, *src);
-      ++src;
     }
   }
 };
@@ -758,6 +955,111 @@ struct RawFullByteBlender<ColorMode, BlendingMode::kDestination, byte_order> {
   }
 };
 
+/// Blends a run of `count` colors over consecutive raw pixels (stored in the
+/// specified color mode) starting at `dst`. The generic version blends pixel by
+/// pixel; the source-over modes are specialized to use the batch kernels.
+template <typename ColorMode, BlendingMode blending_mode,
+          roo_io::ByteOrder byte_order>
+struct RawFullByteSpanBlender {
+  void operator()(roo::byte* dst, const Color* src, uint32_t count,
+                  const ColorMode& mode) const {
+    constexpr uint32_t kBytesPerPixel = ColorTraits<ColorMode>::bytes_per_pixel;
+    RawFullByteBlender<ColorMode, blending_mode, byte_order> blender;
+    while (count-- > 0) {
+      blender(dst, *src++, mode);
+      dst += kBytesPerPixel;
+    }
+  }
+
+  void operator()(roo::byte* dst, Color src, uint32_t count,
+                  const ColorMode& mode) const {
+    constexpr uint32_t kBytesPerPixel = ColorTraits<ColorMode>::bytes_per_pixel;
+    RawFullByteBlender<ColorMode, blending_mode, byte_order> blender;
+    while (count-- > 0) {
+      blender(dst, src, mode);
+      dst += kBytesPerPixel;
+    }
+  }
+};
+
+namespace internal {
+
+// Converts raw pixels to ARGB in small chunks, blends the chunk using the batch
+// kernels, and converts back.
+template <typename ColorMode, roo_io::ByteOrder byte_order, bool opaque>
+struct RawFullByteSourceOverSpanBlender {
+  static constexpr uint32_t kChunkSize = 32;
+
+  void operator()(roo::byte* dst, const Color* src, uint32_t count,
+                  const ColorMode& mode) const {
+    Color buf[kChunkSize];
+    while (count > 0) {
+      uint32_t n = count < kChunkSize ? count : kChunkSize;
+      load(dst, buf, n, mode);
+      if (opaque) {
+        AlphaBlendSpanOverOpaque(buf, src, n);
+      } else {
+        AlphaBlendSpan(buf, src, n);
+      }
+      dst = store(buf, dst, n, mode);
+      src += n;
+      count -= n;
+    }
+  }
+
+  void operator()(roo::byte* dst, Color src, uint32_t count,
+                  const ColorMode& mode) const {
+    if (src.a() == 0 && !opaque) return;
+    Color buf[kChunkSize];
+    while (count > 0) {
+      uint32_t n = count < kChunkSize ? count : kChunkSize;
+      load(dst, buf, n, mode);
+      if (opaque) {
+        AlphaBlendSpanOverOpaque(buf, src, n);
+      } else {
+        AlphaBlendSpan(buf, src, n);
+      }
+      dst = store(buf, dst, n, mode);
+      count -= n;
+    }
+  }
+
+ private:
+  static void load(const roo::byte* dst, Color* buf, uint32_t n,
+                   const ColorMode& mode) {
+    constexpr uint32_t kBytesPerPixel = ColorTraits<ColorMode>::bytes_per_pixel;
+    ColorIo<ColorMode, byte_order> io;
+    for (uint32_t i = 0; i < n; ++i) {
+      buf[i] = io.load(dst, mode);
+      dst += kBytesPerPixel;
+    }
+  }
+
+  static roo::byte* store(const Color* buf, roo::byte* dst, uint32_t n,
+                          const ColorMode& mode) {
+    constexpr uint32_t kBytesPerPixel = ColorTraits<ColorMode>::bytes_per_pixel;
+    ColorIo<ColorMode, byte_order> io;
+    for (uint32_t i = 0; i < n; ++i) {
+      io.store(buf[i], dst, mode);
+      dst += kBytesPerPixel;
+    }
+    return dst;
+  }
+};
+
+}  // namespace internal
+
+template <typename ColorMode, roo_io::ByteOrder byte_order>
+struct RawFullByteSpanBlender<ColorMode, BlendingMode::kSourceOver, byte_order>
+    : public internal::RawFullByteSourceOverSpanBlender<ColorMode, byte_order,
+                                                        false> {};
+
+template <typename ColorMode, roo_io::ByteOrder byte_order>
+struct RawFullByteSpanBlender<ColorMode, BlendingMode::kSourceOverOpaque,
+                              byte_order>
+    : public internal::RawFullByteSourceOverSpanBlender<ColorMode, byte_order,
+                                                        true> {};
+
 template <typename ColorMode, BlendingMode blending_mode>
 struct RawSubByteBlender {
   uint8_t operator()(uint8_t dst, Color src,
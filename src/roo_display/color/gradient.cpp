@@ -1,14 +1,20 @@
 #include "roo_display/color/gradient.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "roo_display/color/interpolation.h"
 
 namespace roo_display {
 
-ColorGradient::ColorGradient(std::vector<Node> gradient, Boundary boundary)
+ColorGradient::ColorGradient(std::vector<Node> gradient, Boundary boundary,
+                             uint16_t lut_size)
     : gradient_(std::move(gradient)),
       boundary_(boundary),
       transparency_mode_(TransparencyMode::kNone),
-      inv_period_(1.0f / (gradient_.back().value - gradient_.front().value)) {
+      inv_period_(1.0f / (gradient_.back().value - gradient_.front().value)),
+      lut_(),
+      lut_scale_(0) {
   for (const Node& n : gradient_) {
     uint8_t a = n.color.a();
     if (a != 255) {
@@ -19,6 +25,17 @@ ColorGradient::ColorGradient(std::vector<Node> gradient, Boundary boundary)
       transparency_mode_ = TransparencyMode::kCrude;
     }
   }
+  float range = gradient_.back().value - gradient_.front().value;
+  if (lut_size < 2 || !(range > 0)) return;
+  CHECK_EQ(lut_size & (lut_size - 1), 0)
+      << "Gradient LUT size must be a power of two: " << lut_size;
+  lut_.resize(lut_size);
+  uint16_t intervals =
+      (boundary_ == Boundary::kPeriodic) ? lut_size : lut_size - 1;
+  lut_scale_ = intervals / range;
+  for (uint16_t i = 0; i < lut_size; ++i) {
+    lut_[i] = getColor(gradient_.front().value + range * i / intervals);
+  }
 }
 
 Color ColorGradient::getColor(float value) const {
@@ -97,6 +114,144 @@ Color ColorGradient::getColor(float value) const {
   }
 }
 
+Color ColorGradient::lookupColor(float value) const {
+  if (lut_.empty()) return getColor(value);
+  float pos = (value - gradient_.front().value) * lut_scale_;
+  if (boundary_ == Boundary::kPeriodic) {
+    // Since the table size is a power of two, masking the (rounded) index
+    // wraps it around correctly, also for negative positions.
+    return lut_[(int32_t)floorf(pos + 0.5f) & (lut_.size() - 1)];
+  }
+  if (value < gradient_.front().value || value > gradient_.back().value) {
+    return getColor(value);
+  }
+  return lut_[(uint16_t)(pos + 0.5f)];
+}
+
+void ColorGradient::lookupColors(float value, float step, uint32_t count,
+                                 Color* result) const {
+  if (lut_.empty()) {
+    for (uint32_t i = 0; i < count; ++i) {
+      result[i] = getColor(value + i * step);
+    }
+    return;
+  }
+  const float size = lut_.size();
+  float pos = (value - gradient_.front().value) * lut_scale_;
+  float dpos = step * lut_scale_;
+  if (boundary_ == Boundary::kPeriodic) {
+    // Positions in 16.16 fixed point, reduced modulo the table size, so that
+    // they can wrap around freely.
+    pos -= size * floorf(pos / size);
+    dpos -= size * floorf(dpos / size);
+    const uint32_t mask = lut_.size() - 1;
+    uint32_t p = (uint32_t)(pos * 65536.0f) + 0x8000;
+    uint32_t dp = (uint32_t)(dpos * 65536.0f);
+    while (count-- > 0) {
+      *result++ = lut_[(p >> 16) & mask];
+      p += dp;
+    }
+    return;
+  }
+  if (fabsf(dpos) >= size) {
+    // Each pixel jumps by more than the whole table.
+    for (uint32_t i = 0; i < count; ++i) {
+      result[i] = lookupColor(value + i * step);
+    }
+    return;
+  }
+  const int32_t max_p = (int32_t)(lut_.size() - 1) << 16;
+  const int32_t dp = (int32_t)lroundf(dpos * 65536.0f);
+  uint32_t i = 0;
+  while (i < count) {
+    float v = value + i * step;
+    if (v < gradient_.front().value || v > gradient_.back().value) {
+      // Outside of the table; evaluate exactly.
+      result[i++] = getColor(v);
+      continue;
+    }
+    int32_t p =
+        (int32_t)((v - gradient_.front().value) * lut_scale_ * 65536.0f);
+    if (p > max_p) p = max_p;
+    // Find how many pixels, starting at this one, stay within the table.
+    uint32_t n = count - i;
+    if (dp > 0) {
+      n = std::min<uint32_t>(n, (max_p - p) / dp + 1);
+    } else if (dp < 0) {
+      n = std::min<uint32_t>(n, p / -dp + 1);
+    }
+    p += 0x8000;
+    while (n-- > 0) {
+      result[i++] = lut_[p >> 16];
+      p += dp;
+    }
+  }
+}
+
+bool ColorGradient::getUniformColor(float min_value, float max_value,
+                                    Color* result) const {
+  float front = gradient_.front().value;
+  float back = gradient_.back().value;
+  switch (boundary_) {
+    case Boundary::kExtended: {
+      break;
+    }
+    case Boundary::kTruncated: {
+      if (max_value <= front - 1 || min_value >= back + 1) {
+        *result = color::Transparent;
+        return true;
+      }
+      if (min_value < front || max_value > back) return false;
+      break;
+    }
+    case Boundary::kPeriodic: {
+      if (min_value < front || max_value > back) return false;
+      break;
+    }
+  }
+  // The colors of the values within the range are interpolated between the
+  // nodes from (right_bound(min_value) - 1) to right_bound(max_value),
+  // inclusive (see getColor()). Interpolating between equal colors yields
+  // the same color.
+  uint16_t first = 0;
+  while (first < gradient_.size() && gradient_[first].value < min_value) {
+    ++first;
+  }
+  if (first > 0) --first;
+  uint16_t last = first;
+  while (last < gradient_.size() - 1 && gradient_[last].value < max_value) {
+    ++last;
+  }
+  Color color = gradient_[first].color;
+  for (uint16_t i = first + 1; i <= last; ++i) {
+    if (gradient_[i].color != color) return false;
+  }
+  *result = color;
+  return true;
+}
+
+namespace {
+
+// Returns the minimum and the maximum of |v| over the range [v0, v1].
+inline void AbsRange(float v0, float v1, float* min_abs, float* max_abs) {
+  *min_abs = (v0 > 0) ? v0 : (v1 < 0) ? -v1 : 0;
+  *max_abs = std::max(fabsf(v0), fabsf(v1));
+}
+
+// Writes the rect of `width` x `height` pixels, with colors determined
+// row-by-row by `row_fn(y, row)`.
+template <typename RowFn>
+inline void FillRows(int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                     Color* result, RowFn row_fn) {
+  int16_t width = xMax - xMin + 1;
+  for (int16_t y = yMin; y <= yMax; ++y) {
+    row_fn(y, result);
+    result += width;
+  }
+}
+
+}  // namespace
+
 RadialGradient::RadialGradient(FpPoint center, ColorGradient gradient,
                                Box extents)
     : cx_(center.x),
@@ -110,13 +265,41 @@ void RadialGradient::readColors(const int16_t* x, const int16_t* y,
     float dx = *x - cx_;
     float dy = *y - cy_;
     float r = sqrtf(dx * dx + dy * dy);
-    Color c = gradient_.getColor(r);
+    Color c = gradient_.lookupColor(r);
     *result++ = c;
     ++x;
     ++y;
   }
 }
 
+bool RadialGradient::readColorRect(int16_t xMin, int16_t yMin, int16_t xMax,
+                                   int16_t yMax, Color* result) const {
+  if (readUniformColorRect(xMin, yMin, xMax, yMax, result)) return true;
+  FillRows(xMin, yMin, xMax, yMax, result, [&](int16_t y, Color* row) {
+    float dy = y - cy_;
+    float dy2 = dy * dy;
+    // The distance is computed exactly as in readColors(), so that both give
+    // the same colors. (Updating it incrementally would accumulate rounding
+    // errors, as the center is not necessarily integer.)
+    for (int16_t x = xMin; x <= xMax; ++x) {
+      float dx = x - cx_;
+      *row++ = gradient_.lookupColor(sqrtf(dx * dx + dy2));
+    }
+  });
+  return false;
+}
+
+bool RadialGradient::readUniformColorRect(int16_t xMin, int16_t yMin,
+                                          int16_t xMax, int16_t yMax,
+                                          Color* result) const {
+  float min_dx, max_dx, min_dy, max_dy;
+  AbsRange(xMin - cx_, xMax - cx_, &min_dx, &max_dx);
+  AbsRange(yMin - cy_, yMax - cy_, &min_dy, &max_dy);
+  return gradient_.getUniformColor(sqrtf(min_dx * min_dx + min_dy * min_dy),
+                                   sqrtf(max_dx * max_dx + max_dy * max_dy),
+                                   result);
+}
+
 RadialGradientSq::RadialGradientSq(Point center, ColorGradient gradient,
                                    Box extents)
     : cx_(center.x),
@@ -130,13 +313,41 @@ void RadialGradientSq::readColors(const int16_t* x, const int16_t* y,
     int16_t dx = *x - cx_;
     int16_t dy = *y - cy_;
     uint32_t r = dx * dx + dy * dy;
-    Color c = gradient_.getColor(r);
+    Color c = gradient_.lookupColor(r);
     *result++ = c;
     ++x;
     ++y;
   }
 }
 
+bool RadialGradientSq::readColorRect(int16_t xMin, int16_t yMin,
+                                     int16_t xMax, int16_t yMax,
+                                     Color* result) const {
+  if (readUniformColorRect(xMin, yMin, xMax, yMax, result)) return true;
+  FillRows(xMin, yMin, xMax, yMax, result, [&](int16_t y, Color* row) {
+    int32_t dy = y - cy_;
+    int32_t dx = xMin - cx_;
+    // Squared distance, updated incrementally: (dx + 1)^2 = dx^2 + 2dx + 1.
+    uint32_t d2 = dx * dx + dy * dy;
+    for (int16_t x = xMin; x <= xMax; ++x) {
+      *row++ = gradient_.lookupColor(d2);
+      d2 += 2 * dx + 1;
+      ++dx;
+    }
+  });
+  return false;
+}
+
+bool RadialGradientSq::readUniformColorRect(int16_t xMin, int16_t yMin,
+                                            int16_t xMax, int16_t yMax,
+                                            Color* result) const {
+  float min_dx, max_dx, min_dy, max_dy;
+  AbsRange(xMin - cx_, xMax - cx_, &min_dx, &max_dx);
+  AbsRange(yMin - cy_, yMax - cy_, &min_dy, &max_dy);
+  return gradient_.getUniformColor(min_dx * min_dx + min_dy * min_dy,
+                                   max_dx * max_dx + max_dy * max_dy, result);
+}
+
 LinearGradient::LinearGradient(Point origin, float dx, float dy,
                                ColorGradient gradient, Box extents)
     : cx_(origin.x),
@@ -151,75 +362,78 @@ void LinearGradient::readColors(const int16_t* x, const int16_t* y,
   if (dx_ == 0.0f) {
     if (dy_ == 1.0f) {
       while (count-- > 0) {
-        *result++ = gradient_.getColor(*y++ - cy_);
+        *result++ = gradient_.lookupColor(*y++ - cy_);
       }
     } else {
       while (count-- > 0) {
-        *result++ = gradient_.getColor((*y++ - cy_) * dy_);
+        *result++ = gradient_.lookupColor((*y++ - cy_) * dy_);
       }
     }
   } else if (dy_ == 0.0f) {
     if (dx_ == 1.0f) {
       while (count-- > 0) {
-        *result++ = gradient_.getColor(*x++ - cx_);
+        *result++ = gradient_.lookupColor(*x++ - cx_);
       }
     } else {
       while (count-- > 0) {
-        *result++ = gradient_.getColor((*x++ - cx_) * dx_);
+        *result++ = gradient_.lookupColor((*x++ - cx_) * dx_);
       }
     }
   } else {
     while (count-- > 0) {
-      *result++ = gradient_.getColor((*x++ - cx_) * dx_ + (*y++ - cy_) * dy_);
+      *result++ =
+          gradient_.lookupColor((*x++ - cx_) * dx_ + (*y++ - cy_) * dy_);
     }
   }
 }
 
 bool LinearGradient::readColorRect(int16_t xMin, int16_t yMin, int16_t xMax,
                                    int16_t yMax, Color* result) const {
+  if (readUniformColorRect(xMin, yMin, xMax, yMax, result)) return true;
   int16_t width = xMax - xMin + 1;
   if (dx_ == 0.0f) {
-    if (dy_ == 1.0f) {
-      for (int16_t y = yMin; y <= yMax; ++y) {
-        FillColor(result, width, gradient_.getColor(y - cy_));
-        result += width;
-      }
-    } else {
-      for (int16_t y = yMin; y <= yMax; ++y) {
-        FillColor(result, width, gradient_.getColor((y - cy_) * dy_));
-        result += width;
-      }
+    for (int16_t y = yMin; y <= yMax; ++y) {
+      FillColor(result, width, gradient_.lookupColor((y - cy_) * dy_));
+      result += width;
     }
   } else if (dy_ == 0.0f) {
-    if (dx_ == 1.0f) {
-      const Color* start = result;
-      for (int16_t x = xMin; x <= xMax; ++x) {
-        *result++ = gradient_.getColor(x - cx_);
-      }
-      for (int16_t y = yMin + 1; y <= yMax; ++y) {
-        memcpy(result, start, width * sizeof(Color));
-        result += width;
-      }
-    } else {
-      const Color* start = result;
-      for (int16_t x = xMin; x <= xMax; ++x) {
-        *result++ = gradient_.getColor((x - cx_) * dx_);
-      }
-      for (int16_t y = yMin + 1; y <= yMax; ++y) {
-        memcpy(result, start, width * sizeof(Color));
-        result += width;
-      }
+    const Color* start = result;
+    gradient_.lookupColors((xMin - cx_) * dx_, dx_, width, result);
+    result += width;
+    for (int16_t y = yMin + 1; y <= yMax; ++y) {
+      memcpy(result, start, width * sizeof(Color));
+      result += width;
     }
   } else {
     for (int16_t y = yMin; y <= yMax; ++y) {
-      for (int16_t x = xMin; x <= xMax; ++x) {
-        *result++ = gradient_.getColor((x - cx_) * dx_ + (y - cy_) * dy_);
-      }
+      gradient_.lookupColors((xMin - cx_) * dx_ + (y - cy_) * dy_, dx_, width,
+                             result);
+      result += width;
     }
   }
   return false;
 }
 
+bool LinearGradient::readUniformColorRect(int16_t xMin, int16_t yMin,
+                                          int16_t xMax, int16_t yMax,
+                                          Color* result) const {
+  float min_value, max_value;
+  getValueRange(xMin, yMin, xMax, yMax, &min_value, &max_value);
+  return gradient_.getUniformColor(min_value, max_value, result);
+}
+
+void LinearGradient::getValueRange(int16_t xMin, int16_t yMin, int16_t xMax,
+                                   int16_t yMax, float* min_value,
+                                   float* max_value) const {
+  // The value is linear, so the extremes are in the corners.
+  float vx0 = (xMin - cx_) * dx_;
+  float vx1 = (xMax - cx_) * dx_;
+  float vy0 = (yMin - cy_) * dy_;
+  float vy1 = (yMax - cy_) * dy_;
+  *min_value = std::min(vx0, vx1) + std::min(vy0, vy1);
+  *max_value = std::max(vx0, vx1) + std::max(vy0, vy1);
+}
+
 AngularGradient::AngularGradient(FpPoint center, ColorGradient gradient,
                                  Box extents)
     : cx_(center.x),
@@ -230,10 +444,21 @@ AngularGradient::AngularGradient(FpPoint center, ColorGradient gradient,
 void AngularGradient::readColors(const int16_t* x, const int16_t* y,
                                  uint32_t count, Color* result) const {
   while (count-- > 0) {
-    *result++ = gradient_.getColor(atan2f(*x++ - cx_, cy_ - *y++));
+    *result++ = gradient_.lookupColor(atan2f(*x++ - cx_, cy_ - *y++));
   }
 }
 
+bool AngularGradient::readColorRect(int16_t xMin, int16_t yMin, int16_t xMax,
+                                    int16_t yMax, Color* result) const {
+  FillRows(xMin, yMin, xMax, yMax, result, [&](int16_t y, Color* row) {
+    float dy = cy_ - y;
+    for (int16_t x = xMin; x <= xMax; ++x) {
+      *row++ = gradient_.lookupColor(atan2f(x - cx_, dy));
+    }
+  });
+  return false;
+}
+
 roo_logging::Stream& operator<<(roo_logging::Stream& os, ColorGradient::Boundary boundary) {
   switch (boundary) {
     case ColorGradient::Boundary::kExtended:
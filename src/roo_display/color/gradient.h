@@ -49,8 +49,18 @@ class ColorGradient {
   /// Node list must contain at least one node for EXTENDED/TRUNCATED, and at
   /// least two nodes with different values for PERIODIC. Nodes must be sorted
   /// by value. Equal successive values create sharp transitions.
+  ///
+  /// If `lut_size` is non-zero (it must be a power of two, e.g. 256 or 1024),
+  /// the colors within the node range are pre-computed into a lookup table of
+  /// that many entries (taking 4 bytes each), used by `lookupColor()` and
+  /// `lookupColors()`, and thus by the gradient rasterizables. This trades a
+  /// bit of precision for speed: the lookup avoids the search over the nodes
+  /// and the floating-point interpolation, and rows of a linear gradient are
+  /// then evaluated in fixed point. Sharp transitions may shift by up to half
+  /// a table entry, i.e. by (range / lut_size / 2).
   ColorGradient(std::vector<Node> gradient,
-                Boundary boundary = Boundary::kExtended);
+                Boundary boundary = Boundary::kExtended,
+                uint16_t lut_size = 0);
 
   /// Return the color for a given value.
   ///
@@ -58,6 +68,26 @@ class ColorGradient {
   /// the range follow the boundary specification.
   Color getColor(float value) const;
 
+  /// Return the color for a given value, using the lookup table if there is
+  /// one. Otherwise, equivalent to `getColor()`.
+  ///
+  /// Values outside the node range (except for periodic gradients) are
+  /// always evaluated exactly.
+  Color lookupColor(float value) const;
+
+  /// Stores the colors for `count` equally spaced values, starting at
+  /// `value`, and increasing by `step`, in `result`. Equivalent to calling
+  /// `lookupColor(value + i * step)` for each i, but (with the lookup table)
+  /// steps through the table in fixed point.
+  void lookupColors(float value, float step, uint32_t count,
+                    Color* result) const;
+
+  /// Returns true if all the values within [min_value, max_value] map to the
+  /// same color, and if so, stores that color in *result. Exact, regardless
+  /// of the lookup table. Conservative: may return false for some uniform
+  /// ranges (e.g. spanning a whole period of a periodic gradient).
+  bool getUniformColor(float min_value, float max_value, Color* result) const;
+
   /// Return the transparency mode of the gradient.
   TransparencyMode getTransparencyMode() const { return transparency_mode_; }
 
@@ -66,6 +96,14 @@ class ColorGradient {
   Boundary boundary_;
   TransparencyMode transparency_mode_;
   float inv_period_;
+
+  // Optional lookup table. For periodic gradients, entry i corresponds to
+  // value front + i * range / size; otherwise, to front + i * range / (size -
+  // 1), so that both ends are exact.
+  std::vector<Color> lut_;
+
+  // Number of table entries per unit of value.
+  float lut_scale_;
 };
 
 roo_logging::Stream& operator<<(roo_logging::Stream& os,
@@ -87,6 +125,12 @@ class RadialGradient : public Rasterizable {
   void readColors(const int16_t* x, const int16_t* y, uint32_t count,
                   Color* result) const override;
 
+  bool readColorRect(int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                     Color* result) const override;
+
+  bool readUniformColorRect(int16_t xMin, int16_t yMin, int16_t xMax,
+                            int16_t yMax, Color* result) const override;
+
  private:
   float cx_;
   float cy_;
@@ -108,6 +152,12 @@ class RadialGradientSq : public Rasterizable {
   void readColors(const int16_t* x, const int16_t* y, uint32_t count,
                   Color* result) const override;
 
+  bool readColorRect(int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                     Color* result) const override;
+
+  bool readUniformColorRect(int16_t xMin, int16_t yMin, int16_t xMax,
+                            int16_t yMax, Color* result) const override;
+
  private:
   int16_t cx_;
   int16_t cy_;
@@ -136,7 +186,14 @@ class LinearGradient : public Rasterizable {
   bool readColorRect(int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
                      Color* result) const override;
 
+  bool readUniformColorRect(int16_t xMin, int16_t yMin, int16_t xMax,
+                            int16_t yMax, Color* result) const override;
+
  private:
+  // Sets *min_value and *max_value to the range of values within the rect.
+  void getValueRange(int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                     float* min_value, float* max_value) const;
+
   int16_t cx_;
   int16_t cy_;
   float dx_;
@@ -175,6 +232,9 @@ class AngularGradient : public Rasterizable {
   void readColors(const int16_t* x, const int16_t* y, uint32_t count,
                   Color* result) const override;
 
+  bool readColorRect(int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                     Color* result) const override;
+
  private:
   float cx_;
   float cy_;
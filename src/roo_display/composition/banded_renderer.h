@@ -0,0 +1,133 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "roo_display.h"
+#include "roo_display/core/offscreen.h"
+#include "roo_display/internal/color_format.h"
+#include "roo_logging.h"
+
+namespace roo_display {
+
+/// Renders a scene into a display through a small, reusable band buffer.
+///
+/// Displays without a framebuffer (e.g. SPI panels such as ILI9341, ST7789,
+/// or ILI9486) receive the pixels of each drawable in many small writes,
+/// interleaved with address window switches. The banded renderer instead
+/// draws the scene into an offscreen band of a few dozen rows, in the
+/// display's native color format, and ships each finished band with a single
+/// `drawDirectRectAsync()`. Two band buffers are used alternately, so that the
+/// next band gets rendered while the previous one is still being transferred
+/// (e.g. by DMA). With 16-32 row bands, the throughput approaches that of a
+/// full framebuffer, at a fraction of its memory cost.
+///
+/// The scene is a callable that takes a `DrawingContext&`. It is invoked once
+/// per band, with a context whose coordinates are the display's, and whose
+/// clip box is limited to the band; it should draw everything that may
+/// intersect the band (objects outside of it are clipped away cheaply). Each
+/// band is first cleared, using the display's background settings.
+///
+/// Example:
+///
+///   BandedRenderer<Rgb565> renderer(display.width(), 24);
+///   renderer.draw(display, [&](DrawingContext& dc) {
+///     dc.draw(background_panel);
+///     dc.draw(clock_label, 10, 20);
+///   });
+///
+/// The template parameters must match the display's native color format.
+/// For sub-byte color modes, the drawn area's width must be a multiple of the
+/// number of pixels per byte.
+template <typename ColorModeT,
+          ColorPixelOrder pixel_order = ColorPixelOrder::kMsbFirst,
+          ByteOrder byte_order = roo_io::kBigEndian>
+class BandedRenderer {
+ public:
+  using ColorMode = ColorModeT;
+
+  /// Create a renderer for areas up to `max_width` pixels wide, using bands
+  /// of `band_height` rows. Allocates two band buffers.
+  BandedRenderer(int16_t max_width, int16_t band_height,
+                 ColorMode color_mode = ColorMode())
+      : max_width_(max_width),
+        band_height_(band_height),
+        color_mode_(color_mode),
+        current_(0) {
+    size_t size =
+        ((size_t)max_width * band_height * ColorMode::bits_per_pixel + 7) / 8;
+    buffers_[0].reset(new roo::byte[size]);
+    buffers_[1].reset(new roo::byte[size]);
+  }
+
+  BandedRenderer(const BandedRenderer&) = delete;
+  BandedRenderer& operator=(const BandedRenderer&) = delete;
+
+  int16_t band_height() const { return band_height_; }
+
+  /// Renders the scene to the entire display.
+  template <typename Scene>
+  void draw(Display& display, Scene&& scene) {
+    draw(display, display.extents(), std::forward<Scene>(scene));
+  }
+
+  /// Renders the scene to the specified area of the display (in display
+  /// coordinates). The area is clipped to the display's extents.
+  template <typename Scene>
+  void draw(Display& display, Box area, Scene&& scene) {
+    area = Box::Intersect(area, display.extents());
+    if (area.empty()) return;
+    CHECK_LE(area.width(), max_width_);
+    DisplayOutput& out = display.output();
+    DCHECK(out.getColorFormat().mode() ==
+               internal::ColorFormatTraits<ColorMode>::mode &&
+           out.getColorFormat().pixel_order() == pixel_order &&
+           out.getColorFormat().byte_order() == byte_order)
+        << "The band format must match the display's native format";
+    size_t row_width_bytes;
+    if constexpr (ColorTraits<ColorMode>::pixels_per_byte == 1) {
+      row_width_bytes =
+          area.width() * ColorTraits<ColorMode>::bytes_per_pixel;
+    } else {
+      // Offscreen rows are packed continuously.
+      DCHECK_EQ(0, area.width() % ColorTraits<ColorMode>::pixels_per_byte);
+      row_width_bytes =
+          area.width() / ColorTraits<ColorMode>::pixels_per_byte;
+    }
+    // Keeps the display in a single transaction.
+    DrawingContext transaction(display);
+    for (int16_t y0 = area.yMin(); y0 <= area.yMax(); y0 += band_height_) {
+      int16_t y1 = std::min<int16_t>(y0 + band_height_ - 1, area.yMax());
+      roo::byte* buffer = buffers_[current_].get();
+      {
+        // The offscreen's extents put the band at its place in the display
+        // coordinates.
+        Offscreen<ColorMode, pixel_order, byte_order> band(
+            Box(area.xMin(), y0, area.xMax(), y1), buffer, color_mode_);
+        DrawingContext dc(band);
+        dc.setBackgroundColor(display.getBackgroundColor());
+        dc.setBackground(display.getRasterizableBackground());
+        dc.clear();
+        scene(dc);
+      }
+      // The transfer of the previous band, from the other buffer, completes
+      // at the latest when this call is made; see drawDirectRectAsync().
+      out.drawDirectRectAsync(buffer, row_width_bytes, 0, 0,
+                              area.width() - 1, y1 - y0, area.xMin(), y0);
+      current_ ^= 1;
+    }
+    // Make sure that the last band's buffer can be reused.
+    out.flush();
+  }
+
+ private:
+  int16_t max_width_;
+  int16_t band_height_;
+  ColorMode color_mode_;
+  std::unique_ptr<roo::byte[]> buffers_[2];
+  uint8_t current_;
+};
+
+}  // namespace roo_display
@@ -0,0 +1,113 @@
+#include "roo_display/composition/damage_tracker.h"
+
+#include <cstring>
+
+namespace roo_display {
+
+DamageTracker::DamageTracker(const Box& extents, uint8_t tile_bits)
+    : extents_(extents),
+      tile_bits_(tile_bits),
+      tile_columns_(extents.empty()
+                        ? 0
+                        : ((extents.width() - 1) >> tile_bits) + 1),
+      tile_rows_(extents.empty() ? 0
+                                 : ((extents.height() - 1) >> tile_bits) + 1),
+      tiles_(new uint8_t[(tile_columns_ * tile_rows_ + 7) / 8]),
+      dirty_tile_count_(0) {
+  reset();
+}
+
+void DamageTracker::reset() {
+  memset(tiles_.get(), 0, (tile_columns_ * tile_rows_ + 7) / 8);
+  dirty_tile_count_ = 0;
+}
+
+void DamageTracker::invalidateAll() { invalidate(extents_); }
+
+void DamageTracker::invalidate(const Box& box) {
+  Box clipped = Box::Intersect(box, extents_);
+  if (clipped.empty()) return;
+  int16_t c0 = (clipped.xMin() - extents_.xMin()) >> tile_bits_;
+  int16_t c1 = (clipped.xMax() - extents_.xMin()) >> tile_bits_;
+  int16_t r0 = (clipped.yMin() - extents_.yMin()) >> tile_bits_;
+  int16_t r1 = (clipped.yMax() - extents_.yMin()) >> tile_bits_;
+  for (int16_t r = r0; r <= r1; ++r) {
+    uint32_t idx = r * tile_columns_ + c0;
+    for (int16_t c = c0; c <= c1; ++c) {
+      setTile(idx++);
+    }
+  }
+}
+
+namespace {
+
+// Number of clean pixels that would get included by replacing a and b with
+// their bounding box.
+int32_t MergeCost(const Box& a, const Box& b) {
+  return Box::Extent(a, b).area() - a.area() - b.area();
+}
+
+}  // namespace
+
+void DamageTracker::getDirtyRegions(std::vector<Box>& result,
+                                    size_t max_regions) const {
+  if (empty()) return;
+  size_t first = result.size();
+  // Regions that ended on the previous tile row, and may be extended
+  // downwards. Indexes into `result`.
+  std::vector<size_t> open;
+  std::vector<size_t> next_open;
+  int16_t tile_size = 1 << tile_bits_;
+  for (int16_t r = 0; r < tile_rows_; ++r) {
+    next_open.clear();
+    int16_t y0 = extents_.yMin() + (r << tile_bits_);
+    int16_t y1 = std::min<int16_t>(y0 + tile_size - 1, extents_.yMax());
+    size_t open_idx = 0;
+    int16_t c = 0;
+    while (c < tile_columns_) {
+      if (!isTileDirty(c, r)) {
+        ++c;
+        continue;
+      }
+      int16_t c0 = c;
+      while (c < tile_columns_ && isTileDirty(c, r)) ++c;
+      int16_t x0 = extents_.xMin() + (c0 << tile_bits_);
+      int16_t x1 =
+          std::min<int16_t>(extents_.xMin() + (c << tile_bits_) - 1,
+                            extents_.xMax());
+      // Open regions are sorted by xMin, and disjoint; skip those to the left.
+      while (open_idx < open.size() && result[open[open_idx]].xMin() < x0) {
+        ++open_idx;
+      }
+      if (open_idx < open.size() && result[open[open_idx]].xMin() == x0 &&
+          result[open[open_idx]].xMax() == x1) {
+        Box& b = result[open[open_idx]];
+        b = Box(b.xMin(), b.yMin(), b.xMax(), y1);
+        next_open.push_back(open[open_idx]);
+        ++open_idx;
+      } else {
+        next_open.push_back(result.size());
+        result.emplace_back(x0, y0, x1, y1);
+      }
+    }
+    open.swap(next_open);
+  }
+  if (max_regions == 0) return;
+  // Greedily merge neighboring regions (in the row-major order) that waste
+  // the fewest clean pixels, until the bound is satisfied.
+  while (result.size() - first > max_regions) {
+    size_t best = first;
+    int32_t best_cost = MergeCost(result[first], result[first + 1]);
+    for (size_t i = first + 1; i + 1 < result.size(); ++i) {
+      int32_t cost = MergeCost(result[i], result[i + 1]);
+      if (cost < best_cost) {
+        best = i;
+        best_cost = cost;
+      }
+    }
+    result[best] = Box::Extent(result[best], result[best + 1]);
+    result.erase(result.begin() + best + 1);
+  }
+}
+
+}  // namespace roo_display
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include <memory>
+#include <vector>
+
+#include "roo_display/core/box.h"
+
+namespace roo_display {
+
+/// Tracks invalidated (dirty) regions of a rectangular area.
+///
+/// The area is divided into a grid of square tiles, of size `2^tile_bits`
+/// pixels. Invalidating a box marks all tiles it touches as dirty. The memory
+/// footprint is fixed (1 bit per tile), regardless of how many boxes get
+/// invalidated, and so is the cost of retrieving the dirty regions.
+///
+/// Dirty tiles are coalesced into rectangles: horizontal runs of dirty tiles
+/// within a tile row are merged, and runs spanning identical columns in
+/// consecutive tile rows are merged vertically. The number of the resulting
+/// rectangles can be further bounded, in which case rectangles get merged
+/// greedily, at the cost of including some clean pixels.
+class DamageTracker {
+ public:
+  /// Create a tracker for the specified extents, with tiles of size
+  /// `2^tile_bits` x `2^tile_bits`. Initially, nothing is dirty.
+  DamageTracker(const Box& extents, uint8_t tile_bits = 4);
+
+  /// Returns the tracked area.
+  const Box& extents() const { return extents_; }
+
+  /// Returns the tile width (and height) in pixels.
+  int16_t tile_size() const { return 1 << tile_bits_; }
+
+  /// Returns the number of tile columns.
+  int16_t tile_columns() const { return tile_columns_; }
+
+  /// Returns the number of tile rows.
+  int16_t tile_rows() const { return tile_rows_; }
+
+  /// Marks the tiles intersecting with the specified box (in the tracker's
+  /// coordinates) as dirty. Portions outside `extents()` are ignored.
+  void invalidate(const Box& box);
+
+  /// Marks the entire area as dirty.
+  void invalidateAll();
+
+  /// Returns true if the specified tile is dirty.
+  bool isTileDirty(int16_t column, int16_t row) const {
+    uint32_t idx = row * tile_columns_ + column;
+    return (tiles_[idx / 8] >> (idx % 8)) & 1;
+  }
+
+  /// Returns true if no tiles are dirty.
+  bool empty() const { return dirty_tile_count_ == 0; }
+
+  /// Returns the number of dirty tiles.
+  int32_t dirtyTileCount() const { return dirty_tile_count_; }
+
+  /// Marks all tiles as clean.
+  void reset();
+
+  /// Computes the coalesced dirty regions, clipped to `extents()`, and appends
+  /// them to `result`. If `max_regions` is non-zero, no more than
+  /// `max_regions` regions are produced. Unless bounded that way, the regions
+  /// are mutually disjoint.
+  void getDirtyRegions(std::vector<Box>& result, size_t max_regions = 0) const;
+
+ private:
+  void setTile(uint32_t idx) {
+    uint8_t mask = 1 << (idx % 8);
+    if ((tiles_[idx / 8] & mask) == 0) {
+      tiles_[idx / 8] |= mask;
+      ++dirty_tile_count_;
+    }
+  }
+
+  Box extents_;
+  uint8_t tile_bits_;
+  int16_t tile_columns_;
+  int16_t tile_rows_;
+  std::unique_ptr<uint8_t[]> tiles_;
+  int32_t dirty_tile_count_;
+};
+
+}  // namespace roo_display
@@ -0,0 +1,252 @@
+#include "roo_display/composition/parallel_rasterizable.h"
+
+#include "roo_display/color/blending.h"
+#include "roo_display/core/buffered_drawing.h"
+
+namespace roo_display {
+
+RenderWorkerPool::RenderWorkerPool(uint8_t worker_count)
+    : job_(nullptr), generation_(0), active_(0), shutdown_(false) {
+  workers_.reserve(worker_count);
+  for (uint8_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back([this]() { workerLoop(); });
+  }
+}
+
+RenderWorkerPool::~RenderWorkerPool() {
+  {
+    roo::unique_lock<roo::mutex> lock(mutex_);
+    shutdown_ = true;
+    cv_.notify_all();
+  }
+  for (auto& worker : workers_) worker.join();
+}
+
+void RenderWorkerPool::start(Job& job) {
+  roo::unique_lock<roo::mutex> lock(mutex_);
+  job_ = &job;
+  active_ = workers_.size();
+  ++generation_;
+  cv_.notify_all();
+}
+
+void RenderWorkerPool::finish() {
+  roo::unique_lock<roo::mutex> lock(mutex_);
+  while (active_ > 0) cv_.wait(lock);
+  job_ = nullptr;
+}
+
+void RenderWorkerPool::workerLoop() {
+  uint32_t seen_generation = 0;
+  roo::unique_lock<roo::mutex> lock(mutex_);
+  while (true) {
+    while (!shutdown_ && generation_ == seen_generation) cv_.wait(lock);
+    if (shutdown_) return;
+    seen_generation = generation_;
+    Job* job = job_;
+    lock.unlock();
+    job->work();
+    lock.lock();
+    if (--active_ == 0) cv_.notify_all();
+  }
+}
+
+namespace {
+
+static constexpr int16_t kTileSize = 8;
+static constexpr int kTilePixels = kTileSize * kTileSize;
+
+// How the rasterizable's colors get combined with the surface background.
+enum class BgBlend { kNone, kOverOpaque, kOver };
+
+// Renders the clip box of a surface in bands of 8x8 tiles, matching the
+// tiling of the default Rasterizable::drawTo(). Bands are evaluated by the
+// pool workers and by the drawing thread, and written to the output by the
+// drawing thread, in order. Each band in flight occupies one of a fixed
+// number of slots; a band can only be claimed once its slot is free.
+class BandRenderer : public RenderWorkerPool::Job {
+ public:
+  BandRenderer(const Rasterizable& object, const Surface& s, uint8_t workers)
+      : object_(object),
+        s_(s),
+        fill_(s.fill_mode() == FillMode::kExtents ||
+              object.getTransparencyMode() == TransparencyMode::kNone),
+        x_outer_(s.clip_box().xMin() & ~(kTileSize - 1)),
+        y_outer_(s.clip_box().yMin() & ~(kTileSize - 1)),
+        tile_count_(((s.clip_box().xMax() | (kTileSize - 1)) - x_outer_ + 1) /
+                    kTileSize),
+        band_count_(((s.clip_box().yMax() | (kTileSize - 1)) - y_outer_ + 1) /
+                    kTileSize),
+        slot_count_(workers + 2),
+        colors_(new Color[slot_count_ * tile_count_ * kTilePixels]),
+        uniform_(new bool[slot_count_ * tile_count_]),
+        ready_(new bool[slot_count_]()),
+        next_claim_(0),
+        next_emit_(0) {
+    Color bgcolor = s.bgcolor();
+    if (bgcolor.a() == 0 ||
+        (fill_ && object.getTransparencyMode() == TransparencyMode::kNone)) {
+      bg_blend_ = BgBlend::kNone;
+    } else if (bgcolor.a() == 0xFF) {
+      bg_blend_ = BgBlend::kOverOpaque;
+    } else {
+      bg_blend_ = BgBlend::kOver;
+    }
+  }
+
+  // Draws the bands, using the pool. Called by the drawing thread.
+  void run(RenderWorkerPool& pool) {
+    pool.start(*this);
+    for (int16_t band = 0; band < band_count_; ++band) {
+      uint8_t slot = band % slot_count_;
+      {
+        roo::unique_lock<roo::mutex> lock(mutex_);
+        while (!ready_[slot]) {
+          if (canClaim()) {
+            // Rather than just wait, help out.
+            int16_t claimed = next_claim_++;
+            lock.unlock();
+            render(claimed);
+            lock.lock();
+            ready_[claimed % slot_count_] = true;
+          } else {
+            cv_.wait(lock);
+          }
+        }
+      }
+      emit(band);
+      {
+        roo::unique_lock<roo::mutex> lock(mutex_);
+        ready_[slot] = false;
+        ++next_emit_;
+        cv_.notify_all();
+      }
+    }
+    pool.finish();
+  }
+
+  // Called by the pool workers.
+  void work() override {
+    roo::unique_lock<roo::mutex> lock(mutex_);
+    while (next_claim_ < band_count_) {
+      if (!canClaim()) {
+        cv_.wait(lock);
+        continue;
+      }
+      int16_t claimed = next_claim_++;
+      lock.unlock();
+      render(claimed);
+      lock.lock();
+      ready_[claimed % slot_count_] = true;
+      cv_.notify_all();
+    }
+  }
+
+ private:
+  bool canClaim() const {
+    return next_claim_ < band_count_ && next_claim_ < next_emit_ + slot_count_;
+  }
+
+  Box tileBox(int16_t band, int16_t tile) const {
+    const Box& clip = s_.clip_box();
+    int16_t x = x_outer_ + tile * kTileSize;
+    int16_t y = y_outer_ + band * kTileSize;
+    return Box(std::max(x, clip.xMin()), std::max(y, clip.yMin()),
+               std::min<int16_t>(x + kTileSize - 1, clip.xMax()),
+               std::min<int16_t>(y + kTileSize - 1, clip.yMax()));
+  }
+
+  Color* tileColors(int16_t band, int16_t tile) const {
+    return &colors_[((band % slot_count_) * tile_count_ + tile) * kTilePixels];
+  }
+
+  bool& tileUniform(int16_t band, int16_t tile) const {
+    return uniform_[(band % slot_count_) * tile_count_ + tile];
+  }
+
+  void blend(Color* buf, uint32_t count) const {
+    Color bgcolor = s_.bgcolor();
+    for (uint32_t i = 0; i < count; ++i) {
+      // In the 'visible' mode, fully transparent pixels get skipped when
+      // emitted, so they need to stay recognizable.
+      if (!fill_ && buf[i] == color::Transparent) continue;
+      buf[i] = (bg_blend_ == BgBlend::kOverOpaque)
+                   ? AlphaBlendOverOpaque(bgcolor, buf[i])
+                   : AlphaBlend(bgcolor, buf[i]);
+    }
+  }
+
+  // Evaluates the colors of the specified band. Thread-safe.
+  void render(int16_t band) const {
+    for (int16_t tile = 0; tile < tile_count_; ++tile) {
+      Box box = tileBox(band, tile);
+      Color* buf = tileColors(band, tile);
+      bool uniform = object_.readColorRect(
+          box.xMin() - s_.dx(), box.yMin() - s_.dy(), box.xMax() - s_.dx(),
+          box.yMax() - s_.dy(), buf);
+      tileUniform(band, tile) = uniform;
+      if (bg_blend_ != BgBlend::kNone) blend(buf, uniform ? 1 : box.area());
+    }
+  }
+
+  // Writes the evaluated band to the output.
+  void emit(int16_t band) const {
+    DisplayOutput& output = s_.out();
+    BlendingMode mode = s_.blending_mode();
+    for (int16_t tile = 0; tile < tile_count_; ++tile) {
+      Box box = tileBox(band, tile);
+      Color* buf = tileColors(band, tile);
+      if (tileUniform(band, tile)) {
+        if (fill_ || buf[0] != color::Transparent) {
+          output.fillRect(mode, box, buf[0]);
+        }
+      } else if (fill_) {
+        output.setAddress(box, mode);
+        output.write(buf, box.area());
+      } else {
+        BufferedPixelWriter writer(output, mode);
+        for (int16_t j = box.yMin(); j <= box.yMax(); ++j) {
+          for (int16_t i = box.xMin(); i <= box.xMax(); ++i) {
+            if (*buf != color::Transparent) writer.writePixel(i, j, *buf);
+            ++buf;
+          }
+        }
+      }
+    }
+  }
+
+  const Rasterizable& object_;
+  const Surface& s_;
+  bool fill_;
+  BgBlend bg_blend_;
+  int16_t x_outer_;
+  int16_t y_outer_;
+  int16_t tile_count_;
+  int16_t band_count_;
+  uint8_t slot_count_;
+  std::unique_ptr<Color[]> colors_;
+  std::unique_ptr<bool[]> uniform_;
+
+  // Guards the fields below.
+  roo::mutex mutex_;
+  roo::condition_variable cv_;
+  std::unique_ptr<bool[]> ready_;
+  int16_t next_claim_;
+  int16_t next_emit_;
+};
+
+}  // namespace
+
+void ParallelRasterizable::drawTo(const Surface& s) const {
+  const Box& box = s.clip_box();
+  if (pool_.worker_count() == 0 || box.area() <= kTilePixels ||
+      (box.yMin() & ~(kTileSize - 1)) == (box.yMax() & ~(kTileSize - 1))) {
+    // Nothing to parallelize.
+    s.drawObject(delegate_);
+    return;
+  }
+  BandRenderer renderer(delegate_, s, pool_.worker_count());
+  renderer.run(pool_);
+}
+
+}  // namespace roo_display
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include <memory>
+#include <vector>
+
+#include "roo_display/core/box.h"
+#include "roo_display/core/drawable.h"
+#include "roo_display/core/rasterizable.h"
+#include "roo_threads.h"
+#include "roo_threads/condition_variable.h"
+#include "roo_threads/mutex.h"
+#include "roo_threads/thread.h"
+
+namespace roo_display {
+
+/// Pool of worker threads, used by `ParallelRasterizable` to evaluate pixels
+/// off the calling thread.
+///
+/// The threads are started in the constructor, and stopped in the destructor.
+/// Between jobs, they sleep on a condition variable. On ESP32, the threads
+/// are FreeRTOS tasks, so that a single worker is enough to put the second
+/// core to use.
+///
+/// A pool executes one job at a time; it must not be used by multiple
+/// concurrently drawing threads.
+class RenderWorkerPool {
+ public:
+  /// Create a pool with the specified number of worker threads. The calling
+  /// thread also participates in the work, so e.g. on a dual-core MCU, one
+  /// worker is usually optimal. With zero workers, everything is evaluated on
+  /// the calling thread.
+  explicit RenderWorkerPool(uint8_t worker_count = 1);
+
+  ~RenderWorkerPool();
+
+  RenderWorkerPool(const RenderWorkerPool&) = delete;
+  RenderWorkerPool& operator=(const RenderWorkerPool&) = delete;
+
+  /// Returns the number of worker threads.
+  uint8_t worker_count() const { return workers_.size(); }
+
+  /// A unit of work to be shared by the workers and the calling thread.
+  class Job {
+   public:
+    virtual ~Job() = default;
+
+    /// Called by each worker thread. Should process work items until there
+    /// are none left, and then return.
+    virtual void work() = 0;
+  };
+
+  /// Makes all workers call `job.work()`, and returns immediately. The job
+  /// must remain valid until `finish()` returns.
+  void start(Job& job);
+
+  /// Blocks until all workers have returned from `work()` of the job passed
+  /// to `start()`.
+  void finish();
+
+ private:
+  void workerLoop();
+
+  roo::mutex mutex_;
+  roo::condition_variable cv_;
+  Job* job_;
+  uint32_t generation_;
+  uint8_t active_;
+  bool shutdown_;
+  std::vector<roo::thread> workers_;
+};
+
+/// Rasterizable wrapper that, when drawn, evaluates the pixels of the
+/// underlying rasterizable in parallel.
+///
+/// The drawn area is split into horizontal bands, 8 pixels tall. The bands
+/// get evaluated (using `readColorRect()` on 8x8 tiles, and blended with the
+/// background) by the workers of the pool, and by the calling thread, while
+/// the calling thread streams the completed bands to the output, in order.
+/// The output receives the same sequence of writes as if the underlying
+/// rasterizable was drawn using the default `Rasterizable::drawTo()`.
+///
+/// This pays off for rasterizables that are expensive to evaluate, e.g.
+/// gradients, shadows, and `RasterizableStack`s of those, used as large
+/// backgrounds. All the other `Rasterizable` methods simply delegate to the
+/// underlying rasterizable, so the wrapper can be used anywhere a rasterizable
+/// can (e.g. as a background).
+///
+/// The underlying rasterizable's `readColorRect()` must be safe to call from
+/// multiple threads concurrently. (That is true for the rasterizables in this
+/// library, as long as they don't read from shared non-thread-safe resources.)
+class ParallelRasterizable : public Rasterizable {
+ public:
+  ParallelRasterizable(const Rasterizable& delegate, RenderWorkerPool& pool)
+      : delegate_(delegate), pool_(pool) {}
+
+  Box extents() const override { return delegate_.extents(); }
+
+  Box anchorExtents() const override { return delegate_.anchorExtents(); }
+
+  TransparencyMode getTransparencyMode() const override {
+    return delegate_.getTransparencyMode();
+  }
+
+  void readColors(const int16_t* x, const int16_t* y, uint32_t count,
+                  Color* result) const override {
+    delegate_.readColors(x, y, count, result);
+  }
+
+  bool readColorRect(int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                     Color* result) const override {
+    return delegate_.readColorRect(xMin, yMin, xMax, yMax, result);
+  }
+
+  bool readUniformColorRect(int16_t xMin, int16_t yMin, int16_t xMax,
+                            int16_t yMax, Color* result) const override {
+    return delegate_.readUniformColorRect(xMin, yMin, xMax, yMax, result);
+  }
+
+  std::unique_ptr<PixelStream> createStream() const override {
+    return delegate_.createStream();
+  }
+
+  std::unique_ptr<PixelStream> createStream(const Box& bounds) const override {
+    return delegate_.createStream(bounds);
+  }
+
+ private:
+  void drawTo(const Surface& s) const override;
+
+  const Rasterizable& delegate_;
+  RenderWorkerPool& pool_;
+};
+
+}  // namespace roo_display
@@ -0,0 +1,67 @@
+#include "roo_display/composition/partial_refresh.h"
+
+#include <algorithm>
+
+#include "roo_logging.h"
+
+namespace roo_display {
+
+std::vector<PartialRefresh::Item>::iterator PartialRefresh::find(
+    const Drawable* drawable) {
+  return std::find_if(items_.begin(), items_.end(), [drawable](const Item& i) {
+    return i.drawable == drawable;
+  });
+}
+
+void PartialRefresh::remove(const Drawable* drawable) {
+  auto itr = find(drawable);
+  if (itr == items_.end()) return;
+  invalidate(itr->drawable->extents().translate(itr->dx, itr->dy));
+  items_.erase(itr);
+}
+
+void PartialRefresh::move(const Drawable* drawable, int16_t dx, int16_t dy) {
+  auto itr = find(drawable);
+  CHECK(itr != items_.end());
+  if (itr->dx == dx && itr->dy == dy) return;
+  Box extents = drawable->extents();
+  invalidate(extents.translate(itr->dx, itr->dy));
+  itr->dx = dx;
+  itr->dy = dy;
+  invalidate(extents.translate(dx, dy));
+}
+
+void PartialRefresh::invalidate(const Drawable* drawable) {
+  auto itr = find(drawable);
+  CHECK(itr != items_.end());
+  invalidate(drawable->extents().translate(itr->dx, itr->dy));
+}
+
+const PartialRefresh::FrameStats& PartialRefresh::refresh(Display& display) {
+  last_stats_ = FrameStats{damage_.dirtyTileCount(), 0, 0, 0};
+  if (damage_.empty()) return last_stats_;
+  regions_.clear();
+  damage_.getDirtyRegions(regions_, max_regions_);
+  damage_.reset();
+  DrawingContext dc(display);
+  for (const Box& region : regions_) {
+    dc.setClipBox(region);
+    const Box& clip_box = dc.getClipBox();
+    if (clip_box.empty()) continue;
+    ++last_stats_.regions;
+    last_stats_.refreshed_pixels += clip_box.area();
+    dc.clear();
+    for (const Item& item : items_) {
+      if (!item.drawable->extents()
+               .translate(item.dx, item.dy)
+               .intersects(clip_box)) {
+        continue;
+      }
+      ++last_stats_.draw_calls;
+      dc.draw(*item.drawable, item.dx, item.dy);
+    }
+  }
+  return last_stats_;
+}
+
+}  // namespace roo_display
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <vector>
+
+#include "roo_display.h"
+#include "roo_display/composition/damage_tracker.h"
+
+namespace roo_display {
+
+/// Redraws only the invalidated portions of a scene.
+///
+/// The scene is an ordered list of drawables (back to front), each drawn at
+/// a given offset. Whenever some part of the scene changes (e.g. an object
+/// gets added, moved, or its content changes), the affected area is
+/// invalidated. A subsequent call to `refresh()` coalesces the invalidated
+/// areas into a bounded number of tile-aligned regions, and for each region,
+/// clears it (respecting the display's background settings) and redraws the
+/// drawables that intersect it, clipped to that region. Drawables that don't
+/// intersect any dirty region are not visited at all.
+///
+/// Example:
+///
+///   PartialRefresh scene(display.extents());
+///   scene.add(&background_panel);
+///   scene.add(&clock_label, 10, 20);
+///   ...
+///   // Later, after clock_label's text changes:
+///   scene.invalidate(&clock_label);
+///   scene.refresh(display);
+///
+/// The drawables must remain valid for as long as they are in the scene.
+class PartialRefresh {
+ public:
+  /// Statistics about a single `refresh()` call.
+  struct FrameStats {
+    /// Number of tiles that were marked dirty.
+    int32_t dirty_tiles;
+
+    /// Number of (coalesced) regions that were redrawn.
+    int32_t regions;
+
+    /// Number of drawable invocations across all regions.
+    int32_t draw_calls;
+
+    /// Total area of the redrawn regions, in pixels.
+    int32_t refreshed_pixels;
+  };
+
+  /// Create a scene covering the specified extents (in the display
+  /// coordinates), tracking damage with tiles of size
+  /// `2^tile_bits` x `2^tile_bits`, and redrawing at most `max_regions`
+  /// separate regions per frame.
+  PartialRefresh(const Box& extents, uint8_t tile_bits = 4,
+                 size_t max_regions = 16)
+      : damage_(extents, tile_bits),
+        max_regions_(max_regions),
+        last_stats_{0, 0, 0, 0} {}
+
+  /// Appends the drawable to the scene, in front of all existing drawables,
+  /// and invalidates its extents.
+  void add(const Drawable* drawable, int16_t dx = 0, int16_t dy = 0) {
+    items_.push_back(Item{drawable, dx, dy});
+    invalidate(drawable->extents().translate(dx, dy));
+  }
+
+  /// Removes the drawable from the scene, and invalidates its extents.
+  void remove(const Drawable* drawable);
+
+  /// Moves the drawable to a new offset, invalidating both its old and its
+  /// new extents.
+  void move(const Drawable* drawable, int16_t dx, int16_t dy);
+
+  /// Removes all drawables from the scene, and invalidates the entire area.
+  void clear() {
+    items_.clear();
+    damage_.invalidateAll();
+  }
+
+  /// Invalidates the specified area (in the display coordinates).
+  void invalidate(const Box& box) { damage_.invalidate(box); }
+
+  /// Invalidates the current extents of the drawable, which must be in the
+  /// scene. Call it after the drawable's content changes. (If its extents
+  /// also change, call `invalidate()` with the old extents as well).
+  void invalidate(const Drawable* drawable);
+
+  /// Invalidates the entire area.
+  void invalidateAll() { damage_.invalidateAll(); }
+
+  /// Returns true if there is anything to redraw.
+  bool isDirty() const { return !damage_.empty(); }
+
+  /// Redraws the dirty regions, and marks everything as clean. Returns the
+  /// statistics of this refresh (also available as `lastFrameStats()`).
+  const FrameStats& refresh(Display& display);
+
+  /// Returns the statistics of the most recent `refresh()`.
+  const FrameStats& lastFrameStats() const { return last_stats_; }
+
+  /// Returns the underlying damage tracker.
+  const DamageTracker& damage() const { return damage_; }
+
+ private:
+  struct Item {
+    const Drawable* drawable;
+    int16_t dx;
+    int16_t dy;
+  };
+
+  std::vector<Item>::iterator find(const Drawable* drawable);
+
+  DamageTracker damage_;
+  size_t max_regions_;
+  std::vector<Item> items_;
+
+  // Reused across frames, to avoid re-allocation.
+  std::vector<Box> regions_;
+
+  FrameStats last_stats_;
+};
+
+}  // namespace roo_display
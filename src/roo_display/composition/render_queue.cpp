@@ -0,0 +1,201 @@
+#include "roo_display/composition/render_queue.h"
+
+#include <string.h>
+
+#include "roo_display/shape/basic.h"
+#include "roo_display/ui/text_label.h"
+
+namespace roo_display {
+
+namespace {
+
+uint32_t RoundUpToPowerOfTwo(uint32_t n) {
+  uint32_t result = 1;
+  while (result < n) result <<= 1;
+  return result;
+}
+
+uint32_t SlotCount(uint16_t capacity) {
+  if (capacity == 0) return 1;
+  if (capacity > RenderQueue::kMaxCapacity) return RenderQueue::kMaxCapacity;
+  return RoundUpToPowerOfTwo(capacity);
+}
+
+}  // namespace
+
+RenderQueue::RenderQueue(uint16_t capacity)
+    : slots_(new Slot[SlotCount(capacity)]),
+      mask_(SlotCount(capacity) - 1),
+      enqueue_pos_(0),
+      dequeue_pos_(0),
+      enqueued_(0),
+      rejected_(0),
+      max_depth_(0),
+      executed_(0) {
+  for (uint32_t i = 0; i <= mask_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+RenderQueue::Command* RenderQueue::claim(uint32_t& pos) {
+  pos = enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    Slot& slot = slots_[pos & mask_];
+    uint32_t seq = slot.sequence.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      // The slot is free; try to claim it.
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+      // Lost the race (pos has been reloaded); retry.
+    } else if (diff < 0) {
+      // The slot still holds the command from the previous lap; full.
+      rejected_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    } else {
+      // Another producer claimed the slot; catch up.
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  uint16_t depth = pos + 1 - dequeue_pos_.load(std::memory_order_relaxed);
+  uint16_t max_depth = max_depth_.load(std::memory_order_relaxed);
+  while (depth > max_depth &&
+         !max_depth_.compare_exchange_weak(max_depth, depth,
+                                           std::memory_order_relaxed)) {
+  }
+  return &slots_[pos & mask_].command;
+}
+
+void RenderQueue::publish(uint32_t pos) {
+  slots_[pos & mask_].sequence.store(pos + 1, std::memory_order_release);
+  enqueued_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool RenderQueue::fillRect(const Box& rect, Color color) {
+  uint32_t pos;
+  Command* cmd = claim(pos);
+  if (cmd == nullptr) return false;
+  cmd->type = CommandType::kFillRect;
+  cmd->box = rect;
+  cmd->color = color;
+  publish(pos);
+  return true;
+}
+
+bool RenderQueue::draw(const Drawable& object, int16_t dx, int16_t dy,
+                       const Box& clip_box) {
+  uint32_t pos;
+  Command* cmd = claim(pos);
+  if (cmd == nullptr) return false;
+  cmd->type = CommandType::kDraw;
+  cmd->ptr = &object;
+  cmd->x = dx;
+  cmd->y = dy;
+  cmd->box = clip_box;
+  publish(pos);
+  return true;
+}
+
+bool RenderQueue::drawText(roo::string_view text, const Font& font,
+                           Color color, int16_t x, int16_t y) {
+  if (text.size() > kMaxTextLength) {
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  uint32_t pos;
+  Command* cmd = claim(pos);
+  if (cmd == nullptr) return false;
+  cmd->type = CommandType::kDrawText;
+  cmd->ptr = &font;
+  cmd->color = color;
+  cmd->x = x;
+  cmd->y = y;
+  cmd->text_length = text.size();
+  memcpy(cmd->text, text.data(), text.size());
+  publish(pos);
+  return true;
+}
+
+uint32_t RenderQueue::drain(DrawingContext& dc, uint32_t max_commands) {
+  uint32_t count = 0;
+  uint32_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  while (count < max_commands) {
+    Slot& slot = slots_[pos & mask_];
+    uint32_t seq = slot.sequence.load(std::memory_order_acquire);
+    if ((int32_t)(seq - (pos + 1)) < 0) break;  // Empty.
+    execute(slot.command, dc);
+    // Advance before releasing the slot, so that the producer that claims it
+    // sees the new position (and computes the depth correctly).
+    dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+    // Release the slot to the producers, for the next lap.
+    slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+    ++pos;
+    ++count;
+  }
+  executed_.fetch_add(count, std::memory_order_relaxed);
+  return count;
+}
+
+void RenderQueue::execute(const Command& cmd, DrawingContext& dc) {
+  switch (cmd.type) {
+    case CommandType::kFillRect: {
+      dc.draw(FilledRect(cmd.box, cmd.color));
+      break;
+    }
+    case CommandType::kDraw: {
+      Box clip_box = dc.getClipBox();
+      dc.setClipBox(Box::Intersect(clip_box, cmd.box));
+      dc.draw(*(const Drawable*)cmd.ptr, cmd.x, cmd.y);
+      dc.setClipBox(clip_box);
+      break;
+    }
+    case CommandType::kDrawText: {
+      roo::string_view text(cmd.text, cmd.text_length);
+      dc.draw(StringViewLabel(text, *(const Font*)cmd.ptr, cmd.color), cmd.x,
+              cmd.y);
+      break;
+    }
+  }
+}
+
+bool RenderQueue::empty() const {
+  uint32_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  return (int32_t)(slots_[pos & mask_].sequence.load(
+                       std::memory_order_acquire) -
+                   (pos + 1)) < 0;
+}
+
+RenderQueue::Stats RenderQueue::stats() const {
+  return Stats{enqueued_.load(std::memory_order_relaxed),
+               rejected_.load(std::memory_order_relaxed),
+               executed_.load(std::memory_order_relaxed),
+               max_depth_.load(std::memory_order_relaxed)};
+}
+
+RenderTask::RenderTask(Display& display, RenderQueue& queue,
+                       roo_time::Duration idle_interval)
+    : display_(display),
+      queue_(queue),
+      idle_interval_(idle_interval),
+      shutdown_(false),
+      thread_([this]() { loop(); }) {}
+
+RenderTask::~RenderTask() {
+  shutdown_.store(true, std::memory_order_relaxed);
+  thread_.join();
+}
+
+void RenderTask::loop() {
+  while (!shutdown_.load(std::memory_order_relaxed)) {
+    if (queue_.empty()) {
+      roo::this_thread::sleep_for(idle_interval_);
+      continue;
+    }
+    DrawingContext dc(display_);
+    queue_.drain(dc);
+  }
+}
+
+}  // namespace roo_display
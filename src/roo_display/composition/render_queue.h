@@ -0,0 +1,179 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include <atomic>
+#include <memory>
+
+#include "roo_backport.h"
+#include "roo_backport/string_view.h"
+#include "roo_display.h"
+#include "roo_display/font/font.h"
+#include "roo_threads.h"
+#include "roo_threads/thread.h"
+#include "roo_time.h"
+
+namespace roo_display {
+
+/// Bounded queue of draw commands, letting any number of tasks request
+/// drawing, while a single task (the one that owns the display) executes the
+/// commands.
+///
+/// Drawing must normally happen on a single task, since display outputs are
+/// synchronous and not thread-safe. With a render queue, e.g. sensor tasks
+/// can publish UI updates without blocking on SPI transfers: they just
+/// enqueue commands, and return. The render task calls `drain()`, typically
+/// in its main loop, or uses `RenderTask`.
+///
+/// Enqueuing is lock-free, and never blocks: if the queue is full, the
+/// command is rejected (the call returns false), and it is up to the producer
+/// to drop it or retry later. The rejections, along with the maximum queue
+/// depth seen, are counted in `stats()`, which helps sizing the queue.
+///
+/// Commands are small, fixed-size records. Drawables and fonts are passed by
+/// pointer, and must remain valid (and unchanged) until the command has been
+/// executed; text is copied, up to `kMaxTextLength` bytes.
+///
+/// Commands enqueued by the same producer are executed in order. Commands
+/// enqueued concurrently by different producers are executed in the order in
+/// which they claimed their slots in the queue.
+class RenderQueue {
+ public:
+  /// Maximum length, in bytes, of text passed to `drawText()`.
+  static constexpr int kMaxTextLength = 32;
+
+  /// Queue counters. Approximate while producers are active.
+  struct Stats {
+    /// Commands successfully enqueued.
+    uint32_t enqueued;
+
+    /// Commands rejected because the queue was full (or the text was too
+    /// long).
+    uint32_t rejected;
+
+    /// Commands executed by `drain()`.
+    uint32_t executed;
+
+    /// Maximum number of commands pending at once.
+    uint16_t max_depth;
+  };
+
+  /// The largest supported capacity.
+  static constexpr uint16_t kMaxCapacity = 0x8000;
+
+  /// Create a queue with at least the specified capacity (rounded up to a
+  /// power of two), but no more than `kMaxCapacity`.
+  explicit RenderQueue(uint16_t capacity = 32);
+
+  RenderQueue(const RenderQueue&) = delete;
+  RenderQueue& operator=(const RenderQueue&) = delete;
+
+  /// Returns the maximum number of pending commands.
+  uint16_t capacity() const { return mask_ + 1; }
+
+  /// Enqueues filling the rectangle with the specified color. Returns false
+  /// if the queue is full.
+  bool fillRect(const Box& rect, Color color);
+
+  /// Enqueues drawing the object, offset by (dx, dy). Returns false if the
+  /// queue is full.
+  bool draw(const Drawable& object, int16_t dx = 0, int16_t dy = 0) {
+    return draw(object, dx, dy, Box::MaximumBox());
+  }
+
+  /// Enqueues drawing the object, offset by (dx, dy), clipped to the
+  /// specified box. Returns false if the queue is full. Use it e.g. to draw a
+  /// region of a raster.
+  bool draw(const Drawable& object, int16_t dx, int16_t dy,
+            const Box& clip_box);
+
+  /// Enqueues drawing the text at the specified position (the left end of
+  /// the baseline). Returns false if the queue is full, or if the text is
+  /// longer than `kMaxTextLength`.
+  bool drawText(roo::string_view text, const Font& font, Color color,
+                int16_t x, int16_t y);
+
+  /// Executes pending commands, at most `max_commands`, in the specified
+  /// context, and returns the number of commands executed. The clip box of
+  /// each command is intersected with the clip box of the context. Must only
+  /// be called by a single task at a time.
+  uint32_t drain(DrawingContext& dc, uint32_t max_commands = 0xFFFFFFFF);
+
+  /// Returns true if there are no pending commands. (They may get added
+  /// concurrently at any time.)
+  bool empty() const;
+
+  Stats stats() const;
+
+ private:
+  enum class CommandType : uint8_t { kFillRect, kDraw, kDrawText };
+
+  struct Command {
+    CommandType type;
+    uint8_t text_length;
+    int16_t x;
+    int16_t y;
+    Color color;
+    Box box;
+    const void* ptr;
+    char text[kMaxTextLength];
+  };
+
+  // A slot of the ring. The sequence number tells who owns the slot: if it
+  // equals the producer position, the slot is free to write; if it equals
+  // the consumer position + 1, the slot contains a command ready to execute.
+  struct Slot {
+    std::atomic<uint32_t> sequence;
+    Command command;
+  };
+
+  // Claims a slot, and returns the command to fill, or nullptr if full.
+  // The command gets published by `publish()`.
+  Command* claim(uint32_t& pos);
+  void publish(uint32_t pos);
+
+  void execute(const Command& cmd, DrawingContext& dc);
+
+  std::unique_ptr<Slot[]> slots_;
+  uint32_t mask_;
+
+  std::atomic<uint32_t> enqueue_pos_;
+  std::atomic<uint32_t> dequeue_pos_;
+
+  std::atomic<uint32_t> enqueued_;
+  std::atomic<uint32_t> rejected_;
+  std::atomic<uint16_t> max_depth_;
+  std::atomic<uint32_t> executed_;
+};
+
+/// Dedicated task that drains a `RenderQueue` into a display.
+///
+/// The task polls the queue, sleeping for `idle_interval` whenever it is
+/// empty (so that the producers never need to wake it up, and remain
+/// lock-free). The pending commands are executed in a single drawing
+/// context, i.e. within a single begin()/end() transaction.
+///
+/// The display must not be drawn to by other tasks while the render task
+/// exists.
+class RenderTask {
+ public:
+  RenderTask(Display& display, RenderQueue& queue,
+             roo_time::Duration idle_interval = roo_time::Millis(5));
+
+  /// Stops the task, after it finishes the current batch of commands.
+  ~RenderTask();
+
+  RenderTask(const RenderTask&) = delete;
+  RenderTask& operator=(const RenderTask&) = delete;
+
+ private:
+  void loop();
+
+  Display& display_;
+  RenderQueue& queue_;
+  roo_time::Duration idle_interval_;
+  std::atomic<bool> shutdown_;
+  roo::thread thread_;
+};
+
+}  // namespace roo_display
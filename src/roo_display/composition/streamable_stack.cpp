@@ -110,7 +110,8 @@ enum Instruction {
 
 class Composition {
  public:
-  Composition(const Box& bounds) : bounds_(bounds), input_count_(0) {
+  Composition(const Box& bounds)
+      : bounds_(bounds), input_count_(0), fusable_pos_(-1) {
     data_.emplace_back(bounds.height());
     data_.back().AddChunk(bounds.width(), 0);
   }
@@ -121,13 +122,52 @@ class Composition {
   void Compile(Program* prg);
 
  private:
+  // Emits BLANK or WRITE_SINGLE. If the previously emitted instruction was
+  // the same (and for the same input), extends it instead, so that the
+  // interpreter can transfer the pixels in bulk.
+  void EmitFusable(std::vector<uint16_t>* code, uint16_t op, int input,
+                   uint32_t count);
+
+  // Emits any other instruction.
+  void Emit(std::vector<uint16_t>* code, uint16_t word) {
+    code->push_back(word);
+    fusable_pos_ = -1;
+  }
+
   Box bounds_;
   std::vector<Box> input_extents_;
   std::vector<BlendingMode> blending_modes_;
   std::vector<Block> data_;
   int input_count_;
+
+  // Position of the last emitted fusable instruction, if it is the last
+  // instruction so far; -1 otherwise.
+  int fusable_pos_;
 };
 
+inline void Composition::EmitFusable(std::vector<uint16_t>* code, uint16_t op,
+                                     int input, uint32_t count) {
+  if (fusable_pos_ >= 0 && (*code)[fusable_pos_] == op) {
+    if (op == BLANK) {
+      uint32_t fused = (*code)[fusable_pos_ + 1] + count;
+      if (fused <= 65535) {
+        (*code)[fusable_pos_ + 1] = fused;
+        return;
+      }
+    } else if ((*code)[fusable_pos_ + 1] == input) {
+      uint32_t fused = (*code)[fusable_pos_ + 2] + count;
+      if (fused <= 65535) {
+        (*code)[fusable_pos_ + 2] = fused;
+        return;
+      }
+    }
+  }
+  fusable_pos_ = code->size();
+  code->push_back(op);
+  if (op == WRITE_SINGLE) code->push_back(input);
+  code->push_back(count);
+}
+
 // Returns true for a blending mode when a transparent source implies
 // transparent result.
 bool IsBlendingModeSourceClearing(BlendingMode blending_mode) {
@@ -166,13 +206,14 @@ bool IsBlendingModeDestinationClearing(BlendingMode blending_mode) {
 
 inline void Composition::Compile(Program* prg) {
   std::vector<uint16_t>* code = &prg->prg_;
+  fusable_pos_ = -1;
   // First, emit initial skips.
   int i = 0;
   for (const auto& input : input_extents_) {
     if (input.yMin() < bounds_.yMin()) {
-      code->push_back(SKIP);
-      code->push_back(i);
-      code->push_back((bounds_.yMin() - input.yMin()) * input.width());
+      Emit(code, SKIP);
+      Emit(code, i);
+      Emit(code, (bounds_.yMin() - input.yMin()) * input.width());
     }
     i++;
   }
@@ -184,8 +225,7 @@ inline void Composition::Compile(Program* prg) {
       if (total <= 65535) {
         // Optimize fully empty blocks.
         if (mask == 0) {
-          code->push_back(BLANK);
-          code->push_back(total);
+          EmitFusable(code, BLANK, 0, total);
           continue;
         }
       }
@@ -205,13 +245,11 @@ inline void Composition::Compile(Program* prg) {
         if (mask == 0) {
           // Success. Merge.
           if (i == first) {
-            code->push_back(WRITE_SINGLE);
-            code->push_back(first);
-            code->push_back(total);
+            EmitFusable(code, WRITE_SINGLE, first, total);
           } else {
-            code->push_back(WRITE);
-            code->push_back(block.chunks_[0].input_mask_);
-            code->push_back(total);
+            Emit(code, WRITE);
+            Emit(code, block.chunks_[0].input_mask_);
+            Emit(code, total);
           }
           break;
         }
@@ -226,16 +264,16 @@ inline void Composition::Compile(Program* prg) {
 
     // Emit the loop code.
     if (block.height_ > 1) {
-      code->push_back(LOOP);
-      code->push_back(block.height_);
+      Emit(code, LOOP);
+      Emit(code, block.height_);
     }
     // First, emit potential left skips.
     i = 0;
     for (const auto& input : input_extents_) {
       if (input.xMin() < bounds_.xMin() && block.all_inputs_ & (1 << i)) {
-        code->push_back(SKIP);
-        code->push_back(i);
-        code->push_back(bounds_.xMin() - input.xMin());
+        Emit(code, SKIP);
+        Emit(code, i);
+        Emit(code, bounds_.xMin() - input.xMin());
       }
       i++;
     }
@@ -263,9 +301,9 @@ inline void Composition::Compile(Program* prg) {
         index = 0;
         while (skip_mask > 0) {
           if (skip_mask & 1) {
-            code->push_back(SKIP);
-            code->push_back(index);
-            code->push_back(chunk.width_);
+            Emit(code, SKIP);
+            Emit(code, index);
+            Emit(code, chunk.width_);
           }
           skip_mask >>= 1;
         }
@@ -280,9 +318,9 @@ inline void Composition::Compile(Program* prg) {
           if ((m & 1) != 0) {
             if (dst_clear &&
                 IsBlendingModeDestinationClearing(blending_modes_[index])) {
-              code->push_back(SKIP);
-              code->push_back(index);
-              code->push_back(chunk.width_);
+              Emit(code, SKIP);
+              Emit(code, index);
+              Emit(code, chunk.width_);
               mask &= ~(1 << index);
             } else {
               dst_clear = false;
@@ -293,8 +331,7 @@ inline void Composition::Compile(Program* prg) {
         }
       }
       if (mask == 0) {
-        code->push_back(BLANK);
-        code->push_back(chunk.width_);
+        EmitFusable(code, BLANK, 0, chunk.width_);
       } else {
         uint16_t mask_copy = mask;
         int index = 0;
@@ -303,13 +340,11 @@ inline void Composition::Compile(Program* prg) {
           ++index;
         }
         if (mask_copy == 1) {
-          code->push_back(WRITE_SINGLE);
-          code->push_back(index);
-          code->push_back(chunk.width_);
+          EmitFusable(code, WRITE_SINGLE, index, chunk.width_);
         } else {
-          code->push_back(WRITE);
-          code->push_back(mask);
-          code->push_back(chunk.width_);
+          Emit(code, WRITE);
+          Emit(code, mask);
+          Emit(code, chunk.width_);
         }
       }
     }
@@ -317,18 +352,18 @@ inline void Composition::Compile(Program* prg) {
     i = 0;
     for (const auto& input : input_extents_) {
       if (input.xMax() > bounds_.xMax() && block.all_inputs_ & (1 << i)) {
-        code->push_back(SKIP);
-        code->push_back(i);
-        code->push_back(input.xMax() - bounds_.xMax());
+        Emit(code, SKIP);
+        Emit(code, i);
+        Emit(code, input.xMax() - bounds_.xMax());
       }
       i++;
     }
     if (block.height_ > 1) {
       // We emitted the loop code, so we need to emit the RET.
-      code->push_back(RET);
+      Emit(code, RET);
     }
   }
-  code->push_back(EXIT);
+  Emit(code, EXIT);
 }
 
 class Engine {
@@ -496,16 +531,7 @@ void WriteRect(Engine* engine, const Box& bounds,
           // better to blend all inputs together, and only then blend the
           // results onto the background.
           if (s.bgcolor() != color::Transparent) {
-            Color bg = s.bgcolor();
-            if (bg.isOpaque()) {
-              for (int i = 0; i < batch; ++i) {
-                buf[i] = AlphaBlendOverOpaque(bg, buf[i]);
-              }
-            } else {
-              for (int i = 0; i < batch; ++i) {
-                buf[i] = AlphaBlend(bg, buf[i]);
-              }
-            }
+            AlphaBlendSpanOverBackground(s.bgcolor(), buf, batch);
           }
           writer.advance_buffer_ptr(batch);
           count -= batch;
@@ -524,20 +550,18 @@ void WriteVisible(Engine* engine, const Box& bounds,
                   internal::BufferingStream* streams,
                   const BlendingMode* blending_modes, const Surface& s) {
   BufferedPixelWriter writer(s.out(), s.blending_mode());
-  uint16_t x = bounds.xMin();
-  uint16_t y = bounds.yMin();
+  int16_t x = bounds.xMin();
+  int16_t y = bounds.yMin();
   while (true) {
     switch (engine->fetch()) {
       case EXIT: {
         return;
       }
       case BLANK: {
-        uint16_t count = engine->read_word();
-        x += count;
-        if (x > bounds.xMax()) {
-          y += (x - bounds.xMin()) / bounds.width();
-          x = (x - bounds.xMin()) % bounds.width() + bounds.xMin();
-        }
+        // Fused blanks may span many rows.
+        uint32_t offset = (x - bounds.xMin()) + engine->read_word();
+        y += offset / bounds.width();
+        x = offset % bounds.width() + bounds.xMin();
         break;
       }
       case SKIP: {
@@ -549,23 +573,18 @@ void WriteVisible(Engine* engine, const Box& bounds,
       case WRITE_SINGLE: {
         uint16_t input = engine->read_word();
         uint16_t count = engine->read_word();
-        if (s.bgcolor() == color::Transparent) {
-          while (count-- > 0) {
-            Color c = streams[input].next();
-            if (c.a() != 0) {
-              writer.writePixel(x, y, c);
-            }
-            ++x;
-            if (x > bounds.xMax()) {
-              x = bounds.xMin();
-              ++y;
-            }
-          }
-        } else {
-          while (count-- > 0) {
-            Color c = streams[input].next();
-            if (c.a() != 0) {
-              writer.writePixel(x, y, AlphaBlend(s.bgcolor(), c));
+        // Read in bulk, rather than pixel-by-pixel.
+        Color buf[kPixelWritingBufferSize];
+        do {
+          uint16_t batch = kPixelWritingBufferSize;
+          if (batch > count) batch = count;
+          streams[input].read(buf, batch);
+          for (int i = 0; i < batch; ++i) {
+            if (buf[i].a() != 0) {
+              writer.writePixel(x, y,
+                                s.bgcolor() == color::Transparent
+                                    ? buf[i]
+                                    : AlphaBlend(s.bgcolor(), buf[i]));
             }
             ++x;
             if (x > bounds.xMax()) {
@@ -573,7 +592,8 @@ void WriteVisible(Engine* engine, const Box& bounds,
               ++y;
             }
           }
-        }
+          count -= batch;
+        } while (count > 0);
         break;
       }
       case WRITE: {
@@ -643,11 +663,11 @@ class StreamableComboStream : public PixelStream {
  public:
   using PixelStream::read;
 
-  StreamableComboStream(Program prg,
+  StreamableComboStream(std::shared_ptr<const Program> prg,
                         std::vector<internal::BufferingStream> streams,
                         std::vector<BlendingMode> blending_modes)
       : prg_(std::move(prg)),
-        engine_(&prg_),
+        engine_(prg_.get()),
         streams_(std::move(streams)),
         blending_modes_(std::move(blending_modes)),
         remaining_count_(0) {}
@@ -657,38 +677,7 @@ class StreamableComboStream : public PixelStream {
     Color* result = buf;
     bool first_batch = true;
     do {
-      while (remaining_count_ == 0) {
-        last_instruction_ = engine_.fetch();
-        switch (last_instruction_) {
-          case EXIT: {
-            return;
-          }
-          case BLANK: {
-            remaining_count_ = engine_.read_word();
-            break;
-          }
-          case SKIP: {
-            uint16_t input = engine_.read_word();
-            uint16_t count = engine_.read_word();
-            streams_[input].skip(count);
-            continue;
-          }
-          case WRITE_SINGLE: {
-            input_ = engine_.read_word();
-            remaining_count_ = engine_.read_word();
-            break;
-          }
-          case WRITE: {
-            input_ = engine_.read_word();
-            remaining_count_ = engine_.read_word();
-            break;
-          }
-          default: {
-            // Unexpected.
-            return;
-          }
-        }
-      }
+      if (!fetch()) return;
       uint16_t batch = std::min(size, remaining_count_);
       switch (last_instruction_) {
         case BLANK: {
@@ -746,8 +735,85 @@ class StreamableComboStream : public PixelStream {
     } while (size > 0);
   }
 
+  uint32_t readSpan(Color* buf, uint16_t size, uint32_t max_count,
+                    bool& is_run) override {
+    if (!fetch()) {
+      return PixelStream::readSpan(buf, size, max_count, is_run);
+    }
+    uint32_t n = std::min<uint32_t>(remaining_count_, max_count);
+    switch (last_instruction_) {
+      case BLANK: {
+        // Not stored anywhere, so never expanded.
+        is_run = true;
+        buf[0] = color::Transparent;
+        remaining_count_ -= n;
+        return n;
+      }
+      case WRITE_SINGLE: {
+        // Forward the runs of the single input.
+        if (n > size) n = size;
+        uint32_t run_length = 0;
+        streams_[input_].read(buf, n, run_length);
+        if (run_length >= n && n > 1) {
+          uint32_t run = std::min<uint32_t>(
+              std::min<uint32_t>(run_length, remaining_count_), max_count);
+          streams_[input_].skip(run - n);
+          remaining_count_ -= run;
+          is_run = true;
+          return run;
+        }
+        remaining_count_ -= n;
+        is_run = false;
+        return n;
+      }
+      default: {
+        return PixelStream::readSpan(buf, size, max_count, is_run);
+      }
+    }
+  }
+
  private:
-  Program prg_;
+  // Fetches instructions until there are pixels to emit. Returns false if the
+  // program has ended.
+  bool fetch() {
+    while (remaining_count_ == 0) {
+      last_instruction_ = engine_.fetch();
+      switch (last_instruction_) {
+        case EXIT: {
+          return false;
+        }
+        case BLANK: {
+          remaining_count_ = engine_.read_word();
+          break;
+        }
+        case SKIP: {
+          uint16_t input = engine_.read_word();
+          uint16_t count = engine_.read_word();
+          streams_[input].skip(count);
+          continue;
+        }
+        case WRITE_SINGLE: {
+          input_ = engine_.read_word();
+          remaining_count_ = engine_.read_word();
+          break;
+        }
+        case WRITE: {
+          input_ = engine_.read_word();
+          remaining_count_ = engine_.read_word();
+          break;
+        }
+        default: {
+          // Unexpected.
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Shared with the stack's cache, so that the stream stays valid even if
+  // the stack recompiles.
+  std::shared_ptr<const Program> prg_;
   Engine engine_;
   std::vector<internal::BufferingStream> streams_;
   std::vector<BlendingMode> blending_modes_;
@@ -758,27 +824,99 @@ class StreamableComboStream : public PixelStream {
 
 }  // namespace
 
-void StreamableStack::drawTo(const Surface& s) const {
-  Box bounds = Box::Intersect(s.clip_box(), extents_.translate(s.dx(), s.dy()));
-  if (bounds.empty()) return;
-  std::vector<internal::BufferingStream> streams;
+namespace internal {
+
+struct StreamableStackCache {
+  // The inputs (in the stack coordinates, pre-intersected with bounds) that
+  // the program has been compiled for.
+  Box bounds;
+  std::vector<Box> extents;
   std::vector<BlendingMode> blending_modes;
-  Composition composition(bounds);
+  std::shared_ptr<const Program> program;
+
+  // Composition of the first prefix_size inputs, from which the program can
+  // be recompiled if only the subsequent inputs change. Empty if
+  // prefix_size == 0.
+  std::unique_ptr<Composition> prefix;
+  size_t prefix_size = 0;
+};
+
+}  // namespace internal
+
+void StreamableStack::prepare(
+    const Box& bounds, std::vector<internal::BufferingStream>& streams,
+    std::vector<BlendingMode>& blending_modes) const {
+  if (cache_ == nullptr) {
+    cache_ = std::make_shared<internal::StreamableStackCache>();
+  }
+  internal::StreamableStackCache& cache = *cache_;
+  bool same_bounds = (cache.bounds == bounds);
+  std::vector<Box> extents;
+  extents.reserve(inputs_.size());
+  streams.reserve(inputs_.size());
+  blending_modes.reserve(inputs_.size());
+  size_t first_changed = same_bounds ? inputs_.size() : 0;
   for (const auto& input : inputs_) {
-    Box extents =
-        Box::Intersect(input.extents(), bounds.translate(-s.dx(), -s.dy()));
-    if (composition.Add(extents.translate(s.dx(), s.dy()),
-                        input.blending_mode())) {
-      streams.emplace_back(input.createStream(extents), extents.area());
-    } else {
+    size_t i = extents.size();
+    extents.push_back(Box::Intersect(input.extents(), bounds));
+    blending_modes.push_back(input.blending_mode());
+    if (extents.back().empty()) {
       streams.emplace_back(nullptr, 0);
+    } else {
+      streams.emplace_back(input.createStream(extents.back()),
+                           extents.back().area());
     }
-    blending_modes.push_back(input.blending_mode());
+    if (first_changed > i &&
+        (i >= cache.extents.size() || !(cache.extents[i] == extents[i]) ||
+         cache.blending_modes[i] != blending_modes[i])) {
+      first_changed = i;
+    }
+  }
+  if (cache.program != nullptr && first_changed == inputs_.size() &&
+      cache.extents.size() == inputs_.size()) {
+    // Nothing changed.
+    return;
+  }
+  // Recompile, starting from the cached prefix if possible.
+  std::unique_ptr<Composition> composition;
+  size_t start = 0;
+  if (cache.prefix != nullptr && same_bounds &&
+      cache.prefix_size <= first_changed) {
+    composition.reset(new Composition(*cache.prefix));
+    start = cache.prefix_size;
+  } else {
+    composition.reset(new Composition(bounds));
+    cache.prefix = nullptr;
+    cache.prefix_size = 0;
+  }
+  for (size_t i = start; i < extents.size(); ++i) {
+    if (i == first_changed && i > 0 && i != cache.prefix_size) {
+      // Remember the unchanged prefix, anticipating that the same input is
+      // going to change again.
+      cache.prefix.reset(new Composition(*composition));
+      cache.prefix_size = i;
+    }
+    composition->Add(extents[i], blending_modes[i]);
   }
+  Program* prg = new Program();
+  composition->Compile(prg);
+  cache.program.reset(prg);
+  cache.bounds = bounds;
+  cache.extents = std::move(extents);
+  cache.blending_modes = blending_modes;
+}
 
-  Program prg;
-  composition.Compile(&prg);
-  Engine engine(&prg);
+void StreamableStack::drawTo(const Surface& s) const {
+  Box bounds = Box::Intersect(s.clip_box(), extents_.translate(s.dx(), s.dy()));
+  if (bounds.empty()) return;
+  std::vector<internal::BufferingStream> streams;
+  std::vector<BlendingMode> blending_modes;
+  // The program only depends on the relative placement of the inputs, so it
+  // is compiled (and cached) in the stack coordinates.
+  prepare(bounds.translate(-s.dx(), -s.dy()), streams, blending_modes);
+  // Keeps the program alive even if the stack gets redrawn reentrantly.
+  std::shared_ptr<const Program> prg = cache_->program;
+  Engine engine(prg.get());
   if (s.fill_mode() == FillMode::kExtents) {
     WriteRect(&engine, bounds, &*streams.begin(), &*blending_modes.begin(), s);
   } else {
@@ -788,46 +926,20 @@ void StreamableStack::drawTo(const Surface& s) const {
 }
 
 std::unique_ptr<PixelStream> StreamableStack::createStream() const {
-  Box bounds = extents();
   std::vector<internal::BufferingStream> streams;
   std::vector<BlendingMode> blending_modes;
-  Composition composition(bounds);
-  for (const auto& input : inputs_) {
-    Box extents = Box::Intersect(input.extents(), bounds);
-    if (composition.Add(extents, input.blending_mode())) {
-      streams.emplace_back(input.createStream(extents), extents.area());
-    } else {
-      streams.emplace_back(nullptr, 0);
-    }
-    blending_modes.push_back(input.blending_mode());
-  }
-
-  Program prg;
-  composition.Compile(&prg);
+  prepare(extents(), streams, blending_modes);
   return std::unique_ptr<PixelStream>(new StreamableComboStream(
-      std::move(prg), std::move(streams), std::move(blending_modes)));
+      cache_->program, std::move(streams), std::move(blending_modes)));
 }
 
 std::unique_ptr<PixelStream> StreamableStack::createStream(
     const Box& clip_box) const {
-  Box bounds = Box::Intersect(extents(), clip_box);
   std::vector<internal::BufferingStream> streams;
   std::vector<BlendingMode> blending_modes;
-  Composition composition(bounds);
-  for (const auto& input : inputs_) {
-    Box extents = Box::Intersect(input.extents(), bounds);
-    if (composition.Add(extents, input.blending_mode())) {
-      streams.emplace_back(input.createStream(extents), extents.area());
-    } else {
-      streams.emplace_back(nullptr, 0);
-    }
-    blending_modes.push_back(input.blending_mode());
-  }
-
-  Program prg;
-  composition.Compile(&prg);
+  prepare(Box::Intersect(extents(), clip_box), streams, blending_modes);
   return std::unique_ptr<PixelStream>(new StreamableComboStream(
-      std::move(prg), std::move(streams), std::move(blending_modes)));
+      cache_->program, std::move(streams), std::move(blending_modes)));
 }
 
 }  // namespace roo_display
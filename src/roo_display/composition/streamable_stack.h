@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "roo_display/core/device.h"
@@ -8,7 +9,23 @@
 
 namespace roo_display {
 
+namespace internal {
+struct StreamableStackCache;
+}
+
 /// Multi-layer stack of streamables composited in order.
+///
+/// When drawn or streamed, the stack compiles the layout of its inputs into a
+/// small program that drives the compositing. The most recent program is
+/// cached, and reused as long as the (clipped) extents and blending modes of
+/// the inputs remain unchanged. When only the trailing inputs change (e.g.
+/// an animated overlay on top of static layers), only those get recompiled.
+/// To benefit from this, reuse the stack across frames (e.g. using
+/// `clearInputs()` and re-adding the inputs), rather than constructing a new
+/// one each time.
+///
+/// The cache is not thread-safe; a single stack should not be drawn by
+/// multiple threads concurrently.
 class StreamableStack : public Streamable {
  public:
   /// An input layer in the stack.
@@ -90,6 +107,16 @@ class StreamableStack : public Streamable {
     return inputs_.back();
   }
 
+  /// Remove all inputs while preserving allocated storage (and the cached
+  /// program) for reuse.
+  void clearInputs() { inputs_.clear(); }
+
+  /// Reserve storage for at least `capacity` inputs.
+  void reserveInputs(size_t capacity) { inputs_.reserve(capacity); }
+
+  /// Return the current number of inputs.
+  size_t inputCount() const { return inputs_.size(); }
+
   /// Return the overall extents of the stack.
   Box extents() const override { return extents_; }
 
@@ -122,9 +149,18 @@ class StreamableStack : public Streamable {
  private:
   void drawTo(const Surface& s) const override;
 
+  // Creates the streams for the inputs, clipped to `bounds` (in the stack
+  // coordinates), and brings the cached program up to date.
+  void prepare(const Box& bounds,
+               std::vector<internal::BufferingStream>& streams,
+               std::vector<BlendingMode>& blending_modes) const;
+
   Box extents_;
   Box anchor_extents_;
   std::vector<Input> inputs_;
+
+  // Lazily allocated.
+  mutable std::shared_ptr<internal::StreamableStackCache> cache_;
 };
 
 }  // namespace roo_display
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "roo_display/core/device.h"
 
+#include <algorithm>
+
 #include "roo_io/memory/fill.h"
 
 namespace roo_display {
@@ -83,4 +85,44 @@ void DisplayOutput::blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1,
   // No-op by default. Devices that advertise supportsBlitCopy() override this.
 }
 
+bool DisplayOutput::scrollRect(const Box& rect, int16_t dx, int16_t dy,
+                               Color bgcolor) {
+  if (!getCapabilities().supportsBlitCopy()) return false;
+  if (rect.empty()) return true;
+  if (dx <= -rect.width() || dx >= rect.width() || dy <= -rect.height() ||
+      dy >= rect.height()) {
+    // Everything scrolls out.
+    fillRect(BlendingMode::kSource, rect, bgcolor);
+    return true;
+  }
+  // The part of the content that remains visible, in its old location.
+  Box src(rect.xMin() - std::min<int16_t>(dx, 0),
+          rect.yMin() - std::min<int16_t>(dy, 0),
+          rect.xMax() - std::max<int16_t>(dx, 0),
+          rect.yMax() - std::max<int16_t>(dy, 0));
+  if (dx != 0 || dy != 0) {
+    blitCopy(src.xMin(), src.yMin(), src.xMax(), src.yMax(), src.xMin() + dx,
+             src.yMin() + dy);
+  }
+  // Uncovered full-width rows.
+  if (dy > 0) {
+    fillRect(BlendingMode::kSource, rect.xMin(), rect.yMin(), rect.xMax(),
+             rect.yMin() + dy - 1, bgcolor);
+  } else if (dy < 0) {
+    fillRect(BlendingMode::kSource, rect.xMin(), rect.yMax() + dy + 1,
+             rect.xMax(), rect.yMax(), bgcolor);
+  }
+  // Uncovered columns, next to the rows that remained.
+  int16_t y0 = src.yMin() + dy;
+  int16_t y1 = src.yMax() + dy;
+  if (dx > 0) {
+    fillRect(BlendingMode::kSource, rect.xMin(), y0, rect.xMin() + dx - 1, y1,
+             bgcolor);
+  } else if (dx < 0) {
+    fillRect(BlendingMode::kSource, rect.xMax() + dx + 1, y0, rect.xMax(), y1,
+             bgcolor);
+  }
+  return true;
+}
+
 }  // namespace roo_display
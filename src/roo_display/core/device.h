@@ -231,6 +231,16 @@ class DisplayOutput {
   /// `supportsBlitCopy()` must override this method.
   virtual void blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1,
                         int16_t src_y1, int16_t dst_x0, int16_t dst_y0);
+
+  /// Scroll the content of the rectangle `rect` by `(dx, dy)` pixels, and
+  /// fill the uncovered area with `bgcolor`.
+  ///
+  /// Content scrolled out of `rect` is discarded. Uses `blitCopy()`, so that
+  /// only the newly uncovered strips need to be redrawn, rather than the
+  /// entire rectangle. If the device does not support the 'blit copy'
+  /// capability, does nothing and returns false; the caller must then redraw
+  /// the rectangle. Invalidates the address window.
+  bool scrollRect(const Box& rect, int16_t dx, int16_t dy, Color bgcolor);
 };
 
 /// Base class for display device drivers.
@@ -302,6 +312,39 @@ class DisplayDevice : public DisplayOutput {
   /// using `BlendingMode::kSourceOver`.
   virtual void setBgColorHint(Color bgcolor) {}
 
+  /// Return the number of framebuffers that the device cycles through.
+  ///
+  /// Devices that draw directly to the visible content (the default) return 1.
+  /// Multi-buffered devices (see `MultiBufferedDevice`) return 2 or more, and
+  /// implement the frame presentation methods below.
+  virtual uint8_t frameBufferCount() const { return 1; }
+
+  /// Start rendering a new frame.
+  ///
+  /// On multi-buffered devices, subsequent drawing goes to a back buffer,
+  /// which is first brought up to date with the most recently presented frame.
+  /// May block until a back buffer becomes available. Must be called outside
+  /// a transaction.
+  ///
+  /// The default implementation does nothing.
+  virtual void beginFrame() {}
+
+  /// Present the frame rendered since `beginFrame()`.
+  ///
+  /// On multi-buffered devices, schedules the back buffer to be shown at the
+  /// next frame boundary (e.g. vsync), and returns without waiting for it, so
+  /// that rendering of the next frame can overlap the scan-out. Must be called
+  /// outside a transaction.
+  ///
+  /// The default implementation does nothing; i.e. content drawn to
+  /// single-buffered devices becomes visible as it is drawn.
+  virtual void presentFrame() {}
+
+  /// Block until the most recently presented frame is visible.
+  ///
+  /// The default implementation does nothing.
+  virtual void awaitFrame() {}
+
  protected:
   DisplayDevice(int16_t raw_width, int16_t raw_height)
       : DisplayDevice(Orientation::Default(), raw_width, raw_height) {}
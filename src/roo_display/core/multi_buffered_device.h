@@ -0,0 +1,334 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include <memory>
+#include <vector>
+
+#include "roo_display/composition/damage_tracker.h"
+#include "roo_display/core/device.h"
+#include "roo_display/core/offscreen.h"
+#include "roo_display/hal/async_blit.h"
+#include "roo_display/internal/color_format.h"
+#include "roo_logging.h"
+
+namespace roo_display {
+
+/// Display device that renders to one of 2 or more framebuffers, while
+/// another one is being shown.
+///
+/// Use it with the frame API of `DisplayDevice`:
+///
+/// \code{.cpp}
+/// display.beginFrame();
+/// {
+///   DrawingContext dc(display);
+///   ...
+/// }
+/// display.presentFrame();
+/// \endcode
+///
+/// Drawing between `beginFrame()` and `presentFrame()` goes to the back
+/// buffer, so that the visible content never shows partially rendered frames.
+/// `presentFrame()` schedules the back buffer to be shown, and returns
+/// immediately; the next `beginFrame()` only blocks if no back buffer is free
+/// yet (with 2 buffers, until the previously presented one is shown; with 3
+/// buffers, it normally does not block at all).
+///
+/// Content is retained across frames, as with a single framebuffer: the new
+/// back buffer is brought up to date with the most recently presented frame
+/// by `beginFrame()`. To keep that cheap, the device tracks (at 16x16 tile
+/// granularity) the areas drawn since each buffer was last up to date, and
+/// copies only those, using `async_blit()`, so that on platforms with DMA the
+/// copy overlaps with the rendering of the new frame.
+///
+/// Before the first `beginFrame()`, drawing goes directly to the visible
+/// buffer, as on single-buffered devices.
+///
+/// By itself (e.g. on the host), the device owns its buffers, and 'shows' a
+/// buffer immediately upon presentation; the visible content can be inspected
+/// via `front()`. Drivers for panels that scan out from memory (e.g. RGB
+/// parallel panels) subclass it, attach the panel's framebuffers, and
+/// override `flip()` and `awaitFlip()`.
+///
+/// Only color modes with at least 8 bits per pixel are supported.
+template <typename ColorMode,
+          ColorPixelOrder pixel_order = ColorPixelOrder::kMsbFirst,
+          ByteOrder byte_order = roo_io::kBigEndian>
+class MultiBufferedDevice : public DisplayDevice {
+ public:
+  static_assert(ColorTraits<ColorMode>::pixels_per_byte == 1,
+                "Sub-byte color modes are not supported");
+
+  using Dev = OffscreenDevice<ColorMode, pixel_order, byte_order>;
+
+  /// Maximum supported number of framebuffers.
+  static constexpr uint8_t kMaxBuffers = 3;
+
+  /// Create a device with the specified number of framebuffers, allocated on
+  /// the heap.
+  MultiBufferedDevice(int16_t width, int16_t height, uint8_t buffer_count = 2,
+                      ColorMode color_mode = ColorMode())
+      : MultiBufferedDevice(width, height, color_mode) {
+    CHECK_GE(buffer_count, 2);
+    CHECK_LE(buffer_count, kMaxBuffers);
+    size_t size = static_cast<size_t>(width) * height * kBytesPerPixel;
+    roo::byte* buffers[kMaxBuffers];
+    for (uint8_t i = 0; i < buffer_count; ++i) {
+      owned_[i].reset(new roo::byte[size]);
+      buffers[i] = owned_[i].get();
+    }
+    attachBuffers(buffers, buffer_count);
+  }
+
+  MultiBufferedDevice(const MultiBufferedDevice&) = delete;
+  MultiBufferedDevice& operator=(const MultiBufferedDevice&) = delete;
+
+  uint8_t frameBufferCount() const override { return buffer_count_; }
+
+  void beginFrame() override {
+    if (buffer_count_ < 2 || in_frame_) return;
+    uint8_t next = (back_ + 1) % buffer_count_;
+    if (next == displayed_ || next == pending_) awaitFrame();
+    copyForward(back_, next);
+    back_ = next;
+    in_frame_ = true;
+  }
+
+  void presentFrame() override {
+    if (!in_frame_) return;
+    // Keep at most one flip in flight.
+    awaitFrame();
+    devs_[back_]->flush();
+    flip(back_, devs_[back_]->buffer());
+    pending_ = back_;
+    in_frame_ = false;
+  }
+
+  void awaitFrame() override {
+    if (pending_ < 0) return;
+    awaitFlip();
+    displayed_ = pending_;
+    pending_ = -1;
+  }
+
+  void orientationUpdated() override {
+    orienter_.setOrientation(orientation());
+    for (uint8_t i = 0; i < buffer_count_; ++i) {
+      devs_[i]->setOrientation(orientation());
+    }
+  }
+
+  void begin() override { current().begin(); }
+
+  void end() override { current().end(); }
+
+  void flush() override { current().flush(); }
+
+  void setAddress(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                  BlendingMode mode) override {
+    markDamaged(x0, y0, x1, y1);
+    current().setAddress(x0, y0, x1, y1, mode);
+  }
+
+  void write(Color* color, uint32_t pixel_count) override {
+    current().write(color, pixel_count);
+  }
+
+  void fill(Color color, uint32_t pixel_count) override {
+    current().fill(color, pixel_count);
+  }
+
+  void writePixels(BlendingMode mode, Color* color, int16_t* x, int16_t* y,
+                   uint16_t pixel_count) override {
+    for (uint16_t i = 0; i < pixel_count; ++i) {
+      markDamaged(x[i], y[i], x[i], y[i]);
+    }
+    current().writePixels(mode, color, x, y, pixel_count);
+  }
+
+  void fillPixels(BlendingMode mode, Color color, int16_t* x, int16_t* y,
+                  uint16_t pixel_count) override {
+    for (uint16_t i = 0; i < pixel_count; ++i) {
+      markDamaged(x[i], y[i], x[i], y[i]);
+    }
+    current().fillPixels(mode, color, x, y, pixel_count);
+  }
+
+  void writeRects(BlendingMode mode, Color* color, int16_t* x0, int16_t* y0,
+                  int16_t* x1, int16_t* y1, uint16_t count) override {
+    for (uint16_t i = 0; i < count; ++i) {
+      markDamaged(x0[i], y0[i], x1[i], y1[i]);
+    }
+    current().writeRects(mode, color, x0, y0, x1, y1, count);
+  }
+
+  void fillRects(BlendingMode mode, Color color, int16_t* x0, int16_t* y0,
+                 int16_t* x1, int16_t* y1, uint16_t count) override {
+    for (uint16_t i = 0; i < count; ++i) {
+      markDamaged(x0[i], y0[i], x1[i], y1[i]);
+    }
+    current().fillRects(mode, color, x0, y0, x1, y1, count);
+  }
+
+  void drawDirectRect(const roo::byte* data, size_t row_width_bytes,
+                      int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                      int16_t src_y1, int16_t dst_x0, int16_t dst_y0) override {
+    if (src_x1 < src_x0 || src_y1 < src_y0) return;
+    markDamaged(dst_x0, dst_y0, dst_x0 + (src_x1 - src_x0),
+                dst_y0 + (src_y1 - src_y0));
+    current().drawDirectRect(data, row_width_bytes, src_x0, src_y0, src_x1,
+                             src_y1, dst_x0, dst_y0);
+  }
+
+  void drawDirectRectAsync(const roo::byte* data, size_t row_width_bytes,
+                           int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                           int16_t src_y1, int16_t dst_x0,
+                           int16_t dst_y0) override {
+    if (src_x1 < src_x0 || src_y1 < src_y0) return;
+    markDamaged(dst_x0, dst_y0, dst_x0 + (src_x1 - src_x0),
+                dst_y0 + (src_y1 - src_y0));
+    current().drawDirectRectAsync(data, row_width_bytes, src_x0, src_y0,
+                                  src_x1, src_y1, dst_x0, dst_y0);
+  }
+
+  void blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1, int16_t src_y1,
+                int16_t dst_x0, int16_t dst_y0) override {
+    if (src_x1 < src_x0 || src_y1 < src_y0) return;
+    markDamaged(dst_x0, dst_y0, dst_x0 + (src_x1 - src_x0),
+                dst_y0 + (src_y1 - src_y0));
+    current().blitCopy(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+  }
+
+  const ColorFormat& getColorFormat() const override { return color_format_; }
+
+  const Capabilities& getCapabilities() const override {
+    static const Capabilities kCaps(/*supports_blending=*/true,
+                                    /*supports_blit_copy=*/true);
+    return kCaps;
+  }
+
+  /// Access color mode.
+  const ColorMode& color_mode() const { return color_mode_; }
+
+  /// Returns the buffer that is currently visible (i.e. the most recently
+  /// presented one, once it has been shown).
+  const Dev& front() const { return *devs_[displayed_]; }
+
+  /// Returns the buffer that is currently being drawn to.
+  const Dev& back() const { return *devs_[back_]; }
+
+ protected:
+  /// Create a device without buffers. The subclass must call
+  /// `attachBuffers()` before the device is used.
+  MultiBufferedDevice(int16_t width, int16_t height, ColorMode color_mode)
+      : DisplayDevice(width, height),
+        color_mode_(color_mode),
+        color_format_(color_mode_),
+        orienter_(width, height),
+        buffer_count_(0),
+        back_(0),
+        displayed_(0),
+        pending_(-1),
+        in_frame_(false) {}
+
+  /// Sets up the device to use the specified framebuffers, each of
+  /// `raw_width() * raw_height()` pixels. The first buffer is assumed to be
+  /// the one currently shown. Contents of the remaining buffers are assumed
+  /// to be unknown.
+  void attachBuffers(roo::byte* const* buffers, uint8_t count) {
+    CHECK_GE(count, 1);
+    CHECK_LE(count, kMaxBuffers);
+    Box extents(0, 0, raw_width() - 1, raw_height() - 1);
+    for (uint8_t i = 0; i < count; ++i) {
+      devs_[i].reset(
+          new Dev(raw_width(), raw_height(), buffers[i], color_mode_));
+      devs_[i]->setOrientation(orientation());
+      stale_[i].reset(new DamageTracker(extents));
+      if (i > 0) stale_[i]->invalidateAll();
+    }
+    buffer_count_ = count;
+    back_ = 0;
+    displayed_ = 0;
+    pending_ = -1;
+    in_frame_ = false;
+  }
+
+  /// Called by `presentFrame()` to request that the specified buffer gets
+  /// shown, at the next frame boundary. Should not block. All drawing to the
+  /// buffer has been completed at this point.
+  ///
+  /// The default implementation does nothing.
+  virtual void flip(uint8_t index, const roo::byte* buffer) {}
+
+  /// Blocks until the buffer passed to the most recent `flip()` is shown.
+  ///
+  /// The default implementation does nothing.
+  virtual void awaitFlip() {}
+
+  /// Returns true if `beginFrame()` has been called, but `presentFrame()` has
+  /// not.
+  bool inFrame() const { return in_frame_; }
+
+ private:
+  static constexpr size_t kBytesPerPixel =
+      ColorTraits<ColorMode>::bytes_per_pixel;
+
+  // Limits the number of async_blit() calls per frame, at the cost of copying
+  // some extra pixels.
+  static constexpr size_t kMaxCopyRegions = 16;
+
+  Dev& current() { return *devs_[back_]; }
+
+  // Records that the specified rectangle (in the device coordinates) has been
+  // drawn to the back buffer, and is thus stale in the other buffers.
+  void markDamaged(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    orienter_.orientRect(x0, y0, x1, y1);
+    Box box(x0, y0, x1, y1);
+    for (uint8_t i = 0; i < buffer_count_; ++i) {
+      if (i != back_) stale_[i]->invalidate(box);
+    }
+  }
+
+  // Copies the stale regions of buffer `to` from buffer `from`.
+  void copyForward(uint8_t from, uint8_t to) {
+    DamageTracker& stale = *stale_[to];
+    if (stale.empty()) return;
+    regions_.clear();
+    stale.getDirtyRegions(regions_, kMaxCopyRegions);
+    size_t stride = static_cast<size_t>(raw_width()) * kBytesPerPixel;
+    const roo::byte* src = devs_[from]->buffer();
+    roo::byte* dst = devs_[to]->buffer();
+    for (const Box& r : regions_) {
+      size_t offset = r.yMin() * stride + r.xMin() * kBytesPerPixel;
+      async_blit(src + offset, stride, dst + offset, stride,
+                 r.width() * kBytesPerPixel, r.height());
+    }
+    stale.reset();
+  }
+
+  ColorMode color_mode_;
+  internal::ColorFormatImpl<ColorMode, byte_order, pixel_order> color_format_;
+  internal::Orienter orienter_;
+
+  std::unique_ptr<roo::byte[]> owned_[kMaxBuffers];
+  std::unique_ptr<Dev> devs_[kMaxBuffers];
+
+  // For each buffer, the areas (in raw coordinates) where it may differ from
+  // the back buffer.
+  std::unique_ptr<DamageTracker> stale_[kMaxBuffers];
+
+  std::vector<Box> regions_;
+
+  uint8_t buffer_count_;
+  uint8_t back_;
+  uint8_t displayed_;
+
+  // The buffer passed to flip() but not yet known to be shown, or -1.
+  int8_t pending_;
+
+  // Whether beginFrame() has been called, but presentFrame() has not.
+  bool in_frame_;
+};
+
+}  // namespace roo_display
@@ -53,6 +53,12 @@ class Orienter {
   int16_t yMax_;
 };
 
+// How consecutive pixels of an address window row map onto the buffer, for
+// the 8 orientations: adjacent and ascending (left-to-right, not swapped),
+// adjacent and descending (right-to-left, not swapped), or a raster row
+// apart (swapped, i.e. rows of the window are columns of the buffer).
+enum class WindowWalk { kForward, kBackward, kStrided };
+
 // Helper class used by Offscreen to implement setAddress() and then
 // write()/fill() under different orientations. Internally, the class
 // stores two (signed) integer offsets, specifying the amount of pixel
@@ -587,6 +593,37 @@ class OffscreenDevice : public DisplayDevice {
     }
   }
 
+  /// Copy a rectangle from another offscreen device with the same pixel
+  /// format.
+  ///
+  /// The source rectangle `(src_x0, src_y0, src_x1, src_y1)` is given in the
+  /// raw (native) coordinates of `src`, i.e. in the coordinates of
+  /// `src.raster()`. It gets copied to this device, with the top-left corner
+  /// at `(dst_x0, dst_y0)`, honoring this device's orientation. The pixels are
+  /// copied verbatim, without conversion to `Color`, and without blending.
+  /// The caller must ensure that both rectangles fit within the respective
+  /// devices.
+  ///
+  /// `src` may be this device only in the default orientation, in which case
+  /// the rectangles may overlap (see `blitCopy()`).
+  void copyRectFrom(const OffscreenDevice& src, int16_t src_x0, int16_t src_y0,
+                    int16_t src_x1, int16_t src_y1, int16_t dst_x0,
+                    int16_t dst_y0);
+
+  /// Asynchronous variant of `copyRectFrom()`.
+  ///
+  /// When possible (default orientation, and byte-aligned rows for sub-byte
+  /// color modes), the copy is handed off to `async_blit()`, so that it can
+  /// use DMA while the CPU keeps rendering elsewhere. Otherwise, the copy is
+  /// performed synchronously. The returned token completes when the copy
+  /// lands; see `async_blit_done()` and `async_blit_await()`. Until then, the
+  /// source rectangle must not be modified. Subsequent drawing to this device
+  /// waits for pending copies automatically.
+  AsyncBlitToken copyRectFromAsync(const OffscreenDevice& src, int16_t src_x0,
+                                   int16_t src_y0, int16_t src_x1,
+                                   int16_t src_y1, int16_t dst_x0,
+                                   int16_t dst_y0);
+
   // const Raster<const roo::byte *, ColorMode, pixel_order, byte_order>
   // &raster()
   //     const {
@@ -633,20 +670,53 @@ class OffscreenDevice : public DisplayDevice {
   template <typename, typename, ColorPixelOrder, ByteOrder>
   friend struct WriteOp;
 
+  // Writes `count` pixels, generated by the writer, to the address window.
   template <typename Writer>
   void writeToWindow(Writer& write, uint32_t count) {
-    if (window_.advance_x() == 1) {
-      while (count > 0) {
-        uint32_t run = std::min<uint32_t>(count, window_.remaining_in_row());
-        write(buffer_, window_.offset(), run);
-        window_.advance(run);
-        count -= run;
-      }
+    writeToWindowOriented<false>(write, count);
+  }
+
+  // Like writeToWindow(), but for fillers, which write the same pixel
+  // regardless of the order, and thus can fill mirrored rows front to back.
+  template <typename Filler>
+  void fillWindow(Filler& fill, uint32_t count) {
+    writeToWindowOriented<true>(fill, count);
+  }
+
+  template <bool uniform, typename Writer>
+  void writeToWindowOriented(Writer& write, uint32_t count) {
+    Orientation orientation = window_.orientation();
+    if (orientation.isXYswapped()) {
+      writeWindowRows<internal::WindowWalk::kStrided, uniform>(write, count);
+    } else if (orientation.isLeftToRight()) {
+      writeWindowRows<internal::WindowWalk::kForward, uniform>(write, count);
     } else {
-      while (count-- > 0) {
-        write(buffer_, window_.offset());
-        window_.advance();
+      writeWindowRows<internal::WindowWalk::kBackward, uniform>(write, count);
+    }
+  }
+
+  // Writes the pixels row by row, with the walk along the row resolved at
+  // compile time; only the row ends go through the address window.
+  template <internal::WindowWalk walk, bool uniform, typename Writer>
+  void writeWindowRows(Writer& write, uint32_t count) {
+    while (count > 0) {
+      uint32_t run = std::min<uint32_t>(count, window_.remaining_in_row());
+      uint32_t offset = window_.offset();
+      if constexpr (walk == internal::WindowWalk::kForward) {
+        write(buffer_, offset, run);
+      } else if constexpr (walk == internal::WindowWalk::kBackward && uniform) {
+        write(buffer_, offset - run + 1, run);
+      } else {
+        const int32_t step = (walk == internal::WindowWalk::kBackward)
+                                 ? -1
+                                 : window_.advance_x();
+        for (uint32_t i = run; i > 0; --i) {
+          write(buffer_, offset);
+          offset += step;
+        }
       }
+      window_.advance(run);
+      count -= run;
     }
   }
 
@@ -821,6 +891,50 @@ class Offscreen : public Rasterizable {
 
   const ColorMode& color_mode() const { return output().color_mode(); }
 
+  /// Copy the `src_rect` region of `src` so that its top-left corner lands at
+  /// `(dst_x, dst_y)` in this offscreen. Both are specified in the respective
+  /// offscreens' extents coordinates. The region is clipped to both extents.
+  /// The pixels are copied verbatim, without conversion to `Color`.
+  void copyFrom(const Offscreen& src, Box src_rect, int16_t dst_x,
+                int16_t dst_y) {
+    int16_t src_x0, src_y0, dst_x0, dst_y0;
+    if (!clipCopy(src, src_rect, dst_x, dst_y, src_x0, src_y0, dst_x0,
+                  dst_y0)) {
+      return;
+    }
+    device_.copyRectFrom(src.device_, src_x0, src_y0,
+                         src_x0 + src_rect.width() - 1,
+                         src_y0 + src_rect.height() - 1, dst_x0, dst_y0);
+  }
+
+  /// Asynchronous variant of `copyFrom()`. See
+  /// `OffscreenDevice::copyRectFromAsync()`.
+  AsyncBlitToken copyFromAsync(const Offscreen& src, Box src_rect,
+                               int16_t dst_x, int16_t dst_y) {
+    int16_t src_x0, src_y0, dst_x0, dst_y0;
+    if (!clipCopy(src, src_rect, dst_x, dst_y, src_x0, src_y0, dst_x0,
+                  dst_y0)) {
+      return async_blit_mark();
+    }
+    return device_.copyRectFromAsync(
+        src.device_, src_x0, src_y0, src_x0 + src_rect.width() - 1,
+        src_y0 + src_rect.height() - 1, dst_x0, dst_y0);
+  }
+
+  /// Scroll the content of `rect` (in extents coordinates) by `(dx, dy)`,
+  /// filling the uncovered area with `bgcolor`. See
+  /// `DisplayOutput::scrollRect()`.
+  ///
+  /// Returns false if the content could not be scrolled (and remained
+  /// unchanged); the caller must then redraw the rectangle.
+  bool scroll(Box rect, int16_t dx, int16_t dy, Color bgcolor) {
+    rect = Box::Intersect(rect, extents_);
+    if (rect.empty()) return true;
+    return device_.scrollRect(rect.translate(-raster_.extents().xMin(),
+                                             -raster_.extents().yMin()),
+                              dx, dy, bgcolor);
+  }
+
  protected:
   // Sets the default (maximum) clip box. Usually the same as raster extents,
   // but may be smaller, e.g. if the underlying raster is byte-aligned and the
@@ -833,6 +947,24 @@ class Offscreen : public Rasterizable {
   // Implements Drawable.
   void drawTo(const Surface& s) const override { s.drawObject(raster()); }
 
+  // Clips the copy of `src_rect` from `src` to (dst_x, dst_y) to the extents
+  // of both offscreens, and translates the result to device coordinates.
+  // Returns false if nothing is left to copy.
+  bool clipCopy(const Offscreen& src, Box& src_rect, int16_t dst_x,
+                int16_t dst_y, int16_t& src_x0, int16_t& src_y0,
+                int16_t& dst_x0, int16_t& dst_y0) const {
+    int16_t dx = dst_x - src_rect.xMin();
+    int16_t dy = dst_y - src_rect.yMin();
+    src_rect = Box::Intersect(src_rect, src.extents());
+    src_rect = Box::Intersect(src_rect, extents_.translate(-dx, -dy));
+    if (src_rect.empty()) return false;
+    src_x0 = src_rect.xMin() - src.raster_.extents().xMin();
+    src_y0 = src_rect.yMin() - src.raster_.extents().yMin();
+    dst_x0 = src_rect.xMin() + dx - raster_.extents().xMin();
+    dst_y0 = src_rect.yMin() + dy - raster_.extents().yMin();
+    return true;
+  }
+
   // For DrawingContext.
   void nest() const {}
   void unnest() const {}
@@ -924,6 +1056,82 @@ class BitMaskOffscreen : public Offscreen<Monochrome> {
 
 namespace internal {
 
+// Maps sub-byte pixels through a function of the raw pixel value, such as
+// blending with a constant color. The function is evaluated at most once per
+// raw value, on first use. Spans are processed a whole byte (all of its
+// pixels) at a time, with only the ragged ends handled per pixel; runs of
+// identical bytes, typical for masks, are mapped once per run.
+template <typename ColorMode, ColorPixelOrder pixel_order, typename RawFn>
+class SubByteSpanMapper {
+ public:
+  static constexpr int kPixelsPerByte = ColorTraits<ColorMode>::pixels_per_byte;
+  static constexpr int kBitsPerPixel = ColorMode::bits_per_pixel;
+  static constexpr uint8_t kPixelMask = (1 << kBitsPerPixel) - 1;
+
+  SubByteSpanMapper(RawFn fn) : fn_(std::move(fn)), known_(0) {}
+
+  void operator()(roo::byte* p, uint32_t offset) {
+    SubByteColorIo<ColorMode, pixel_order> io;
+    int pixel_index = offset % kPixelsPerByte;
+    roo::byte* target = p + offset / kPixelsPerByte;
+    io.storeRaw(map(io.loadRaw(*target, pixel_index)), target, pixel_index);
+  }
+
+  void operator()(roo::byte* p, uint32_t offset, uint32_t count) {
+    SubByteColorIo<ColorMode, pixel_order> io;
+    int pixel_index = offset % kPixelsPerByte;
+    roo::byte* target = p + offset / kPixelsPerByte;
+    if (pixel_index > 0) {
+      do {
+        if (count-- == 0) return;
+        io.storeRaw(map(io.loadRaw(*target, pixel_index)), target,
+                    pixel_index);
+      } while (++pixel_index < kPixelsPerByte);
+      ++target;
+    }
+    uint32_t byte_count = count / kPixelsPerByte;
+    if (byte_count > 0) {
+      // The pixels within a byte are mapped independently, so the pixel order
+      // does not matter.
+      roo::byte in = *target;
+      roo::byte out = mapByte(in);
+      for (uint32_t i = 0; i < byte_count; ++i) {
+        if (target[i] != in) {
+          in = target[i];
+          out = mapByte(in);
+        }
+        target[i] = out;
+      }
+      target += byte_count;
+    }
+    count %= kPixelsPerByte;
+    for (uint32_t i = 0; i < count; ++i) {
+      io.storeRaw(map(io.loadRaw(*target, i)), target, i);
+    }
+  }
+
+ private:
+  uint8_t map(uint8_t raw) {
+    if ((known_ & (1 << raw)) == 0) {
+      lut_[raw] = fn_(raw);
+      known_ |= (1 << raw);
+    }
+    return lut_[raw];
+  }
+
+  roo::byte mapByte(roo::byte in) {
+    roo::byte out{0};
+    for (int shift = 0; shift < 8; shift += kBitsPerPixel) {
+      out |= (roo::byte)(map((uint8_t)(in >> shift) & kPixelMask) << shift);
+    }
+    return out;
+  }
+
+  RawFn fn_;
+  uint16_t known_;
+  uint8_t lut_[1 << kBitsPerPixel];
+};
+
 // For sub-byte color modes.
 template <typename ColorMode, ColorPixelOrder pixel_order, ByteOrder byte_order,
           BlendingMode blending_mode,
@@ -948,6 +1156,26 @@ class BlendingWriterOperator {
     SubByteColorIo<ColorMode, pixel_order> io;
     int pixel_index = offset % pixels_per_byte;
     roo::byte* target = p + offset / pixels_per_byte;
+    if constexpr (blending_mode == BlendingMode::kSource) {
+      // The previous content does not matter; assemble whole bytes, and
+      // store each one once.
+      if (pixel_index > 0) {
+        do {
+          if (count-- == 0) return;
+          io.storeRaw(color_mode_.fromArgbColor(*color_++), target,
+                      pixel_index);
+        } while (++pixel_index < pixels_per_byte);
+        pixel_index = 0;
+        ++target;
+      }
+      for (; count >= pixels_per_byte; count -= pixels_per_byte) {
+        roo::byte packed{0};
+        for (int i = 0; i < pixels_per_byte; ++i) {
+          io.storeRaw(color_mode_.fromArgbColor(*color_++), &packed, i);
+        }
+        *target++ = packed;
+      }
+    }
     while (count-- > 0) {
       RawSubByteBlender<ColorMode, blending_mode> blender;
       auto color =
@@ -982,12 +1210,9 @@ class BlendingWriterOperator<ColorMode, pixel_order, byte_order, blending_mode,
 
   void operator()(roo::byte* p, uint32_t offset, uint32_t count) {
     constexpr uint32_t kBytesPerPixel = ColorTraits<ColorMode>::bytes_per_pixel;
-    roo::byte* cursor = p + offset * kBytesPerPixel;
-    RawFullByteBlender<ColorMode, blending_mode, byte_order> blender;
-    while (count-- > 0) {
-      blender(cursor, *color_++, color_mode_);
-      cursor += kBytesPerPixel;
-    }
+    RawFullByteSpanBlender<ColorMode, blending_mode, byte_order>()(
+        p + offset * kBytesPerPixel, color_, count, color_mode_);
+    color_ += count;
   }
 
  private:
@@ -1163,36 +1388,27 @@ template <typename ColorMode, ColorPixelOrder pixel_order, ByteOrder byte_order,
 class BlendingFillerOperator {
  public:
   BlendingFillerOperator(ColorMode& color_mode, Color color)
-      : color_mode_(color_mode), color_(color) {}
+      : mapper_(Blend{color_mode, color}) {}
 
-  void operator()(roo::byte* p, uint32_t offset) {
-    SubByteColorIo<ColorMode, pixel_order> io;
-    int pixel_index = offset % pixels_per_byte;
-    roo::byte* target = p + offset / pixels_per_byte;
-    RawSubByteBlender<ColorMode, blending_mode> blender;
-    auto color = blender(io.loadRaw(*target, pixel_index), color_, color_mode_);
-    io.storeRaw(color, target, pixel_index);
-  }
+  void operator()(roo::byte* p, uint32_t offset) { mapper_(p, offset); }
 
   void operator()(roo::byte* p, uint32_t offset, uint32_t count) {
-    SubByteColorIo<ColorMode, pixel_order> io;
-    int pixel_index = offset % pixels_per_byte;
-    roo::byte* target = p + offset / pixels_per_byte;
-    RawSubByteBlender<ColorMode, blending_mode> blender;
-    while (count-- > 0) {
-      auto color =
-          blender(io.loadRaw(*target, pixel_index), color_, color_mode_);
-      io.storeRaw(color, target, pixel_index);
-      if (++pixel_index == pixels_per_byte) {
-        pixel_index = 0;
-        target++;
-      }
-    }
+    mapper_(p, offset, count);
   }
 
  private:
-  ColorMode& color_mode_;
-  Color color_;
+  // The result depends only on the previous raw value.
+  struct Blend {
+    uint8_t operator()(uint8_t raw) const {
+      return RawSubByteBlender<ColorMode, blending_mode>()(raw, color,
+                                                           color_mode);
+    }
+
+    ColorMode& color_mode;
+    Color color;
+  };
+
+  SubByteSpanMapper<ColorMode, pixel_order, Blend> mapper_;
 };
 
 // For color modes in which a pixel takes up at least 1 byte.
@@ -1212,12 +1428,8 @@ class BlendingFillerOperator<ColorMode, pixel_order, byte_order, blending_mode,
 
   void operator()(roo::byte* p, uint32_t offset, uint32_t count) const {
     constexpr uint32_t kBytesPerPixel = ColorTraits<ColorMode>::bytes_per_pixel;
-    roo::byte* cursor = p + offset * kBytesPerPixel;
-    RawFullByteBlender<ColorMode, blending_mode, byte_order> blender;
-    while (count-- > 0) {
-      blender(cursor, color_, color_mode_);
-      cursor += kBytesPerPixel;
-    }
+    RawFullByteSpanBlender<ColorMode, blending_mode, byte_order>()(
+        p + offset * kBytesPerPixel, color_, count, color_mode_);
   }
 
  private:
@@ -1376,38 +1588,26 @@ template <typename ColorMode, ColorPixelOrder pixel_order, ByteOrder byte_order,
 class GenericFiller {
  public:
   GenericFiller(ColorMode& color_mode, BlendingMode blending_mode, Color color)
-      : color_mode_(color_mode), color_(color), blending_mode_(blending_mode) {}
+      : mapper_(Blend{color_mode, color, blending_mode}) {}
 
-  void operator()(roo::byte* p, uint32_t offset) {
-    SubByteColorIo<ColorMode, pixel_order> io;
-    int pixel_index = offset % pixels_per_byte;
-    roo::byte* target = p + offset / pixels_per_byte;
-    auto color = ApplyRawSubByteBlending(
-        blending_mode_, io.loadRaw(*target, pixel_index), color_, color_mode_);
-    io.storeRaw(color, target, pixel_index);
-  }
+  void operator()(roo::byte* p, uint32_t offset) { mapper_(p, offset); }
 
   void operator()(roo::byte* p, uint32_t offset, uint32_t count) {
-    SubByteColorIo<ColorMode, pixel_order> io;
-    int pixel_index = offset % pixels_per_byte;
-    roo::byte* target = p + offset / pixels_per_byte;
-    // TODO: this loop can be optimized to work on an array of color at a time.
-    while (count-- > 0) {
-      auto color = ApplyRawSubByteBlending(blending_mode_,
-                                           io.loadRaw(*target, pixel_index),
-                                           color_, color_mode_);
-      io.storeRaw(color, target, pixel_index);
-      if (++pixel_index == pixels_per_byte) {
-        pixel_index = 0;
-        target++;
-      }
-    }
+    mapper_(p, offset, count);
   }
 
  private:
-  ColorMode& color_mode_;
-  Color color_;
-  BlendingMode blending_mode_;
+  struct Blend {
+    uint8_t operator()(uint8_t raw) const {
+      return ApplyRawSubByteBlending(blending_mode, raw, color, color_mode);
+    }
+
+    ColorMode& color_mode;
+    Color color;
+    BlendingMode blending_mode;
+  };
+
+  SubByteSpanMapper<ColorMode, pixel_order, Blend> mapper_;
 };
 
 // For color modes in which a pixel takes up at least 1 byte.
@@ -1441,6 +1641,101 @@ class GenericFiller<ColorMode, pixel_order, byte_order, 1, storage_type> {
   BlendingMode blending_mode_;
 };
 
+// Copies `count` raw pixels of a sub-byte color mode, starting at the
+// specified pixel offsets. When the source and the destination share the same
+// position within a byte, whole bytes are copied at once.
+template <typename ColorMode, ColorPixelOrder pixel_order>
+void CopySubBytePixels(const roo::byte* src, uint32_t src_offset,
+                       roo::byte* dst, uint32_t dst_offset, uint32_t count) {
+  constexpr int kPixelsPerByte = ColorTraits<ColorMode>::pixels_per_byte;
+  SubByteColorIo<ColorMode, pixel_order> io;
+  src += src_offset / kPixelsPerByte;
+  dst += dst_offset / kPixelsPerByte;
+  int src_index = src_offset % kPixelsPerByte;
+  int dst_index = dst_offset % kPixelsPerByte;
+  if (src_index == dst_index) {
+    while (count > 0 && src_index != 0) {
+      io.storeRaw(io.loadRaw(*src, src_index), dst, src_index);
+      --count;
+      if (++src_index == kPixelsPerByte) {
+        src_index = 0;
+        ++src;
+        ++dst;
+      }
+    }
+    uint32_t bytes = count / kPixelsPerByte;
+    std::memcpy(dst, src, bytes);
+    src += bytes;
+    dst += bytes;
+    count %= kPixelsPerByte;
+    for (uint32_t i = 0; i < count; ++i) {
+      io.storeRaw(io.loadRaw(*src, i), dst, i);
+    }
+    return;
+  }
+  while (count-- > 0) {
+    io.storeRaw(io.loadRaw(*src, src_index), dst, dst_index);
+    if (++src_index == kPixelsPerByte) {
+      src_index = 0;
+      ++src;
+    }
+    if (++dst_index == kPixelsPerByte) {
+      dst_index = 0;
+      ++dst;
+    }
+  }
+}
+
+// Writer that copies raw pixels of a sub-byte color mode from a row-major
+// rectangle of a (possibly not byte-aligned) source buffer. Used by
+// OffscreenDevice::copyRectFrom() for non-default orientations.
+template <typename ColorMode, ColorPixelOrder pixel_order>
+class SubBytePixelCopier {
+ public:
+  SubBytePixelCopier(const roo::byte* src, int16_t src_raw_width,
+                     int16_t src_x0, int16_t src_y0, int16_t width)
+      : src_(src),
+        src_raw_width_(src_raw_width),
+        src_row_offset_((uint32_t)src_y0 * src_raw_width + src_x0),
+        src_offset_(src_row_offset_),
+        width_(width),
+        remaining_in_row_(width) {}
+
+  void operator()(roo::byte* p, uint32_t offset) {
+    CopySubBytePixels<ColorMode, pixel_order>(src_, src_offset_, p, offset, 1);
+    advance(1);
+  }
+
+  void operator()(roo::byte* p, uint32_t offset, uint32_t count) {
+    while (count > 0) {
+      uint32_t n = std::min<uint32_t>(count, remaining_in_row_);
+      CopySubBytePixels<ColorMode, pixel_order>(src_, src_offset_, p, offset,
+                                                n);
+      offset += n;
+      count -= n;
+      advance(n);
+    }
+  }
+
+ private:
+  void advance(uint32_t n) {
+    src_offset_ += n;
+    remaining_in_row_ -= n;
+    if (remaining_in_row_ == 0) {
+      src_row_offset_ += src_raw_width_;
+      src_offset_ = src_row_offset_;
+      remaining_in_row_ = width_;
+    }
+  }
+
+  const roo::byte* src_;
+  int16_t src_raw_width_;
+  uint32_t src_row_offset_;
+  uint32_t src_offset_;
+  int16_t width_;
+  int16_t remaining_in_row_;
+};
+
 inline BlendingMode ResolveBlendingModeForFill(
     BlendingMode mode, TransparencyMode transparency_mode, Color color) {
   if (transparency_mode == TransparencyMode::kNone) {
@@ -1675,7 +1970,7 @@ void OffscreenDevice<ColorMode, pixel_order, byte_order, pixels_per_byte,
     typename internal::BlendingFiller<ColorMode, pixel_order, byte_order>::
         template Operator<BlendingMode::kSource>
             filler(color_mode_, color);
-    writeToWindow(filler, pixel_count);
+    fillWindow(filler, pixel_count);
   } else {
     if (m == BlendingMode::kDestination) return;
     if (m == BlendingMode::kSourceOverOpaque) {
@@ -1686,23 +1981,23 @@ void OffscreenDevice<ColorMode, pixel_order, byte_order, pixels_per_byte,
                                             byte_order>::
               template Operator<BlendingMode::kSourceOverOpaque, true>
                   filler(color_mode_, color);
-          writeToWindow(filler, pixel_count);
+          fillWindow(filler, pixel_count);
           return;
         }
       }
       typename internal::BlendingFiller<ColorMode, pixel_order, byte_order>::
           template Operator<BlendingMode::kSourceOverOpaque>
               filler(color_mode_, color);
-      writeToWindow(filler, pixel_count);
+      fillWindow(filler, pixel_count);
     } else if (m == BlendingMode::kSourceOver) {
       typename internal::BlendingFiller<ColorMode, pixel_order, byte_order>::
           template Operator<BlendingMode::kSourceOver>
               filler(color_mode_, color);
-      writeToWindow(filler, pixel_count);
+      fillWindow(filler, pixel_count);
     } else {
       internal::GenericFiller<ColorMode, pixel_order, byte_order> filler(
           color_mode_, blending_mode_, color);
-      writeToWindow(filler, pixel_count);
+      fillWindow(filler, pixel_count);
     }
   }
 
@@ -1887,6 +2182,80 @@ void OffscreenDevice<ColorMode, pixel_order, byte_order, pixels_per_byte,
   }
 }
 
+template <typename ColorMode, ColorPixelOrder pixel_order, ByteOrder byte_order,
+          int8_t pixels_per_byte, typename storage_type>
+void OffscreenDevice<ColorMode, pixel_order, byte_order, pixels_per_byte,
+                     storage_type>::copyRectFrom(const OffscreenDevice& src,
+                                                 int16_t src_x0, int16_t src_y0,
+                                                 int16_t src_x1, int16_t src_y1,
+                                                 int16_t dst_x0,
+                                                 int16_t dst_y0) {
+  if (src_x1 < src_x0 || src_y1 < src_y0) return;
+  if (&src == this) {
+    DCHECK(orientation() == Orientation::Default())
+        << "copyRectFrom(*this) requires the default orientation";
+    blitCopy(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+    return;
+  }
+  if constexpr (ColorTraits<ColorMode>::pixels_per_byte == 1) {
+    drawDirectRect(src.buffer(),
+                   static_cast<size_t>(src.raw_width()) *
+                       ColorTraits<ColorMode>::bytes_per_pixel,
+                   src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+  } else {
+    // Rows of sub-byte offscreens are not necessarily byte-aligned, so
+    // drawDirectRect() is not applicable in general.
+    awaitAsyncBlit();
+    int16_t width = src_x1 - src_x0 + 1;
+    int16_t height = src_y1 - src_y0 + 1;
+    if (orientation() == Orientation::Default()) {
+      uint32_t src_offset = (uint32_t)src_y0 * src.raw_width() + src_x0;
+      uint32_t dst_offset = (uint32_t)dst_y0 * raw_width() + dst_x0;
+      for (int16_t r = 0; r < height; ++r) {
+        internal::CopySubBytePixels<ColorMode, pixel_order>(
+            src.buffer(), src_offset, buffer_, dst_offset, width);
+        src_offset += src.raw_width();
+        dst_offset += raw_width();
+      }
+      return;
+    }
+    setAddress(dst_x0, dst_y0, dst_x0 + width - 1, dst_y0 + height - 1,
+               BlendingMode::kSource);
+    internal::SubBytePixelCopier<ColorMode, pixel_order> copier(
+        src.buffer(), src.raw_width(), src_x0, src_y0, width);
+    writeToWindow(copier, static_cast<uint32_t>(width) * height);
+  }
+}
+
+template <typename ColorMode, ColorPixelOrder pixel_order, ByteOrder byte_order,
+          int8_t pixels_per_byte, typename storage_type>
+AsyncBlitToken
+OffscreenDevice<ColorMode, pixel_order, byte_order, pixels_per_byte,
+                storage_type>::copyRectFromAsync(const OffscreenDevice& src,
+                                                 int16_t src_x0, int16_t src_y0,
+                                                 int16_t src_x1, int16_t src_y1,
+                                                 int16_t dst_x0,
+                                                 int16_t dst_y0) {
+  if (&src != this) {
+    if constexpr (ColorTraits<ColorMode>::pixels_per_byte == 1) {
+      drawDirectRectAsync(src.buffer(),
+                          static_cast<size_t>(src.raw_width()) *
+                              ColorTraits<ColorMode>::bytes_per_pixel,
+                          src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+      return async_blit_mark();
+    } else {
+      constexpr int kPixelsPerByte = ColorTraits<ColorMode>::pixels_per_byte;
+      if (src.raw_width() % kPixelsPerByte == 0) {
+        drawDirectRectAsync(src.buffer(), src.raw_width() / kPixelsPerByte,
+                            src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+        return async_blit_mark();
+      }
+    }
+  }
+  copyRectFrom(src, src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+  return async_blit_mark();
+}
+
 template <typename Filler>
 void fillRectsAbsoluteImpl(Filler& fill, roo::byte* buffer, int16_t width,
                            int16_t* x0, int16_t* y0, int16_t* x1, int16_t* y1,
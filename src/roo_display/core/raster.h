@@ -10,6 +10,7 @@
 #include "roo_display/internal/byte_order.h"
 #include "roo_display/internal/color_format.h"
 #include "roo_display/internal/color_io.h"
+#include "roo_display/internal/pixel_pipeline.h"
 #include "roo_io/data/byte_order.h"
 #include "roo_io/data/read.h"
 #include "roo_io/memory/load.h"
@@ -384,6 +385,13 @@ class Raster : public Rasterizable {
         }
       }
     }
+    // Otherwise, try to convert the pixels straight to the device format.
+    if (internal::DrawConvertedRect<ColorMode, pixel_order, byte_order>(
+            s, color_mode_, ptr_, width_,
+            bounds.translate(-extents_.xMin(), -extents_.yMin()),
+            bounds.xMin() + s.dx(), bounds.yMin() + s.dy())) {
+      return;
+    }
     if (extents_.width() == bounds.width() &&
         extents_.height() == bounds.height()) {
       StreamType stream(roo_io::UnsafeGenericMemoryIterator<PtrType>(ptr_),
@@ -0,0 +1,94 @@
+#include "roo_display/core/stream_arena.h"
+
+#include <new>
+
+#include "roo_logging.h"
+
+namespace roo_display {
+
+namespace {
+
+thread_local StreamArena* current_arena = nullptr;
+
+// Every allocation is preceded by a header that identifies the owning arena
+// (or nullptr, for the heap). The header is padded to kAlignment, so that the
+// allocation stays aligned.
+union Header {
+  StreamArena* owner;
+  alignas(StreamArena::kAlignment) roo::byte padding[StreamArena::kAlignment];
+};
+
+static_assert(sizeof(Header) == StreamArena::kAlignment,
+              "Unexpected header size");
+
+void* Tag(void* block, StreamArena* owner) {
+  Header* header = (Header*)block;
+  header->owner = owner;
+  return header + 1;
+}
+
+void* AllocateFromHeap(size_t size) {
+  return Tag(::operator new(sizeof(Header) + size), nullptr);
+}
+
+}  // namespace
+
+StreamArena::~StreamArena() {
+  DCHECK_EQ(0, live_.load(std::memory_order_relaxed))
+      << "A pixel stream outlived its arena";
+}
+
+StreamArena::Scope::Scope(StreamArena& arena)
+    : arena_(arena),
+      engaged_(!arena.active_),
+      previous_(current_arena),
+      heap_allocations_(arena.stats_.heap_allocations) {
+  if (!engaged_) return;
+  arena_.active_ = true;
+  current_arena = &arena_;
+}
+
+StreamArena::Scope::~Scope() {
+  if (!engaged_) return;
+  DCHECK_EQ(current_arena, &arena_);
+  current_arena = previous_;
+  arena_.active_ = false;
+  arena_.stats_.last_draw_heap_allocations =
+      arena_.stats_.heap_allocations - heap_allocations_;
+}
+
+void* StreamArena::Allocate(size_t size) {
+  StreamArena* arena = current_arena;
+  if (arena == nullptr) return AllocateFromHeap(size);
+  if (arena->live_.load(std::memory_order_acquire) == 0) {
+    // All the space is free again.
+    arena->used_ = 0;
+  }
+  size_t aligned =
+      sizeof(Header) + ((size + kAlignment - 1) & ~(kAlignment - 1));
+  if (aligned > arena->capacity_ - arena->used_) {
+    ++arena->stats_.heap_allocations;
+    return AllocateFromHeap(size);
+  }
+  void* result = Tag(arena->buffer_ + arena->used_, arena);
+  arena->used_ += aligned;
+  arena->live_.fetch_add(1, std::memory_order_relaxed);
+  ++arena->stats_.arena_allocations;
+  if (arena->used_ > arena->stats_.peak_bytes) {
+    arena->stats_.peak_bytes = arena->used_;
+  }
+  return result;
+}
+
+void StreamArena::Deallocate(void* ptr) {
+  if (ptr == nullptr) return;
+  Header* header = (Header*)ptr - 1;
+  StreamArena* owner = header->owner;
+  if (owner == nullptr) {
+    ::operator delete(header);
+    return;
+  }
+  owner->live_.fetch_sub(1, std::memory_order_release);
+}
+
+}  // namespace roo_display
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "roo_backport.h"
+#include "roo_backport/byte.h"
+
+#ifndef ROO_DISPLAY_STREAM_ARENA_SIZE
+#define ROO_DISPLAY_STREAM_ARENA_SIZE 512
+#endif
+
+namespace roo_display {
+
+/// Bump allocator for the pixel streams created while drawing.
+///
+/// Drawing a streamable creates a `PixelStream` (often several, e.g. for a
+/// `StreamableStack`, or a font rendering a string), and destroys it right
+/// after the object is drawn. With the general-purpose heap, this churn is
+/// slow, and over long uptimes, fragments the memory. While an arena is
+/// active (see `Scope`), the streams are instead allocated from its fixed
+/// buffer, and the space is reclaimed all at once when the last of them is
+/// destroyed. Allocations that do not fit fall back to the heap, and are
+/// counted, so that the arena size (ROO_DISPLAY_STREAM_ARENA_SIZE) can be
+/// tuned.
+///
+/// `DrawingContext` owns an arena, and activates it for the duration of each
+/// `draw()`. Each allocation is tagged with the arena that owns it, so that a
+/// stream can be released after its draw completes, also from a different
+/// thread, but it must not outlive the arena (i.e., the drawing context).
+///
+/// Arenas are activated per thread, and allocated from only by the thread
+/// that activated them.
+class StreamArena {
+ public:
+  static constexpr size_t kAlignment = alignof(max_align_t);
+
+  struct Stats {
+    /// Allocations served from the arena.
+    uint32_t arena_allocations;
+
+    /// Allocations that did not fit in the arena, and went to the heap.
+    uint32_t heap_allocations;
+
+    /// The maximum number of bytes in use at the same time.
+    uint32_t peak_bytes;
+
+    /// Heap allocations during the most recent draw (i.e., scope). A
+    /// non-zero value means that the arena was too small for that draw.
+    uint32_t last_draw_heap_allocations;
+  };
+
+  /// Creates an arena over the specified buffer, which must be aligned to
+  /// `kAlignment`.
+  StreamArena(roo::byte* buffer, size_t capacity)
+      : buffer_(buffer),
+        capacity_(capacity),
+        used_(0),
+        live_(0),
+        active_(false),
+        stats_{0, 0, 0, 0} {}
+
+  ~StreamArena();
+
+  StreamArena(const StreamArena&) = delete;
+  StreamArena& operator=(const StreamArena&) = delete;
+
+  const Stats& stats() const { return stats_; }
+  void resetStats() { stats_ = Stats{0, 0, 0, 0}; }
+
+  /// Returns the number of bytes currently in use.
+  size_t used() const {
+    return live_.load(std::memory_order_acquire) == 0 ? 0 : used_;
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  /// Makes the arena current for the calling thread, for the lifetime of the
+  /// scope. Scopes can nest; the innermost arena serves the allocations. A
+  /// scope opened on an arena that is already active (e.g. for a nested
+  /// draw in the same context) has no effect.
+  class Scope {
+   public:
+    Scope(StreamArena& arena);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    StreamArena& arena_;
+    bool engaged_;
+    StreamArena* previous_;
+    uint32_t heap_allocations_;
+  };
+
+  /// Allocates memory for a stream: from the current arena if there is one
+  /// and the request fits, or from the heap otherwise.
+  static void* Allocate(size_t size);
+
+  /// Releases memory obtained from `Allocate()`. Can be called from any
+  /// thread.
+  static void Deallocate(void* ptr);
+
+ private:
+  roo::byte* buffer_;
+  size_t capacity_;
+
+  // Modified only by the owning thread. The space is reclaimed lazily, by the
+  // first allocation after all the previous ones have been released.
+  size_t used_;
+
+  // Number of allocations not yet released.
+  std::atomic<uint16_t> live_;
+
+  bool active_;
+
+  Stats stats_;
+};
+
+/// Stream arena with an inline buffer.
+template <size_t kCapacity>
+class StreamArenaWithStorage : public StreamArena {
+ public:
+  StreamArenaWithStorage() : StreamArena(storage_, kCapacity) {}
+
+ private:
+  alignas(StreamArena::kAlignment) roo::byte storage_[kCapacity];
+};
+
+}  // namespace roo_display
@@ -5,6 +5,7 @@
 #include "roo_display/core/buffered_drawing.h"
 #include "roo_display/core/device.h"
 #include "roo_display/core/drawable.h"
+#include "roo_display/core/stream_arena.h"
 
 namespace roo_display {
 
@@ -35,6 +36,35 @@ class PixelStream {
     read(buf, size, ignored_run_length);
   }
 
+  /// Read the next span of pixels: either a run of a uniform color, or a
+  /// sequence of arbitrary (literal) pixels. Returns the number of pixels
+  /// consumed, which is at least 1 and at most `max_count`. `size` and
+  /// `max_count` must be positive.
+  ///
+  /// For a run, sets `is_run` to true and stores the color in `buf[0]`; the
+  /// run may be longer than `size`. Otherwise, sets `is_run` to false and
+  /// stores the pixels in `buf`; their number does not exceed `size`.
+  ///
+  /// The default implementation relies on the run metadata reported by
+  /// `read()`. Streams that know their run structure (e.g. RLE images) should
+  /// override it, so that runs are never expanded to individual pixels.
+  virtual uint32_t readSpan(Color* buf, uint16_t size, uint32_t max_count,
+                            bool& is_run) {
+    uint16_t n = size;
+    if (n > max_count) n = max_count;
+    uint32_t run_length = 0;
+    read(buf, n, run_length);
+    if (run_length >= n && n > 1) {
+      if (run_length > max_count) run_length = max_count;
+      if (run_length > n) skip(run_length - n);
+      is_run = true;
+      return run_length;
+    }
+    // A shorter uniform prefix is returned as literal pixels.
+    is_run = false;
+    return n;
+  }
+
   /// Skip `count` pixels.
   virtual void skip(uint32_t count) {
     Color buf[kPixelWritingBufferSize];
@@ -57,207 +87,199 @@ class PixelStream {
   }
 
   virtual ~PixelStream() {}
+
+  // Streams are allocated from the current StreamArena, if any (i.e., from
+  // the drawing context's arena while drawing), and from the heap otherwise.
+  static void* operator new(size_t size) { return StreamArena::Allocate(size); }
+  static void operator delete(void* ptr) { StreamArena::Deallocate(ptr); }
 };
 
 namespace internal {
 
 constexpr uint32_t kRunLengthFillThreshold = 32;
 
-inline void fillReplaceRect(DisplayOutput& output, const Box& extents,
-                            PixelStream* stream, BlendingMode mode) {
+// Reads `count` pixels from the stream, passing them to `fill(color, n)` or
+// `write(buf, n)`. Long runs are passed to `fill()` without being expanded.
+// Short runs are expanded and merged with the neighboring pixels, so that the
+// output is not fragmented into many small calls. `write()` may modify the
+// buffer.
+template <typename FillFn, typename WriteFn>
+inline void ReadSpans(PixelStream* stream, uint32_t count, FillFn&& fill,
+                      WriteFn&& write) {
   Color buf[kPixelWritingBufferSize];
-  output.setAddress(extents, mode);
-  uint32_t count = extents.area();
+  uint16_t buffered = 0;
   while (count > 0) {
-    uint32_t n = count;
-    if (n > kPixelWritingBufferSize) n = kPixelWritingBufferSize;
-    uint32_t run_length = 0;
-    stream->read(buf, n, run_length);
-    if (run_length >= n) {
-      if (run_length > count) run_length = count;
-      output.fill(buf[0], run_length);
-      stream->skip(run_length - n);
-      count -= run_length;
+    bool is_run;
+    uint32_t n = stream->readSpan(buf + buffered,
+                                  kPixelWritingBufferSize - buffered, count,
+                                  is_run);
+    count -= n;
+    if (!is_run) {
+      buffered += n;
+      if (buffered == kPixelWritingBufferSize) {
+        write(buf, buffered);
+        buffered = 0;
+      }
       continue;
     }
-    if (run_length >= kRunLengthFillThreshold) {
-      output.fill(buf[0], run_length);
-      output.write(buf + run_length, n - run_length);
-    } else {
-      output.write(buf, n);
+    Color color = buf[buffered];
+    if (n >= kRunLengthFillThreshold) {
+      if (buffered > 0) {
+        write(buf, buffered);
+        buffered = 0;
+      }
+      fill(color, n);
+      continue;
+    }
+    while (n > 0) {
+      uint16_t k = kPixelWritingBufferSize - buffered;
+      if (k > n) k = n;
+      FillColor(buf + buffered, k, color);
+      buffered += k;
+      n -= k;
+      if (buffered == kPixelWritingBufferSize) {
+        write(buf, buffered);
+        buffered = 0;
+      }
     }
-    count -= n;
   }
+  if (buffered > 0) write(buf, buffered);
+}
+
+inline void fillReplaceRect(DisplayOutput& output, const Box& extents,
+                            PixelStream* stream, BlendingMode mode) {
+  output.setAddress(extents, mode);
+  ReadSpans(
+      stream, extents.area(),
+      [&output](Color color, uint32_t n) { output.fill(color, n); },
+      [&output](Color* buf, uint16_t n) { output.write(buf, n); });
 }
 
 inline void fillPaintRectOverOpaqueBg(DisplayOutput& output, const Box& extents,
                                       Color bgColor, PixelStream* stream,
                                       BlendingMode mode) {
-  Color buf[kPixelWritingBufferSize];
   output.setAddress(extents, mode);
-  uint32_t count = extents.area();
-  do {
-    uint16_t n = kPixelWritingBufferSize;
-    if (n > count) n = count;
-    uint32_t run_length = 0;
-    stream->read(buf, n, run_length);
-    if (run_length == 0) {
-      for (int i = 0; i < n; i++) {
-        buf[i] = AlphaBlendOverOpaque(bgColor, buf[i]);
-      }
-      output.write(buf, n);
-      count -= n;
-      continue;
-    }
-
-    Color blended_prefix = AlphaBlendOverOpaque(bgColor, buf[0]);
-
-    if (run_length >= n) {
-      if (run_length > count) run_length = count;
-      output.fill(blended_prefix, run_length);
-      stream->skip(run_length - n);
-      count -= run_length;
-      continue;
-    }
-
-    for (uint32_t i = 0; i < run_length; ++i) {
-      buf[i] = blended_prefix;
-    }
-    for (uint32_t i = run_length; i < n; ++i) {
-      buf[i] = AlphaBlendOverOpaque(bgColor, buf[i]);
-    }
-
-    if (run_length >= kRunLengthFillThreshold) {
-      output.fill(blended_prefix, run_length);
-      output.write(buf + run_length, n - run_length);
-    } else {
-      output.write(buf, n);
-    }
-    count -= n;
-  } while (count > 0);
+  ReadSpans(
+      stream, extents.area(),
+      [&](Color color, uint32_t n) {
+        output.fill(AlphaBlendOverOpaque(bgColor, color), n);
+      },
+      [&](Color* buf, uint16_t n) {
+        for (int i = 0; i < n; i++) {
+          buf[i] = AlphaBlendOverOpaque(bgColor, buf[i]);
+        }
+        output.write(buf, n);
+      });
 }
 
 inline void fillPaintRectOverBg(DisplayOutput& output, const Box& extents,
                                 Color bgcolor, PixelStream* stream,
                                 BlendingMode mode) {
-  Color buf[kPixelWritingBufferSize];
   output.setAddress(extents, mode);
-  uint32_t count = extents.area();
-  do {
-    uint16_t n = kPixelWritingBufferSize;
-    if (n > count) n = count;
-    uint32_t run_length = 0;
-    stream->read(buf, n, run_length);
-    if (run_length == 0) {
-      for (int i = 0; i < n; ++i) {
-        buf[i] = AlphaBlend(bgcolor, buf[i]);
+  ReadSpans(
+      stream, extents.area(),
+      [&](Color color, uint32_t n) {
+        output.fill(AlphaBlend(bgcolor, color), n);
+      },
+      [&](Color* buf, uint16_t n) {
+        for (int i = 0; i < n; ++i) {
+          buf[i] = AlphaBlend(bgcolor, buf[i]);
+        }
+        output.write(buf, n);
+      });
+}
+
+// Visible runs at least that long are drawn as rectangles, rather than as
+// individual pixels.
+constexpr uint32_t kVisibleRunFillThreshold = 4;
+
+// Reads the pixels of `extents` from the stream, and writes the ones that are
+// not fully transparent, converted by `paint`. Transparent runs are skipped,
+// and long visible runs are drawn as rectangles, without being expanded.
+template <typename PaintFn>
+inline void writeRectVisibleSpans(DisplayOutput& output, const Box& extents,
+                                  PixelStream* stream, BlendingMode mode,
+                                  PaintFn&& paint) {
+  Color buf[kPixelWritingBufferSize];
+  BufferedPixelWriter writer(output, mode);
+  const int16_t width = extents.width();
+  uint32_t remaining = extents.area();
+  int16_t x = extents.xMin();
+  int16_t y = extents.yMin();
+  while (remaining > 0) {
+    bool is_run;
+    uint32_t n =
+        stream->readSpan(buf, kPixelWritingBufferSize, remaining, is_run);
+    remaining -= n;
+    if (!is_run) {
+      for (uint32_t i = 0; i < n; ++i) {
+        if (buf[i].a() != 0) {
+          writer.writePixel(x, y, paint(buf[i]));
+        }
+        if (++x > extents.xMax()) {
+          x = extents.xMin();
+          ++y;
+        }
       }
-      output.write(buf, n);
-      count -= n;
       continue;
     }
-
-    Color blended_prefix = AlphaBlend(bgcolor, buf[0]);
-
-    if (run_length >= n) {
-      if (run_length > count) run_length = count;
-      output.fill(blended_prefix, run_length);
-      stream->skip(run_length - n);
-      count -= run_length;
+    if (buf[0].a() == 0) {
+      uint32_t offset = (x - extents.xMin()) + n;
+      y += offset / width;
+      x = extents.xMin() + offset % width;
       continue;
     }
-
-    for (uint32_t i = 0; i < run_length; ++i) {
-      buf[i] = blended_prefix;
-    }
-    for (uint32_t i = run_length; i < n; ++i) {
-      buf[i] = AlphaBlend(bgcolor, buf[i]);
-    }
-
-    if (run_length >= kRunLengthFillThreshold) {
-      output.fill(blended_prefix, run_length);
-      output.write(buf + run_length, n - run_length);
-    } else {
-      output.write(buf, n);
+    Color color = paint(buf[0]);
+    while (n > 0) {
+      if (x == extents.xMin() && n >= (uint32_t)width) {
+        // Full rows.
+        int16_t rows = n / width;
+        output.fillRect(mode, Box(x, y, extents.xMax(), y + rows - 1), color);
+        y += rows;
+        n -= (uint32_t)rows * width;
+        continue;
+      }
+      uint32_t k = extents.xMax() - x + 1;
+      if (k > n) k = n;
+      if (k >= kVisibleRunFillThreshold) {
+        output.fillRect(mode, Box(x, y, x + k - 1, y), color);
+      } else {
+        for (uint32_t i = 0; i < k; ++i) {
+          writer.writePixel(x + i, y, color);
+        }
+      }
+      n -= k;
+      x += k;
+      if (x > extents.xMax()) {
+        x = extents.xMin();
+        ++y;
+      }
     }
-    count -= n;
-  } while (count > 0);
+  }
 }
 
 // Assumes no bgcolor.
 inline void writeRectVisible(DisplayOutput& output, const Box& extents,
                              PixelStream* stream, BlendingMode mode) {
-  // TODO(dawidk): need to optimize this.
-  Color buf[kPixelWritingBufferSize];
-  BufferedPixelWriter writer(output, mode);
-  uint32_t remaining = extents.area();
-  int idx = kPixelWritingBufferSize;
-  for (int16_t j = extents.yMin(); j <= extents.yMax(); ++j) {
-    for (int16_t i = extents.xMin(); i <= extents.xMax(); ++i) {
-      if (idx >= kPixelWritingBufferSize) {
-        idx = 0;
-        int n = remaining < kPixelWritingBufferSize ? remaining
-                                                    : kPixelWritingBufferSize;
-        stream->read(buf, n);
-        remaining -= n;
-      }
-      Color color = buf[idx++];
-      if (color.a() != 0) {
-        writer.writePixel(i, j, color);
-      }
-    }
-  }
+  writeRectVisibleSpans(output, extents, stream, mode,
+                        [](Color color) { return color; });
 }
 
 inline void writeRectVisibleOverOpaqueBg(DisplayOutput& output,
                                          const Box& extents, Color bgcolor,
                                          PixelStream* stream,
                                          BlendingMode mode) {
-  // TODO(dawidk): need to optimize this.
-  Color buf[kPixelWritingBufferSize];
-  BufferedPixelWriter writer(output, mode);
-  uint32_t remaining = extents.area();
-  int idx = kPixelWritingBufferSize;
-  for (int16_t j = extents.yMin(); j <= extents.yMax(); ++j) {
-    for (int16_t i = extents.xMin(); i <= extents.xMax(); ++i) {
-      if (idx >= kPixelWritingBufferSize) {
-        idx = 0;
-        int n = remaining < kPixelWritingBufferSize ? remaining
-                                                    : kPixelWritingBufferSize;
-        stream->read(buf, n);
-        remaining -= n;
-      }
-      Color color = buf[idx++];
-      if (color.a() != 0) {
-        writer.writePixel(i, j, AlphaBlendOverOpaque(bgcolor, color));
-      }
-    }
-  }
+  writeRectVisibleSpans(output, extents, stream, mode, [bgcolor](Color color) {
+    return AlphaBlendOverOpaque(bgcolor, color);
+  });
 }
 
 inline void writeRectVisibleOverBg(DisplayOutput& output, const Box& extents,
                                    Color bgcolor, PixelStream* stream,
                                    BlendingMode mode) {
-  // TODO(dawidk): need to optimize this.
-  Color buf[kPixelWritingBufferSize];
-  BufferedPixelWriter writer(output, mode);
-  uint32_t remaining = extents.area();
-  int idx = kPixelWritingBufferSize;
-  for (int16_t j = extents.yMin(); j <= extents.yMax(); ++j) {
-    for (int16_t i = extents.xMin(); i <= extents.xMax(); ++i) {
-      if (idx >= kPixelWritingBufferSize) {
-        idx = 0;
-        int n = remaining < kPixelWritingBufferSize ? remaining
-                                                    : kPixelWritingBufferSize;
-        stream->read(buf, n);
-        remaining -= n;
-      }
-      Color color = buf[idx++];
-      if (color.a() != 0) {
-        writer.writePixel(i, j, AlphaBlend(bgcolor, color));
-      }
-    }
-  }
+  writeRectVisibleSpans(output, extents, stream, mode, [bgcolor](Color color) {
+    return AlphaBlend(bgcolor, color);
+  });
 }
 
 // This function will fill in the specified rectangle using the most appropriate
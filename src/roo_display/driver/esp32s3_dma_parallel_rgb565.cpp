@@ -6,6 +6,8 @@
 #include "esp_heap_caps.h"
 #include "esp_idf_version.h"
 #include "esp_lcd_panel_ops.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "roo_backport.h"
 #include "roo_backport/byte.h"
 #include "roo_display/driver/esp32s3_dma_parallel_rgb565.h"
@@ -25,7 +27,9 @@ namespace roo_display {
 
 namespace esp32s3_dma {
 
-AllocatedPanel AllocatePanel(const Config& config) {
+namespace {
+
+esp_lcd_panel_handle_t CreatePanel(const Config& config, uint8_t num_fbs) {
   esp_lcd_rgb_panel_config_t cfg = {};
 
   cfg.clk_src = LCD_CLK_SRC_PLL160M;
@@ -120,7 +124,7 @@ AllocatedPanel AllocatePanel(const Config& config) {
 #if defined(LEGACY_RGBPANEL)
   cfg.flags.relax_on_idle = 0;
 #else
-  cfg.num_fbs = 1;
+  cfg.num_fbs = num_fbs;
 #endif
 
   cfg.flags.fb_in_psram = 1;  // allocate frame buffer in PSRAM
@@ -129,7 +133,13 @@ AllocatedPanel AllocatePanel(const Config& config) {
   ESP_ERROR_CHECK(esp_lcd_new_rgb_panel(&cfg, &handle));
   ESP_ERROR_CHECK(esp_lcd_panel_reset(handle));
   ESP_ERROR_CHECK(esp_lcd_panel_init(handle));
+  return handle;
+}
 
+}  // namespace
+
+AllocatedPanel AllocatePanel(const Config& config) {
+  esp_lcd_panel_handle_t handle = CreatePanel(config, 1);
   roo::byte* buf;
   esp_lcd_rgb_panel_get_frame_buffer(handle, 1, (void**)&buf);
   return {buf, handle};
@@ -617,6 +627,80 @@ void ParallelRgb565<FLUSH_MODE_LAZY>::drawDirectRectAsync(
 //   flush(x0_orig, y0_orig, x1_orig, y1_orig, count_orig);
 // }
 
+#ifndef LEGACY_RGBPANEL
+
+namespace {
+
+bool IRAM_ATTR OnVsync(esp_lcd_panel_handle_t panel,
+                       const esp_lcd_rgb_panel_event_data_t* edata,
+                       void* user_ctx) {
+  BaseType_t woken = pdFALSE;
+  xSemaphoreGiveFromISR((SemaphoreHandle_t)user_ctx, &woken);
+  return woken == pdTRUE;
+}
+
+}  // namespace
+
+ParallelRgb565MultiBuffered::ParallelRgb565MultiBuffered(Config cfg,
+                                                         uint8_t buffer_count)
+    : MultiBufferedDevice(cfg.width, cfg.height, Rgb565()),
+      cfg_(std::move(cfg)),
+      buffer_count_(buffer_count),
+      vsync_(xSemaphoreCreateBinary()) {
+  CHECK_GE(buffer_count, 2);
+  CHECK_LE(buffer_count, kMaxBuffers);
+}
+
+void ParallelRgb565MultiBuffered::init() {
+  CHECK(panel_handle_ == nullptr) << "Re-initialization is not supported";
+  async_blit_init();
+  panel_handle_ = CreatePanel(cfg_, buffer_count_);
+  roo::byte* buffers[kMaxBuffers];
+  if (buffer_count_ == 2) {
+    ESP_ERROR_CHECK(esp_lcd_rgb_panel_get_frame_buffer(
+        panel_handle_, 2, (void**)&buffers[0], (void**)&buffers[1]));
+  } else {
+    ESP_ERROR_CHECK(esp_lcd_rgb_panel_get_frame_buffer(
+        panel_handle_, 3, (void**)&buffers[0], (void**)&buffers[1],
+        (void**)&buffers[2]));
+  }
+  attachBuffers(buffers, buffer_count_);
+  esp_lcd_rgb_panel_event_callbacks_t callbacks = {};
+  callbacks.on_vsync = &OnVsync;
+  ESP_ERROR_CHECK(
+      esp_lcd_rgb_panel_register_event_callbacks(panel_handle_, &callbacks,
+                                                 vsync_));
+}
+
+void ParallelRgb565MultiBuffered::end() {
+  MultiBufferedDevice::end();
+  if (!inFrame()) {
+    // Drawing outside of frames goes to the visible buffer.
+    writeBack(back().raster().buffer());
+  }
+}
+
+void ParallelRgb565MultiBuffered::flip(uint8_t index,
+                                       const roo::byte* buffer) {
+  writeBack(buffer);
+  // Discard a stale vsync signal, so that awaitFlip() waits for the next one.
+  xSemaphoreTake(vsync_, 0);
+  // Passing one of the panel's own framebuffers makes the driver switch to it
+  // at the next frame boundary, without copying.
+  ESP_ERROR_CHECK(esp_lcd_panel_draw_bitmap(panel_handle_, 0, 0, cfg_.width,
+                                            cfg_.height, buffer));
+}
+
+void ParallelRgb565MultiBuffered::awaitFlip() {
+  xSemaphoreTake(vsync_, portMAX_DELAY);
+}
+
+void ParallelRgb565MultiBuffered::writeBack(const roo::byte* buffer) {
+  Cache_WriteBack_Addr((uint32_t)buffer, cfg_.width * cfg_.height * 2);
+}
+
+#endif  // LEGACY_RGBPANEL
+
 }  // namespace esp32s3_dma
 
 }  // namespace roo_display
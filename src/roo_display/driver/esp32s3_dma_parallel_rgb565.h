@@ -8,10 +8,14 @@
 
 #include <memory>
 
+#include "esp_idf_version.h"
 #include "esp_lcd_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "rom/cache.h"
 #include "roo_display/color/blending.h"
 #include "roo_display/core/device.h"
+#include "roo_display/core/multi_buffered_device.h"
 #include "roo_display/core/offscreen.h"
 #include "roo_display/internal/byte_order.h"
 #include "roo_display/internal/color_format.h"
@@ -376,6 +380,40 @@ class ParallelRgb565 : public DisplayDevice {
 
 using ParallelRgb565Buffered = ParallelRgb565<FLUSH_MODE_BUFFERED>;
 
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+
+/// Variant of the parallel RGB565 driver that allocates 2 or 3 framebuffers
+/// in the panel, and uses them for tear-free frame presentation (see
+/// `MultiBufferedDevice`). Flips are synchronized with the panel's vsync.
+///
+/// Outside of `beginFrame()` / `presentFrame()`, drawing goes directly to the
+/// visible framebuffer, like with `ParallelRgb565Buffered`.
+class ParallelRgb565MultiBuffered
+    : public MultiBufferedDevice<Rgb565, ColorPixelOrder::kMsbFirst,
+                                 roo_io::kLittleEndian> {
+ public:
+  ParallelRgb565MultiBuffered(Config cfg, uint8_t buffer_count = 2);
+
+  void init() override;
+
+  void end() override;
+
+ protected:
+  void flip(uint8_t index, const roo::byte* buffer) override;
+
+  void awaitFlip() override;
+
+ private:
+  void writeBack(const roo::byte* buffer);
+
+  Config cfg_;
+  uint8_t buffer_count_;
+  esp_lcd_panel_handle_t panel_handle_{nullptr};
+  SemaphoreHandle_t vsync_;
+};
+
+#endif  // ESP_IDF_VERSION >= 5.1.0
+
 }  // namespace esp32s3_dma
 
 }  // namespace roo_display
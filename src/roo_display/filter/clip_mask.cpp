@@ -0,0 +1,52 @@
+#include "roo_display/filter/clip_mask.h"
+
+#include "roo_display/core/offscreen.h"
+
+namespace roo_display {
+
+TiledClipMask::TiledClipMask(const roo::byte* data, Box bounds, bool inverted)
+    : ClipMask(data, bounds, inverted),
+      summary_(new uint8_t[line_width_bytes() * ((bounds.height() + 7) / 8)]) {
+  setTiles(summary_.get());
+  update();
+}
+
+TiledClipMask::TiledClipMask(const BitMaskOffscreen& offscreen, bool inverted)
+    : TiledClipMask(offscreen.buffer(), offscreen.extents(), inverted) {}
+
+void TiledClipMask::update(const Box& area) {
+  Box box = Box::Intersect(area, bounds());
+  if (box.empty()) return;
+  uint32_t tx0 = (box.xMin() - bounds().xMin()) / 8;
+  uint32_t tx1 = (box.xMax() - bounds().xMin()) / 8;
+  uint32_t ty0 = (box.yMin() - bounds().yMin()) / 8;
+  uint32_t ty1 = (box.yMax() - bounds().yMin()) / 8;
+  for (uint32_t ty = ty0; ty <= ty1; ++ty) {
+    uint8_t* tile = &summary_[ty * line_width_bytes()];
+    for (uint32_t tx = tx0; tx <= tx1; ++tx) {
+      tile[tx] = computeTile(tx, ty);
+    }
+  }
+}
+
+uint8_t TiledClipMask::computeTile(uint32_t tx, uint32_t ty) const {
+  // Only consider the bits within bounds; the last column and the last row of
+  // tiles may be partial.
+  roo::byte mask{0xFF};
+  int16_t width = bounds().width() - tx * 8;
+  if (width < 8) mask <<= (8 - width);
+  int16_t height = std::min<int16_t>(8, bounds().height() - ty * 8);
+  const roo::byte* ptr = data() + ty * 8 * line_width_bytes() + tx;
+  bool any_set = false;
+  bool any_clear = false;
+  while (height-- > 0) {
+    roo::byte b = *ptr & mask;
+    if (b != roo::byte{0}) any_set = true;
+    if (b != mask) any_clear = true;
+    ptr += line_width_bytes();
+  }
+  if (any_set && any_clear) return kTileMixed;
+  return any_set ? kTileAllSet : kTileAllClear;
+}
+
+}  // namespace roo_display
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <memory>
 #include <type_traits>
 
 #include "roo_backport.h"
@@ -9,6 +11,8 @@
 
 namespace roo_display {
 
+class BitMaskOffscreen;
+
 /// Binary clip mask using a packed bit buffer.
 ///
 /// Each bit represents a pixel within `bounds`. Rows are byte-aligned. For
@@ -37,6 +41,55 @@ class ClipMask {
   /// Return inversion flag.
   bool inverted() const { return inverted_; }
 
+  /// Return a copy of this mask, translated by the specified offset.
+  ClipMask translate(int16_t dx, int16_t dy) const {
+    ClipMask result = *this;
+    result.bounds_ = bounds_.translate(dx, dy);
+    return result;
+  }
+
+  /// Masking of a horizontal run of pixels; see `span()`.
+  enum class Coverage { kUnmasked, kMasked, kMixed };
+
+  /// Return the length of the longest run of pixels starting at (x, y), and
+  /// ending no further than at `x_max`, that can be classified together, and
+  /// store the classification in `coverage`. Pixels outside `bounds` are
+  /// classified by the inversion flag. Within `bounds`, the classification is
+  /// based on the tile summary (see `TiledClipMask`), if available; otherwise,
+  /// the run extends to the edge of `bounds`, and is reported as `kMixed`.
+  inline int32_t span(int16_t x, int16_t y, int16_t x_max,
+                      Coverage& coverage) const {
+    if (y < bounds_.yMin() || y > bounds_.yMax() || x > bounds_.xMax()) {
+      coverage = inverted_ ? Coverage::kMasked : Coverage::kUnmasked;
+      return (int32_t)x_max - x + 1;
+    }
+    if (x < bounds_.xMin()) {
+      coverage = inverted_ ? Coverage::kMasked : Coverage::kUnmasked;
+      return (int32_t)std::min<int16_t>(x_max, bounds_.xMin() - 1) - x + 1;
+    }
+    int16_t x_end = std::min(x_max, bounds_.xMax());
+    if (tiles_ == nullptr) {
+      coverage = Coverage::kMixed;
+      return (int32_t)x_end - x + 1;
+    }
+    uint32_t tx = (x - bounds_.xMin()) / 8;
+    uint32_t ty = (y - bounds_.yMin()) / 8;
+    const uint8_t* tile = tiles_ + ty * line_width_bytes_ + tx;
+    uint8_t state = *tile;
+    int32_t tile_end = bounds_.xMin() + (int32_t)tx * 8 + 7;
+    while (tile_end < x_end && tile[1] == state) {
+      ++tile;
+      tile_end += 8;
+    }
+    if (state == kTileMixed) {
+      coverage = Coverage::kMixed;
+    } else {
+      coverage = ((state == kTileAllSet) ^ inverted_) ? Coverage::kMasked
+                                                       : Coverage::kUnmasked;
+    }
+    return std::min<int32_t>(tile_end, x_end) - x + 1;
+  }
+
   /// Return whether a point is masked out.
   inline bool isMasked(int16_t x, int16_t y) const {
     if (!bounds_.contains(x, y)) return inverted_;
@@ -51,20 +104,42 @@ class ClipMask {
   /// Return whether all bits in a block are masked.
   inline bool isAllMasked(int16_t x, int16_t y, roo::byte mask,
                           uint8_t lines) const {
-    return inverted_ ? isAllUnset(x, y, mask, ~lines)
+    return inverted_ ? isAllUnset(x, y, mask, lines)
                      : isAllSet(x, y, mask, lines);
   }
 
   /// Return whether all bits in a block are unmasked.
   inline bool isAllUnmasked(int16_t x, int16_t y, roo::byte mask,
                             uint8_t lines) const {
-    return inverted_ ? isAllSet(x, y, mask, ~lines)
+    return inverted_ ? isAllSet(x, y, mask, lines)
                      : isAllUnset(x, y, mask, lines);
   }
 
+  /// Return the coverage of the 8x8 tile containing the specified point, which
+  /// must be within `bounds`. Tiles are aligned to the top-left corner of
+  /// `bounds`. Returns `kMixed` if there is no tile summary.
+  inline Coverage tileCoverage(int16_t x, int16_t y) const {
+    if (tiles_ == nullptr) return Coverage::kMixed;
+    uint8_t state = tiles_[(y - bounds_.yMin()) / 8 * line_width_bytes_ +
+                           (x - bounds_.xMin()) / 8];
+    if (state == kTileMixed) return Coverage::kMixed;
+    return ((state == kTileAllSet) ^ inverted_) ? Coverage::kMasked
+                                                : Coverage::kUnmasked;
+  }
+
   /// Set inversion behavior.
   void setInverted(bool inverted) { inverted_ = inverted; }
 
+ protected:
+  // Tile summary states, in terms of the raw bits.
+  static constexpr uint8_t kTileAllClear = 0;
+  static constexpr uint8_t kTileAllSet = 1;
+  static constexpr uint8_t kTileMixed = 2;
+
+  void setTiles(const uint8_t* tiles) { tiles_ = tiles; }
+
+  uint32_t line_width_bytes() const { return line_width_bytes_; }
+
  private:
   inline bool isAllSet(int16_t x, int16_t y, roo::byte mask,
                        uint8_t lines) const {
@@ -97,6 +172,45 @@ class ClipMask {
   bool inverted_;
 
   uint32_t line_width_bytes_;
+
+  // Optional tile summary, with one entry per 8x8 tile; i.e., one row of
+  // entries per 8 rows of data. Owned by `TiledClipMask`.
+  const uint8_t* tiles_ = nullptr;
+};
+
+/// Clip mask with a coarse summary, recording for each 8x8 tile whether its
+/// bits are all set, all clear, or mixed. `ClipMaskFilter` uses the summary to
+/// draw or drop whole runs of uniform tiles without testing individual bits,
+/// which pays off for large masks that are mostly uniform, e.g. masked text
+/// over large panels.
+///
+/// The summary must be refreshed by calling `update()` whenever the mask data
+/// changes. Since filters refer to the summary, the mask must outlive them.
+class TiledClipMask : public ClipMask {
+ public:
+  /// Construct a tiled clip mask over the specified data, and compute the
+  /// summary.
+  TiledClipMask(const roo::byte* data, Box bounds, bool inverted = false);
+
+  /// Construct a tiled clip mask over the content of the specified bit mask
+  /// offscreen (in which pixels drawn with a non-transparent color are
+  /// masked out), and compute the summary. After drawing to the offscreen,
+  /// call `update()` with the changed area.
+  TiledClipMask(const BitMaskOffscreen& offscreen, bool inverted = false);
+
+  TiledClipMask(const TiledClipMask&) = delete;
+  TiledClipMask& operator=(const TiledClipMask&) = delete;
+
+  /// Recompute the summary for the entire mask.
+  void update() { update(bounds()); }
+
+  /// Recompute the summary of the tiles intersecting the specified area.
+  void update(const Box& area);
+
+ private:
+  uint8_t computeTile(uint32_t tx, uint32_t ty) const;
+
+  std::unique_ptr<uint8_t[]> summary_;
 };
 
 /// Filtering device that applies a clip mask.
@@ -105,8 +219,7 @@ class ClipMaskFilter : public DisplayOutput {
   ClipMaskFilter(DisplayOutput& output, const ClipMask* clip_mask,
                  int16_t dx = 0, int16_t dy = 0)
       : output_(output),
-        clip_mask_(clip_mask->data(), clip_mask->bounds().translate(dx, dy),
-                   clip_mask->inverted()),
+        clip_mask_(clip_mask->translate(dx, dy)),
         address_window_(0, 0, 0, 0),
         cursor_x_(0),
         cursor_y_(0),
@@ -124,33 +237,59 @@ class ClipMaskFilter : public DisplayOutput {
   }
 
   void write(Color* color, uint32_t pixel_count) override {
-    // Naive implementation, for now.
-    uint32_t i = 0;
     BufferedPixelWriter writer(output_, blending_mode_);
-    while (i < pixel_count) {
-      if (!clip_mask_.isMasked(cursor_x_, cursor_y_)) {
-        writer.writePixel(cursor_x_, cursor_y_, color[i]);
-      }
-      if (++cursor_x_ > address_window_.xMax()) {
-        ++cursor_y_;
-        cursor_x_ = address_window_.xMin();
+    while (pixel_count > 0) {
+      ClipMask::Coverage coverage;
+      int32_t n = nextSpan(pixel_count, coverage);
+      if (coverage == ClipMask::Coverage::kUnmasked) {
+        if (n >= kMinDirectSpan) {
+          writer.flush();
+          output_.setAddress(cursor_x_, cursor_y_, cursor_x_ + n - 1,
+                             cursor_y_, blending_mode_);
+          output_.write(color, n);
+        } else {
+          for (int32_t i = 0; i < n; ++i) {
+            writer.writePixel(cursor_x_ + i, cursor_y_, color[i]);
+          }
+        }
+      } else if (coverage == ClipMask::Coverage::kMixed) {
+        for (int32_t i = 0; i < n; ++i) {
+          if (!clip_mask_.isMasked(cursor_x_ + i, cursor_y_)) {
+            writer.writePixel(cursor_x_ + i, cursor_y_, color[i]);
+          }
+        }
       }
-      ++i;
+      color += n;
+      pixel_count -= n;
+      advance(n);
     }
   }
 
   void fill(Color color, uint32_t pixel_count) override {
-    uint32_t i = 0;
     BufferedPixelFiller filler(output_, color, blending_mode_);
-    while (i < pixel_count) {
-      if (!clip_mask_.isMasked(cursor_x_, cursor_y_)) {
-        filler.fillPixel(cursor_x_, cursor_y_);
-      }
-      if (++cursor_x_ > address_window_.xMax()) {
-        ++cursor_y_;
-        cursor_x_ = address_window_.xMin();
+    while (pixel_count > 0) {
+      ClipMask::Coverage coverage;
+      int32_t n = nextSpan(pixel_count, coverage);
+      if (coverage == ClipMask::Coverage::kUnmasked) {
+        if (n >= kMinDirectSpan) {
+          filler.flush();
+          output_.setAddress(cursor_x_, cursor_y_, cursor_x_ + n - 1,
+                             cursor_y_, blending_mode_);
+          output_.fill(color, n);
+        } else {
+          for (int32_t i = 0; i < n; ++i) {
+            filler.fillPixel(cursor_x_ + i, cursor_y_);
+          }
+        }
+      } else if (coverage == ClipMask::Coverage::kMixed) {
+        for (int32_t i = 0; i < n; ++i) {
+          if (!clip_mask_.isMasked(cursor_x_ + i, cursor_y_)) {
+            filler.fillPixel(cursor_x_ + i, cursor_y_);
+          }
+        }
       }
-      ++i;
+      pixel_count -= n;
+      advance(n);
     }
   }
 
@@ -283,6 +422,9 @@ class ClipMaskFilter : public DisplayOutput {
       if (yc1 > y1) yc1 = y1;
       uint8_t lines = yc1 - yc0 + 1;
       uint8_t xshift = (x0 - bounds.xMin()) % 8;
+      // Pending run of unmasked blocks; empty if run_x1 < run_x0.
+      int16_t run_x0 = x0;
+      int16_t run_x1 = x0 - 1;
       for (int16_t xc0 = x0; xc0 <= x1;) {
         int16_t xc1 = xc0 - xshift + 7;
         roo::byte mask = roo::byte{0xFF} >> xshift;
@@ -290,10 +432,25 @@ class ClipMaskFilter : public DisplayOutput {
           mask &= (roo::byte{0xFF} << (xc1 - x1));
           xc1 = x1;
         }
-        if (!clip_mask_.isAllMasked(xc0, yc0, mask, lines)) {
-          if (clip_mask_.isAllUnmasked(xc0, yc0, mask, lines)) {
-            rfiller.fillRect(xc0, yc0, xc1, yc1);
-          } else {
+        // Uniform tiles don't need to be inspected.
+        ClipMask::Coverage coverage = clip_mask_.tileCoverage(xc0, yc0);
+        if (coverage == ClipMask::Coverage::kMixed) {
+          if (clip_mask_.isAllMasked(xc0, yc0, mask, lines)) {
+            coverage = ClipMask::Coverage::kMasked;
+          } else if (clip_mask_.isAllUnmasked(xc0, yc0, mask, lines)) {
+            coverage = ClipMask::Coverage::kUnmasked;
+          }
+        }
+        if (coverage == ClipMask::Coverage::kUnmasked) {
+          // Merge with the preceding unmasked blocks, if any.
+          if (run_x1 < run_x0) run_x0 = xc0;
+          run_x1 = xc1;
+        } else {
+          if (run_x1 >= run_x0) {
+            rfiller.fillRect(run_x0, yc0, run_x1, yc1);
+            run_x1 = run_x0 - 1;
+          }
+          if (coverage == ClipMask::Coverage::kMixed) {
             // Degenerate to the slow version.
             for (int16_t y = yc0; y <= yc1; ++y) {
               for (int16_t x = xc0; x <= xc1; ++x) {
@@ -308,11 +465,36 @@ class ClipMaskFilter : public DisplayOutput {
         xc0 = xc0 - xshift + 8;
         xshift = 0;
       }
+      if (run_x1 >= run_x0) {
+        rfiller.fillRect(run_x0, yc0, run_x1, yc1);
+      }
       yc0 = yc0 - yshift + 8;
       yshift = 0;
     }
   }
 
+  // Unmasked spans shorter than that are written as individual pixels.
+  static constexpr int32_t kMinDirectSpan = 8;
+
+  // Returns the length of the next span of pixels, starting at the cursor,
+  // that can be processed together, and stores its coverage. The span does
+  // not exceed the row, or `pixel_count`.
+  int32_t nextSpan(uint32_t pixel_count, ClipMask::Coverage& coverage) const {
+    int16_t x_max = address_window_.xMax();
+    if ((uint32_t)(x_max - cursor_x_ + 1) > pixel_count) {
+      x_max = cursor_x_ + pixel_count - 1;
+    }
+    return clip_mask_.span(cursor_x_, cursor_y_, x_max, coverage);
+  }
+
+  void advance(int32_t n) {
+    cursor_x_ += n;
+    if (cursor_x_ > address_window_.xMax()) {
+      ++cursor_y_;
+      cursor_x_ = address_window_.xMin();
+    }
+  }
+
   const Box& bounds() const { return clip_mask_.bounds(); }
 
   DisplayOutput& output_;
@@ -0,0 +1,137 @@
+#include "roo_display/filter/counting_output.h"
+
+namespace roo_display {
+
+namespace {
+
+uint8_t BitsPerPixel(DisplayOutput::ColorFormat::Mode mode) {
+  switch (mode) {
+    case DisplayOutput::ColorFormat::kModeArgb8888:
+    case DisplayOutput::ColorFormat::kModeRgba8888:
+      return 32;
+    case DisplayOutput::ColorFormat::kModeRgb888:
+    case DisplayOutput::ColorFormat::kModeArgb6666:
+      return 24;
+    case DisplayOutput::ColorFormat::kModeArgb4444:
+    case DisplayOutput::ColorFormat::kModeRgb565:
+    case DisplayOutput::ColorFormat::kModeGrayAlpha8:
+      return 16;
+    case DisplayOutput::ColorFormat::kModeGrayscale8:
+    case DisplayOutput::ColorFormat::kModeAlpha8:
+    case DisplayOutput::ColorFormat::kModeIndexed8:
+      return 8;
+    case DisplayOutput::ColorFormat::kModeGrayscale4:
+    case DisplayOutput::ColorFormat::kModeAlpha4:
+    case DisplayOutput::ColorFormat::kModeIndexed4:
+      return 4;
+    case DisplayOutput::ColorFormat::kModeIndexed2:
+      return 2;
+    case DisplayOutput::ColorFormat::kModeMonochrome:
+    case DisplayOutput::ColorFormat::kModeIndexed1:
+      return 1;
+    default:
+      // Unknown; assume the most common case.
+      return 16;
+  }
+}
+
+}  // namespace
+
+CountingOutput::CountingOutput(DisplayOutput& output,
+                               uint8_t address_window_bytes)
+    : output_(output),
+      address_window_bytes_(address_window_bytes),
+      bits_per_pixel_(BitsPerPixel(output.getColorFormat().mode())) {
+  reset();
+}
+
+void CountingOutput::reset() {
+  counters_ = Counters{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+}
+
+void CountingOutput::setAddress(uint16_t x0, uint16_t y0, uint16_t x1,
+                                uint16_t y1, BlendingMode blending_mode) {
+  ++counters_.set_address_calls;
+  countWindow();
+  output_.setAddress(x0, y0, x1, y1, blending_mode);
+}
+
+void CountingOutput::write(Color* color, uint32_t pixel_count) {
+  ++counters_.write_calls;
+  countPixels(pixel_count);
+  output_.write(color, pixel_count);
+}
+
+void CountingOutput::fill(Color color, uint32_t pixel_count) {
+  ++counters_.fill_calls;
+  countPixels(pixel_count);
+  output_.fill(color, pixel_count);
+}
+
+void CountingOutput::writePixels(BlendingMode blending_mode, Color* color,
+                                 int16_t* x, int16_t* y,
+                                 uint16_t pixel_count) {
+  ++counters_.write_pixels_calls;
+  countIndividualPixels(pixel_count);
+  output_.writePixels(blending_mode, color, x, y, pixel_count);
+}
+
+void CountingOutput::fillPixels(BlendingMode blending_mode, Color color,
+                                int16_t* x, int16_t* y, uint16_t pixel_count) {
+  ++counters_.fill_pixels_calls;
+  countIndividualPixels(pixel_count);
+  output_.fillPixels(blending_mode, color, x, y, pixel_count);
+}
+
+void CountingOutput::writeRects(BlendingMode blending_mode, Color* color,
+                                int16_t* x0, int16_t* y0, int16_t* x1,
+                                int16_t* y1, uint16_t count) {
+  ++counters_.write_rects_calls;
+  for (uint16_t i = 0; i < count; ++i) {
+    countRect(x0[i], y0[i], x1[i], y1[i]);
+  }
+  output_.writeRects(blending_mode, color, x0, y0, x1, y1, count);
+}
+
+void CountingOutput::fillRects(BlendingMode blending_mode, Color color,
+                               int16_t* x0, int16_t* y0, int16_t* x1,
+                               int16_t* y1, uint16_t count) {
+  ++counters_.fill_rects_calls;
+  for (uint16_t i = 0; i < count; ++i) {
+    countRect(x0[i], y0[i], x1[i], y1[i]);
+  }
+  output_.fillRects(blending_mode, color, x0, y0, x1, y1, count);
+}
+
+void CountingOutput::drawDirectRect(const roo::byte* data,
+                                    size_t row_width_bytes, int16_t src_x0,
+                                    int16_t src_y0, int16_t src_x1,
+                                    int16_t src_y1, int16_t dst_x0,
+                                    int16_t dst_y0) {
+  ++counters_.draw_direct_rect_calls;
+  countRect(src_x0, src_y0, src_x1, src_y1);
+  output_.drawDirectRect(data, row_width_bytes, src_x0, src_y0, src_x1, src_y1,
+                         dst_x0, dst_y0);
+}
+
+void CountingOutput::drawDirectRectAsync(const roo::byte* data,
+                                         size_t row_width_bytes,
+                                         int16_t src_x0, int16_t src_y0,
+                                         int16_t src_x1, int16_t src_y1,
+                                         int16_t dst_x0, int16_t dst_y0) {
+  ++counters_.draw_direct_rect_calls;
+  countRect(src_x0, src_y0, src_x1, src_y1);
+  output_.drawDirectRectAsync(data, row_width_bytes, src_x0, src_y0, src_x1,
+                              src_y1, dst_x0, dst_y0);
+}
+
+void CountingOutput::blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                              int16_t src_y1, int16_t dst_x0, int16_t dst_y0) {
+  // The copy happens within the device, so only the command itself goes over
+  // the bus.
+  ++counters_.blit_copy_calls;
+  countWindow();
+  output_.blitCopy(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+}
+
+}  // namespace roo_display
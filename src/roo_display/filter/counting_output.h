@@ -0,0 +1,133 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include "roo_display/core/device.h"
+
+namespace roo_display {
+
+/// Pass-through filtering device that counts the calls made to the underlying
+/// output, and estimates the resulting bus traffic.
+///
+/// Intended for benchmarks and tests: wrap a device (e.g. an
+/// `OffscreenDevice`) to find out how many primitive operations, and how many
+/// bytes on a typical SPI/parallel bus, a given drawing operation costs.
+///
+/// The bus model assumes a MIPI-DCS-style controller: every address window
+/// costs `address_window_bytes` (by default, 11 bytes: CASET and RASET with
+/// two 16-bit coordinates each, plus RAMWR), and every pixel costs the number
+/// of bits per pixel of the device's color format (rounded up to full bytes for
+/// individually addressed pixels). Individually addressed pixels (as in
+/// `writePixels()` and `fillPixels()`) each cost a separate address window.
+class CountingOutput : public DisplayOutput {
+ public:
+  /// Counters accumulated since construction or the last `reset()`.
+  struct Counters {
+    uint32_t set_address_calls;
+    uint32_t write_calls;
+    uint32_t fill_calls;
+    uint32_t write_pixels_calls;
+    uint32_t fill_pixels_calls;
+    uint32_t write_rects_calls;
+    uint32_t fill_rects_calls;
+    uint32_t draw_direct_rect_calls;
+    uint32_t blit_copy_calls;
+
+    /// Number of address windows (explicit, or implied by the per-pixel and
+    /// per-rect methods).
+    uint64_t address_windows;
+
+    /// Number of pixels written.
+    uint64_t pixels;
+
+    /// Estimated number of bytes that would be sent over the bus.
+    uint64_t bus_bytes;
+  };
+
+  /// Create a counting filter wrapping the specified output.
+  CountingOutput(DisplayOutput& output, uint8_t address_window_bytes = 11);
+
+  CountingOutput(const CountingOutput&) = delete;
+  CountingOutput& operator=(const CountingOutput&) = delete;
+
+  const Counters& counters() const { return counters_; }
+
+  /// Zeroes all counters.
+  void reset();
+
+  void begin() override { output_.begin(); }
+  void end() override { output_.end(); }
+  void flush() override { output_.flush(); }
+
+  void setAddress(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                  BlendingMode blending_mode) override;
+
+  void write(Color* color, uint32_t pixel_count) override;
+
+  void fill(Color color, uint32_t pixel_count) override;
+
+  void writePixels(BlendingMode blending_mode, Color* color, int16_t* x,
+                   int16_t* y, uint16_t pixel_count) override;
+
+  void fillPixels(BlendingMode blending_mode, Color color, int16_t* x,
+                  int16_t* y, uint16_t pixel_count) override;
+
+  void writeRects(BlendingMode blending_mode, Color* color, int16_t* x0,
+                  int16_t* y0, int16_t* x1, int16_t* y1,
+                  uint16_t count) override;
+
+  void fillRects(BlendingMode blending_mode, Color color, int16_t* x0,
+                 int16_t* y0, int16_t* x1, int16_t* y1,
+                 uint16_t count) override;
+
+  const ColorFormat& getColorFormat() const override {
+    return output_.getColorFormat();
+  }
+
+  const Capabilities& getCapabilities() const override {
+    return output_.getCapabilities();
+  }
+
+  void drawDirectRect(const roo::byte* data, size_t row_width_bytes,
+                      int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                      int16_t src_y1, int16_t dst_x0, int16_t dst_y0) override;
+
+  void drawDirectRectAsync(const roo::byte* data, size_t row_width_bytes,
+                           int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                           int16_t src_y1, int16_t dst_x0,
+                           int16_t dst_y0) override;
+
+  void blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1, int16_t src_y1,
+                int16_t dst_x0, int16_t dst_y0) override;
+
+ private:
+  void countWindow() {
+    ++counters_.address_windows;
+    counters_.bus_bytes += address_window_bytes_;
+  }
+
+  void countPixels(uint64_t count) {
+    counters_.pixels += count;
+    counters_.bus_bytes += (count * bits_per_pixel_ + 7) / 8;
+  }
+
+  // Each pixel gets its own address window.
+  void countIndividualPixels(uint64_t count) {
+    counters_.address_windows += count;
+    counters_.pixels += count;
+    counters_.bus_bytes +=
+        count * (address_window_bytes_ + (bits_per_pixel_ + 7) / 8);
+  }
+
+  void countRect(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    countWindow();
+    countPixels((uint64_t)(x1 - x0 + 1) * (y1 - y0 + 1));
+  }
+
+  DisplayOutput& output_;
+  uint8_t address_window_bytes_;
+  uint8_t bits_per_pixel_;
+  Counters counters_;
+};
+
+}  // namespace roo_display
@@ -0,0 +1,365 @@
+#include "roo_display/filter/diffing_framebuffer_device.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "roo_display/color/blending.h"
+#include "roo_display/color/color_modes.h"
+#include "roo_display/color/named.h"
+#include "roo_logging.h"
+
+namespace roo_display {
+
+namespace {
+
+// Resolves the source color against the destination, in the way that the
+// Rgb565 device would store it.
+inline uint16_t Resolve(BlendingMode mode, Color dst, Color src) {
+  return Rgb565().fromArgbColor(ApplyBlending(mode, dst, src));
+}
+
+}  // namespace
+
+DiffingFramebufferDevice::DiffingFramebufferDevice(DisplayDevice& device,
+                                                   uint8_t max_gap)
+    : DisplayDevice(device.raw_width(), device.raw_height()),
+      device_(device),
+      max_gap_(max_gap),
+      width_(device.raw_width()),
+      height_(device.raw_height()),
+      shadow_(new uint16_t[(uint32_t)device.raw_width() *
+                           device.raw_height()]),
+      known_(new uint32_t[((uint32_t)device.raw_width() * device.raw_height() +
+                           31) /
+                          32]),
+      row_(new Color[std::max(device.raw_width(), device.raw_height())]),
+      src_row_(new Color[std::max(device.raw_width(), device.raw_height())]),
+      bgcolor_(color::Black),
+      window_(0, 0, -1, -1),
+      cursor_x_(0),
+      cursor_y_(0),
+      blending_mode_(BlendingMode::kSource),
+      run_x0_(-1),
+      run_x1_(-1),
+      run_y_(-1),
+      scan_x_(-1),
+      has_rect_(false),
+      rect_x0_(0),
+      rect_y0_(0),
+      rect_x1_(0),
+      rect_y1_(0),
+      rect_color_(color::Transparent) {
+  CHECK_EQ(device.getColorFormat().mode(), ColorFormat::kModeRgb565)
+      << "DiffingFramebufferDevice requires an Rgb565 device";
+  invalidate();
+  setOrientation(device.orientation());
+}
+
+void DiffingFramebufferDevice::setPrefilled(Color color) {
+  flushPending();
+  uint16_t raw = Rgb565().fromArgbColor(color);
+  uint32_t pixel_count = (uint32_t)width_ * height_;
+  std::fill(&shadow_[0], &shadow_[pixel_count], raw);
+  memset(known_.get(), 0xFF, ((pixel_count + 31) / 32) * sizeof(uint32_t));
+}
+
+void DiffingFramebufferDevice::invalidate() {
+  flushPending();
+  uint32_t pixel_count = (uint32_t)width_ * height_;
+  memset(known_.get(), 0, ((pixel_count + 31) / 32) * sizeof(uint32_t));
+}
+
+void DiffingFramebufferDevice::invalidateRect(const Box& rect) {
+  flushPending();
+  Box box = Box::Intersect(rect, Box(0, 0, width_ - 1, height_ - 1));
+  if (box.empty()) return;
+  for (int16_t y = box.yMin(); y <= box.yMax(); ++y) {
+    uint32_t offset = (uint32_t)y * width_ + box.xMin();
+    for (int16_t x = box.xMin(); x <= box.xMax(); ++x) {
+      setKnown(offset++, false);
+    }
+  }
+}
+
+void DiffingFramebufferDevice::init() {
+  device_.init();
+  invalidate();
+}
+
+void DiffingFramebufferDevice::orientationUpdated() {
+  flushPending();
+  device_.setOrientation(orientation());
+  width_ = effective_width();
+  height_ = effective_height();
+  // The shadow is laid out in the current orientation; rather than
+  // transposing it, start over.
+  invalidate();
+}
+
+void DiffingFramebufferDevice::setBgColorHint(Color bgcolor) {
+  bgcolor_ = bgcolor;
+  device_.setBgColorHint(bgcolor);
+}
+
+void DiffingFramebufferDevice::end() {
+  flushPending();
+  device_.end();
+}
+
+void DiffingFramebufferDevice::flush() {
+  flushPending();
+  device_.flush();
+}
+
+void DiffingFramebufferDevice::setAddress(uint16_t x0, uint16_t y0,
+                                          uint16_t x1, uint16_t y1,
+                                          BlendingMode mode) {
+  DCHECK_LT(x1, width_);
+  DCHECK_LT(y1, height_);
+  window_ = Box(x0, y0, x1, y1);
+  cursor_x_ = x0;
+  cursor_y_ = y0;
+  blending_mode_ = mode;
+}
+
+void DiffingFramebufferDevice::write(Color* color, uint32_t pixel_count) {
+  while (pixel_count > 0) {
+    DCHECK_LE(cursor_y_, window_.yMax());
+    int16_t n = (int16_t)std::min<uint32_t>(pixel_count,
+                                            window_.xMax() - cursor_x_ + 1);
+    processSegment(cursor_x_, cursor_y_, color, color::Transparent, n,
+                   blending_mode_);
+    color += n;
+    pixel_count -= n;
+    cursor_x_ += n;
+    if (cursor_x_ > window_.xMax()) {
+      cursor_x_ = window_.xMin();
+      ++cursor_y_;
+    }
+  }
+}
+
+void DiffingFramebufferDevice::fill(Color color, uint32_t pixel_count) {
+  while (pixel_count > 0) {
+    DCHECK_LE(cursor_y_, window_.yMax());
+    int16_t n = (int16_t)std::min<uint32_t>(pixel_count,
+                                            window_.xMax() - cursor_x_ + 1);
+    processSegment(cursor_x_, cursor_y_, nullptr, color, n, blending_mode_);
+    pixel_count -= n;
+    cursor_x_ += n;
+    if (cursor_x_ > window_.xMax()) {
+      cursor_x_ = window_.xMin();
+      ++cursor_y_;
+    }
+  }
+}
+
+void DiffingFramebufferDevice::writeRects(BlendingMode mode, Color* color,
+                                          int16_t* x0, int16_t* y0,
+                                          int16_t* x1, int16_t* y1,
+                                          uint16_t count) {
+  while (count-- > 0) {
+    for (int16_t y = *y0; y <= *y1; ++y) {
+      processSegment(*x0, y, nullptr, *color, *x1 - *x0 + 1, mode);
+    }
+    ++color;
+    ++x0;
+    ++y0;
+    ++x1;
+    ++y1;
+  }
+}
+
+void DiffingFramebufferDevice::fillRects(BlendingMode mode, Color color,
+                                         int16_t* x0, int16_t* y0, int16_t* x1,
+                                         int16_t* y1, uint16_t count) {
+  while (count-- > 0) {
+    for (int16_t y = *y0; y <= *y1; ++y) {
+      processSegment(*x0, y, nullptr, color, *x1 - *x0 + 1, mode);
+    }
+    ++x0;
+    ++y0;
+    ++x1;
+    ++y1;
+  }
+}
+
+void DiffingFramebufferDevice::writePixels(BlendingMode mode, Color* color,
+                                           int16_t* x, int16_t* y,
+                                           uint16_t pixel_count) {
+  processPixels(mode, color, color::Transparent, x, y, pixel_count);
+}
+
+void DiffingFramebufferDevice::fillPixels(BlendingMode mode, Color color,
+                                          int16_t* x, int16_t* y,
+                                          uint16_t pixel_count) {
+  processPixels(mode, nullptr, color, x, y, pixel_count);
+}
+
+void DiffingFramebufferDevice::drawDirectRect(
+    const roo::byte* data, size_t row_width_bytes, int16_t src_x0,
+    int16_t src_y0, int16_t src_x1, int16_t src_y1, int16_t dst_x0,
+    int16_t dst_y0) {
+  if (src_x1 < src_x0 || src_y1 < src_y0) return;
+  const ColorFormat& format = device_.getColorFormat();
+  int16_t width = src_x1 - src_x0 + 1;
+  for (int16_t y = src_y0; y <= src_y1; ++y) {
+    format.decode(data, row_width_bytes, src_x0, y, src_x1, y, src_row_.get());
+    processSegment(dst_x0, dst_y0 + (y - src_y0), src_row_.get(),
+                   color::Transparent, width, BlendingMode::kSource);
+  }
+}
+
+void DiffingFramebufferDevice::blitCopy(int16_t src_x0, int16_t src_y0,
+                                        int16_t src_x1, int16_t src_y1,
+                                        int16_t dst_x0, int16_t dst_y0) {
+  flushPending();
+  device_.blitCopy(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+  if (!device_.getCapabilities().supportsBlitCopy()) return;
+  int16_t width = src_x1 - src_x0 + 1;
+  int16_t height = src_y1 - src_y0 + 1;
+  if (width <= 0 || height <= 0) return;
+  // Iterate in the direction that keeps overlapping areas intact.
+  bool bottom_up = dst_y0 > src_y0;
+  for (int16_t i = 0; i < height; ++i) {
+    int16_t row = bottom_up ? height - 1 - i : i;
+    uint32_t from = (uint32_t)(src_y0 + row) * width_ + src_x0;
+    uint32_t to = (uint32_t)(dst_y0 + row) * width_ + dst_x0;
+    memmove(&shadow_[to], &shadow_[from], width * sizeof(uint16_t));
+    if (to > from) {
+      for (int16_t j = width - 1; j >= 0; --j) {
+        setKnown(to + j, isKnown(from + j));
+      }
+    } else {
+      for (int16_t j = 0; j < width; ++j) {
+        setKnown(to + j, isKnown(from + j));
+      }
+    }
+  }
+}
+
+void DiffingFramebufferDevice::processSegment(int16_t x, int16_t y,
+                                              const Color* src, Color color,
+                                              int16_t count,
+                                              BlendingMode mode) {
+  DCHECK_GE(x, 0);
+  DCHECK_GE(y, 0);
+  DCHECK_LE(x + count, width_);
+  DCHECK_LT(y, height_);
+  if (run_x0_ >= 0 && (y != run_y_ || x != scan_x_)) {
+    // Not contiguous with the current run; gap pixels can't be re-sent.
+    flushRun();
+  }
+  uint32_t offset = (uint32_t)y * width_ + x;
+  int16_t end = x + count;
+  for (; x < end; ++x, ++offset) {
+    Color c = (src != nullptr) ? *src++ : color;
+    uint16_t old_raw = shadow_[offset];
+    bool known = isKnown(offset);
+    uint16_t raw =
+        Resolve(mode, known ? Rgb565().toArgbColor(old_raw) : bgcolor_, c);
+    row_[x] = Rgb565().toArgbColor(raw);
+    if (known && raw == old_raw) continue;
+    shadow_[offset] = raw;
+    if (!known) setKnown(offset, true);
+    if (run_x0_ >= 0 && x - run_x1_ - 1 <= max_gap_) {
+      run_x1_ = x;
+    } else {
+      flushRun();
+      run_x0_ = x;
+      run_x1_ = x;
+      run_y_ = y;
+    }
+  }
+  scan_x_ = end;
+}
+
+void DiffingFramebufferDevice::processPixels(BlendingMode mode,
+                                             const Color* src, Color color,
+                                             const int16_t* x,
+                                             const int16_t* y,
+                                             uint16_t pixel_count) {
+  flushPending();
+  static constexpr int kBatchSize = 64;
+  Color out_color[kBatchSize];
+  int16_t out_x[kBatchSize];
+  int16_t out_y[kBatchSize];
+  int out_count = 0;
+  while (pixel_count-- > 0) {
+    DCHECK_GE(*x, 0);
+    DCHECK_GE(*y, 0);
+    DCHECK_LT(*x, width_);
+    DCHECK_LT(*y, height_);
+    Color c = (src != nullptr) ? *src++ : color;
+    uint32_t offset = (uint32_t)*y * width_ + *x;
+    uint16_t old_raw = shadow_[offset];
+    bool known = isKnown(offset);
+    uint16_t raw =
+        Resolve(mode, known ? Rgb565().toArgbColor(old_raw) : bgcolor_, c);
+    if (!known || raw != old_raw) {
+      shadow_[offset] = raw;
+      setKnown(offset, true);
+      out_color[out_count] = Rgb565().toArgbColor(raw);
+      out_x[out_count] = *x;
+      out_y[out_count] = *y;
+      if (++out_count == kBatchSize) {
+        device_.writePixels(BlendingMode::kSource, out_color, out_x, out_y,
+                            out_count);
+        out_count = 0;
+      }
+    }
+    ++x;
+    ++y;
+  }
+  if (out_count > 0) {
+    device_.writePixels(BlendingMode::kSource, out_color, out_x, out_y,
+                        out_count);
+  }
+}
+
+void DiffingFramebufferDevice::flushRun() {
+  if (run_x0_ < 0) return;
+  int16_t x0 = run_x0_;
+  int16_t x1 = run_x1_;
+  int16_t y = run_y_;
+  run_x0_ = -1;
+  Color color = row_[x0];
+  bool uniform = true;
+  for (int16_t x = x0 + 1; x <= x1; ++x) {
+    if (row_[x] != color) {
+      uniform = false;
+      break;
+    }
+  }
+  if (uniform) {
+    if (has_rect_ && rect_x0_ == x0 && rect_x1_ == x1 && rect_y1_ + 1 == y &&
+        rect_color_ == color) {
+      ++rect_y1_;
+      return;
+    }
+    flushRect();
+    has_rect_ = true;
+    rect_x0_ = x0;
+    rect_y0_ = y;
+    rect_x1_ = x1;
+    rect_y1_ = y;
+    rect_color_ = color;
+    return;
+  }
+  flushRect();
+  device_.setAddress(x0, y, x1, y, BlendingMode::kSource);
+  device_.write(&row_[x0], x1 - x0 + 1);
+}
+
+void DiffingFramebufferDevice::flushRect() {
+  if (!has_rect_) return;
+  has_rect_ = false;
+  int16_t x0 = rect_x0_;
+  int16_t y0 = rect_y0_;
+  int16_t x1 = rect_x1_;
+  int16_t y1 = rect_y1_;
+  device_.fillRects(BlendingMode::kSource, rect_color_, &x0, &y0, &x1, &y1, 1);
+}
+
+}  // namespace roo_display
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include <memory>
+
+#include "roo_display/color/color.h"
+#include "roo_display/core/box.h"
+#include "roo_display/core/device.h"
+
+namespace roo_display {
+
+/// Display device wrapper that keeps a full shadow framebuffer of the panel,
+/// and forwards to the underlying device only the pixels that actually change.
+///
+/// Unlike `BackgroundFillOptimizer`, which only tracks solid fills from a
+/// small palette at 4x4 granularity, this wrapper compares every pixel, so it
+/// also eliminates redundant redraws of anti-aliased text, images, and
+/// gradients. The price is RAM: 2 bytes per pixel for the shadow (plus 1 bit
+/// per pixel of bookkeeping), i.e. about 160 KB for a 320x240 display. It is
+/// meant for boards with PSRAM.
+///
+/// Incoming pixels are resolved against the shadow contents (so that alpha
+/// blending uses the actual previous pixel values), and compared with them.
+/// Changed pixels are forwarded as horizontal runs; runs in the same row
+/// separated by at most `max_gap` unchanged pixels are coalesced, since
+/// re-sending a few pixels is cheaper than opening a new address window.
+/// Uniformly colored runs that line up in consecutive rows are further merged
+/// into rectangles. Everything is forwarded using `BlendingMode::kSource`.
+///
+/// Initially, the panel contents are unknown, and every pixel is forwarded
+/// the first time it is written (blended over the background color hint, as
+/// address-window devices do). Use `setPrefilled()` if the contents are known
+/// up front (e.g. the panel has just been cleared). Orientation changes
+/// invalidate the shadow.
+///
+/// The underlying device must use the Rgb565 color mode.
+class DiffingFramebufferDevice : public DisplayDevice {
+ public:
+  /// Default maximum number of unchanged pixels between two changed runs in a
+  /// row that get coalesced. With Rgb565, a new address window costs about as
+  /// much as 5 pixels.
+  static constexpr uint8_t kDefaultMaxGap = 5;
+
+  /// Create a wrapper device. Allocates the shadow framebuffer.
+  DiffingFramebufferDevice(DisplayDevice& device,
+                           uint8_t max_gap = kDefaultMaxGap);
+
+  DiffingFramebufferDevice(const DiffingFramebufferDevice&) = delete;
+  DiffingFramebufferDevice& operator=(const DiffingFramebufferDevice&) =
+      delete;
+
+  /// Declares that the entire panel is currently filled with the specified
+  /// color.
+  void setPrefilled(Color color);
+
+  /// Forgets the shadow contents, so that all subsequent writes are
+  /// forwarded. Call it when the panel has been drawn to bypassing this
+  /// device.
+  void invalidate();
+
+  /// Forgets the shadow contents within the specified rectangle.
+  void invalidateRect(const Box& rect);
+
+  void init() override;
+
+  void orientationUpdated() override;
+
+  void setBgColorHint(Color bgcolor) override;
+
+  void begin() override { device_.begin(); }
+
+  void end() override;
+
+  void flush() override;
+
+  void setAddress(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                  BlendingMode mode) override;
+
+  void write(Color* color, uint32_t pixel_count) override;
+
+  void fill(Color color, uint32_t pixel_count) override;
+
+  void writeRects(BlendingMode mode, Color* color, int16_t* x0, int16_t* y0,
+                  int16_t* x1, int16_t* y1, uint16_t count) override;
+
+  void fillRects(BlendingMode mode, Color color, int16_t* x0, int16_t* y0,
+                 int16_t* x1, int16_t* y1, uint16_t count) override;
+
+  void writePixels(BlendingMode mode, Color* color, int16_t* x, int16_t* y,
+                   uint16_t pixel_count) override;
+
+  void fillPixels(BlendingMode mode, Color color, int16_t* x, int16_t* y,
+                  uint16_t pixel_count) override;
+
+  void drawDirectRect(const roo::byte* data, size_t row_width_bytes,
+                      int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                      int16_t src_y1, int16_t dst_x0, int16_t dst_y0) override;
+
+  void blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1, int16_t src_y1,
+                int16_t dst_x0, int16_t dst_y0) override;
+
+  const ColorFormat& getColorFormat() const override {
+    return device_.getColorFormat();
+  }
+
+  const Capabilities& getCapabilities() const override {
+    return device_.getCapabilities();
+  }
+
+ private:
+  bool isKnown(uint32_t offset) const {
+    return (known_[offset >> 5] >> (offset & 31)) & 1;
+  }
+
+  void setKnown(uint32_t offset, bool known) {
+    if (known) {
+      known_[offset >> 5] |= (1u << (offset & 31));
+    } else {
+      known_[offset >> 5] &= ~(1u << (offset & 31));
+    }
+  }
+
+  // Resolves `count` pixels in row `y`, starting at `x`, against the shadow,
+  // and extends or emits changed runs. Takes colors from `src`, or uses
+  // `color` for all pixels if `src` is nullptr.
+  void processSegment(int16_t x, int16_t y, const Color* src, Color color,
+                      int16_t count, BlendingMode mode);
+
+  // Resolves individually addressed pixels against the shadow, and forwards
+  // the changed ones. Takes colors from `src`, or uses `color` for all pixels
+  // if `src` is nullptr.
+  void processPixels(BlendingMode mode, const Color* src, Color color,
+                     const int16_t* x, const int16_t* y, uint16_t pixel_count);
+
+  // Forwards the current run (if any), or merges it into the pending
+  // rectangle.
+  void flushRun();
+
+  // Forwards the pending rectangle (if any).
+  void flushRect();
+
+  void flushPending() {
+    flushRun();
+    flushRect();
+  }
+
+  DisplayDevice& device_;
+  uint8_t max_gap_;
+
+  // Dimensions in the current orientation.
+  int16_t width_;
+  int16_t height_;
+
+  // Rgb565 shadow of the panel, row-major in the current orientation.
+  std::unique_ptr<uint16_t[]> shadow_;
+
+  // One bit per pixel, indicating whether the shadow pixel is known to match
+  // the panel.
+  std::unique_ptr<uint32_t[]> known_;
+
+  // Resolved colors of the row currently being scanned, indexed by x.
+  std::unique_ptr<Color[]> row_;
+
+  // Decoded source row, used by drawDirectRect().
+  std::unique_ptr<Color[]> src_row_;
+
+  Color bgcolor_;
+
+  // Current address window, and the write cursor within it.
+  Box window_;
+  int16_t cursor_x_;
+  int16_t cursor_y_;
+  BlendingMode blending_mode_;
+
+  // The run of changed pixels [run_x0_, run_x1_] in row run_y_, or run_x0_ <
+  // 0 if none. Pixels in row_ are valid between run_x0_ and scan_x_ - 1.
+  int16_t run_x0_;
+  int16_t run_x1_;
+  int16_t run_y_;
+  int16_t scan_x_;
+
+  // Uniformly colored rectangle, accumulated from runs in consecutive rows.
+  bool has_rect_;
+  int16_t rect_x0_;
+  int16_t rect_y0_;
+  int16_t rect_x1_;
+  int16_t rect_y1_;
+  Color rect_color_;
+};
+
+}  // namespace roo_display
@@ -0,0 +1,293 @@
+#include "roo_display/filter/rect_batching_output.h"
+
+#include <algorithm>
+
+namespace roo_display {
+
+namespace {
+
+// How many later commands to check when looking for an occluder.
+static constexpr uint16_t kCullWindow = 8;
+
+// Maximum number of tiles used to track the ordering constraints.
+static constexpr uint16_t kLevelTiles = 1024;
+
+// Maximum number of rectangles passed to a single fillRects() / writeRects().
+static constexpr uint16_t kEmitBatch = 32;
+
+// Whether drawing the color fully replaces the previous contents.
+inline bool IsOpaqueReplace(BlendingMode mode, Color color) {
+  return mode == BlendingMode::kSource ||
+         ((mode == BlendingMode::kSourceOver ||
+           mode == BlendingMode::kSourceOverOpaque) &&
+          color.isOpaque());
+}
+
+// Whether drawing the color leaves the previous contents unchanged.
+inline bool IsNoOp(BlendingMode mode, Color color) {
+  return mode == BlendingMode::kDestination ||
+         ((mode == BlendingMode::kSourceOver ||
+           mode == BlendingMode::kSourceOverOpaque) &&
+          color.a() == 0);
+}
+
+// The commands are private to RectBatchingOutput; hence the templates.
+template <typename Command>
+inline bool Contains(const Command& outer, const Command& inner) {
+  return outer.x0 <= inner.x0 && outer.x1 >= inner.x1 &&
+         outer.y0 <= inner.y0 && outer.y1 >= inner.y1;
+}
+
+// Tries to extend `target` to also cover `c`, which must come right after it
+// in the row-major or the column-major order. Succeeds if both have the same
+// color and blending mode, and if they abut, forming a rectangle.
+template <typename Command>
+inline bool TryMerge(Command& target, const Command& c) {
+  if (target.color != c.color || target.blending_mode != c.blending_mode) {
+    return false;
+  }
+  if (target.y0 == c.y0 && target.y1 == c.y1 && target.x1 + 1 == c.x0) {
+    target.x1 = c.x1;
+    return true;
+  }
+  if (target.x0 == c.x0 && target.x1 == c.x1 && target.y1 + 1 == c.y0) {
+    target.y1 = c.y1;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+RectBatchingOutput::RectBatchingOutput(DisplayOutput& output,
+                                       uint16_t capacity)
+    : output_(output),
+      capacity_(capacity),
+      size_(0),
+      queue_(new Command[capacity]),
+      levels_(new uint16_t[kLevelTiles]) {}
+
+void RectBatchingOutput::end() {
+  flushQueue();
+  output_.end();
+}
+
+void RectBatchingOutput::flush() {
+  flushQueue();
+  output_.flush();
+}
+
+void RectBatchingOutput::setAddress(uint16_t x0, uint16_t y0, uint16_t x1,
+                                    uint16_t y1, BlendingMode blending_mode) {
+  flushQueue();
+  output_.setAddress(x0, y0, x1, y1, blending_mode);
+}
+
+void RectBatchingOutput::writePixels(BlendingMode blending_mode, Color* color,
+                                     int16_t* x, int16_t* y,
+                                     uint16_t pixel_count) {
+  for (uint16_t i = 0; i < pixel_count; ++i) {
+    enqueue(blending_mode, color[i], x[i], y[i], x[i], y[i]);
+  }
+}
+
+void RectBatchingOutput::fillPixels(BlendingMode blending_mode, Color color,
+                                    int16_t* x, int16_t* y,
+                                    uint16_t pixel_count) {
+  for (uint16_t i = 0; i < pixel_count; ++i) {
+    enqueue(blending_mode, color, x[i], y[i], x[i], y[i]);
+  }
+}
+
+void RectBatchingOutput::writeRects(BlendingMode blending_mode, Color* color,
+                                    int16_t* x0, int16_t* y0, int16_t* x1,
+                                    int16_t* y1, uint16_t count) {
+  for (uint16_t i = 0; i < count; ++i) {
+    enqueue(blending_mode, color[i], x0[i], y0[i], x1[i], y1[i]);
+  }
+}
+
+void RectBatchingOutput::fillRects(BlendingMode blending_mode, Color color,
+                                   int16_t* x0, int16_t* y0, int16_t* x1,
+                                   int16_t* y1, uint16_t count) {
+  for (uint16_t i = 0; i < count; ++i) {
+    enqueue(blending_mode, color, x0[i], y0[i], x1[i], y1[i]);
+  }
+}
+
+void RectBatchingOutput::drawDirectRect(const roo::byte* data,
+                                        size_t row_width_bytes,
+                                        int16_t src_x0, int16_t src_y0,
+                                        int16_t src_x1, int16_t src_y1,
+                                        int16_t dst_x0, int16_t dst_y0) {
+  flushQueue();
+  output_.drawDirectRect(data, row_width_bytes, src_x0, src_y0, src_x1, src_y1,
+                         dst_x0, dst_y0);
+}
+
+void RectBatchingOutput::drawDirectRectAsync(const roo::byte* data,
+                                             size_t row_width_bytes,
+                                             int16_t src_x0, int16_t src_y0,
+                                             int16_t src_x1, int16_t src_y1,
+                                             int16_t dst_x0, int16_t dst_y0) {
+  flushQueue();
+  output_.drawDirectRectAsync(data, row_width_bytes, src_x0, src_y0, src_x1,
+                              src_y1, dst_x0, dst_y0);
+}
+
+void RectBatchingOutput::blitCopy(int16_t src_x0, int16_t src_y0,
+                                  int16_t src_x1, int16_t src_y1,
+                                  int16_t dst_x0, int16_t dst_y0) {
+  flushQueue();
+  output_.blitCopy(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+}
+
+void RectBatchingOutput::enqueue(BlendingMode blending_mode, Color color,
+                                 int16_t x0, int16_t y0, int16_t x1,
+                                 int16_t y1) {
+  if (IsNoOp(blending_mode, color)) return;
+  if (size_ == capacity_) flushQueue();
+  queue_[size_++] = Command{x0, y0, x1, y1, color, blending_mode, 0};
+}
+
+void RectBatchingOutput::flushQueue() {
+  if (size_ == 0) return;
+  cull();
+  assignLevels();
+  // Sorting by rows brings together the rectangles that may merge
+  // horizontally, and sorting by columns, those that may merge vertically.
+  std::sort(&queue_[0], &queue_[size_],
+            [](const Command& a, const Command& b) {
+              return a.level != b.level ? a.level < b.level
+                     : a.y0 != b.y0     ? a.y0 < b.y0
+                                        : a.x0 < b.x0;
+            });
+  merge();
+  std::sort(&queue_[0], &queue_[size_],
+            [](const Command& a, const Command& b) {
+              return a.level != b.level ? a.level < b.level
+                     : a.x0 != b.x0     ? a.x0 < b.x0
+                                        : a.y0 < b.y0;
+            });
+  merge();
+  emit();
+  size_ = 0;
+}
+
+void RectBatchingOutput::cull() {
+  // Walks backwards, collecting the survivors at the end of the queue, so
+  // that each command only needs to be checked against the later survivors.
+  // (If a later command got culled, its occluder is a survivor that covers
+  // it, too.) Only the nearest survivors are checked, to bound the cost.
+  uint16_t out = size_;
+  for (int i = size_ - 1; i >= 0; --i) {
+    const Command& c = queue_[i];
+    bool hidden = false;
+    uint16_t limit = std::min<uint16_t>(size_, out + kCullWindow);
+    for (uint16_t j = out; j < limit; ++j) {
+      const Command& o = queue_[j];
+      if (Contains(o, c) && IsOpaqueReplace(o.blending_mode, o.color)) {
+        hidden = true;
+        break;
+      }
+    }
+    if (!hidden) queue_[--out] = c;
+  }
+  // The survivors are now at [out, size_), in the original order.
+  if (out > 0) {
+    std::copy(&queue_[out], &queue_[size_], &queue_[0]);
+    size_ -= out;
+  }
+}
+
+void RectBatchingOutput::assignLevels() {
+  // Divides the bounding box of the commands into at most kLevelTiles tiles,
+  // and records, for each tile, the level above the topmost command that
+  // touched it so far.
+  int16_t bx0 = queue_[0].x0;
+  int16_t by0 = queue_[0].y0;
+  int16_t bx1 = queue_[0].x1;
+  int16_t by1 = queue_[0].y1;
+  for (uint16_t i = 1; i < size_; ++i) {
+    bx0 = std::min(bx0, queue_[i].x0);
+    by0 = std::min(by0, queue_[i].y0);
+    bx1 = std::max(bx1, queue_[i].x1);
+    by1 = std::max(by1, queue_[i].y1);
+  }
+  // The extents can span up to 65536 pixels in each dimension, so the tile
+  // count is computed in 64 bits, to avoid overflow.
+  const int32_t w = bx1 - bx0;
+  const int32_t h = by1 - by0;
+  uint8_t shift = 0;
+  while ((int64_t)((w >> shift) + 1) * ((h >> shift) + 1) > kLevelTiles) {
+    ++shift;
+  }
+  const int16_t cols = ((bx1 - bx0) >> shift) + 1;
+  const int16_t rows = ((by1 - by0) >> shift) + 1;
+  std::fill(&levels_[0], &levels_[cols * rows], 0);
+  for (uint16_t i = 0; i < size_; ++i) {
+    Command& c = queue_[i];
+    const int16_t tx0 = (c.x0 - bx0) >> shift;
+    const int16_t ty0 = (c.y0 - by0) >> shift;
+    const int16_t tx1 = (c.x1 - bx0) >> shift;
+    const int16_t ty1 = (c.y1 - by0) >> shift;
+    uint16_t level = 0;
+    for (int16_t ty = ty0; ty <= ty1; ++ty) {
+      const uint16_t* row = &levels_[ty * cols];
+      for (int16_t tx = tx0; tx <= tx1; ++tx) {
+        level = std::max(level, row[tx]);
+      }
+    }
+    c.level = level;
+    for (int16_t ty = ty0; ty <= ty1; ++ty) {
+      std::fill(&levels_[ty * cols + tx0], &levels_[ty * cols + tx1 + 1],
+                level + 1);
+    }
+  }
+}
+
+void RectBatchingOutput::merge() {
+  // Commands of the same level are disjoint, so after sorting, any two that
+  // can be merged are next to each other.
+  uint16_t out = 0;
+  for (uint16_t i = 0; i < size_; ++i) {
+    const Command& c = queue_[i];
+    if (out > 0 && queue_[out - 1].level == c.level &&
+        TryMerge(queue_[out - 1], c)) {
+      continue;
+    }
+    queue_[out++] = c;
+  }
+  size_ = out;
+}
+
+void RectBatchingOutput::emit() {
+  Color color[kEmitBatch];
+  int16_t x0[kEmitBatch];
+  int16_t y0[kEmitBatch];
+  int16_t x1[kEmitBatch];
+  int16_t y1[kEmitBatch];
+  uint16_t i = 0;
+  while (i < size_) {
+    BlendingMode mode = queue_[i].blending_mode;
+    bool uniform = true;
+    uint16_t n = 0;
+    while (i < size_ && n < kEmitBatch && queue_[i].blending_mode == mode) {
+      const Command& c = queue_[i++];
+      color[n] = c.color;
+      x0[n] = c.x0;
+      y0[n] = c.y0;
+      x1[n] = c.x1;
+      y1[n] = c.y1;
+      uniform &= (c.color == color[0]);
+      ++n;
+    }
+    if (uniform) {
+      output_.fillRects(mode, color[0], x0, y0, x1, y1, n);
+    } else {
+      output_.writeRects(mode, color, x0, y0, x1, y1, n);
+    }
+  }
+}
+
+}  // namespace roo_display
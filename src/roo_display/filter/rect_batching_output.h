@@ -0,0 +1,148 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include <memory>
+
+#include "roo_display/color/blending.h"
+#include "roo_display/color/color.h"
+#include "roo_display/core/device.h"
+
+namespace roo_display {
+
+/// Filtering output that defers rectangle and pixel fills, and sends them to
+/// the underlying output in an optimized form.
+///
+/// Address-window devices pay a fixed cost (setting the window and starting a
+/// RAM write) for every rectangle, and every run of pixels. Layouts that draw
+/// many small rectangles (e.g. grids, tables, and tiled backgrounds) are
+/// dominated by that overhead. This filter queues the calls to
+/// `fillRects()`, `writeRects()`, `fillPixels()`, and `writePixels()` (each
+/// rectangle or pixel becomes a separate command), and when the queue is
+/// flushed:
+///
+/// * drops commands that are fully overdrawn by later opaque commands, and
+///   commands that have no effect (e.g. transparent color with
+///   `BlendingMode::kSourceOver`),
+/// * assigns each command a level: the lowest one above the levels of all
+///   the earlier commands that it (conservatively, at the granularity of a
+///   coarse tile grid) intersects. Commands at the same level are disjoint,
+///   so they can be freely reordered,
+/// * sorts the commands within each level spatially, and merges rectangles of
+///   the same color and blending mode that abut into larger rectangles;
+///   first by rows (merging horizontally), then by columns (merging
+///   vertically), and
+/// * emits the remaining rectangles in batches, as `fillRects()` or
+///   `writeRects()` calls.
+///
+/// The queue is flushed when it fills up, on `end()` and `flush()`, and before
+/// any call that does not go through the queue (`setAddress()` and the
+/// subsequent `write()`s, `drawDirectRect()`, and `blitCopy()`), so the
+/// ordering with respect to those calls is preserved.
+///
+/// Each queued command takes 20 bytes of RAM. The level tracking takes
+/// another 2 KB.
+class RectBatchingOutput : public DisplayOutput {
+ public:
+  /// Default maximum number of queued commands.
+  static constexpr uint16_t kDefaultCapacity = 512;
+
+  /// Create a batching filter wrapping the specified output. Allocates the
+  /// queue.
+  RectBatchingOutput(DisplayOutput& output,
+                     uint16_t capacity = kDefaultCapacity);
+
+  RectBatchingOutput(const RectBatchingOutput&) = delete;
+  RectBatchingOutput& operator=(const RectBatchingOutput&) = delete;
+
+  /// Returns the number of commands currently in the queue.
+  uint16_t queued() const { return size_; }
+
+  void begin() override { output_.begin(); }
+
+  void end() override;
+
+  void flush() override;
+
+  void setAddress(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                  BlendingMode blending_mode) override;
+
+  void write(Color* color, uint32_t pixel_count) override {
+    output_.write(color, pixel_count);
+  }
+
+  void fill(Color color, uint32_t pixel_count) override {
+    output_.fill(color, pixel_count);
+  }
+
+  void writePixels(BlendingMode blending_mode, Color* color, int16_t* x,
+                   int16_t* y, uint16_t pixel_count) override;
+
+  void fillPixels(BlendingMode blending_mode, Color color, int16_t* x,
+                  int16_t* y, uint16_t pixel_count) override;
+
+  void writeRects(BlendingMode blending_mode, Color* color, int16_t* x0,
+                  int16_t* y0, int16_t* x1, int16_t* y1,
+                  uint16_t count) override;
+
+  void fillRects(BlendingMode blending_mode, Color color, int16_t* x0,
+                 int16_t* y0, int16_t* x1, int16_t* y1,
+                 uint16_t count) override;
+
+  const ColorFormat& getColorFormat() const override {
+    return output_.getColorFormat();
+  }
+
+  const Capabilities& getCapabilities() const override {
+    return output_.getCapabilities();
+  }
+
+  void drawDirectRect(const roo::byte* data, size_t row_width_bytes,
+                      int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                      int16_t src_y1, int16_t dst_x0, int16_t dst_y0) override;
+
+  void drawDirectRectAsync(const roo::byte* data, size_t row_width_bytes,
+                           int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                           int16_t src_y1, int16_t dst_x0,
+                           int16_t dst_y0) override;
+
+  void blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1, int16_t src_y1,
+                int16_t dst_x0, int16_t dst_y0) override;
+
+ private:
+  struct Command {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+    Color color;
+    BlendingMode blending_mode;
+    uint16_t level;
+  };
+
+  void enqueue(BlendingMode blending_mode, Color color, int16_t x0, int16_t y0,
+               int16_t x1, int16_t y1);
+
+  // Optimizes and emits all the queued commands.
+  void flushQueue();
+
+  // Removes the commands that are entirely overdrawn by later ones.
+  void cull();
+
+  // Assigns the levels, so that commands that intersect earlier ones end up at
+  // higher levels.
+  void assignLevels();
+
+  // Merges sorted commands into larger rectangles, where possible.
+  void merge();
+
+  void emit();
+
+  DisplayOutput& output_;
+  uint16_t capacity_;
+  uint16_t size_;
+  std::unique_ptr<Command[]> queue_;
+  std::unique_ptr<uint16_t[]> levels_;
+};
+
+}  // namespace roo_display
@@ -0,0 +1,310 @@
+#include "roo_display/filter/tracing_output.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "roo_time.h"
+
+namespace roo_display {
+
+namespace {
+
+uint32_t UptimeMicros() {
+  return (uint32_t)roo_time::Uptime::Now().inMicros();
+}
+
+int HistogramBucket(uint32_t us) {
+  int bucket = 0;
+  while (us > 0 && bucket < TracingOutput::kHistogramBuckets - 1) {
+    us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+uint32_t RectsArea(const int16_t* x0, const int16_t* y0, const int16_t* x1,
+                   const int16_t* y1, uint16_t count) {
+  uint32_t area = 0;
+  for (uint16_t i = 0; i < count; ++i) {
+    area += (uint32_t)(x1[i] - x0[i] + 1) * (y1[i] - y0[i] + 1);
+  }
+  return area;
+}
+
+}  // namespace
+
+TracingOutput::TracingOutput(DisplayOutput& output, uint16_t event_capacity,
+                             Clock clock)
+    : output_(output),
+      clock_(clock != nullptr ? clock : &UptimeMicros),
+      enabled_(true),
+      events_(event_capacity > 0 ? new Event[event_capacity] : nullptr),
+      event_capacity_(event_capacity) {
+  reset();
+}
+
+const char* TracingOutput::CallName(CallType call) {
+  switch (call) {
+    case kSetAddress:
+      return "setAddress";
+    case kWrite:
+      return "write";
+    case kFill:
+      return "fill";
+    case kWritePixels:
+      return "writePixels";
+    case kFillPixels:
+      return "fillPixels";
+    case kWriteRects:
+      return "writeRects";
+    case kFillRects:
+      return "fillRects";
+    case kDrawDirectRect:
+      return "drawDirectRect";
+    case kDrawDirectRectAsync:
+      return "drawDirectRectAsync";
+    case kBlitCopy:
+      return "blitCopy";
+    case kFlush:
+      return "flush";
+    default:
+      return "unknown";
+  }
+}
+
+void TracingOutput::reset() {
+  memset(stats_, 0, sizeof(stats_));
+  event_head_ = 0;
+  event_count_ = 0;
+}
+
+TracingOutput::Event& TracingOutput::addEvent() {
+  if (event_count_ < event_capacity_) {
+    return events_[(event_head_ + event_count_++) % event_capacity_];
+  }
+  // Overwrite the oldest.
+  Event& e = events_[event_head_];
+  event_head_ = (event_head_ + 1) % event_capacity_;
+  return e;
+}
+
+void TracingOutput::record(CallType call, uint32_t start_us, uint32_t pixels,
+                           uint32_t rects) {
+  uint32_t duration = clock_() - start_us;
+  CallStats& s = stats_[call];
+  ++s.calls;
+  s.pixels += pixels;
+  s.rects += rects;
+  s.total_us += duration;
+  if (duration > s.max_us) s.max_us = duration;
+  ++s.histogram[HistogramBucket(duration)];
+  if (event_capacity_ > 0) {
+    Event& e = addEvent();
+    e.kind = Event::kCall;
+    e.call = call;
+    e.name = nullptr;
+    e.start_us = start_us;
+    e.duration_us = duration;
+    e.pixels = pixels;
+  }
+}
+
+void TracingOutput::beginSpan(const char* name) {
+  if (!enabled_ || event_capacity_ == 0) return;
+  Event& e = addEvent();
+  e.kind = Event::kSpanBegin;
+  e.call = kCallTypeCount;
+  e.name = name;
+  e.start_us = clock_();
+  e.duration_us = 0;
+  e.pixels = 0;
+}
+
+void TracingOutput::endSpan() {
+  if (!enabled_ || event_capacity_ == 0) return;
+  Event& e = addEvent();
+  e.kind = Event::kSpanEnd;
+  e.call = kCallTypeCount;
+  e.name = nullptr;
+  e.start_us = clock_();
+  e.duration_us = 0;
+  e.pixels = 0;
+}
+
+void TracingOutput::writeChromeTrace(
+    const std::function<void(roo::string_view)>& sink) const {
+  char buf[160];
+  sink("{\"traceEvents\":[");
+  for (uint16_t i = 0; i < event_count_; ++i) {
+    const Event& e = event(i);
+    const char* sep = (i == 0) ? "" : ",";
+    int n;
+    switch (e.kind) {
+      case Event::kCall: {
+        n = snprintf(buf, sizeof(buf),
+                     "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%" PRIu32
+                     ",\"dur\":%" PRIu32
+                     ",\"pid\":0,\"tid\":0,\"args\":{\"pixels\":%" PRIu32
+                     "}}",
+                     sep, CallName(e.call), e.start_us, e.duration_us,
+                     e.pixels);
+        break;
+      }
+      case Event::kSpanBegin: {
+        n = snprintf(buf, sizeof(buf),
+                     "%s{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%" PRIu32
+                     ",\"pid\":0,\"tid\":0}",
+                     sep, e.name, e.start_us);
+        break;
+      }
+      default: {
+        n = snprintf(buf, sizeof(buf),
+                     "%s{\"ph\":\"E\",\"ts\":%" PRIu32 ",\"pid\":0,\"tid\":0}",
+                     sep, e.start_us);
+        break;
+      }
+    }
+    if (n >= (int)sizeof(buf)) n = sizeof(buf) - 1;
+    sink(roo::string_view(buf, n));
+  }
+  sink("]}");
+}
+
+void TracingOutput::flush() {
+  if (!enabled_) {
+    output_.flush();
+    return;
+  }
+  uint32_t start = clock_();
+  output_.flush();
+  record(kFlush, start, 0, 0);
+}
+
+void TracingOutput::setAddress(uint16_t x0, uint16_t y0, uint16_t x1,
+                               uint16_t y1, BlendingMode blending_mode) {
+  if (!enabled_) {
+    output_.setAddress(x0, y0, x1, y1, blending_mode);
+    return;
+  }
+  uint32_t start = clock_();
+  output_.setAddress(x0, y0, x1, y1, blending_mode);
+  record(kSetAddress, start, 0, 0);
+}
+
+void TracingOutput::write(Color* color, uint32_t pixel_count) {
+  if (!enabled_) {
+    output_.write(color, pixel_count);
+    return;
+  }
+  uint32_t start = clock_();
+  output_.write(color, pixel_count);
+  record(kWrite, start, pixel_count, 0);
+}
+
+void TracingOutput::fill(Color color, uint32_t pixel_count) {
+  if (!enabled_) {
+    output_.fill(color, pixel_count);
+    return;
+  }
+  uint32_t start = clock_();
+  output_.fill(color, pixel_count);
+  record(kFill, start, pixel_count, 0);
+}
+
+void TracingOutput::writePixels(BlendingMode blending_mode, Color* color,
+                                int16_t* x, int16_t* y, uint16_t pixel_count) {
+  if (!enabled_) {
+    output_.writePixels(blending_mode, color, x, y, pixel_count);
+    return;
+  }
+  uint32_t start = clock_();
+  output_.writePixels(blending_mode, color, x, y, pixel_count);
+  record(kWritePixels, start, pixel_count, 0);
+}
+
+void TracingOutput::fillPixels(BlendingMode blending_mode, Color color,
+                               int16_t* x, int16_t* y, uint16_t pixel_count) {
+  if (!enabled_) {
+    output_.fillPixels(blending_mode, color, x, y, pixel_count);
+    return;
+  }
+  uint32_t start = clock_();
+  output_.fillPixels(blending_mode, color, x, y, pixel_count);
+  record(kFillPixels, start, pixel_count, 0);
+}
+
+void TracingOutput::writeRects(BlendingMode blending_mode, Color* color,
+                               int16_t* x0, int16_t* y0, int16_t* x1,
+                               int16_t* y1, uint16_t count) {
+  if (!enabled_) {
+    output_.writeRects(blending_mode, color, x0, y0, x1, y1, count);
+    return;
+  }
+  // The area is computed up front, since the output may modify the arrays.
+  uint32_t area = RectsArea(x0, y0, x1, y1, count);
+  uint32_t start = clock_();
+  output_.writeRects(blending_mode, color, x0, y0, x1, y1, count);
+  record(kWriteRects, start, area, count);
+}
+
+void TracingOutput::fillRects(BlendingMode blending_mode, Color color,
+                              int16_t* x0, int16_t* y0, int16_t* x1,
+                              int16_t* y1, uint16_t count) {
+  if (!enabled_) {
+    output_.fillRects(blending_mode, color, x0, y0, x1, y1, count);
+    return;
+  }
+  uint32_t area = RectsArea(x0, y0, x1, y1, count);
+  uint32_t start = clock_();
+  output_.fillRects(blending_mode, color, x0, y0, x1, y1, count);
+  record(kFillRects, start, area, count);
+}
+
+void TracingOutput::drawDirectRect(const roo::byte* data,
+                                   size_t row_width_bytes, int16_t src_x0,
+                                   int16_t src_y0, int16_t src_x1,
+                                   int16_t src_y1, int16_t dst_x0,
+                                   int16_t dst_y0) {
+  if (!enabled_) {
+    output_.drawDirectRect(data, row_width_bytes, src_x0, src_y0, src_x1,
+                           src_y1, dst_x0, dst_y0);
+    return;
+  }
+  uint32_t start = clock_();
+  output_.drawDirectRect(data, row_width_bytes, src_x0, src_y0, src_x1, src_y1,
+                         dst_x0, dst_y0);
+  record(kDrawDirectRect, start,
+         (uint32_t)(src_x1 - src_x0 + 1) * (src_y1 - src_y0 + 1), 1);
+}
+
+void TracingOutput::drawDirectRectAsync(const roo::byte* data,
+                                        size_t row_width_bytes, int16_t src_x0,
+                                        int16_t src_y0, int16_t src_x1,
+                                        int16_t src_y1, int16_t dst_x0,
+                                        int16_t dst_y0) {
+  if (!enabled_) {
+    output_.drawDirectRectAsync(data, row_width_bytes, src_x0, src_y0, src_x1,
+                                src_y1, dst_x0, dst_y0);
+    return;
+  }
+  // Measures the time to issue the transfer, not to complete it.
+  uint32_t start = clock_();
+  output_.drawDirectRectAsync(data, row_width_bytes, src_x0, src_y0, src_x1,
+                              src_y1, dst_x0, dst_y0);
+  record(kDrawDirectRectAsync, start,
+         (uint32_t)(src_x1 - src_x0 + 1) * (src_y1 - src_y0 + 1), 1);
+}
+
+void TracingOutput::blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                             int16_t src_y1, int16_t dst_x0, int16_t dst_y0) {
+  if (!enabled_) {
+    output_.blitCopy(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+    return;
+  }
+  uint32_t start = clock_();
+  output_.blitCopy(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+  record(kBlitCopy, start,
+         (uint32_t)(src_x1 - src_x0 + 1) * (src_y1 - src_y0 + 1), 1);
+}
+
+}  // namespace roo_display
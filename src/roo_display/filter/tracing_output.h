@@ -0,0 +1,216 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include <functional>
+#include <memory>
+
+#include "roo_backport.h"
+#include "roo_backport/string_view.h"
+#include "roo_display/core/device.h"
+
+namespace roo_display {
+
+/// Pass-through filtering device that measures the calls made to the
+/// underlying output: how many, how many pixels and rectangles they carry,
+/// and how long they take.
+///
+/// Where `CountingOutput` estimates the cost of drawing, this one measures
+/// it. Wrap the driver (or any filter, e.g. a `BackgroundFillOptimizer` or
+/// `ClipMaskFilter`) to find out where the frame time goes. For each call
+/// type, the latencies are collected in a fixed-size log2 histogram.
+/// Optionally, the most recent calls are also recorded, as individual
+/// events, in a ring buffer, which can be exported in the Chrome trace event
+/// format (viewable in chrome://tracing or Perfetto). Named spans (see
+/// `beginSpan()`) can be added to attribute the calls to specific widgets or
+/// drawing phases.
+///
+/// When disabled, every call is forwarded after a single flag check, so the
+/// filter can stay in place in production builds.
+///
+/// Not thread-safe.
+class TracingOutput : public DisplayOutput {
+ public:
+  /// Returns the current time in microseconds. May wrap around.
+  using Clock = uint32_t (*)();
+
+  /// The traced calls.
+  enum CallType {
+    kSetAddress = 0,
+    kWrite,
+    kFill,
+    kWritePixels,
+    kFillPixels,
+    kWriteRects,
+    kFillRects,
+    kDrawDirectRect,
+    kDrawDirectRectAsync,
+    kBlitCopy,
+    kFlush,
+    kCallTypeCount
+  };
+
+  /// Number of latency histogram buckets. Bucket 0 counts calls that took
+  /// less than 1 us; bucket i > 0 counts calls that took [2^(i-1), 2^i) us;
+  /// the last bucket also counts all the longer calls.
+  static constexpr int kHistogramBuckets = 16;
+
+  /// Aggregates for a single call type.
+  struct CallStats {
+    uint32_t calls;
+
+    /// Pixels written (or copied).
+    uint64_t pixels;
+
+    /// Rectangles written (or copied); zero for calls that write to the
+    /// current address window.
+    uint32_t rects;
+
+    /// Total and maximum time spent in the calls, in microseconds.
+    uint64_t total_us;
+    uint32_t max_us;
+
+    uint32_t histogram[kHistogramBuckets];
+  };
+
+  /// A single recorded event: a call, or a span boundary.
+  struct Event {
+    enum Kind : uint8_t { kCall, kSpanBegin, kSpanEnd };
+
+    Kind kind;
+
+    /// The call type, for `kCall`.
+    CallType call;
+
+    /// The span name, for `kSpanBegin`.
+    const char* name;
+
+    uint32_t start_us;
+
+    /// Duration, for `kCall`.
+    uint32_t duration_us;
+
+    /// Pixel count, for `kCall`.
+    uint32_t pixels;
+  };
+
+  /// Create a tracing filter wrapping the specified output. If
+  /// `event_capacity` is positive, the most recent events are additionally
+  /// recorded in a ring buffer of that capacity. If `clock` is null, the
+  /// system uptime is used.
+  TracingOutput(DisplayOutput& output, uint16_t event_capacity = 0,
+                Clock clock = nullptr);
+
+  TracingOutput(const TracingOutput&) = delete;
+  TracingOutput& operator=(const TracingOutput&) = delete;
+
+  /// Enables or disables tracing. Enabled by default.
+  void setEnabled(bool enabled) { enabled_ = enabled; }
+  bool isEnabled() const { return enabled_; }
+
+  /// Returns the aggregates for the specified call type.
+  const CallStats& stats(CallType call) const { return stats_[call]; }
+
+  /// Returns the name of the call type, e.g. "fillRects".
+  static const char* CallName(CallType call);
+
+  /// Zeroes the aggregates, and clears the recorded events.
+  void reset();
+
+  /// Marks the beginning of a named span. The name must be a string literal
+  /// (or otherwise remain valid while the event is recorded). Spans may nest,
+  /// and must be closed by `endSpan()`.
+  void beginSpan(const char* name);
+
+  /// Marks the end of the most recently begun span.
+  void endSpan();
+
+  /// Begins a span in the constructor, and ends it in the destructor.
+  class Span {
+   public:
+    Span(TracingOutput& tracer, const char* name) : tracer_(tracer) {
+      tracer_.beginSpan(name);
+    }
+    ~Span() { tracer_.endSpan(); }
+
+   private:
+    TracingOutput& tracer_;
+  };
+
+  /// Returns the number of recorded events (at most `event_capacity`).
+  uint16_t event_count() const { return event_count_; }
+
+  /// Returns the recorded event with the specified index, with 0 being the
+  /// oldest one.
+  const Event& event(uint16_t idx) const {
+    return events_[(event_head_ + idx) % event_capacity_];
+  }
+
+  /// Writes the recorded events, as Chrome trace event JSON, to the sink, in
+  /// chunks.
+  void writeChromeTrace(
+      const std::function<void(roo::string_view)>& sink) const;
+
+  void begin() override { output_.begin(); }
+  void end() override { output_.end(); }
+  void flush() override;
+
+  void setAddress(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                  BlendingMode blending_mode) override;
+
+  void write(Color* color, uint32_t pixel_count) override;
+
+  void fill(Color color, uint32_t pixel_count) override;
+
+  void writePixels(BlendingMode blending_mode, Color* color, int16_t* x,
+                   int16_t* y, uint16_t pixel_count) override;
+
+  void fillPixels(BlendingMode blending_mode, Color color, int16_t* x,
+                  int16_t* y, uint16_t pixel_count) override;
+
+  void writeRects(BlendingMode blending_mode, Color* color, int16_t* x0,
+                  int16_t* y0, int16_t* x1, int16_t* y1,
+                  uint16_t count) override;
+
+  void fillRects(BlendingMode blending_mode, Color color, int16_t* x0,
+                 int16_t* y0, int16_t* x1, int16_t* y1,
+                 uint16_t count) override;
+
+  const ColorFormat& getColorFormat() const override {
+    return output_.getColorFormat();
+  }
+
+  const Capabilities& getCapabilities() const override {
+    return output_.getCapabilities();
+  }
+
+  void drawDirectRect(const roo::byte* data, size_t row_width_bytes,
+                      int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                      int16_t src_y1, int16_t dst_x0, int16_t dst_y0) override;
+
+  void drawDirectRectAsync(const roo::byte* data, size_t row_width_bytes,
+                           int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                           int16_t src_y1, int16_t dst_x0,
+                           int16_t dst_y0) override;
+
+  void blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1, int16_t src_y1,
+                int16_t dst_x0, int16_t dst_y0) override;
+
+ private:
+  void record(CallType call, uint32_t start_us, uint32_t pixels,
+              uint32_t rects);
+
+  Event& addEvent();
+
+  DisplayOutput& output_;
+  Clock clock_;
+  bool enabled_;
+  CallStats stats_[kCallTypeCount];
+
+  std::unique_ptr<Event[]> events_;
+  uint16_t event_capacity_;
+  uint16_t event_head_;
+  uint16_t event_count_;
+};
+
+}  // namespace roo_display
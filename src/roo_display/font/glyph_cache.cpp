@@ -0,0 +1,177 @@
+#include "roo_display/font/glyph_cache.h"
+
+#include "roo_logging.h"
+
+namespace roo_display {
+
+namespace {
+
+uint16_t RoundUpToPowerOfTwo(uint16_t n) {
+  uint16_t result = 1;
+  while (result < n) result <<= 1;
+  return result;
+}
+
+inline uint32_t HashPtr(const void* ptr) {
+  uintptr_t v = (uintptr_t)ptr;
+  return (uint32_t)(v ^ (v >> 7) ^ (v >> 15)) * 0x9E3779B1u;
+}
+
+}  // namespace
+
+GlyphCache::GlyphCache(size_t capacity_bytes, uint16_t max_entries,
+                       uint16_t index_slots)
+    : capacity_bytes_(capacity_bytes),
+      size_bytes_(0),
+      entry_count_(0),
+      entries_(max_entries),
+      buckets_(RoundUpToPowerOfTwo(max_entries), -1),
+      lru_head_(-1),
+      lru_tail_(-1),
+      free_head_(-1),
+      index_(RoundUpToPowerOfTwo(index_slots), IndexSlot{nullptr, 0, -1}),
+      palette_fg_(color::Transparent),
+      palette_bg_(color::Transparent),
+      palette_valid_(false),
+      stats_{0, 0, 0, 0, 0} {
+  CHECK_GT(max_entries, 0);
+  CHECK_LE(max_entries, 0x7FFF);
+  clear();
+}
+
+void GlyphCache::clear() {
+  for (int16_t i = 0; i < (int16_t)entries_.size(); ++i) {
+    Entry& e = entries_[i];
+    e.key = nullptr;
+    e.data.reset();
+    e.size = 0;
+    e.prev = -1;
+    e.next = (i + 1 < (int16_t)entries_.size()) ? i + 1 : -1;
+    e.chain = -1;
+  }
+  for (int16_t& b : buckets_) b = -1;
+  for (IndexSlot& slot : index_) slot = IndexSlot{nullptr, 0, -1};
+  free_head_ = 0;
+  lru_head_ = -1;
+  lru_tail_ = -1;
+  size_bytes_ = 0;
+  entry_count_ = 0;
+  palette_valid_ = false;
+}
+
+uint16_t GlyphCache::bucketOf(const void* key) const {
+  return (HashPtr(key) >> 16) & (buckets_.size() - 1);
+}
+
+int16_t GlyphCache::find(const void* key) const {
+  int16_t idx = buckets_[bucketOf(key)];
+  while (idx >= 0 && entries_[idx].key != key) idx = entries_[idx].chain;
+  return idx;
+}
+
+void GlyphCache::unlink(int16_t idx) {
+  Entry& e = entries_[idx];
+  if (e.prev >= 0) {
+    entries_[e.prev].next = e.next;
+  } else {
+    lru_head_ = e.next;
+  }
+  if (e.next >= 0) {
+    entries_[e.next].prev = e.prev;
+  } else {
+    lru_tail_ = e.prev;
+  }
+  e.prev = -1;
+  e.next = -1;
+}
+
+void GlyphCache::pushFront(int16_t idx) {
+  Entry& e = entries_[idx];
+  e.prev = -1;
+  e.next = lru_head_;
+  if (lru_head_ >= 0) entries_[lru_head_].prev = idx;
+  lru_head_ = idx;
+  if (lru_tail_ < 0) lru_tail_ = idx;
+}
+
+void GlyphCache::evictLast() {
+  int16_t idx = lru_tail_;
+  DCHECK_GE(idx, 0);
+  Entry& e = entries_[idx];
+  // Remove from the hash chain.
+  int16_t* link = &buckets_[bucketOf(e.key)];
+  while (*link != idx) link = &entries_[*link].chain;
+  *link = e.chain;
+  unlink(idx);
+  size_bytes_ -= e.size;
+  --entry_count_;
+  e.key = nullptr;
+  e.data.reset();
+  e.size = 0;
+  e.chain = -1;
+  e.next = free_head_;
+  free_head_ = idx;
+  ++stats_.evictions;
+}
+
+const roo::byte* GlyphCache::get(const void* key) {
+  int16_t idx = find(key);
+  if (idx < 0) {
+    ++stats_.misses;
+    return nullptr;
+  }
+  ++stats_.hits;
+  if (idx != lru_head_) {
+    unlink(idx);
+    pushFront(idx);
+  }
+  return entries_[idx].data.get();
+}
+
+const roo::byte* GlyphCache::peek(const void* key) const {
+  int16_t idx = find(key);
+  return idx < 0 ? nullptr : entries_[idx].data.get();
+}
+
+roo::byte* GlyphCache::put(const void* key, size_t size) {
+  DCHECK_LT(find(key), 0);
+  if (size > capacity_bytes_) return nullptr;
+  while (size_bytes_ + size > capacity_bytes_ || free_head_ < 0) {
+    evictLast();
+  }
+  int16_t idx = free_head_;
+  Entry& e = entries_[idx];
+  free_head_ = e.next;
+  e.key = key;
+  e.data.reset(new roo::byte[size]);
+  e.size = size;
+  uint16_t bucket = bucketOf(key);
+  e.chain = buckets_[bucket];
+  buckets_[bucket] = idx;
+  pushFront(idx);
+  size_bytes_ += size;
+  ++entry_count_;
+  return e.data.get();
+}
+
+GlyphCache::IndexSlot& GlyphCache::indexSlot(const void* font, char32_t code) {
+  uint32_t hash = HashPtr(font) + (uint32_t)code * 0x9E3779B1u;
+  return index_[(hash >> 8) & (index_.size() - 1)];
+}
+
+bool GlyphCache::getGlyphIndex(const void* font, char32_t code, int& index) {
+  const IndexSlot& slot = indexSlot(font, code);
+  if (slot.font == font && slot.code == code) {
+    ++stats_.index_hits;
+    index = slot.index;
+    return true;
+  }
+  ++stats_.index_misses;
+  return false;
+}
+
+void GlyphCache::putGlyphIndex(const void* font, char32_t code, int index) {
+  indexSlot(font, code) = IndexSlot{font, code, index};
+}
+
+}  // namespace roo_display
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "roo_backport.h"
+#include "roo_backport/byte.h"
+#include "roo_display/color/color.h"
+
+namespace roo_display {
+
+/// Bounded-memory cache of decoded glyph bitmaps, shared by fonts that
+/// support it (currently, `SmoothFontV2`).
+///
+/// Smooth fonts store glyphs as RLE-compressed 4-bit alpha data in PROGMEM,
+/// and decode them every time they are drawn. When the same glyphs get drawn
+/// over and over (e.g. digits of a frequently updated counter), it is cheaper
+/// to decode them once, and then draw them from the uncompressed bitmaps in
+/// RAM. Cached bitmaps are color-independent (they store alpha levels), so
+/// the same entry is reused regardless of the foreground and background
+/// colors. The most recently used palette is memoized as well.
+///
+/// The cache additionally maintains a small, direct-mapped code point to
+/// glyph index table, which short-circuits the cmap lookups.
+///
+/// When the memory budget is exceeded, the least recently used bitmaps are
+/// evicted.
+///
+/// The cache is opt-in; see `SmoothFontV2::SetGlyphCache()`. It is not
+/// thread-safe.
+class GlyphCache {
+ public:
+  /// Hit/miss counters.
+  struct Stats {
+    /// Glyph bitmap lookups that found the decoded bitmap.
+    uint32_t hits;
+
+    /// Glyph bitmap lookups that required decoding.
+    uint32_t misses;
+
+    /// Glyph bitmaps evicted to make room for new ones.
+    uint32_t evictions;
+
+    /// Code point lookups resolved by the index table.
+    uint32_t index_hits;
+
+    /// Code point lookups that required a cmap lookup.
+    uint32_t index_misses;
+  };
+
+  /// Create a cache that stores at most `capacity_bytes` of decoded bitmap
+  /// data, in at most `max_entries` entries, with `index_slots` (rounded up
+  /// to a power of two) entries in the code point table.
+  GlyphCache(size_t capacity_bytes, uint16_t max_entries = 128,
+             uint16_t index_slots = 128);
+
+  GlyphCache(const GlyphCache&) = delete;
+  GlyphCache& operator=(const GlyphCache&) = delete;
+
+  /// Returns the decoded bitmap identified by `key`, marking it as most
+  /// recently used, or nullptr if not found.
+  const roo::byte* get(const void* key);
+
+  /// Like `get()`, but does not affect the LRU order, nor the stats.
+  const roo::byte* peek(const void* key) const;
+
+  /// Allocates an entry for `size` bytes of data, identified by `key`, which
+  /// must not already be in the cache, evicting the least recently used
+  /// entries as needed. Returns the buffer to decode into, or nullptr if the
+  /// data can't fit in the cache at all.
+  roo::byte* put(const void* key, size_t size);
+
+  /// Looks up the glyph index of the specified code point in the specified
+  /// font. Returns true and sets `index` on hit.
+  bool getGlyphIndex(const void* font, char32_t code, int& index);
+
+  /// Records the glyph index of the specified code point in the specified
+  /// font.
+  void putGlyphIndex(const void* font, char32_t code, int index);
+
+  /// Returns a 16-entry palette for the given (fg, bg) colors, rebuilding it
+  /// with `build` only if they differ from the previous call.
+  template <typename Builder>
+  const Color* getPalette(Color fg, Color bg, Builder build) {
+    if (!palette_valid_ || fg != palette_fg_ || bg != palette_bg_) {
+      build(palette_, bg, fg);
+      palette_fg_ = fg;
+      palette_bg_ = bg;
+      palette_valid_ = true;
+    }
+    return palette_;
+  }
+
+  /// Removes all entries. Does not reset the stats.
+  void clear();
+
+  /// Returns the total size of the cached bitmap data, in bytes.
+  size_t size_bytes() const { return size_bytes_; }
+
+  /// Returns the memory budget, in bytes.
+  size_t capacity_bytes() const { return capacity_bytes_; }
+
+  /// Returns the number of cached bitmaps.
+  uint16_t entry_count() const { return entry_count_; }
+
+  const Stats& stats() const { return stats_; }
+
+  void resetStats() { stats_ = Stats{0, 0, 0, 0, 0}; }
+
+ private:
+  struct Entry {
+    const void* key;
+    std::unique_ptr<roo::byte[]> data;
+    size_t size;
+    // LRU list links (most recent at head).
+    int16_t prev;
+    int16_t next;
+    // Hash bucket chain.
+    int16_t chain;
+  };
+
+  struct IndexSlot {
+    const void* font;
+    char32_t code;
+    int index;
+  };
+
+  uint16_t bucketOf(const void* key) const;
+  IndexSlot& indexSlot(const void* font, char32_t code);
+  int16_t find(const void* key) const;
+  void unlink(int16_t idx);
+  void pushFront(int16_t idx);
+  void evictLast();
+
+  size_t capacity_bytes_;
+  size_t size_bytes_;
+  uint16_t entry_count_;
+
+  std::vector<Entry> entries_;
+  std::vector<int16_t> buckets_;
+  int16_t lru_head_;
+  int16_t lru_tail_;
+  int16_t free_head_;
+
+  std::vector<IndexSlot> index_;
+
+  Color palette_[16];
+  Color palette_fg_;
+  Color palette_bg_;
+  bool palette_valid_;
+
+  Stats stats_;
+};
+
+}  // namespace roo_display
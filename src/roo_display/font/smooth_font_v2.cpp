@@ -71,6 +71,7 @@
 #include "roo_display/color/blending.h"
 #include "roo_display/color/color_mode_indexed.h"
 #include "roo_display/core/raster.h"
+#include "roo_display/font/glyph_cache.h"
 #include "roo_display/image/image.h"
 #include "roo_display/internal/raw_streamable_overlay.h"
 #include "roo_display/io/memory.h"
@@ -108,8 +109,14 @@ void BuildAlpha4Palette(Color* out, Color bgcolor, Color color) {
   }
 }
 
+GlyphCache* glyph_cache = nullptr;
+
 }  // namespace
 
+void SmoothFontV2::SetGlyphCache(GlyphCache* cache) { glyph_cache = cache; }
+
+GlyphCache* SmoothFontV2::GetGlyphCache() { return glyph_cache; }
+
 class FontMetricReader {
  public:
   FontMetricReader(
@@ -343,6 +350,7 @@ void SmoothFontV2::drawGlyphModeVisible(
     DisplayOutput& output, int16_t x, int16_t y, const GlyphMetrics& metrics,
     bool compressed, const roo::byte* PROGMEM data, const Box& clip_box,
     const Palette& palette, BlendingMode blending_mode) const {
+  useDecodedGlyph(metrics, compressed, data);
   Surface s(output, x + metrics.bearingX(), y - metrics.bearingY(), clip_box,
             false, color::Transparent, FillMode::kVisible, blending_mode);
   if (rle() && compressed) {
@@ -415,6 +423,7 @@ void SmoothFontV2::drawGlyphModeFill(DisplayOutput& output, int16_t x,
                                      int16_t offset, const Box& clip_box,
                                      const Palette& palette, Color borderColor,
                                      BlendingMode blending_mode) const {
+  useDecodedGlyph(glyph_metrics, compressed, data);
   Box box = glyph_metrics.screen_extents().translate(offset, 0);
   if (rle() && compressed) {
     auto glyph = MakeDrawableRawStreamable(
@@ -437,6 +446,18 @@ void SmoothFontV2::drawKernedGlyphsModeFill(
     const roo::byte* PROGMEM right_data, int16_t right_offset,
     const Box& clip_box, Color color, Color bgColor,
     BlendingMode blending_mode) const {
+  const roo::byte* PROGMEM left_glyph = left_data;
+  useDecodedGlyph(left_metrics, left_compressed, left_data);
+  useDecodedGlyph(right_metrics, right_compressed, right_data);
+  if (left_data != left_glyph) {
+    // Caching the right glyph may have evicted the left one (if the cache
+    // can't hold both). If so, draw the left one from the compressed data.
+    left_data = glyph_cache->peek(left_glyph);
+    if (left_data == nullptr) {
+      left_data = left_glyph;
+      left_compressed = true;
+    }
+  }
   Box lb = left_metrics.screen_extents().translate(left_offset, 0);
   Box rb = right_metrics.screen_extents().translate(right_offset, 0);
   if (rle() && left_compressed && right_compressed) {
@@ -691,8 +712,8 @@ void SmoothFontV2::drawHorizontalString(const Surface& s, const char* utf8_data,
   // Pre-compute a 16-color Indexed4 palette that bakes in the alpha blend
   // against bgcolor, so per-glyph rendering avoids per-pixel blending.
   Color palette_colors[16];
-  BuildAlpha4Palette(palette_colors, s.bgcolor(), color);
-  Palette palette = Palette::ReadOnly(palette_colors, 16);
+  Palette palette = Palette::ReadOnly(
+      alpha4Palette(palette_colors, s.bgcolor(), color), 16);
   bool has_more;
   do {
     has_more = decoder.next(next_code);
@@ -800,8 +821,8 @@ void SmoothFontV2::drawGlyph(const Surface& s, char32_t code, FontLayout layout,
 
   // Pre-compute a 16-color Indexed4 palette (see BuildAlpha4Palette).
   Color palette_colors[16];
-  BuildAlpha4Palette(palette_colors, s.bgcolor(), color);
-  Palette palette = Palette::ReadOnly(palette_colors, 16);
+  Palette palette = Palette::ReadOnly(
+      alpha4Palette(palette_colors, s.bgcolor(), color), 16);
 
   if (s.fill_mode() == FillMode::kVisible) {
     drawGlyphModeVisible(output, x - preadvanced, y, glyph_metrics, compressed,
@@ -861,6 +882,55 @@ int16_t SmoothFontV2::getKerning(char32_t left, char32_t right) const {
 }
 
 int SmoothFontV2::findGlyphIndex(char32_t code) const {
+  if (glyph_cache == nullptr) return findGlyphIndexInCmap(code);
+  int index;
+  if (!glyph_cache->getGlyphIndex(this, code, index)) {
+    index = findGlyphIndexInCmap(code);
+    glyph_cache->putGlyphIndex(this, code, index);
+  }
+  return index;
+}
+
+void SmoothFontV2::useDecodedGlyph(const GlyphMetrics& metrics,
+                                   bool& compressed,
+                                   const roo::byte* PROGMEM& data) const {
+  if (glyph_cache == nullptr || !rle() || !compressed) return;
+  const roo::byte* decoded = glyph_cache->get(data);
+  if (decoded == nullptr) {
+    int16_t width = metrics.width();
+    int16_t height = metrics.height();
+    if (width <= 0 || height <= 0) return;
+    uint32_t pixel_count = (uint32_t)width * height;
+    roo::byte* buf = glyph_cache->put(data, (pixel_count + 1) / 2);
+    if (buf == nullptr) return;
+    // Decode into the same layout as uncompressed glyphs (4 bits per pixel,
+    // MSB first). Alpha4 maps nibble n to alpha n * 17.
+    internal::RleStream4bppxBiased<ProgMemPtr, Alpha4> stream(
+        ProgMemPtr(data).iterator(), Alpha4(color::Black));
+    for (uint32_t i = 0; i < pixel_count; i += 2) {
+      uint8_t hi = stream.next().a() / 17;
+      uint8_t lo = (i + 1 < pixel_count) ? stream.next().a() / 17 : 0;
+      buf[i / 2] = (roo::byte)((hi << 4) | lo);
+    }
+    decoded = buf;
+  }
+  // The decoded glyph lives in RAM, but PROGMEM reads are plain memory reads
+  // on all supported platforms, so it can be drawn using the same (ProgMem)
+  // rasters as uncompressed glyphs.
+  data = decoded;
+  compressed = false;
+}
+
+const Color* SmoothFontV2::alpha4Palette(Color* buf, Color bgcolor,
+                                         Color color) const {
+  if (glyph_cache == nullptr) {
+    BuildAlpha4Palette(buf, bgcolor, color);
+    return buf;
+  }
+  return glyph_cache->getPalette(color, bgcolor, BuildAlpha4Palette);
+}
+
+int SmoothFontV2::findGlyphIndexInCmap(char32_t code) const {
   if (code > 0xFFFF) return -1;
   uint16_t ucode = (uint16_t)code;
   for (int i = 0; i < cmap_entries_count_; ++i) {
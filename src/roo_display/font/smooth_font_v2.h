@@ -10,6 +10,7 @@
 
 namespace roo_display {
 
+class GlyphCache;
 class Palette;
 
 /// Smooth font v2 with split cmap and glyph metrics format.
@@ -25,6 +26,14 @@ class SmoothFontV2 : public Font {
   /// Construct from PROGMEM font data.
   SmoothFontV2(const roo::byte* font_data PROGMEM);
 
+  /// Enables caching of decoded glyphs and glyph indexes, in the specified
+  /// cache, shared by all `SmoothFontV2` instances. Pass nullptr to disable
+  /// caching (the default). The cache must outlive its use by the fonts.
+  static void SetGlyphCache(GlyphCache* cache);
+
+  /// Returns the glyph cache set via `SetGlyphCache()`, or nullptr.
+  static GlyphCache* GetGlyphCache();
+
   void drawHorizontalString(const Surface& s, const char* utf8_data,
                             uint32_t size, Color color) const override;
 
@@ -74,8 +83,21 @@ class SmoothFontV2 : public Font {
   int16_t kerningWithClassFormat(int left_glyph_index,
                                  int right_glyph_index) const;
 
-  // Lookup the glyph index in the cmap ranges.
+  // Lookup the glyph index, using the glyph cache if enabled.
   int findGlyphIndex(char32_t code) const;
+
+  // Lookup the glyph index in the cmap ranges.
+  int findGlyphIndexInCmap(char32_t code) const;
+
+  // If the glyph cache is enabled and the glyph is compressed, replaces `data`
+  // with its decoded (uncompressed) copy from the cache, decoding it if
+  // necessary, and clears `compressed`.
+  void useDecodedGlyph(const GlyphMetrics& metrics, bool& compressed,
+                       const roo::byte* PROGMEM& data) const;
+
+  // Returns the palette for the specified colors, building it in `buf`, or
+  // taking it from the glyph cache if enabled.
+  const Color* alpha4Palette(Color* buf, Color bgcolor, Color color) const;
   const roo::byte* PROGMEM findKernPair(char32_t left, char32_t right) const;
 
   void drawGlyphModeVisible(DisplayOutput& output, int16_t x, int16_t y,
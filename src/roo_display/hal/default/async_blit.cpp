@@ -14,6 +14,12 @@ void async_blit_deinit() {}
 
 void async_blit_await() {}
 
+AsyncBlitToken async_blit_mark() { return 0; }
+
+bool async_blit_done(AsyncBlitToken token) { return true; }
+
+void async_blit_await(AsyncBlitToken token) {}
+
 void async_blit(const roo::byte* src_ptr, size_t src_stride, roo::byte* dst_ptr,
                 size_t dst_stride, size_t width, size_t height) {
   if (src_ptr == nullptr || dst_ptr == nullptr || width == 0 || height == 0) {
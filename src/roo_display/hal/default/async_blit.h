@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "roo_backport/byte.h"
 
@@ -12,6 +13,23 @@ void async_blit_deinit();
 
 void async_blit_await();
 
+// Identifies the async_blit() calls issued up to some point in time. See
+// async_blit_mark().
+using AsyncBlitToken = uint32_t;
+
+// Returns a token that completes once all async_blit() calls issued so far
+// have completed. Cheaper than async_blit_await() when the caller only needs
+// some earlier copy to have landed, e.g. before reusing its source buffer.
+AsyncBlitToken async_blit_mark();
+
+// Returns true if all the async_blit() calls covered by the token have
+// completed. Never blocks.
+bool async_blit_done(AsyncBlitToken token);
+
+// Blocks until all the async_blit() calls covered by the token have completed.
+// Must be called by the same task as async_blit().
+void async_blit_await(AsyncBlitToken token);
+
 void async_blit(const roo::byte* src_ptr, size_t src_stride, roo::byte* dst_ptr,
                 size_t dst_stride, size_t width, size_t height);
 
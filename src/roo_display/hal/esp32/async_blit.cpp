@@ -103,6 +103,10 @@ struct AsyncBlitState {
   size_t remaining_rows = 0;
   bool dma_active = false;
   DmaBlitQueue queue;
+  // Number of operations enqueued, and completed, so far. Used as completion
+  // tokens; compared with wrap-around.
+  uint32_t enqueued_ops = 0;
+  uint32_t completed_ops = 0;
   TaskHandle_t owner_task = nullptr;
   AsyncBlitStats stats;
 
@@ -291,6 +295,11 @@ bool StartActiveDma(AsyncBlitState& st) {
 bool IRAM_ATTR CompleteCurrentAndContinueFromIsr(AsyncBlitState& st) {
   // Hand completion to the owner task first, then keep draining queued ops
   // from ISR context so the DMA engine stays busy without task intervention.
+  // The counter is read by tasks on other cores, so it is updated under the
+  // lock, as in MaybeStartNextFromTask().
+  taskENTER_CRITICAL_ISR(&st.mux);
+  ++st.completed_ops;
+  taskEXIT_CRITICAL_ISR(&st.mux);
   st.notifyOwnerFromISR();
   while (true) {
     DmaBlitOp next;
@@ -308,6 +317,9 @@ bool IRAM_ATTR CompleteCurrentAndContinueFromIsr(AsyncBlitState& st) {
 
     ++st.stats.fallback_esp_err;
     CopyOpSync(next);
+    taskENTER_CRITICAL_ISR(&st.mux);
+    ++st.completed_ops;
+    taskEXIT_CRITICAL_ISR(&st.mux);
     st.notifyOwnerFromISR();
   }
 }
@@ -330,6 +342,7 @@ void MaybeStartNextFromTask(AsyncBlitState& st) {
     ++st.stats.fallback_esp_err;
     CopyOpSync(next);
     taskENTER_CRITICAL(&st.mux);
+    ++st.completed_ops;
     st.dma_active = false;
     taskEXIT_CRITICAL(&st.mux);
   }
@@ -340,6 +353,7 @@ void EnqueueDmaOp(AsyncBlitState& st, const DmaBlitOp& op) {
     bool should_kick = false;
     taskENTER_CRITICAL(&st.mux);
     if (st.queue.push(op)) {
+      ++st.enqueued_ops;
       if (st.queue.size() > st.stats.queue_len_max) {
         st.stats.queue_len_max = st.queue.size();
       }
@@ -430,6 +444,32 @@ void async_blit_await() {
   }
 }
 
+AsyncBlitToken async_blit_mark() {
+  AsyncBlitState& st = State();
+  taskENTER_CRITICAL(&st.mux);
+  AsyncBlitToken token = st.enqueued_ops;
+  taskEXIT_CRITICAL(&st.mux);
+  return token;
+}
+
+bool async_blit_done(AsyncBlitToken token) {
+  AsyncBlitState& st = State();
+  taskENTER_CRITICAL(&st.mux);
+  bool done = (int32_t)(st.completed_ops - token) >= 0;
+  taskEXIT_CRITICAL(&st.mux);
+  return done;
+}
+
+void async_blit_await(AsyncBlitToken token) {
+  AsyncBlitState& st = State();
+  if (st.owner_task == nullptr) return;
+  CHECK_EQ(st.owner_task, xTaskGetCurrentTaskHandle())
+      << "async_blit_await() must be called by the same task as async_blit()";
+  while (!async_blit_done(token)) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
+
 void async_blit(const roo::byte* src_ptr, size_t src_stride, roo::byte* dst_ptr,
                 size_t dst_stride, size_t width, size_t height) {
   if (src_ptr == nullptr || dst_ptr == nullptr || width == 0 || height == 0) {
@@ -565,6 +605,12 @@ void async_blit_deinit() {}
 
 void async_blit_await() {}
 
+AsyncBlitToken async_blit_mark() { return 0; }
+
+bool async_blit_done(AsyncBlitToken token) { return true; }
+
+void async_blit_await(AsyncBlitToken token) {}
+
 void async_blit(const roo::byte* src_ptr, size_t src_stride, roo::byte* dst_ptr,
                 size_t dst_stride, size_t width, size_t height) {
   if (src_ptr == nullptr || dst_ptr == nullptr || width == 0 || height == 0) {
@@ -0,0 +1,70 @@
+#include "roo_display/image/cached_raster.h"
+
+#include "roo_logging.h"
+
+namespace roo_display {
+namespace internal {
+
+RasterRowCache::RasterRowCache(size_t row_bytes, uint16_t capacity)
+    : row_bytes_(row_bytes),
+      capacity_(capacity),
+      data_(new roo::byte[row_bytes * capacity]),
+      rows_(new int16_t[capacity]),
+      last_used_(new uint32_t[capacity]),
+      tick_(0),
+      last_hit_(0) {
+  CHECK_GT(capacity, 0);
+  clear();
+}
+
+const roo::byte* RasterRowCache::get(int16_t row) {
+  // Fast path: consecutive lookups of the same row, e.g. when streaming.
+  if (rows_[last_hit_] == row) {
+    last_used_[last_hit_] = ++tick_;
+    return slot(last_hit_);
+  }
+  for (uint16_t i = 0; i < capacity_; ++i) {
+    if (rows_[i] == row) {
+      last_hit_ = i;
+      last_used_[i] = ++tick_;
+      return slot(i);
+    }
+  }
+  return nullptr;
+}
+
+bool RasterRowCache::contains(int16_t row) const {
+  for (uint16_t i = 0; i < capacity_; ++i) {
+    if (rows_[i] == row) return true;
+  }
+  return false;
+}
+
+roo::byte* RasterRowCache::put(int16_t row) {
+  DCHECK_GE(row, 0);
+  // Pick an empty slot, or else the least recently used one.
+  uint16_t victim = 0;
+  for (uint16_t i = 0; i < capacity_; ++i) {
+    if (rows_[i] < 0) {
+      victim = i;
+      break;
+    }
+    if (last_used_[i] < last_used_[victim]) victim = i;
+  }
+  rows_[victim] = row;
+  last_used_[victim] = ++tick_;
+  last_hit_ = victim;
+  return slot(victim);
+}
+
+void RasterRowCache::clear() {
+  for (uint16_t i = 0; i < capacity_; ++i) {
+    rows_[i] = -1;
+    last_used_[i] = 0;
+  }
+  tick_ = 0;
+  last_hit_ = 0;
+}
+
+}  // namespace internal
+}  // namespace roo_display
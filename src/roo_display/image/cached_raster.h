@@ -0,0 +1,397 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "roo_backport.h"
+#include "roo_backport/byte.h"
+#include "roo_display/core/raster.h"
+#include "roo_display/core/streamable.h"
+#include "roo_display/internal/pixel_pipeline.h"
+
+namespace roo_display {
+
+namespace internal {
+
+// Fixed-capacity cache of raw raster rows, with least-recently-used eviction.
+// Lookups scan the slots linearly; the capacity is expected to be small (a
+// few dozen rows at most). Not thread-safe.
+class RasterRowCache {
+ public:
+  RasterRowCache(size_t row_bytes, uint16_t capacity);
+
+  RasterRowCache(const RasterRowCache&) = delete;
+  RasterRowCache& operator=(const RasterRowCache&) = delete;
+
+  // Returns the cached data of the specified row, marking it as most recently
+  // used, or nullptr if not found.
+  const roo::byte* get(int16_t row);
+
+  // Returns true if the specified row is cached. Does not affect the LRU
+  // order.
+  bool contains(int16_t row) const;
+
+  // Allocates a slot for the specified row, which must not already be in
+  // the cache, evicting the least recently used row if needed. Returns the
+  // buffer to read the row into.
+  roo::byte* put(int16_t row);
+
+  // Removes all rows.
+  void clear();
+
+  uint16_t capacity() const { return capacity_; }
+
+ private:
+  roo::byte* slot(uint16_t idx) { return data_.get() + idx * row_bytes_; }
+
+  size_t row_bytes_;
+  uint16_t capacity_;
+  std::unique_ptr<roo::byte[]> data_;
+  std::unique_ptr<int16_t[]> rows_;
+  std::unique_ptr<uint32_t[]> last_used_;
+  uint32_t tick_;
+  uint16_t last_hit_;
+};
+
+}  // namespace internal
+
+/// Uncompressed raster image backed by a (possibly slow) resource, such as a
+/// file on an SD card or a flash partition, with random access to pixels.
+///
+/// The data format is the same as for `SimpleImage`: consecutive pixels, in
+/// row-major order, with sub-byte rows packed continuously.
+///
+/// Unlike `SimpleImage`, which can only be streamed sequentially, this class
+/// is a `Rasterizable`: it supports `readColors()`, and so it can be used as
+/// a background or an overlay, and drawn through viewports. To make random
+/// and windowed access cheap, it keeps the most recently used rows, in their
+/// raw format, in a small LRU cache. On a miss, the requested row and a few
+/// following ones (`read_ahead_rows`) are read in a single pass, and the
+/// resource iterator is kept open, so that top-to-bottom access (the common
+/// case for drawing) never seeks back. Rows are drawn straight from the
+/// cache via `drawDirectRect()` when the device format allows it.
+///
+/// For resources that are already in addressable memory (DRAM, PROGMEM, or
+/// memory-mapped flash), use `Raster` instead; it needs no cache.
+///
+/// The cache is owned by the raster, and not thread-safe. Streams created by
+/// the raster share the cache, and must not outlive it.
+template <typename Resource, typename ColorModeT,
+          ColorPixelOrder pixel_order = ColorPixelOrder::kMsbFirst,
+          ByteOrder byte_order = roo_io::kBigEndian>
+class CachedRaster : public Rasterizable {
+ public:
+  using ColorMode = ColorModeT;
+
+  /// Cache efficiency counters.
+  struct Stats {
+    /// Row lookups that found the row in the cache.
+    uint32_t hits;
+
+    /// Row lookups that required reading from the resource.
+    uint32_t misses;
+
+    /// Number of times the resource had to be (re)opened and skipped to a
+    /// row, rather than read sequentially.
+    uint32_t seeks;
+  };
+
+  /// Create a raster of the given size, backed by the resource. The cache
+  /// holds `cache_rows` rows; on a miss, up to `read_ahead_rows` rows are
+  /// loaded at once.
+  CachedRaster(int16_t width, int16_t height, Resource resource,
+               const ColorMode& color_mode = ColorMode(),
+               uint16_t cache_rows = 16, uint16_t read_ahead_rows = 4)
+      : CachedRaster(Box(0, 0, width - 1, height - 1), std::move(resource),
+                     color_mode, cache_rows, read_ahead_rows) {}
+
+  /// Create a raster with the given extents, backed by the resource.
+  CachedRaster(Box extents, Resource resource,
+               const ColorMode& color_mode = ColorMode(),
+               uint16_t cache_rows = 16, uint16_t read_ahead_rows = 4)
+      : extents_(extents),
+        resource_(std::move(resource)),
+        color_mode_(color_mode),
+        width_(extents.width()),
+        read_ahead_rows_(
+            std::max<uint16_t>(1, std::min(read_ahead_rows, cache_rows))),
+        cache_(new internal::RasterRowCache(maxRowBytes(), cache_rows)),
+        pos_(0),
+        last_byte_(0),
+        stats_{0, 0, 0} {}
+
+  CachedRaster(const CachedRaster&) = delete;
+  CachedRaster& operator=(const CachedRaster&) = delete;
+
+  Box extents() const override { return extents_; }
+
+  const ColorMode& color_mode() const { return color_mode_; }
+
+  TransparencyMode getTransparencyMode() const override {
+    return color_mode_.transparency();
+  }
+
+  /// Access underlying resource.
+  const Resource& resource() const { return resource_; }
+
+  void readColors(const int16_t* x, const int16_t* y, uint32_t count,
+                  Color* result) const override {
+    Reader read;
+    while (count-- > 0) {
+      int16_t row_idx = *y++ - extents_.yMin();
+      *result++ = read(row(row_idx), phase(row_idx) + *x++ - extents_.xMin(),
+                       color_mode_);
+    }
+  }
+
+  bool readColorRect(int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                     Color* result) const override {
+    Reader read;
+    for (int16_t y = yMin - extents_.yMin(); y <= yMax - extents_.yMin();
+         ++y) {
+      const roo::byte* data = row(y);
+      uint32_t offset = phase(y) + xMin - extents_.xMin();
+      for (int16_t x = xMin; x <= xMax; ++x) {
+        *result++ = read(data, offset++, color_mode_);
+      }
+    }
+    return false;
+  }
+
+  std::unique_ptr<PixelStream> createStream() const override {
+    return createStream(extents_);
+  }
+
+  std::unique_ptr<PixelStream> createStream(const Box& bounds) const override {
+    return std::unique_ptr<PixelStream>(new Stream(
+        *this, bounds.translate(-extents_.xMin(), -extents_.yMin())));
+  }
+
+  /// Drops all cached rows, e.g. after the underlying data has changed.
+  void invalidate() {
+    cache_->clear();
+    stream_.reset();
+  }
+
+  const Stats& stats() const { return stats_; }
+
+  void resetStats() { stats_ = Stats{0, 0, 0}; }
+
+ private:
+  using Reader = internal::Reader<ColorMode, pixel_order, byte_order>;
+
+  // Streams the pixels of the specified rectangle (in raster coordinates, i.e.
+  // relative to the top-left corner of the extents), reading the rows from
+  // the cache.
+  class Stream : public PixelStream {
+   public:
+    using PixelStream::read;
+
+    Stream(const CachedRaster& raster, Box bounds)
+        : raster_(raster),
+          bounds_(bounds),
+          x_(bounds.xMin()),
+          y_(bounds.yMin()) {}
+
+    void read(Color* buf, uint16_t size, uint32_t& run_length) override {
+      run_length = 0;
+      Reader read;
+      while (size > 0) {
+        // Looked up for every chunk, since other readers of the raster may
+        // have evicted the row in the meantime. Repeated lookups of the same
+        // row are cheap.
+        const roo::byte* data = raster_.row(y_);
+        uint32_t offset = raster_.phase(y_) + x_;
+        uint16_t n = std::min<int32_t>(size, bounds_.xMax() - x_ + 1);
+        for (uint16_t i = 0; i < n; ++i) {
+          *buf++ = read(data, offset++, raster_.color_mode_);
+        }
+        size -= n;
+        advance(n);
+      }
+    }
+
+    void skip(uint32_t count) override {
+      while (count > 0) {
+        uint32_t n = std::min<uint32_t>(count, bounds_.xMax() - x_ + 1);
+        count -= n;
+        advance(n);
+      }
+    }
+
+   private:
+    void advance(uint32_t n) {
+      x_ += n;
+      if (x_ > bounds_.xMax()) {
+        x_ = bounds_.xMin();
+        ++y_;
+      }
+    }
+
+    const CachedRaster& raster_;
+    Box bounds_;
+    int16_t x_;
+    int16_t y_;
+  };
+
+  void drawTo(const Surface& s) const override {
+    Box bounds =
+        Box::Intersect(s.clip_box().translate(-s.dx(), -s.dy()), extents_);
+    if (bounds.empty()) return;
+    Box src = bounds.translate(-extents_.xMin(), -extents_.yMin());
+    int16_t dst_x0 = bounds.xMin() + s.dx();
+    int16_t dst_y0 = bounds.yMin() + s.dy();
+    if (isDirectDrawable(s)) {
+      // The rows come straight from the cache, in the device format.
+      for (int16_t y = src.yMin(); y <= src.yMax(); ++y) {
+        int16_t p = phase(y);
+        s.out().drawDirectRect(row(y), maxRowBytes(), src.xMin() + p, 0,
+                               src.xMax() + p, 0, dst_x0,
+                               dst_y0 + y - src.yMin());
+      }
+      return;
+    }
+    // Whether the conversion is possible depends only on the surface, so if
+    // the first row succeeds, so will the others.
+    int16_t y = src.yMin();
+    while (y <= src.yMax()) {
+      int16_t p = phase(y);
+      if (!internal::DrawConvertedRect<ColorMode, pixel_order, byte_order>(
+              s, color_mode_, row(y), width_,
+              Box(src.xMin() + p, 0, src.xMax() + p, 0), dst_x0,
+              dst_y0 + y - src.yMin())) {
+        break;
+      }
+      ++y;
+    }
+    if (y > src.yMax()) return;
+    Stream stream(*this, src);
+    internal::FillRectFromStream(s.out(), bounds.translate(s.dx(), s.dy()),
+                                 &stream, s.bgcolor(), s.fill_mode(),
+                                 s.blending_mode(), getTransparencyMode());
+  }
+
+  // Whether the raw rows can be passed to the device as-is. Mirrors
+  // Raster::drawTo().
+  bool isDirectDrawable(const Surface& s) const {
+    bool source_opaque = (getTransparencyMode() == TransparencyMode::kNone);
+    if (!source_opaque &&
+        !(s.fill_mode() == FillMode::kExtents && s.bgcolor().a() == 0)) {
+      return false;
+    }
+    const DisplayOutput::ColorFormat& format = s.out().getColorFormat();
+    if (format.mode() == DisplayOutput::ColorFormat::kUnspecified ||
+        format.mode() != internal::ColorFormatTraits<ColorMode>::mode ||
+        format.pixel_order() != pixel_order ||
+        format.byte_order() != byte_order) {
+      return false;
+    }
+    BlendingMode mode = s.blending_mode();
+    if (mode == BlendingMode::kSource) return true;
+    if (!source_opaque) return false;
+    return mode == BlendingMode::kSourceOver ||
+           mode == BlendingMode::kSourceOverOpaque ||
+           (format.transparency() == TransparencyMode::kNone &&
+            (mode == BlendingMode::kSourceIn ||
+             mode == BlendingMode::kSourceAtop));
+  }
+
+  static constexpr int kPixelsPerByte = ColorTraits<ColorMode>::pixels_per_byte;
+
+  // Index of the first byte of the row, in the resource.
+  uint32_t firstByte(int16_t y) const {
+    return (uint32_t)y * width_ * ColorMode::bits_per_pixel / 8;
+  }
+
+  // Index past the last byte of the row, in the resource.
+  uint32_t endByte(int16_t y) const {
+    return ((uint32_t)(y + 1) * width_ * ColorMode::bits_per_pixel + 7) / 8;
+  }
+
+  // Position of the first pixel of the row within its first byte. Always zero
+  // for modes with at least one byte per pixel.
+  int16_t phase(int16_t y) const {
+    return ((uint32_t)y * width_) % kPixelsPerByte;
+  }
+
+  size_t maxRowBytes() const {
+    if constexpr (kPixelsPerByte == 1) {
+      return (size_t)width_ * ColorTraits<ColorMode>::bytes_per_pixel;
+    } else {
+      // Continuously packed rows may straddle an extra byte.
+      return (width_ + kPixelsPerByte - 1) / kPixelsPerByte + 1;
+    }
+  }
+
+  // Returns the raw data of the specified row (relative to the extents),
+  // loading it if needed. The pointer is valid until the next call.
+  const roo::byte* row(int16_t y) const {
+    const roo::byte* data = cache_->get(y);
+    if (data != nullptr) {
+      ++stats_.hits;
+      return data;
+    }
+    ++stats_.misses;
+    roo::byte* buf = cache_->put(y);
+    load(y, buf);
+    // Read ahead, since the subsequent rows are likely to be needed next.
+    // The read-ahead never exceeds the cache capacity, so it can't evict the
+    // requested row, which is the most recently used one.
+    int16_t last =
+        std::min<int16_t>(y + read_ahead_rows_ - 1, extents_.height() - 1);
+    for (int16_t r = y + 1; r <= last && !cache_->contains(r); ++r) {
+      load(r, cache_->put(r));
+    }
+    return buf;
+  }
+
+  // Reads the raw bytes of row `y` from the resource into `buf`, continuing
+  // from the current position of the stream if possible.
+  void load(int16_t y, roo::byte* buf) const {
+    uint32_t start = firstByte(y);
+    uint32_t end = endByte(y);
+    roo::byte* out = buf;
+    if (stream_ != nullptr && pos_ > 0 && start == pos_ - 1) {
+      // Sub-byte rows share the boundary byte.
+      *out++ = last_byte_;
+      ++start;
+    }
+    if (stream_ == nullptr || start < pos_) {
+      stream_.reset(new StreamType<Resource>(resource_.iterator()));
+      pos_ = 0;
+      ++stats_.seeks;
+    }
+    if (start > pos_) {
+      stream_->skip(start - pos_);
+      pos_ = start;
+    }
+    size_t remaining = end - start;
+    while (remaining > 0) {
+      size_t n = stream_->read(out, remaining);
+      if (n == 0) break;
+      out += n;
+      remaining -= n;
+    }
+    pos_ = end;
+    last_byte_ = buf[end - firstByte(y) - 1];
+  }
+
+  Box extents_;
+  Resource resource_;
+  ColorMode color_mode_;
+  int16_t width_;
+  int16_t read_ahead_rows_;
+  std::unique_ptr<internal::RasterRowCache> cache_;
+
+  // Sequential reader state.
+  mutable std::unique_ptr<StreamType<Resource>> stream_;
+  mutable uint32_t pos_;
+  mutable roo::byte last_byte_;
+
+  mutable Stats stats_;
+};
+
+}  // namespace roo_display
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+
 #include "roo_display/color/color.h"
 #include "roo_display/core/drawable.h"
 #include "roo_display/core/raster.h"
@@ -88,8 +90,42 @@ class RleStreamUniform<Resource, ColorMode, bits_per_pixel, false>
     }
   }
 
+  uint32_t readSpan(Color* buf, uint16_t size, uint32_t max_count,
+                    bool& is_run) override {
+    if (remaining_items_ == 0) {
+      decode_next_group();
+    }
+    uint32_t n = remaining_items_;
+    if (n > max_count) n = max_count;
+    is_run = run_;
+    if (run_) {
+      buf[0] = run_value_;
+    } else {
+      if (n > size) n = size;
+      for (uint32_t i = 0; i < n; ++i) {
+        buf[i] = read_color();
+      }
+    }
+    remaining_items_ -= n;
+    if (remaining_items_ == 0) run_ = false;
+    return n;
+  }
+
   void skip(uint32_t n) override {
-    while (n-- > 0) next();
+    while (n > 0) {
+      if (remaining_items_ == 0) {
+        decode_next_group();
+      }
+      if (!run_) {
+        next();
+        --n;
+        continue;
+      }
+      uint32_t count = std::min<uint32_t>(n, remaining_items_);
+      remaining_items_ -= count;
+      if (remaining_items_ == 0) run_ = false;
+      n -= count;
+    }
   }
 
   Color next() {
@@ -167,8 +203,44 @@ class RleStreamUniform<Resource, ColorMode, bits_per_pixel, true>
     }
   }
 
+  uint32_t readSpan(Color* buf, uint16_t size, uint32_t max_count,
+                    bool& is_run) override {
+    if (remaining_items_ == 0) {
+      decode_next_group();
+    }
+    uint32_t n = remaining_items_;
+    if (n > max_count) n = max_count;
+    if (current_run_prefix() > 0) {
+      // The repeated byte has all pixels of the same color.
+      is_run = true;
+      buf[0] = value_[pixels_per_byte - 1 -
+                      (remaining_items_ - 1) % pixels_per_byte];
+      remaining_items_ -= n;
+      return n;
+    }
+    is_run = false;
+    if (n > size) n = size;
+    for (uint32_t i = 0; i < n; ++i) {
+      buf[i] = next();
+    }
+    return n;
+  }
+
   void skip(uint32_t n) override {
-    while (n-- > 0) next();
+    while (n > 0) {
+      if (remaining_items_ == 0) {
+        decode_next_group();
+      }
+      if (!run_) {
+        next();
+        --n;
+        continue;
+      }
+      // All bytes in the run are the same, so only the position matters.
+      uint32_t count = std::min<uint32_t>(n, remaining_items_);
+      remaining_items_ -= count;
+      n -= count;
+    }
   }
 
   Color next() {
@@ -203,7 +275,8 @@ class RleStreamUniform<Resource, ColorMode, bits_per_pixel, true>
     if (!run_ || remaining_items_ == 0) return 0;
     // This is a real run only if all the pixels in the batch actually have the
     // same color.
-    int index = pixels_per_byte - 1 - remaining_items_ % pixels_per_byte;
+    int index =
+        pixels_per_byte - 1 - (remaining_items_ - 1) % pixels_per_byte;
     Color color = value_[index];
     uint32_t max = remaining_items_;
     for (uint32_t i = 1; i < max; ++i) {
@@ -261,8 +334,41 @@ class RleStreamRgb565Alpha4 : public PixelStream {
     }
   }
 
+  uint32_t readSpan(Color* buf, uint16_t size, uint32_t max_count,
+                    bool& is_run) override {
+    if (remaining_items_ == 0) {
+      decode_next_group();
+    }
+    uint32_t n = remaining_items_;
+    if (n > max_count) n = max_count;
+    // With per-pixel alpha, the pixels differ even if RGB is uniform.
+    is_run = (run_rgb_ && alpha_mode_ != 0);
+    if (is_run) {
+      buf[0] = run_value_;
+      remaining_items_ -= n;
+      return n;
+    }
+    if (n > size) n = size;
+    for (uint32_t i = 0; i < n; ++i) {
+      buf[i] = next();
+    }
+    return n;
+  }
+
   void skip(uint32_t count) override {
-    while (--count >= 0) next();
+    while (count > 0) {
+      if (remaining_items_ == 0) {
+        decode_next_group();
+      }
+      if (!run_rgb_ || alpha_mode_ == 0) {
+        next();
+        --count;
+        continue;
+      }
+      uint32_t n = std::min<uint32_t>(count, remaining_items_);
+      remaining_items_ -= n;
+      count -= n;
+    }
   }
 
   Color next() {
@@ -325,10 +431,12 @@ class RleStreamRgb565Alpha4 : public PixelStream {
       case 2: {
         remaining_items_ = data & 0x10 ? read_varint(data & 0x0F) : data & 0x0F;
         alpha_buf_ = 0xFF;
+        break;
       }
       case 3: {
         remaining_items_ = data & 0x10 ? read_varint(data & 0x0F) : data & 0x0F;
         alpha_buf_ = 0x00;
+        break;
       }
     }
     if (run_rgb_) {
@@ -343,7 +451,7 @@ class RleStreamRgb565Alpha4 : public PixelStream {
 
   uint32_t read_varint(uint32_t result) {
     while (true) {
-      result <= 7;
+      result <<= 7;
       uint8_t datum = input_.read();
       result |= (datum & 0x7F);
       if ((datum & 0x80) == 0) return result;
@@ -465,8 +573,42 @@ class RleStream4bppxBiased<Resource, ColorMode, 4> : public PixelStream {
     }
   }
 
+  uint32_t readSpan(Color* buf, uint16_t size, uint32_t max_count,
+                    bool& is_run) override {
+    if (remaining_items_ == 0) {
+      decode_next_group();
+    }
+    uint32_t n = remaining_items_;
+    if (n > max_count) n = max_count;
+    is_run = run_;
+    if (run_) {
+      buf[0] = run_value_;
+    } else {
+      if (n > size) n = size;
+      for (uint32_t i = 0; i < n; ++i) {
+        buf[i] = color(reader_.next());
+      }
+    }
+    remaining_items_ -= n;
+    if (remaining_items_ == 0) run_ = false;
+    return n;
+  }
+
   void skip(uint32_t n) override {
-    while (n-- > 0) next();
+    while (n > 0) {
+      if (remaining_items_ == 0) {
+        decode_next_group();
+      }
+      if (!run_) {
+        next();
+        --n;
+        continue;
+      }
+      uint32_t count = std::min<uint32_t>(n, remaining_items_);
+      remaining_items_ -= count;
+      if (remaining_items_ == 0) run_ = false;
+      n -= count;
+    }
   }
 
   TransparencyMode transparency() const { return color_mode_.transparency(); }
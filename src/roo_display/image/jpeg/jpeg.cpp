@@ -1,9 +1,15 @@
 #include "roo_display/image/jpeg/jpeg.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "roo_backport.h"
 #include "roo_backport/byte.h"
 #include "roo_display.h"
+#include "roo_display/color/color_modes.h"
+#include "roo_display/composition/parallel_rasterizable.h"
 #include "roo_display/core/raster.h"
+#include "roo_display/internal/color_io.h"
 
 namespace roo_display {
 
@@ -18,14 +24,297 @@ namespace roo_display {
 #define TJPGD_WORKSPACE_SIZE (3500 + 6144)
 #endif
 
-JpegDecoder::JpegDecoder()
+namespace {
+
+// Converts `count` pixels from RGB888, as output by TJpgDec, to the specified
+// color mode, in place.
+template <typename ColorMode, roo_io::ByteOrder byte_order>
+void ConvertPixels(roo::byte* data, int16_t count) {
+  constexpr int kBytesPerPixel = ColorTraits<ColorMode>::bytes_per_pixel;
+  ColorIo<ColorMode, byte_order> io;
+  const roo::byte* in = data;
+  roo::byte* out = data;
+  while (count-- > 0) {
+    io.store(Color((uint8_t)in[0], (uint8_t)in[1], (uint8_t)in[2]), out);
+    in += 3;
+    out += kBytesPerPixel;
+  }
+}
+
+typedef void (*Converter)(roo::byte* data, int16_t count);
+
+// Returns true if the bands can be written in the device's native format. If
+// so, sets *converter to the function that converts the rows (or to nullptr,
+// if they are already in the native format).
+bool GetNativeConverter(const Surface& s, Converter* converter) {
+  // The pixels are opaque, so they replace the previous content, as long as
+  // the blending mode is one of these (same rules as for rasters).
+  BlendingMode mode = s.blending_mode();
+  const DisplayOutput::ColorFormat& format = s.out().getColorFormat();
+  if (mode != BlendingMode::kSource && mode != BlendingMode::kSourceOver &&
+      mode != BlendingMode::kSourceOverOpaque &&
+      !(format.transparency() == TransparencyMode::kNone &&
+        (mode == BlendingMode::kSourceIn ||
+         mode == BlendingMode::kSourceAtop))) {
+    return false;
+  }
+  switch (format.mode()) {
+    case DisplayOutput::ColorFormat::kModeRgb565: {
+      *converter = (format.byte_order() == roo_io::kBigEndian)
+                       ? &ConvertPixels<Rgb565, roo_io::kBigEndian>
+                       : &ConvertPixels<Rgb565, roo_io::kLittleEndian>;
+      return true;
+    }
+    case DisplayOutput::ColorFormat::kModeRgb888: {
+      *converter = (format.byte_order() == roo_io::kBigEndian)
+                       ? nullptr
+                       : &ConvertPixels<Rgb888, roo_io::kLittleEndian>;
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+// Returns the size of the image dimension, after scaling, as output by
+// TJpgDec. (Each MCU gets scaled separately, with rounding down.)
+int16_t ScaledSize(int16_t size, int16_t mcu_size, uint8_t scale) {
+  int16_t last_mcu = (size - 1) / mcu_size * mcu_size;
+  return (last_mcu >> scale) + ((size - last_mcu) >> scale);
+}
+
+// Holds the mutex (if any) for the lifetime of the scope.
+class IoTurn {
+ public:
+  IoTurn(roo::mutex* mutex) : mutex_(mutex) {
+    if (mutex_ != nullptr) mutex_->lock();
+  }
+
+  ~IoTurn() {
+    if (mutex_ != nullptr) mutex_->unlock();
+  }
+
+ private:
+  roo::mutex* mutex_;
+};
+
+}  // namespace
+
+int jpeg_draw_rect(JDEC* jdec, void* data, JRECT* rect);
+
+// Collects the decoded MCUs into bands, one MCU row tall, and draws them. The
+// decoding may run on a pool worker, filling the next band while the drawing
+// thread draws the previous one. If the input may share the bus with the
+// display, the input reads and the band transfers take turns.
+class JpegBands : public RenderWorkerPool::Job {
+ public:
+  // The `bounds` is the visible portion of the (scaled) image, in the image
+  // coordinates. Must not be empty. The decoder must be open.
+  JpegBands(JpegDecoder& decoder, const Surface& s, uint8_t scale, Box bounds,
+            bool threaded)
+      : decoder_(decoder),
+        s_(s),
+        scale_(scale),
+        bounds_(bounds),
+        converter_(nullptr),
+        direct_(GetNativeConverter(s, &converter_)),
+        row_bytes_(bounds.width() * 3),
+        band_height_(
+            std::max<int16_t>(1, (decoder.jdec_.msy * 8) >> scale)),
+        slot_count_(threaded ? 2 : 1),
+        data_(new roo::byte[slot_count_ * band_height_ * row_bytes_]),
+        top_(new int16_t[slot_count_]),
+        bottom_(new int16_t[slot_count_]),
+        fill_top_(-1),
+        fill_band_(0),
+        threaded_(threaded),
+        exclusive_io_(threaded && decoder.input_shares_display_bus_),
+        ready_count_(0),
+        drawn_count_(0),
+        decoding_claimed_(false),
+        done_(false) {}
+
+  // Decodes and draws the image. If the pool is specified, decoding runs on
+  // one of its workers.
+  void run(RenderWorkerPool* pool) {
+    if (!threaded_) {
+      decode();
+      return;
+    }
+    pool->start(*this);
+    int16_t band = 0;
+    while (true) {
+      {
+        roo::unique_lock<roo::mutex> lock(mutex_);
+        while (band >= ready_count_ && !done_) cv_.wait(lock);
+        if (band >= ready_count_) break;
+      }
+      drawBand(band % slot_count_);
+      {
+        roo::unique_lock<roo::mutex> lock(mutex_);
+        drawn_count_ = ++band;
+        cv_.notify_all();
+      }
+    }
+    pool->finish();
+  }
+
+  // Called by the pool workers. Only the first one decodes.
+  void work() override {
+    {
+      roo::unique_lock<roo::mutex> lock(mutex_);
+      if (decoding_claimed_) return;
+      decoding_claimed_ = true;
+    }
+    decode();
+    roo::unique_lock<roo::mutex> lock(mutex_);
+    done_ = true;
+    cv_.notify_all();
+  }
+
+  // Called for each decoded MCU, on the decoding thread. Returns false if the
+  // decoding should stop.
+  bool addMcu(const JRECT& rect, const roo::byte* data) {
+    if (rect.top > bounds_.yMax()) {
+      // The rest of the image will be clipped out; we can finish early.
+      return false;
+    }
+    if (rect.bottom < bounds_.yMin()) return true;
+    if (rect.top != fill_top_) {
+      finishBand();
+      if (threaded_) {
+        // Wait for the slot to be drawn.
+        roo::unique_lock<roo::mutex> lock(mutex_);
+        while (fill_band_ >= drawn_count_ + slot_count_) cv_.wait(lock);
+      }
+      uint8_t slot = fill_band_ % slot_count_;
+      top_[slot] = rect.top;
+      bottom_[slot] = rect.bottom;
+      fill_top_ = rect.top;
+    }
+    int16_t x0 = std::max<int16_t>(rect.left, bounds_.xMin());
+    int16_t x1 = std::min<int16_t>(rect.right, bounds_.xMax());
+    if (x0 > x1) return true;
+    int16_t y0 = std::max<int16_t>(rect.top, bounds_.yMin());
+    int16_t y1 = std::min<int16_t>(rect.bottom, bounds_.yMax());
+    size_t src_row_bytes = (rect.right - rect.left + 1) * 3;
+    const roo::byte* src =
+        data + (y0 - rect.top) * src_row_bytes + (x0 - rect.left) * 3;
+    roo::byte* dst = slotData(fill_band_ % slot_count_) +
+                     (y0 - rect.top) * row_bytes_ + (x0 - bounds_.xMin()) * 3;
+    for (int16_t y = y0; y <= y1; ++y) {
+      memcpy(dst, src, (x1 - x0 + 1) * 3);
+      src += src_row_bytes;
+      dst += row_bytes_;
+    }
+    return true;
+  }
+
+  // Returns the mutex that the input reads and the output transfers must
+  // hold, or nullptr if they can overlap.
+  roo::mutex* ioMutex() { return exclusive_io_ ? &io_mutex_ : nullptr; }
+
+ private:
+  void decode() {
+    jd_decomp(&decoder_.jdec_, &jpeg_draw_rect, scale_);
+    finishBand();
+  }
+
+  // Hands over the band being filled (if any) for drawing. Called on the
+  // decoding thread.
+  void finishBand() {
+    if (fill_top_ < 0) return;
+    fill_top_ = -1;
+    if (!threaded_) {
+      drawBand(fill_band_ % slot_count_);
+      ++fill_band_;
+      return;
+    }
+    roo::unique_lock<roo::mutex> lock(mutex_);
+    ready_count_ = ++fill_band_;
+    cv_.notify_all();
+  }
+
+  // Draws the visible rows of the band in the specified slot. Called on the
+  // drawing thread.
+  void drawBand(uint8_t slot) {
+    int16_t y0 = std::max<int16_t>(top_[slot], bounds_.yMin());
+    int16_t y1 = std::min<int16_t>(bottom_[slot], bounds_.yMax());
+    roo::byte* data = slotData(slot) + (y0 - top_[slot]) * row_bytes_;
+    if (direct_ && converter_ != nullptr) {
+      for (int16_t y = y0; y <= y1; ++y) {
+        converter_(data + (y - y0) * row_bytes_, bounds_.width());
+      }
+    }
+    // The output transaction must be over (the output paused) before the
+    // input can be read again.
+    IoTurn turn(ioMutex());
+    ResumeOutput resume(s_.out());
+    if (direct_) {
+      s_.out().drawDirectRect(data, row_bytes_, 0, 0, bounds_.width() - 1,
+                              y1 - y0, bounds_.xMin() + s_.dx(),
+                              y0 + s_.dy());
+    } else {
+      ConstDramRaster<Rgb888> raster(
+          Box(bounds_.xMin(), y0, bounds_.xMax(), y1), data);
+      s_.drawObject(raster);
+    }
+  }
+
+  roo::byte* slotData(uint8_t slot) {
+    return &data_[slot * band_height_ * row_bytes_];
+  }
+
+  JpegDecoder& decoder_;
+  const Surface& s_;
+  uint8_t scale_;
+  Box bounds_;
+  Converter converter_;
+  bool direct_;
+  size_t row_bytes_;
+  int16_t band_height_;
+  uint8_t slot_count_;
+  std::unique_ptr<roo::byte[]> data_;
+
+  // Per slot: the (scaled) image rows covered by the band.
+  std::unique_ptr<int16_t[]> top_;
+  std::unique_ptr<int16_t[]> bottom_;
+
+  // Used by the decoding thread. The top of the band being filled, or -1 if
+  // none, and the sequential number of that band.
+  int16_t fill_top_;
+  int16_t fill_band_;
+
+  bool threaded_;
+
+  // Whether the input reads must not overlap with the output transfers.
+  bool exclusive_io_;
+  roo::mutex io_mutex_;
+
+  // Guard the fields below, if threaded.
+  roo::mutex mutex_;
+  roo::condition_variable cv_;
+  int16_t ready_count_;
+  int16_t drawn_count_;
+  bool decoding_claimed_;
+  bool done_;
+};
+
+JpegDecoder::JpegDecoder(RenderWorkerPool* pool,
+                         bool input_shares_display_bus)
     : workspace_(new uint8_t[TJPGD_WORKSPACE_SIZE]),
       jdec_(),
       input_(nullptr),
-      surface_(nullptr) {}
+      pool_(pool),
+      input_shares_display_bus_(input_shares_display_bus),
+      bands_(nullptr) {}
 
 size_t jpeg_read(JDEC* jdec, uint8_t* buf, size_t size) {
   JpegDecoder* decoder = (JpegDecoder*)jdec->device;
+  // While drawing with a worker pool, the reads happen on the worker.
+  IoTurn turn(decoder->bands_ == nullptr ? nullptr
+                                         : decoder->bands_->ioMutex());
   if (buf != nullptr) {
     return decoder->input_->read((roo::byte*)buf, size);
   } else {
@@ -36,18 +325,7 @@ size_t jpeg_read(JDEC* jdec, uint8_t* buf, size_t size) {
 
 int jpeg_draw_rect(JDEC* jdec, void* data, JRECT* rect) {
   JpegDecoder* decoder = (JpegDecoder*)jdec->device;
-  const Surface* surface = decoder->surface_;
-  if (rect->top + surface->dy() > surface->clip_box().yMax()) {
-    // The rest of the image will be clipped out; we can finish early.
-    return 0;
-  }
-  Box box(rect->left, rect->top, rect->right, rect->bottom);
-  ConstDramRaster<Rgb888> raster(box, (const roo::byte*)data);
-  {
-    ResumeOutput resume(surface->out());
-    surface->drawObject(raster);
-  }
-  return 1;
+  return decoder->bands_->addMcu(*rect, (const roo::byte*)data) ? 1 : 0;
 }
 
 bool JpegDecoder::getDimensions(const roo_io::MultipassResource& resource,
@@ -82,9 +360,19 @@ void JpegDecoder::draw(const roo_io::MultipassResource& resource,
     return;
   }
 
-  surface_ = &s;
-  jd_decomp(&jdec_, &jpeg_draw_rect, scale);
-  surface_ = nullptr;
+  Box extents(0, 0, ScaledSize(width, jdec_.msx * 8, scale) - 1,
+              ScaledSize(height, jdec_.msy * 8, scale) - 1);
+  Box bounds =
+      Box::Intersect(s.clip_box().translate(-s.dx(), -s.dy()), extents);
+  if (bounds.empty()) {
+    close();
+    return;
+  }
+  bool threaded = (pool_ != nullptr && pool_->worker_count() > 0);
+  JpegBands bands(*this, s, scale, bounds, threaded);
+  bands_ = &bands;
+  bands.run(threaded ? pool_ : nullptr);
+  bands_ = nullptr;
 
   close();
 }
@@ -20,13 +20,42 @@
 
 namespace roo_display {
 
+class RenderWorkerPool;
+class JpegBands;
+
 /// JPEG decoder (stateful, reusable).
+///
+/// The decoded MCUs (blocks of 8x8 to 16x16 pixels) are collected into bands,
+/// one MCU row tall, and each band is drawn with a single call. When the
+/// image replaces the underlying pixels (e.g. with `BlendingMode::kSource` or
+/// `kSourceOver`, as JPEGs are opaque), and the device uses RGB565 or RGB888,
+/// the bands are converted in place to the device's native format, and sent
+/// via `DisplayOutput::drawDirectRect()`. Decoding stops as soon as the
+/// remaining rows are clipped out.
+///
+/// A band takes (visible image width) x 16 x 3 bytes of RAM, e.g. 15 KB for a
+/// 320-pixel-wide image.
 class JpegDecoder {
  public:
   /// Construct a JPEG decoder instance.
-  JpegDecoder();
+  ///
+  /// If `pool` is specified (and has at least one worker), decoding runs on a
+  /// worker thread, while the calling thread converts and transfers the
+  /// previously decoded bands, so that the two overlap (e.g. on the two cores
+  /// of an ESP32). This uses two bands instead of one. The pool must outlive
+  /// the decoder, and must not be used concurrently by other drawing.
+  ///
+  /// By default, the resources are assumed to possibly share the bus with
+  /// the display (e.g. an SD card on the display's SPI bus), and the worker's
+  /// input reads take turns with the band transfers, happening only while
+  /// the output is paused. If the resources are known to be elsewhere (e.g.
+  /// in memory, or flash), set `input_shares_display_bus` to false, so that
+  /// the reads can overlap with the transfers.
+  explicit JpegDecoder(RenderWorkerPool* pool = nullptr,
+                       bool input_shares_display_bus = true);
 
  private:
+  friend class JpegBands;
   friend class JpegImage;
   friend size_t jpeg_read(JDEC*, uint8_t*, size_t);
   friend int jpeg_draw_rect(JDEC* jdec, void* data, JRECT* rect);
@@ -46,7 +75,11 @@ class JpegDecoder {
   JDEC jdec_;
 
   std::unique_ptr<roo_io::MultipassInputStream> input_;
-  const Surface* surface_;
+  RenderWorkerPool* pool_;
+  bool input_shares_display_bus_;
+
+  // Set while drawing.
+  JpegBands* bands_;
 };
 
 /// Drawable JPEG image backed by a multipass resource.
@@ -1,8 +1,12 @@
 #include "roo_display/image/png/png.h"
 
+#include <algorithm>
+
 #include "roo_display.h"
-#include "roo_display/color/color_mode_indexed.h"
+#include "roo_display/color/color_modes.h"
+#include "roo_display/core/raster.h"
 #include "roo_display/image/png/lib/png.inl"
+#include "roo_display/internal/color_io.h"
 
 PNG_STATIC int PNGInit(PNGIMAGE *pPNG);
 PNG_STATIC int DecodePNG(PNGIMAGE *pImage, void *pUser, int iOptions);
@@ -25,75 +29,320 @@ int32_t png_seek(PNGFILE *pFile, int32_t iPosition) {
 
 namespace {
 
-struct User {
-  const Surface *surface;
-  const Palette *palette;
-};
+// Upper bound on the size of a band, in bytes. A band always has at least one
+// row, though.
+static constexpr size_t kMaxBandBytes = 8192;
 
-}  // namespace
+// Converts `count` pixels of a decoded row, starting at `x0`, to colors.
+typedef void (*RowReader)(const uint8_t *row, int16_t x0, int16_t count,
+                          const Color *palette, Color *out);
 
-void png_draw(PNGDRAW *pDraw) {
-  User &user = *((User *)pDraw->pUser);
-  const Surface *surface = user.surface;
-  int16_t y = pDraw->y;
-  if (y + surface->dy() < surface->clip_box().yMin() ||
-      y + surface->dy() > surface->clip_box().yMax()) {
-    return;
+// Encodes `count` colors into a row of a band.
+typedef void (*RowWriter)(const Color *in, int16_t count, roo::byte *out);
+
+template <typename ColorMode>
+void ReadPixels(const uint8_t *row, int16_t x0, int16_t count,
+                const Color *palette, Color *out) {
+  constexpr int kBytesPerPixel = ColorTraits<ColorMode>::bytes_per_pixel;
+  ColorIo<ColorMode, roo_io::kBigEndian> io;
+  const roo::byte *in = (const roo::byte *)row + x0 * kBytesPerPixel;
+  while (count-- > 0) {
+    *out++ = io.load(in);
+    in += kBytesPerPixel;
   }
-  Box box(0, y, pDraw->iWidth - 1, y);
-  ResumeOutput resume(surface->out());
-  switch (pDraw->iPixelType) {
-    case PNG_PIXEL_TRUECOLOR_ALPHA: {
-      ConstDramRaster<Rgba8888> raster(box, (const roo::byte *)pDraw->pPixels);
-      surface->drawObject(raster);
-      break;
-    }
-    case PNG_PIXEL_TRUECOLOR: {
-      ConstDramRaster<Rgb888> raster(box, (const roo::byte *)pDraw->pPixels);
-      surface->drawObject(raster);
-      break;
-    }
+}
+
+// Returns the raw value of a sub-byte pixel. PNG packs them starting with the
+// most significant bits.
+template <int kBits>
+inline uint8_t RawPixel(const uint8_t *row, int16_t x) {
+  uint32_t bit = (uint32_t)x * kBits;
+  return (row[bit >> 3] >> (8 - kBits - (bit & 7))) & ((1 << kBits) - 1);
+}
+
+template <int kBits>
+void ReadIndexed(const uint8_t *row, int16_t x0, int16_t count,
+                 const Color *palette, Color *out) {
+  for (int16_t x = x0; x < x0 + count; ++x) {
+    *out++ = palette[RawPixel<kBits>(row, x)];
+  }
+}
+
+template <int kBits>
+void ReadGray(const uint8_t *row, int16_t x0, int16_t count,
+              const Color *palette, Color *out) {
+  for (int16_t x = x0; x < x0 + count; ++x) {
+    uint8_t v = RawPixel<kBits>(row, x) * (255 / ((1 << kBits) - 1));
+    *out++ = Color(v, v, v);
+  }
+}
+
+RowReader GetRowReader(int pixel_type, int bpp) {
+  switch (pixel_type) {
+    case PNG_PIXEL_TRUECOLOR_ALPHA:
+      return &ReadPixels<Rgba8888>;
+    case PNG_PIXEL_TRUECOLOR:
+      return &ReadPixels<Rgb888>;
+    case PNG_PIXEL_GRAY_ALPHA:
+      return &ReadPixels<GrayAlpha8>;
     case PNG_PIXEL_GRAYSCALE: {
-      ConstDramRaster<Grayscale8> raster(box,
-                                         (const roo::byte *)pDraw->pPixels);
-      surface->drawObject(raster);
-      break;
-    }
-    case PNG_PIXEL_GRAY_ALPHA: {
-      ConstDramRaster<GrayAlpha8> raster(box,
-                                         (const roo::byte *)pDraw->pPixels);
-      surface->drawObject(raster);
-      break;
+      switch (bpp) {
+        case 1:
+          return &ReadGray<1>;
+        case 2:
+          return &ReadGray<2>;
+        case 4:
+          return &ReadGray<4>;
+        default:
+          return &ReadPixels<Grayscale8>;
+      }
     }
     case PNG_PIXEL_INDEXED: {
-      switch (pDraw->iBpp) {
-        case 8: {
-          ConstDramRaster<Indexed8> raster(
-              box, (const roo::byte *)pDraw->pPixels, Indexed8(user.palette));
-          surface->drawObject(raster);
-          break;
-        }
-        case 4: {
-          ConstDramRaster<Indexed4> raster(
-              box, (const roo::byte *)pDraw->pPixels, Indexed4(user.palette));
-          surface->drawObject(raster);
-          break;
-        }
-        case 2: {
-          ConstDramRaster<Indexed2> raster(
-              box, (const roo::byte *)pDraw->pPixels, Indexed2(user.palette));
-          surface->drawObject(raster);
-          break;
-        }
-        case 1: {
-          ConstDramRaster<Indexed1> raster(
-              box, (const roo::byte *)pDraw->pPixels, Indexed1(user.palette));
-          surface->drawObject(raster);
-          break;
-        }
+      switch (bpp) {
+        case 1:
+          return &ReadIndexed<1>;
+        case 2:
+          return &ReadIndexed<2>;
+        case 4:
+          return &ReadIndexed<4>;
+        default:
+          return &ReadIndexed<8>;
       }
     }
+    default:
+      return nullptr;
+  }
+}
+
+template <typename ColorMode, roo_io::ByteOrder byte_order>
+void WritePixels(const Color *in, int16_t count, roo::byte *out) {
+  constexpr int kBytesPerPixel = ColorTraits<ColorMode>::bytes_per_pixel;
+  ColorIo<ColorMode, byte_order> io;
+  while (count-- > 0) {
+    io.store(*in++, out);
+    out += kBytesPerPixel;
+  }
+}
+
+template <typename ColorMode>
+RowWriter GetRowWriter(roo_io::ByteOrder byte_order) {
+  return byte_order == roo_io::kBigEndian
+             ? &WritePixels<ColorMode, roo_io::kBigEndian>
+             : &WritePixels<ColorMode, roo_io::kLittleEndian>;
+}
+
+// Returns the writer that encodes colors in the specified native format, or
+// nullptr if the format is not supported. Sets *bytes_per_pixel accordingly.
+RowWriter GetNativeRowWriter(const DisplayOutput::ColorFormat &format,
+                             uint8_t *bytes_per_pixel) {
+  switch (format.mode()) {
+    case DisplayOutput::ColorFormat::kModeRgb565:
+      *bytes_per_pixel = 2;
+      return GetRowWriter<Rgb565>(format.byte_order());
+    case DisplayOutput::ColorFormat::kModeRgb888:
+      *bytes_per_pixel = 3;
+      return GetRowWriter<Rgb888>(format.byte_order());
+    case DisplayOutput::ColorFormat::kModeArgb8888:
+      *bytes_per_pixel = 4;
+      return GetRowWriter<Argb8888>(format.byte_order());
+    case DisplayOutput::ColorFormat::kModeRgba8888:
+      *bytes_per_pixel = 4;
+      return GetRowWriter<Rgba8888>(format.byte_order());
+    default:
+      return nullptr;
+  }
+}
+
+// Whether the pixels can be written as-is, replacing the previous content
+// (same rules as for rasters).
+bool CanDrawDirect(const Surface &s, bool opaque,
+                   const DisplayOutput::ColorFormat &format) {
+  if (!opaque && !(s.fill_mode() == FillMode::kExtents &&
+                   s.bgcolor().a() == 0)) {
+    return false;
+  }
+  BlendingMode mode = s.blending_mode();
+  if (mode == BlendingMode::kSource) return true;
+  if (!opaque) return false;
+  if (mode == BlendingMode::kSourceOver ||
+      mode == BlendingMode::kSourceOverOpaque) {
+    return true;
+  }
+  return format.transparency() == TransparencyMode::kNone &&
+         (mode == BlendingMode::kSourceIn || mode == BlendingMode::kSourceAtop);
+}
+
+// Collects the decoded (and possibly downscaled) rows into bands, and draws
+// them.
+class BandWriter {
+ public:
+  // The `bounds` is the visible portion of the (scaled) image, in the image
+  // coordinates. Must not be empty.
+  BandWriter(const Surface &s, int16_t width, int16_t height, uint8_t scale,
+             Box bounds)
+      : s_(s),
+        height_(height),
+        scale_(scale),
+        bounds_(bounds),
+        src_x0_(bounds.xMin() << scale),
+        src_count_(std::min<int16_t>((bounds.xMax() + 1) << scale, width) -
+                   src_x0_),
+        reader_(nullptr),
+        writer_(nullptr),
+        direct_(false),
+        row_bytes_(0),
+        band_capacity_(0),
+        band_rows_(0),
+        band_y0_(0) {}
+
+  // Processes a decoded row. Returns false if the remaining rows are not
+  // needed.
+  bool addRow(const PNGDRAW &draw);
+
+  // Draws the pending rows.
+  void flush();
+
+ private:
+  // Prepares the buffers, once the pixel type is known.
+  void init(const PNGDRAW &draw);
+
+  // Adds the colors (in row_) to the downscaling sums.
+  void accumulate();
+
+  // Converts the downscaling sums (covering `rows` source rows) to colors in
+  // row_, and resets them.
+  void average(int16_t rows);
+
+  // Appends the output row with the specified y coordinate.
+  void emitRow(int16_t y);
+
+  const Surface &s_;
+  int16_t height_;
+  uint8_t scale_;
+  Box bounds_;
+
+  // Source columns that cover bounds_.
+  int16_t src_x0_;
+  int16_t src_count_;
+
+  RowReader reader_;
+  RowWriter writer_;
+  bool direct_;
+  size_t row_bytes_;
+  int16_t band_capacity_;
+  int16_t band_rows_;
+  int16_t band_y0_;
+  std::unique_ptr<roo::byte[]> band_;
+
+  // Colors of the current row.
+  std::unique_ptr<Color[]> row_;
+
+  // Per output pixel: sum(a), sum(r * a), sum(g * a), sum(b * a).
+  std::unique_ptr<uint32_t[]> sums_;
+};
+
+void BandWriter::init(const PNGDRAW &draw) {
+  reader_ = GetRowReader(draw.iPixelType, draw.iBpp);
+  const DisplayOutput::ColorFormat &format = s_.out().getColorFormat();
+  uint8_t bytes_per_pixel = 0;
+  if (CanDrawDirect(s_, !draw.iHasAlpha, format)) {
+    writer_ = GetNativeRowWriter(format, &bytes_per_pixel);
+  }
+  direct_ = (writer_ != nullptr);
+  if (!direct_) {
+    // Draw via a regular raster, which handles blending.
+    writer_ = &WritePixels<Argb8888, roo_io::kBigEndian>;
+    bytes_per_pixel = 4;
+  }
+  row_bytes_ = bounds_.width() * bytes_per_pixel;
+  band_capacity_ = std::max<int16_t>(
+      1, std::min<size_t>(bounds_.height(), kMaxBandBytes / row_bytes_));
+  band_.reset(new roo::byte[row_bytes_ * band_capacity_]);
+  row_.reset(new Color[src_count_]);
+  if (scale_ > 0) sums_.reset(new uint32_t[bounds_.width() * 4]());
+}
+
+bool BandWriter::addRow(const PNGDRAW &draw) {
+  int16_t y = draw.y >> scale_;
+  if (y < bounds_.yMin()) return true;
+  if (y > bounds_.yMax()) return false;
+  if (band_ == nullptr) init(draw);
+  if (reader_ == nullptr) return false;
+  reader_(draw.pPixels, src_x0_, src_count_, draw.pPalette, row_.get());
+  if (scale_ > 0) {
+    accumulate();
+    int16_t rows = draw.y - (y << scale_) + 1;
+    if (rows < (1 << scale_) && draw.y < height_ - 1) {
+      // More source rows to go for this output row.
+      return true;
+    }
+    average(rows);
   }
+  emitRow(y);
+  return y < bounds_.yMax();
+}
+
+void BandWriter::accumulate() {
+  const Color *in = row_.get();
+  uint32_t *sums = sums_.get();
+  for (int16_t i = 0; i < src_count_; ++i) {
+    Color c = in[i];
+    uint32_t *sum = &sums[(i >> scale_) * 4];
+    uint32_t a = c.a();
+    sum[0] += a;
+    sum[1] += c.r() * a;
+    sum[2] += c.g() * a;
+    sum[3] += c.b() * a;
+  }
+}
+
+void BandWriter::average(int16_t rows) {
+  Color *out = row_.get();
+  uint32_t *sum = sums_.get();
+  for (int16_t i = 0; i < bounds_.width(); ++i) {
+    // The last column may cover fewer source columns.
+    int16_t cols =
+        std::min<int16_t>(1 << scale_, src_count_ - (i << scale_));
+    uint32_t n = cols * rows;
+    uint32_t a = sum[0];
+    if (a == 0) {
+      out[i] = color::Transparent;
+    } else {
+      out[i] = Color((a + n / 2) / n, (sum[1] + a / 2) / a,
+                     (sum[2] + a / 2) / a, (sum[3] + a / 2) / a);
+    }
+    sum[0] = sum[1] = sum[2] = sum[3] = 0;
+    sum += 4;
+  }
+}
+
+void BandWriter::emitRow(int16_t y) {
+  if (band_rows_ == 0) band_y0_ = y;
+  writer_(row_.get(), bounds_.width(), &band_[band_rows_ * row_bytes_]);
+  if (++band_rows_ == band_capacity_) flush();
+}
+
+void BandWriter::flush() {
+  if (band_rows_ == 0) return;
+  ResumeOutput resume(s_.out());
+  if (direct_) {
+    s_.out().drawDirectRect(band_.get(), row_bytes_, 0, 0,
+                            bounds_.width() - 1, band_rows_ - 1,
+                            bounds_.xMin() + s_.dx(), band_y0_ + s_.dy());
+  } else {
+    ConstDramRaster<Argb8888> raster(
+        Box(bounds_.xMin(), band_y0_, bounds_.xMax(),
+            band_y0_ + band_rows_ - 1),
+        band_.get());
+    s_.drawObject(raster);
+  }
+  band_rows_ = 0;
+}
+
+}  // namespace
+
+int png_draw(PNGDRAW *pDraw) {
+  return ((BandWriter *)pDraw->pUser)->addRow(*pDraw) ? 1 : 0;
 }
 
 PngDecoder::PngDecoder() : pngdec_(new PNGIMAGE()), input_(nullptr) {}
@@ -144,17 +393,17 @@ void PngDecoder::draw(const roo_io::MultipassResource &resource,
   if (!open(resource, width, height)) {
     return;
   }
-  Box extents(0, 0, pngdec_->iWidth - 1, pngdec_->iHeight - 1);
-  if (Box::Intersect(s.clip_box(), extents.translate(s.dx(), s.dy())).empty()) {
+  Box extents(0, 0, ((width + (1 << scale) - 1) >> scale) - 1,
+              ((height + (1 << scale) - 1) >> scale) - 1);
+  Box bounds =
+      Box::Intersect(s.clip_box().translate(-s.dx(), -s.dy()), extents);
+  if (bounds.empty()) {
     close();
     return;
   }
-  if (pngdec_->ucPixelType == PNG_PIXEL_INDEXED) {
-    palette_ =
-        Palette::ReadOnly((Color *)pngdec_->ucPalette, 1 << pngdec_->ucBpp);
-  }
-  User user{.surface = &s, .palette = &palette_};
-  DecodePNG(pngdec_.get(), (void *)&user, 0);
+  BandWriter writer(s, width, height, scale, bounds);
+  DecodePNG(pngdec_.get(), (void *)&writer, 0);
+  writer.flush();
   close();
 }
 
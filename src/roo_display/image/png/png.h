@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 
 #include "roo_display.h"
@@ -18,6 +19,12 @@
 namespace roo_display {
 
 /// PNG decoder (stateful, reusable).
+///
+/// Decoded rows are collected into bands of several rows, and each band is
+/// drawn with a single call. When the image has no transparency and the
+/// blending mode allows it, the band is converted directly to the native color
+/// format of the output (e.g. RGB565) and drawn with `drawDirectRect()`.
+/// Decoding stops as soon as the remaining rows are clipped out.
 class PngDecoder {
  public:
   /// Construct a PNG decoder instance.
@@ -42,32 +49,40 @@ class PngDecoder {
   std::unique_ptr<PNGIMAGE> pngdec_;
 
   std::unique_ptr<roo_io::MultipassInputStream> input_;
-
-  // Used for indexed color modes.
-  Palette palette_;
 };
 
 /// Drawable PNG image backed by a multipass resource.
+///
+/// The image can be downscaled while decoding, by a factor of 2^scale (i.e.
+/// to 1/2, 1/4, or 1/8 for scale = 1, 2, 3, respectively). Each resulting
+/// pixel is the average of the corresponding block of source pixels.
 class PngImage : public Drawable {
  public:
   /// Create a PNG image using a decoder and resource.
-  PngImage(PngDecoder& decoder, roo_io::MultipassResource& resource)
-      : decoder_(decoder), resource_(resource) {
+  PngImage(PngDecoder& decoder, roo_io::MultipassResource& resource,
+           uint8_t scale = 0)
+      : decoder_(decoder),
+        resource_(resource),
+        scale_(std::min<uint8_t>(scale, 3)) {
     decoder_.getDimensions(resource_, width_, height_);
   }
 
-  Box extents() const override { return Box(0, 0, width_ - 1, height_ - 1); }
+  Box extents() const override {
+    return Box(0, 0, ((width_ + (1 << scale_) - 1) >> scale_) - 1,
+               ((height_ + (1 << scale_) - 1) >> scale_) - 1);
+  }
 
  private:
   void drawTo(const Surface& s) const override {
     // We update the width and height during drawing, so that the file does not
     // need to be re-read just to fetch the dimensions.
-    decoder_.draw(resource_, s, 0, width_, height_);
+    decoder_.draw(resource_, s, scale_, width_, height_);
   }
 
   PngDecoder& decoder_;
 
   roo_io::MultipassResource& resource_;
+  uint8_t scale_;
   mutable int16_t width_;
   mutable int16_t height_;
 };
@@ -77,16 +92,18 @@ class PngImage : public Drawable {
 class PngFile : public Drawable {
  public:
   /// Create a PNG file drawable using an Arduino FS and path.
-  PngFile(PngDecoder& decoder, ::fs::FS& fs, String path)
-      : resource_(fs, path.c_str()), img_(decoder, resource_) {}
+  PngFile(PngDecoder& decoder, ::fs::FS& fs, String path, uint8_t scale = 0)
+      : resource_(fs, path.c_str()), img_(decoder, resource_, scale) {}
 
   /// Create a PNG file drawable using a roo_io filesystem and Arduino String.
-  PngFile(PngDecoder& decoder, roo_io::Filesystem& fs, String path)
-      : resource_(fs, path.c_str()), img_(decoder, resource_) {}
+  PngFile(PngDecoder& decoder, roo_io::Filesystem& fs, String path,
+          uint8_t scale = 0)
+      : resource_(fs, path.c_str()), img_(decoder, resource_, scale) {}
 
   /// Create a PNG file drawable using a roo_io filesystem and std::string.
-  PngFile(PngDecoder& decoder, roo_io::Filesystem& fs, std::string path)
-      : resource_(fs, path.c_str()), img_(decoder, resource_) {}
+  PngFile(PngDecoder& decoder, roo_io::Filesystem& fs, std::string path,
+          uint8_t scale = 0)
+      : resource_(fs, path.c_str()), img_(decoder, resource_, scale) {}
 
   Box extents() const override { return img_.extents(); }
 
@@ -101,8 +118,9 @@ class PngFile : public Drawable {
 class PngFile : public Drawable {
  public:
   /// Create a PNG file drawable using a roo_io filesystem and path.
-  PngFile(PngDecoder& decoder, roo_io::Filesystem& fs, std::string path)
-      : resource_(fs, std::move(path)), img_(decoder, resource_) {}
+  PngFile(PngDecoder& decoder, roo_io::Filesystem& fs, std::string path,
+          uint8_t scale = 0)
+      : resource_(fs, std::move(path)), img_(decoder, resource_, scale) {}
 
   Box extents() const override { return img_.extents(); }
 
@@ -0,0 +1,412 @@
+#pragma once
+
+// Conversion pipeline that draws rectangles of raw pixels in one color mode
+// onto a device with a different native color format, without going through
+// 32-bit `Color` arrays and `DisplayOutput::write()`. Pixels are converted
+// straight into a device-format line buffer (blended over the background, if
+// needed), which is then sent via `DisplayOutput::drawDirectRect()`.
+//
+// Conversion is done by `PixelConverter`, which decodes and re-encodes each
+// pixel, unless specialized for the pair of color modes. Sources with up to 8
+// bits per pixel (grayscale, alpha masks, indexed) use `LutPixelConverter`,
+// which pre-computes the device-format pixel for every possible source value.
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "roo_backport.h"
+#include "roo_backport/byte.h"
+#include "roo_display/color/blending.h"
+#include "roo_display/color/color.h"
+#include "roo_display/color/color_mode_indexed.h"
+#include "roo_display/color/color_modes.h"
+#include "roo_display/color/pixel_order.h"
+#include "roo_display/color/traits.h"
+#include "roo_display/core/box.h"
+#include "roo_display/core/device.h"
+#include "roo_display/core/drawable.h"
+#include "roo_display/internal/color_io.h"
+#include "roo_io/data/byte_order.h"
+
+namespace roo_display {
+namespace internal {
+
+#ifndef ROO_DISPLAY_TESTING
+// Size of the (stack) buffer for the converted pixels.
+static const uint16_t kConversionBufferSize = 512;
+#else
+// Use a small and 'weird' buffer size to challenge unit tests better.
+static const uint16_t kConversionBufferSize = 23;
+#endif
+
+/// Converts pixels from `SrcMode` to `DstMode`, both stored as raw bytes. If
+/// the background color is not transparent (in which case it must be opaque),
+/// the source pixels are alpha-blended over it.
+///
+/// The generic implementation decodes each pixel to `Color`, and encodes it
+/// back; specializations implement common pairs of modes directly.
+template <typename SrcMode, roo_io::ByteOrder src_byte_order,
+          ColorPixelOrder src_pixel_order, typename DstMode,
+          roo_io::ByteOrder dst_byte_order, typename Enable = void>
+class PixelConverter {
+ public:
+  PixelConverter(const SrcMode& src_mode, const DstMode& dst_mode,
+                 Color bgcolor)
+      : src_mode_(src_mode), dst_mode_(dst_mode), bgcolor_(bgcolor) {}
+
+  /// Converts `count` pixels, starting at the specified pixel index.
+  void convert(const roo::byte* data, uint32_t index, int16_t count,
+               roo::byte* out) const {
+    constexpr int kSrcBytes = ColorTraits<SrcMode>::bytes_per_pixel;
+    constexpr int kDstBytes = ColorTraits<DstMode>::bytes_per_pixel;
+    ColorIo<SrcMode, src_byte_order> src_io;
+    ColorIo<DstMode, dst_byte_order> dst_io;
+    const roo::byte* in = data + index * kSrcBytes;
+    if (bgcolor_.a() == 0) {
+      while (count-- > 0) {
+        dst_io.store(src_io.load(in, src_mode_), out, dst_mode_);
+        in += kSrcBytes;
+        out += kDstBytes;
+      }
+    } else {
+      while (count-- > 0) {
+        Color color = src_io.load(in, src_mode_);
+        dst_io.store(AlphaBlendOverOpaque(bgcolor_, color), out, dst_mode_);
+        in += kSrcBytes;
+        out += kDstBytes;
+      }
+    }
+  }
+
+  /// Returns true if the pixel at the specified index is fully transparent.
+  bool transparent(const roo::byte* data, uint32_t index) const {
+    constexpr int kSrcBytes = ColorTraits<SrcMode>::bytes_per_pixel;
+    ColorIo<SrcMode, src_byte_order> src_io;
+    return src_io.load(data + index * kSrcBytes, src_mode_).a() == 0;
+  }
+
+ private:
+  const SrcMode& src_mode_;
+  const DstMode& dst_mode_;
+  Color bgcolor_;
+};
+
+// The same 16-bit mode, in the opposite byte order (e.g. RGB565 big-endian
+// images on a little-endian framebuffer). Since the raw values are identical,
+// only the bytes get swapped. (Only used when there is no blending, i.e. for
+// opaque modes.)
+template <typename Mode, roo_io::ByteOrder src_byte_order,
+          ColorPixelOrder src_pixel_order, roo_io::ByteOrder dst_byte_order>
+class PixelConverter<
+    Mode, src_byte_order, src_pixel_order, Mode, dst_byte_order,
+    std::enable_if_t<ColorTraits<Mode>::bytes_per_pixel == 2 &&
+                     src_byte_order != dst_byte_order>> {
+ public:
+  PixelConverter(const Mode& src_mode, const Mode& dst_mode, Color bgcolor) {}
+
+  void convert(const roo::byte* data, uint32_t index, int16_t count,
+               roo::byte* out) const {
+    const roo::byte* in = data + index * 2;
+    while (count-- > 0) {
+      out[0] = in[1];
+      out[1] = in[0];
+      in += 2;
+      out += 2;
+    }
+  }
+
+  bool transparent(const roo::byte* data, uint32_t index) const {
+    return false;
+  }
+};
+
+// RGB888 images on RGB565 devices (opaque; no blending).
+template <roo_io::ByteOrder src_byte_order, ColorPixelOrder src_pixel_order,
+          roo_io::ByteOrder dst_byte_order>
+class PixelConverter<Rgb888, src_byte_order, src_pixel_order, Rgb565,
+                     dst_byte_order> {
+ public:
+  PixelConverter(const Rgb888& src_mode, const Rgb565& dst_mode,
+                 Color bgcolor) {}
+
+  void convert(const roo::byte* data, uint32_t index, int16_t count,
+               roo::byte* out) const {
+    constexpr int kR = (src_byte_order == roo_io::kBigEndian) ? 0 : 2;
+    constexpr int kB = 2 - kR;
+    const roo::byte* in = data + index * 3;
+    while (count-- > 0) {
+      uint16_t raw = TruncTo5bit((uint8_t)in[kR]) << 11 |
+                     TruncTo6bit((uint8_t)in[1]) << 5 |
+                     TruncTo5bit((uint8_t)in[kB]);
+      *(uint16_t*)out = roo_io::hto<uint16_t, dst_byte_order>(raw);
+      in += 3;
+      out += 2;
+    }
+  }
+
+  bool transparent(const roo::byte* data, uint32_t index) const {
+    return false;
+  }
+};
+
+// Returns the number of the distinct raw values of the color mode, that
+// have a meaningful color.
+template <typename ColorMode>
+inline uint16_t RawColorCount(const ColorMode& mode) {
+  return 1 << ColorMode::bits_per_pixel;
+}
+
+template <uint8_t bits>
+inline uint16_t RawColorCount(const Indexed<bits>& mode) {
+  return mode.palette()->size();
+}
+
+/// Converter for source modes with up to 8 bits per pixel. Pre-computes the
+/// converted (and blended) pixels for all raw source values, so that each
+/// pixel only needs a table lookup.
+template <typename SrcMode, ColorPixelOrder src_pixel_order, typename DstMode,
+          roo_io::ByteOrder dst_byte_order>
+class LutPixelConverter {
+ public:
+  static_assert(SrcMode::bits_per_pixel <= 8,
+                "LutPixelConverter requires at most 8 bits per pixel");
+
+  /// The number of table entries. Drawing fewer pixels than that is faster
+  /// with `PixelConverter`.
+  static constexpr uint16_t kEntries = 1 << SrcMode::bits_per_pixel;
+
+  LutPixelConverter(const SrcMode& src_mode, const DstMode& dst_mode,
+                    Color bgcolor) {
+    ColorIo<DstMode, dst_byte_order> dst_io;
+    uint16_t count = RawColorCount(src_mode);
+    for (uint16_t i = 0; i < kEntries; ++i) {
+      Color color = (i < count) ? src_mode.toArgbColor(i) : color::Transparent;
+      transparent_[i] = (color.a() == 0);
+      if (bgcolor.a() != 0) color = AlphaBlendOverOpaque(bgcolor, color);
+      dst_io.store(color, &lut_[i * kDstBytes], dst_mode);
+    }
+  }
+
+  void convert(const roo::byte* data, uint32_t index, int16_t count,
+               roo::byte* out) const {
+    while (count-- > 0) {
+      memcpy(out, &lut_[raw(data, index++) * kDstBytes], kDstBytes);
+      out += kDstBytes;
+    }
+  }
+
+  bool transparent(const roo::byte* data, uint32_t index) const {
+    return transparent_[raw(data, index)];
+  }
+
+ private:
+  static constexpr int kDstBytes = ColorTraits<DstMode>::bytes_per_pixel;
+
+  static uint8_t raw(const roo::byte* data, uint32_t index) {
+    constexpr int8_t kPixelsPerByte = ColorTraits<SrcMode>::pixels_per_byte;
+    if constexpr (kPixelsPerByte == 1) {
+      return (uint8_t)data[index];
+    } else {
+      SubByteColorIo<SrcMode, src_pixel_order> io;
+      return io.loadRaw(data[index / kPixelsPerByte], index % kPixelsPerByte);
+    }
+  }
+
+  roo::byte lut_[kEntries * kDstBytes];
+  bool transparent_[kEntries];
+};
+
+// Draws the pixels, converted by the converter, via drawDirectRect(). The
+// `src` is the rectangle to draw, in the source pixel coordinates; the source
+// pixel (x, y) has the index x + y * `stride`. (Sub-byte rows are packed
+// continuously, without per-row padding.) If `skip_transparent` is true,
+// fully transparent source pixels are left out.
+template <typename Converter, typename DstMode>
+void DrawConvertedPixels(DisplayOutput& out, const Converter& converter,
+                         const roo::byte* data, int16_t stride,
+                         const Box& src, int16_t dst_x0, int16_t dst_y0,
+                         bool skip_transparent) {
+  constexpr int kDstBytes = ColorTraits<DstMode>::bytes_per_pixel;
+  roo::byte buf[kConversionBufferSize];
+  const int16_t max_width = kConversionBufferSize / kDstBytes;
+  const int16_t width = src.width();
+  if (skip_transparent) {
+    // Draw each run of visible pixels separately.
+    for (int16_t y = src.yMin(); y <= src.yMax(); ++y) {
+      uint32_t row = (uint32_t)y * stride;
+      int16_t dst_y = dst_y0 + y - src.yMin();
+      int16_t x = src.xMin();
+      while (x <= src.xMax()) {
+        while (x <= src.xMax() && converter.transparent(data, row + x)) ++x;
+        int16_t start = x;
+        while (x <= src.xMax() && x - start < max_width &&
+               !converter.transparent(data, row + x)) {
+          ++x;
+        }
+        if (x == start) continue;
+        converter.convert(data, row + start, x - start, buf);
+        out.drawDirectRect(buf, (x - start) * kDstBytes, 0, 0, x - start - 1,
+                           0, dst_x0 + start - src.xMin(), dst_y);
+      }
+    }
+    return;
+  }
+  if (width > max_width) {
+    // Rows don't fit the buffer; draw them in pieces.
+    for (int16_t y = src.yMin(); y <= src.yMax(); ++y) {
+      uint32_t row = (uint32_t)y * stride;
+      int16_t dst_y = dst_y0 + y - src.yMin();
+      for (int16_t x = src.xMin(); x <= src.xMax(); x += max_width) {
+        int16_t count = std::min<int16_t>(max_width, src.xMax() - x + 1);
+        converter.convert(data, row + x, count, buf);
+        out.drawDirectRect(buf, count * kDstBytes, 0, 0, count - 1, 0,
+                           dst_x0 + x - src.xMin(), dst_y);
+      }
+    }
+    return;
+  }
+  // Draw bands of full rows.
+  const size_t buf_row_bytes = width * kDstBytes;
+  const int16_t band_height = kConversionBufferSize / buf_row_bytes;
+  for (int16_t y = src.yMin(); y <= src.yMax(); y += band_height) {
+    int16_t rows = std::min<int16_t>(band_height, src.yMax() - y + 1);
+    for (int16_t i = 0; i < rows; ++i) {
+      converter.convert(data, (uint32_t)(y + i) * stride + src.xMin(), width,
+                        &buf[i * buf_row_bytes]);
+    }
+    out.drawDirectRect(buf, buf_row_bytes, 0, 0, width - 1, rows - 1, dst_x0,
+                       dst_y0 + y - src.yMin());
+  }
+}
+
+template <typename SrcMode, ColorPixelOrder src_pixel_order,
+          roo_io::ByteOrder src_byte_order, typename DstMode,
+          roo_io::ByteOrder dst_byte_order>
+void DrawConvertedTo(DisplayOutput& out, const SrcMode& src_mode,
+                     const roo::byte* data, int16_t stride,
+                     const Box& src, int16_t dst_x0, int16_t dst_y0,
+                     Color bgcolor, bool skip_transparent) {
+  DstMode dst_mode;
+  if constexpr (SrcMode::bits_per_pixel <= 8) {
+    using Lut =
+        LutPixelConverter<SrcMode, src_pixel_order, DstMode, dst_byte_order>;
+    // Sub-byte modes always use the (small) table.
+    if (ColorTraits<SrcMode>::pixels_per_byte > 1 ||
+        src.area() >= Lut::kEntries) {
+      Lut converter(src_mode, dst_mode, bgcolor);
+      DrawConvertedPixels<Lut, DstMode>(out, converter, data, stride,
+                                        src, dst_x0, dst_y0,
+                                        skip_transparent);
+      return;
+    }
+  }
+  if constexpr (ColorTraits<SrcMode>::pixels_per_byte == 1) {
+    using Converter = PixelConverter<SrcMode, src_byte_order, src_pixel_order,
+                                     DstMode, dst_byte_order>;
+    Converter converter(src_mode, dst_mode, bgcolor);
+    DrawConvertedPixels<Converter, DstMode>(out, converter, data,
+                                            stride, src, dst_x0,
+                                            dst_y0, skip_transparent);
+  }
+}
+
+template <typename SrcMode, ColorPixelOrder src_pixel_order,
+          roo_io::ByteOrder src_byte_order, typename DstMode>
+void DrawConvertedTo(DisplayOutput& out, roo_io::ByteOrder dst_byte_order,
+                     const SrcMode& src_mode, const roo::byte* data,
+                     int16_t stride, const Box& src, int16_t dst_x0,
+                     int16_t dst_y0, Color bgcolor, bool skip_transparent) {
+  if (dst_byte_order == roo_io::kBigEndian) {
+    DrawConvertedTo<SrcMode, src_pixel_order, src_byte_order, DstMode,
+                    roo_io::kBigEndian>(out, src_mode, data, stride,
+                                        src, dst_x0, dst_y0, bgcolor,
+                                        skip_transparent);
+  } else {
+    DrawConvertedTo<SrcMode, src_pixel_order, src_byte_order, DstMode,
+                    roo_io::kLittleEndian>(out, src_mode, data,
+                                           stride, src, dst_x0,
+                                           dst_y0, bgcolor, skip_transparent);
+  }
+}
+
+/// Draws the rectangle `src` (in pixel coordinates) of the raw pixel data
+/// onto the surface, at (dst_x0, dst_y0) in the device coordinates, by
+/// converting the pixels to the device's native color format, and passing
+/// them to `drawDirectRect()`. The result is the same as when drawing the
+/// pixels via a regular stream.
+///
+/// Supported device formats are RGB565, RGB888, ARGB8888, RGBA8888, and
+/// Grayscale8. The converted pixels must replace the device content: the
+/// source must be opaque, or the surface background must be opaque (and
+/// then, the pixels are blended over it). In the latter case, with
+/// `FillMode::kVisible`, fully transparent pixels are skipped.
+///
+/// Returns false, without drawing anything, if these conditions are not met.
+template <typename ColorMode, ColorPixelOrder pixel_order,
+          roo_io::ByteOrder byte_order>
+bool DrawConvertedRect(const Surface& s, const ColorMode& mode,
+                       const roo::byte* data, int16_t stride,
+                       const Box& src, int16_t dst_x0, int16_t dst_y0) {
+  bool source_opaque = (mode.transparency() == TransparencyMode::kNone);
+  Color bgcolor = color::Transparent;
+  bool skip_transparent = false;
+  if (!source_opaque) {
+    // Translucent pixels need to be blended over an opaque background, so
+    // that the results are opaque.
+    if (s.bgcolor().a() != 0xFF) return false;
+    bgcolor = s.bgcolor();
+    skip_transparent = (s.fill_mode() == FillMode::kVisible);
+  }
+  const DisplayOutput::ColorFormat& format = s.out().getColorFormat();
+  BlendingMode blending_mode = s.blending_mode();
+  // The pixels to write are opaque; see Raster::drawTo().
+  if (blending_mode != BlendingMode::kSource &&
+      blending_mode != BlendingMode::kSourceOver &&
+      blending_mode != BlendingMode::kSourceOverOpaque &&
+      !(format.transparency() == TransparencyMode::kNone &&
+        (blending_mode == BlendingMode::kSourceIn ||
+         blending_mode == BlendingMode::kSourceAtop))) {
+    return false;
+  }
+  switch (format.mode()) {
+    case DisplayOutput::ColorFormat::kModeRgb565: {
+      DrawConvertedTo<ColorMode, pixel_order, byte_order, Rgb565>(
+          s.out(), format.byte_order(), mode, data, stride, src,
+          dst_x0, dst_y0, bgcolor, skip_transparent);
+      return true;
+    }
+    case DisplayOutput::ColorFormat::kModeRgb888: {
+      DrawConvertedTo<ColorMode, pixel_order, byte_order, Rgb888>(
+          s.out(), format.byte_order(), mode, data, stride, src,
+          dst_x0, dst_y0, bgcolor, skip_transparent);
+      return true;
+    }
+    case DisplayOutput::ColorFormat::kModeArgb8888: {
+      DrawConvertedTo<ColorMode, pixel_order, byte_order, Argb8888>(
+          s.out(), format.byte_order(), mode, data, stride, src,
+          dst_x0, dst_y0, bgcolor, skip_transparent);
+      return true;
+    }
+    case DisplayOutput::ColorFormat::kModeRgba8888: {
+      DrawConvertedTo<ColorMode, pixel_order, byte_order, Rgba8888>(
+          s.out(), format.byte_order(), mode, data, stride, src,
+          dst_x0, dst_y0, bgcolor, skip_transparent);
+      return true;
+    }
+    case DisplayOutput::ColorFormat::kModeGrayscale8: {
+      DrawConvertedTo<ColorMode, pixel_order, byte_order, Grayscale8>(
+          s.out(), format.byte_order(), mode, data, stride, src,
+          dst_x0, dst_y0, bgcolor, skip_transparent);
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace roo_display
@@ -174,6 +174,13 @@ class FilledRectStream : public PixelStream {
     FillColor(buf, count, color_);
   }
 
+  uint32_t readSpan(Color *buf, uint16_t size, uint32_t max_count,
+                    bool &is_run) override {
+    is_run = true;
+    buf[0] = color_;
+    return max_count;
+  }
+
   void skip(uint32_t count) override {}
 
  private:
@@ -421,6 +421,263 @@ Color GetSmoothArcPixelColor(const SmoothShape::Arc& spec, int16_t x,
                                                    (spec.ri - d + 0.5f)))));
 }
 
+// Returns true if the color of the specified pixel, as determined by
+// GetSmoothArcPixelColor(), does not depend on the exact distances to the
+// edges of the arc, but only on the branches taken. Must be kept in sync with
+// GetSmoothArcPixelColor().
+bool IsSmoothArcPixelColorPiecewiseConstant(const SmoothShape::Arc& spec,
+                                            int16_t x, int16_t y) {
+  float dx = x - spec.xc;
+  float dy = y - spec.yc;
+  if (spec.inner_mid.contains(x, y)) return true;
+  float d_squared = dx * dx + dy * dy;
+  if (spec.ri >= 0.5f && d_squared <= spec.ri_sq_adj - spec.ri) return true;
+  if (d_squared >= spec.ro_sq_adj + spec.ro) return true;
+  bool fully_within_outer = d_squared <= spec.ro_sq_adj - spec.ro;
+  bool fully_outside_inner = spec.ro == spec.ri ||
+                             d_squared >= spec.ri_sq_adj + spec.ri ||
+                             spec.ri == 0;
+  // Otherwise, anti-aliased against the ring edges.
+  if (!fully_within_outer || !fully_outside_inner) return false;
+
+  int qx = (dx < 0.5) << 0 | (dx > -0.5) << 1;
+  int quadrant = (((dy < 0.5) * 3) & qx) | (((dy > -0.5)) * 3 & qx) << 2;
+  if ((quadrant & spec.quadrants_) == quadrant) return true;
+  if ((quadrant & (spec.quadrants_ >> 4)) == quadrant) return true;
+
+  float n1 = spec.start_y_slope * dx - spec.start_x_slope * dy;
+  float n2 = spec.end_x_slope * dy - spec.end_y_slope * dx;
+  if (spec.range_angle_sharp ? (n1 <= -0.5 && n2 <= -0.5)
+                             : (n1 <= -0.5 || n2 <= -0.5)) {
+    return true;
+  }
+  // Round endings are anti-aliased against the distance to the endpoints.
+  if (spec.round_endings) return false;
+  // Flat endings are anti-aliased when n1 or n2 is within (-0.5, 0.5).
+  return spec.range_angle_sharp ? (n1 >= 0.5f || n2 >= 0.5f)
+                                : (n1 >= 0.5f && n2 >= 0.5f);
+}
+
+// Returns the first x in (lo, hi] for which the predicate, which must be
+// monotone over [lo, hi], differs from pred(lo), or lo if there is no such x.
+// The guess only affects performance.
+template <typename Pred>
+int16_t FindFlip(const Pred& pred, int16_t lo, int16_t hi, float guess) {
+  if (lo >= hi) return lo;
+  bool initial = pred(lo);
+  if (pred(hi) == initial) return lo;
+  int16_t x;
+  if (!(guess > lo + 1)) {
+    // Also when the guess is NaN.
+    x = lo + 1;
+  } else if (!(guess < hi)) {
+    x = hi;
+  } else {
+    x = (int16_t)ceilf(guess);
+  }
+  if (pred(x) == initial) {
+    do {
+      ++x;
+    } while (pred(x) == initial);
+  } else {
+    while (x - 1 > lo && pred(x - 1) != initial) --x;
+  }
+  return x;
+}
+
+class ArcStream : public PixelStream {
+ public:
+  using PixelStream::read;
+
+  // Emits an arc in row-major order. Each scanline is split at every column
+  // at which any of the conditions that GetSmoothArcPixelColor() branches on
+  // changes value. All pixels of the resulting piece take the same branches,
+  // so unless the color depends on the exact distances (i.e. at the
+  // anti-aliased edges and round endings), it is uniform over the piece and
+  // only needs to be evaluated once.
+  ArcStream(const SmoothShape::Arc& arc, Box bounds)
+      : arc_(arc),
+        bounds_(std::move(bounds)),
+        x_(bounds_.xMin()),
+        y_(bounds_.yMin()),
+        segment_count_(0),
+        segment_index_(0),
+        row_ready_(false) {}
+
+  void read(Color* buf, uint16_t count, uint32_t& run_length) override {
+    run_length = 0;
+    bool first_batch = true;
+    while (count > 0) {
+      if (!row_ready_) PrepareRow();
+      if (segment_index_ >= segment_count_) return;
+      const Segment& segment = segments_[segment_index_];
+      if (first_batch) {
+        run_length = segment.slow ? 0 : (uint32_t)(segment.end_x - x_ + 1);
+        first_batch = false;
+      }
+      uint16_t batch = segment.end_x - x_ + 1;
+      if (batch > count) batch = count;
+      if (segment.slow) {
+        for (uint16_t i = 0; i < batch; ++i) {
+          buf[i] = GetSmoothArcPixelColor(arc_, x_ + i, y_);
+        }
+      } else {
+        FillColor(buf, batch, segment.color);
+      }
+      buf += batch;
+      count -= batch;
+      x_ += batch;
+      if (x_ > segment.end_x) {
+        ++segment_index_;
+      }
+      if (x_ > bounds_.xMax()) {
+        x_ = bounds_.xMin();
+        ++y_;
+        row_ready_ = false;
+      }
+    }
+  }
+
+  void skip(uint32_t count) override {
+    if (row_ready_ && count <= (uint32_t)(bounds_.xMax() - x_)) {
+      // Stays within the current row.
+      x_ += count;
+    } else {
+      const uint32_t offset = x_ - bounds_.xMin() + count;
+      const uint32_t width = bounds_.width();
+      x_ = bounds_.xMin() + offset % width;
+      y_ += offset / width;
+      PrepareRow();
+    }
+    while (segment_index_ < segment_count_ &&
+           x_ > segments_[segment_index_].end_x) {
+      ++segment_index_;
+    }
+  }
+
+ private:
+  struct Segment {
+    int16_t start_x;
+    int16_t end_x;
+    bool slow;
+    Color color;
+  };
+
+  void AddSegment(int16_t start_x, int16_t end_x, bool slow, Color color) {
+    if (segment_count_ > 0) {
+      Segment& prev = segments_[segment_count_ - 1];
+      if (prev.slow == slow && (slow || prev.color == color)) {
+        prev.end_x = end_x;
+        return;
+      }
+    }
+    segments_[segment_count_++] = Segment{start_x, end_x, slow, color};
+  }
+
+  void PrepareRow() {
+    segment_count_ = 0;
+    segment_index_ = 0;
+    row_ready_ = true;
+    if (y_ > bounds_.yMax()) return;
+    const int16_t lo = bounds_.xMin();
+    const int16_t hi = bounds_.xMax();
+    // Same arithmetic as in GetSmoothArcPixelColor().
+    const float dy = y_ - arc_.yc;
+    const float dy_sq = dy * dy;
+    if (dy_sq >= arc_.ro_sq_adj + arc_.ro) {
+      // The entire row is outside of the outer ring.
+      AddSegment(lo, hi, false, color::Transparent);
+      return;
+    }
+
+    int16_t breaks[kMaxBreaks];
+    int break_count = 0;
+    auto add_break = [&](int16_t x) {
+      if (x > lo && x <= hi) breaks[break_count++] = x;
+    };
+    const Box& inner_mid = arc_.inner_mid;
+    if (y_ >= inner_mid.yMin() && y_ <= inner_mid.yMax()) {
+      add_break(inner_mid.xMin());
+      add_break(inner_mid.xMax() + 1);
+    }
+
+    // The distance-based conditions are monotone on either side of the
+    // center.
+    const float xc = arc_.xc;
+    const int16_t mid =
+        (int16_t)std::max<float>(lo - 1, std::min<float>(hi, floorf(xc)));
+    add_break(mid + 1);
+    auto add_circle_breaks = [&](float threshold, bool inside) {
+      auto pred = [&](int16_t x) {
+        float dx = x - xc;
+        float d_squared = dx * dx + dy_sq;
+        return inside ? d_squared <= threshold : d_squared >= threshold;
+      };
+      float r = sqrtf(threshold - dy_sq);
+      add_break(FindFlip(pred, lo, mid, xc - r));
+      add_break(FindFlip(pred, mid + 1, hi, xc + r));
+    };
+    if (arc_.ri >= 0.5f) add_circle_breaks(arc_.ri_sq_adj - arc_.ri, true);
+    add_circle_breaks(arc_.ro_sq_adj + arc_.ro, false);
+    add_circle_breaks(arc_.ro_sq_adj - arc_.ro, true);
+    add_circle_breaks(arc_.ri_sq_adj + arc_.ri, false);
+
+    // Quadrants.
+    add_break(FindFlip([&](int16_t x) { return x - xc < 0.5; }, lo, hi,
+                       xc + 0.5f));
+    add_break(FindFlip([&](int16_t x) { return x - xc > -0.5; }, lo, hi,
+                       xc - 0.5f));
+
+    // Angle range; n1 and n2 are linear in x.
+    const float sxs = arc_.start_x_slope;
+    const float sys = arc_.start_y_slope;
+    const float exs = arc_.end_x_slope;
+    const float eys = arc_.end_y_slope;
+    auto n1 = [&](int16_t x) { return sys * (x - xc) - sxs * dy; };
+    auto n2 = [&](int16_t x) { return exs * dy - eys * (x - xc); };
+    add_break(FindFlip([&](int16_t x) { return n1(x) <= -0.5; }, lo, hi,
+                       xc + (-0.5f + sxs * dy) / sys));
+    add_break(FindFlip([&](int16_t x) { return n1(x) >= 0.5f; }, lo, hi,
+                       xc + (0.5f + sxs * dy) / sys));
+    add_break(FindFlip([&](int16_t x) { return n2(x) <= -0.5; }, lo, hi,
+                       xc + (exs * dy + 0.5f) / eys));
+    add_break(FindFlip([&](int16_t x) { return n2(x) >= 0.5f; }, lo, hi,
+                       xc + (exs * dy - 0.5f) / eys));
+
+    // Sort (there are just a few).
+    for (int i = 1; i < break_count; ++i) {
+      int16_t b = breaks[i];
+      int j = i;
+      for (; j > 0 && breaks[j - 1] > b; --j) breaks[j] = breaks[j - 1];
+      breaks[j] = b;
+    }
+    int16_t start = lo;
+    for (int i = 0; i <= break_count; ++i) {
+      int16_t end = (i < break_count) ? breaks[i] - 1 : hi;
+      if (end < start) continue;
+      if (IsSmoothArcPixelColorPiecewiseConstant(arc_, start, y_)) {
+        AddSegment(start, end, false,
+                   GetSmoothArcPixelColor(arc_, start, y_));
+      } else {
+        AddSegment(start, end, true, color::Transparent);
+      }
+      start = end + 1;
+    }
+  }
+
+  // inner_mid (2), center (1), circles (8), quadrants (2), angles (4).
+  static constexpr int kMaxBreaks = 17;
+
+  const SmoothShape::Arc& arc_;
+  Box bounds_;
+  int16_t x_;
+  int16_t y_;
+  Segment segments_[kMaxBreaks + 1];
+  uint8_t segment_count_;
+  uint8_t segment_index_;
+  bool row_ready_;
+};
+
 inline float CalcDistSq(float x1, float y1, int16_t x2, int16_t y2) {
   float dx = x1 - x2;
   float dy = y1 - y2;
@@ -851,6 +1108,11 @@ void DrawArc(SmoothShape::Arc arc, const Surface& s, const Box& box) {
   DrawArcImpl(arc, s, box);
 }
 
+std::unique_ptr<PixelStream> CreateArcStream(const SmoothShape::Arc& arc,
+                                             const Box& bounds) {
+  return std::unique_ptr<PixelStream>(new ArcStream(arc, bounds));
+}
+
 }  // namespace internal
 
 }  // namespace roo_display
\ No newline at end of file
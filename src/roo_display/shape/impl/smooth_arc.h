@@ -28,5 +28,8 @@ void ReadArcColors(const SmoothShape::Arc& arc, const int16_t* x,
 
 void DrawArc(SmoothShape::Arc arc, const Surface& s, const Box& box);
 
+std::unique_ptr<PixelStream> CreateArcStream(const SmoothShape::Arc& arc,
+                                             const Box& bounds);
+
 }  // namespace internal
 }  // namespace roo_display
\ No newline at end of file
@@ -1442,6 +1442,15 @@ class RoundRectStream : public PixelStream {
   }
 
   void Seek(uint32_t count) {
+    if (row_ready_ && count <= (uint32_t)(bounds_.xMax() - x_)) {
+      // Stays within the current row; no need to recompute it.
+      x_ += count;
+      while (segment_index_ < segment_count_ &&
+             x_ > segments_[segment_index_].end_x) {
+        ++segment_index_;
+      }
+      return;
+    }
     const uint32_t offset = x_ - bounds_.xMin() + count;
     const uint32_t width = bounds_.width();
     x_ = bounds_.xMin() + offset % width;
@@ -1700,6 +1709,15 @@ class RectInnerRoundRectStream : public PixelStream {
   }
 
   void Seek(uint32_t count) {
+    if (row_ready_ && count <= (uint32_t)(bounds_.xMax() - x_)) {
+      // Stays within the current row; no need to recompute it.
+      x_ += count;
+      while (segment_index_ < segment_count_ &&
+             x_ > segments_[segment_index_].end_x) {
+        ++segment_index_;
+      }
+      return;
+    }
     const uint32_t offset = x_ - bounds_.xMin() + count;
     const uint32_t width = bounds_.width();
     x_ = bounds_.xMin() + offset % width;
@@ -2048,6 +2066,15 @@ class RoundRectCornersStream : public PixelStream {
   }
 
   void Seek(uint32_t count) {
+    if (row_ready_ && count <= (uint32_t)(bounds_.xMax() - x_)) {
+      // Stays within the current row; no need to recompute it.
+      x_ += count;
+      while (segment_index_ < segment_count_ &&
+             x_ > segments_[segment_index_].end_x) {
+        ++segment_index_;
+      }
+      return;
+    }
     const uint32_t offset = x_ - bounds_.xMin() + count;
     const uint32_t width = bounds_.width();
     x_ = bounds_.xMin() + offset % width;
@@ -2702,6 +2729,15 @@ std::unique_ptr<PixelStream> CreateRoundRectStream(
   return std::unique_ptr<PixelStream>(new RoundRectCornersStream(rect, bounds));
 }
 
+bool RoundRectStreamIsExact(const SmoothShape::RoundRect& rect) {
+  auto on_grid = [](float value) {
+    return value * 2 == (float)ToDoubledCoord(value);
+  };
+  return on_grid(rect.x0) && on_grid(rect.y0) && on_grid(rect.x1) &&
+         on_grid(rect.y1) && on_grid(rect.ro) &&
+         (UsesRectInnerBoundary(rect) || on_grid(rect.ri));
+}
+
 void DrawRoundRect(SmoothShape::RoundRect rect, const Surface& s,
                    const Box& box) {
   DrawRoundRectImpl(rect, s, box);
@@ -22,6 +22,12 @@ std::unique_ptr<PixelStream> CreateRoundRectStream(
 std::unique_ptr<PixelStream> CreateRoundRectStream(
     const SmoothShape::RoundRectCorners& rect, const Box& bounds);
 
+// Returns true if the stream created by `CreateRoundRectStream()` for the
+// specified rect produces exactly the same colors as `DrawRoundRect()`. This
+// holds when the geometry is aligned to the half-pixel grid, which the stream
+// snaps it to.
+bool RoundRectStreamIsExact(const SmoothShape::RoundRect& rect);
+
 bool ReadColorRectOfRoundRect(const SmoothShape::RoundRect& rect, int16_t xMin,
                               int16_t yMin, int16_t xMax, int16_t yMax,
                               Color* result);
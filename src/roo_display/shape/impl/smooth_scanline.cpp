@@ -0,0 +1,141 @@
+#include "roo_display/shape/impl/smooth_scanline.h"
+
+#include "roo_display/color/blending.h"
+#include "roo_display/core/buffered_drawing.h"
+
+namespace roo_display {
+namespace internal {
+
+namespace {
+
+// Uniform runs shorter than this are written as individual pixels.
+static constexpr int16_t kMinSpanWidth = 2;
+
+// Maximum number of uniform spans per scanline that can be merged with the
+// spans of the next scanline. Further spans get emitted right away.
+static constexpr int kMaxOpenSpans = 32;
+
+struct Span {
+  int16_t x0;
+  int16_t x1;
+  int16_t y0;
+  Color color;
+};
+
+class SpanEmitter {
+ public:
+  SpanEmitter(const Surface& s)
+      : s_(s),
+        rect_writer_(s.out(), s.blending_mode()),
+        pixel_writer_(s.out(), s.blending_mode()),
+        prev_(buf_a_),
+        cur_(buf_b_),
+        prev_count_(0),
+        prev_idx_(0),
+        cur_count_(0),
+        last_color_(color::Transparent),
+        last_blended_(AlphaBlend(s.bgcolor(), color::Transparent)) {}
+
+  void addPixel(int16_t x, int16_t y, Color color) {
+    if (s_.fill_mode() == FillMode::kVisible && color == color::Transparent) {
+      return;
+    }
+    pixel_writer_.writePixel(x, y, blend(color));
+  }
+
+  // Spans must be added in the order of increasing x.
+  void addSpan(int16_t x0, int16_t x1, int16_t y, Color color) {
+    if (s_.fill_mode() == FillMode::kVisible && color == color::Transparent) {
+      return;
+    }
+    Color blended = blend(color);
+    // Try to continue a span from the previous scanline.
+    while (prev_idx_ < prev_count_ && prev_[prev_idx_].x0 < x0) {
+      closeSpan(prev_[prev_idx_++], y - 1);
+    }
+    int16_t y0 = y;
+    if (prev_idx_ < prev_count_ && prev_[prev_idx_].x0 == x0 &&
+        prev_[prev_idx_].x1 == x1 && prev_[prev_idx_].color == blended) {
+      y0 = prev_[prev_idx_++].y0;
+    }
+    if (cur_count_ == kMaxOpenSpans) {
+      rect_writer_.writeRect(x0, y0, x1, y, blended);
+      return;
+    }
+    cur_[cur_count_++] = Span{x0, x1, y0, blended};
+  }
+
+  void startRow() { prev_idx_ = 0; }
+
+  // Emits the spans of the previous scanline that have not been continued.
+  void endRow(int16_t y) {
+    while (prev_idx_ < prev_count_) closeSpan(prev_[prev_idx_++], y - 1);
+    std::swap(prev_, cur_);
+    prev_count_ = cur_count_;
+    cur_count_ = 0;
+  }
+
+  // Emits the spans still open after the last scanline, `y`.
+  void finish(int16_t y) {
+    for (int i = 0; i < prev_count_; ++i) closeSpan(prev_[i], y);
+    prev_count_ = 0;
+  }
+
+ private:
+  Color blend(Color color) {
+    if (color != last_color_) {
+      last_color_ = color;
+      last_blended_ = (s_.fill_mode() == FillMode::kExtents && color.a() == 0)
+                          ? s_.bgcolor()
+                          : AlphaBlend(s_.bgcolor(), color);
+    }
+    return last_blended_;
+  }
+
+  void closeSpan(const Span& span, int16_t y1) {
+    rect_writer_.writeRect(span.x0, span.y0, span.x1, y1, span.color);
+  }
+
+  const Surface& s_;
+  BufferedRectWriter rect_writer_;
+  BufferedPixelWriter pixel_writer_;
+  Span buf_a_[kMaxOpenSpans];
+  Span buf_b_[kMaxOpenSpans];
+  Span* prev_;
+  Span* cur_;
+  int prev_count_;
+  int prev_idx_;
+  int cur_count_;
+  Color last_color_;
+  Color last_blended_;
+};
+
+}  // namespace
+
+void DrawScanlineSpans(PixelStream& stream, const Surface& s, const Box& box) {
+  SpanEmitter emitter(s);
+  for (int16_t y = box.yMin(); y <= box.yMax(); ++y) {
+    emitter.startRow();
+    int16_t x = box.xMin();
+    while (x <= box.xMax()) {
+      Color color;
+      uint32_t run_length = 0;
+      stream.read(&color, 1, run_length);
+      uint32_t remaining = box.xMax() - x + 1;
+      if (run_length > remaining) run_length = remaining;
+      if (run_length < kMinSpanWidth) {
+        emitter.addPixel(x, y, color);
+        ++x;
+        continue;
+      }
+      stream.skip(run_length - 1);
+      emitter.addSpan(x, x + run_length - 1, y, color);
+      x += run_length;
+    }
+    emitter.endRow(y);
+  }
+  emitter.finish(box.yMax());
+}
+
+}  // namespace internal
+}  // namespace roo_display
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "roo_display/core/drawable.h"
+#include "roo_display/core/streamable.h"
+
+namespace roo_display {
+namespace internal {
+
+/// Draws the pixels of `stream`, which must cover exactly `box` (in device
+/// coordinates), scanline by scanline.
+///
+/// Relies on the stream reporting uniform runs (see `PixelStream::read()`).
+/// Uniform runs are emitted as rectangles, merged across consecutive
+/// scanlines when they span the same columns with the same color, so that
+/// e.g. the straight edges and the interior of a shape cost a handful of
+/// rectangles regardless of their size. Only the remaining pixels (typically,
+/// the anti-aliased edges) are read and written one by one.
+void DrawScanlineSpans(PixelStream& stream, const Surface& s, const Box& box);
+
+}  // namespace internal
+}  // namespace roo_display
@@ -1,6 +1,7 @@
 #include "roo_display/shape/impl/smooth_arc.h"
 #include "roo_display/shape/impl/smooth_pixel.h"
 #include "roo_display/shape/impl/smooth_round_rect.h"
+#include "roo_display/shape/impl/smooth_scanline.h"
 #include "roo_display/shape/impl/smooth_triangle.h"
 #include "roo_display/shape/impl/smooth_wedge.h"
 
@@ -20,35 +21,43 @@ class EmptyStream : public PixelStream {
 }  // namespace
 
 SmoothShape::SmoothShape()
-    : kind_(SmoothShape::EMPTY), extents_(0, 0, -1, -1) {}
+    : kind_(SmoothShape::EMPTY),
+      rasterization_(Rasterization::kTiled),
+      extents_(0, 0, -1, -1) {}
 
 SmoothShape::SmoothShape(Box extents, Wedge wedge)
     : kind_(SmoothShape::WEDGE),
+      rasterization_(Rasterization::kTiled),
       extents_(std::move(extents)),
       wedge_(std::move(wedge)) {}
 
 SmoothShape::SmoothShape(Box extents, RoundRect round_rect)
     : kind_(SmoothShape::ROUND_RECT),
+      rasterization_(Rasterization::kTiled),
       extents_(std::move(extents)),
       round_rect_(std::move(round_rect)) {}
 
 SmoothShape::SmoothShape(Box extents, RoundRectCorners round_rect_corners)
     : kind_(SmoothShape::ROUND_RECT_CORNERS),
+      rasterization_(Rasterization::kTiled),
       extents_(std::move(extents)),
       round_rect_corners_(std::move(round_rect_corners)) {}
 
 SmoothShape::SmoothShape(Box extents, Arc arc)
     : kind_(SmoothShape::ARC),
+      rasterization_(Rasterization::kTiled),
       extents_(std::move(extents)),
       arc_(std::move(arc)) {}
 
 SmoothShape::SmoothShape(Box extents, Triangle triangle)
     : kind_(SmoothShape::TRIANGLE),
+      rasterization_(Rasterization::kTiled),
       extents_(std::move(extents)),
       triangle_(std::move(triangle)) {}
 
 SmoothShape::SmoothShape(int16_t x, int16_t y, Pixel pixel)
     : kind_(SmoothShape::PIXEL),
+      rasterization_(Rasterization::kTiled),
       extents_(x, y, x, y),
       pixel_(std::move(pixel)) {}
 
@@ -141,6 +150,8 @@ std::unique_ptr<PixelStream> SmoothShape::createStream(
       return internal::CreateRoundRectStream(round_rect_, bounds);
     case ROUND_RECT_CORNERS:
       return internal::CreateRoundRectStream(round_rect_corners_, bounds);
+    case ARC:
+      return internal::CreateArcStream(arc_, bounds);
     default:
       return Rasterizable::createStream(bounds);
   }
@@ -151,6 +162,13 @@ void SmoothShape::drawTo(const Surface& s) const {
   if (box.empty()) {
     return;
   }
+  if (rasterization_ == Rasterization::kScanline &&
+      ((kind_ == ROUND_RECT && internal::RoundRectStreamIsExact(round_rect_)) ||
+       kind_ == ROUND_RECT_CORNERS || kind_ == ARC)) {
+    internal::DrawScanlineSpans(*createStream(box.translate(-s.dx(), -s.dy())),
+                                s, box);
+    return;
+  }
   switch (kind_) {
     case WEDGE: {
       internal::DrawWedge(wedge_, s, box);
@@ -248,8 +248,35 @@ class SmoothShape : public Rasterizable {
     Color color;
   };
 
+  /// Strategies for drawing round rectangles and arcs.
+  enum class Rasterization : uint8_t {
+    /// Classifies 8x8 tiles as uniform or mixed, filling the uniform ones, and
+    /// evaluating every pixel of the mixed ones. The default.
+    kTiled,
+
+    /// Splits each scanline into uniform spans and anti-aliased edges. Only
+    /// the edge pixels get evaluated; the spans are emitted as rectangles,
+    /// merged across scanlines. Round rectangles whose geometry is not aligned
+    /// to the half-pixel grid are still drawn in tiles. Both strategies
+    /// produce the same pixels. Issues far fewer (and larger) writes, which
+    /// pays off on devices with a costly address window setup (e.g. SPI
+    /// displays), and for shapes dominated by curved edges (circles, arcs);
+    /// large rectangles with small corners take more CPU time than in tiles.
+    kScanline,
+  };
+
   SmoothShape();
 
+  /// Sets the strategy used to draw the shape. Ignored by shapes other than
+  /// round rectangles and arcs (e.g. lines and triangles), which are always
+  /// drawn in tiles.
+  void setRasterization(Rasterization rasterization) {
+    rasterization_ = rasterization;
+  }
+
+  /// Returns the strategy used to draw the shape.
+  Rasterization rasterization() const { return rasterization_; }
+
   Box extents() const override { return extents_; }
 
   SmoothShape translate(int16_t dx, int16_t dy) const;
@@ -315,6 +342,7 @@ class SmoothShape : public Rasterizable {
   SmoothShape(int16_t x, int16_t y, Pixel pixel);
 
   Kind kind_;
+  Rasterization rasterization_;
   Box extents_;
   union {
     Wedge wedge_;
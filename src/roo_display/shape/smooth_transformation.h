@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cmath>
+#include <type_traits>
 
+#include "roo_display/color/interpolation.h"
 #include "roo_display/core/box.h"
 #include "roo_display/core/raster.h"
 #include "roo_display/core/rasterizable.h"
@@ -94,13 +96,25 @@ ProjectiveTransformation Perspective(float px, float py);
 ProjectiveTransformation PerspectiveAbout(float px, float py,
                                           const FpPoint& base);
 
+/// Sampling kernel used by `TransformedRaster`.
+enum class RasterSampling {
+  /// Uses the color of the nearest source pixel. Fastest; makes sense e.g.
+  /// for integer scaling, and for rotations by multiples of 90 degrees.
+  kNearestNeighbor,
+
+  /// Interpolates between the four nearest source pixels. Smooth; the
+  /// default.
+  kBilinear
+};
+
 template <typename RasterType, typename TransformationType>
 class TransformedRaster;
 
 /// Return a rasterizable representation of a transformed raster.
 template <typename RasterType, typename TransformationType>
 TransformedRaster<RasterType, TransformationType> TransformRaster(
-    RasterType& original, TransformationType transformation);
+    RasterType& original, TransformationType transformation,
+    RasterSampling sampling = RasterSampling::kBilinear);
 
 // Implementation details.
 
@@ -384,199 +398,287 @@ class ProjectiveTransformation {
   float m31_, m32_, m33_;
 };
 
-// Uses bi-linear interpolation.
+namespace internal {
+
+// Whether the transformation is affine, i.e., whether moving by a pixel in the
+// destination moves the source coordinates by a constant vector.
+template <typename TransformationType>
+struct IsAffineTransformation : std::true_type {};
+
+template <>
+struct IsAffineTransformation<ProjectiveTransformation> : std::false_type {};
+
+// Source coordinates in 16.16 fixed point. The integer part is the floor of
+// the coordinate.
+inline int32_t ToFixed16(float v) {
+  // Clamped so that the result fits in int32, with room for stepping.
+  if (v < -16384.0f) v = -16384.0f;
+  if (v > 16384.0f) v = 16384.0f;
+  return (int32_t)floorf(v * 65536.0f);
+}
+
+}  // namespace internal
+
+/// Rasterizable representation of a raster, transformed by the specified
+/// transformation.
+///
+/// For every destination pixel, the inverse transformation gives the source
+/// coordinates, sampled using nearest-neighbor or bi-linear interpolation.
+/// Source pixels outside of the raster's extents count as transparent.
+///
+/// For affine transformations, pixels requested along rows (as done by
+/// `readColorRect()`, and typically by the callers of `readColors()`) are
+/// walked incrementally: the source coordinates are computed once per run, and
+/// then stepped in 16.16 fixed point. Pixels whose samples are all inside of
+/// the raster take a fast path, without edge handling.
 template <typename RasterType, typename TransformationType>
 class TransformedRaster : public Rasterizable {
  public:
-  TransformedRaster(RasterType& original, TransformationType transformation)
+  TransformedRaster(RasterType& original, TransformationType transformation,
+                    RasterSampling sampling = RasterSampling::kBilinear)
       : original_(original),
         inverse_transformation_(transformation.inversion()),
         extents_(transformation.transformExtents(original.extents())),
         anchor_extents_(
-            transformation.transformExtents(original.anchorExtents())) {}
+            transformation.transformExtents(original.anchorExtents())),
+        sampling_(sampling) {
+    if constexpr (internal::IsAffineTransformation<TransformationType>::value) {
+      FpPoint origin = inverse_transformation_.apply(FpPoint{0.0f, 0.0f});
+      FpPoint step = inverse_transformation_.apply(FpPoint{1.0f, 0.0f});
+      step_u_ = (int32_t)lroundf((step.x - origin.x) * 65536.0f);
+      step_v_ = (int32_t)lroundf((step.y - origin.y) * 65536.0f);
+    } else {
+      step_u_ = 0;
+      step_v_ = 0;
+    }
+  }
 
   void readColors(const int16_t* x, const int16_t* y, uint32_t count,
                   Color* result) const override {
-    Box orig_extents = original_.extents();
-    if (orig_extents.empty()) {
+    if (original_.extents().empty()) {
       for (uint32_t i = 0; i < count; ++i) {
         result[i] = color::Transparent;
       }
       return;
     }
-    typename RasterType::Reader reader;
-    const auto ptr = original_.buffer();
-    uint16_t w = orig_extents.width();
-    RawColorInterpolator<typename RasterType::ColorMode> interpolator;
-    for (uint32_t i = 0; i < count; ++i) {
-      FpPoint orig =
-          inverse_transformation_.apply(FpPoint{(float)x[i], (float)y[i]});
-      int16_t xMin = (int16_t)floorf(orig.x);
-      int16_t yMin = (int16_t)floorf(orig.y);
-      int16_t xMax = (int16_t)ceilf(orig.x);
-      int16_t yMax = (int16_t)ceilf(orig.y);
-      if (xMax < orig_extents.xMin() || xMin > orig_extents.xMax() ||
-          yMax < orig_extents.yMin() || yMin > orig_extents.yMax()) {
-        result[i] = color::Transparent;
-        continue;
+    uint32_t i = 0;
+    while (i < count) {
+      // Find the run of consecutive pixels in the same row.
+      uint32_t run = 1;
+      while (i + run < count && y[i + run] == y[i] &&
+             x[i + run] == x[i] + (int16_t)run) {
+        ++run;
       }
-      int32_t offset =
-          xMin - orig_extents.xMin() + (yMin - orig_extents.yMin()) * w;
-      if (xMin == xMax && yMin == yMax) {
-        result[i] = reader(ptr, offset, original_.color_mode());
-        continue;
+      readRow(x[i], y[i], run, result + i);
+      i += run;
+    }
+  }
+
+  bool readColorRect(int16_t xMin, int16_t yMin, int16_t xMax, int16_t yMax,
+                     Color* result) const override {
+    if (original_.extents().empty()) {
+      *result = color::Transparent;
+      return true;
+    }
+    uint32_t width = xMax - xMin + 1;
+    for (int16_t y = yMin; y <= yMax; ++y) {
+      readRow(xMin, y, width, result);
+      result += width;
+    }
+    return false;
+  }
+
+  Box extents() const override { return extents_; }
+  Box anchorExtents() const override { return anchor_extents_; }
+
+ private:
+  using Reader = typename RasterType::Reader;
+
+  // Reads `count` consecutive pixels of the row `y`, starting at `x`.
+  void readRow(int16_t x, int16_t y, uint32_t count, Color* result) const {
+    if constexpr (!internal::IsAffineTransformation<
+                      TransformationType>::value) {
+      readRowPerPixel(x, y, count, result);
+    } else {
+      FpPoint start =
+          inverse_transformation_.apply(FpPoint{(float)x, (float)y});
+      FpPoint end = inverse_transformation_.apply(
+          FpPoint{(float)(x + (int16_t)count - 1), (float)y});
+      if (fabsf(start.x) > 16384.0f || fabsf(start.y) > 16384.0f ||
+          fabsf(end.x) > 16384.0f || fabsf(end.y) > 16384.0f) {
+        // Stepping could overflow.
+        readRowPerPixel(x, y, count, result);
+        return;
       }
-      if (xMin == xMax) {
-        int16_t interpolation_fraction = (int16_t)(256 * (orig.y - yMin));
-        if (yMin < orig_extents.yMin()) {
-          result[i] =
-              InterpolateColors(color::Transparent,
-                                reader(ptr, offset + w, original_.color_mode()),
-                                interpolation_fraction);
-        } else if (yMax > orig_extents.yMax()) {
-          result[i] =
-              InterpolateColors(original_.get(xMin, yMin), color::Transparent,
-                                interpolation_fraction);
+      readRowStepping(internal::ToFixed16(start.x),
+                      internal::ToFixed16(start.y), count, result);
+    }
+  }
+
+  // Computes the source coordinates for each pixel separately.
+  void readRowPerPixel(int16_t x, int16_t y, uint32_t count,
+                       Color* result) const {
+    for (uint32_t i = 0; i < count; ++i) {
+      FpPoint orig = inverse_transformation_.apply(
+          FpPoint{(float)(x + (int16_t)i), (float)y});
+      result[i] =
+          sample(internal::ToFixed16(orig.x), internal::ToFixed16(orig.y));
+    }
+  }
+
+  // Walks the source, starting at (u, v), by the constant step.
+  void readRowStepping(int32_t u, int32_t v, uint32_t count,
+                       Color* result) const {
+    Box ext = original_.extents();
+    const auto ptr = original_.buffer();
+    const auto& color_mode = original_.color_mode();
+    uint16_t w = ext.width();
+    Reader read;
+    if (sampling_ == RasterSampling::kNearestNeighbor) {
+      // Rounds to the nearest pixel.
+      u += 0x8000;
+      v += 0x8000;
+      int32_t u_min = (int32_t)ext.xMin() << 16;
+      int32_t v_min = (int32_t)ext.yMin() << 16;
+      uint32_t u_range = (uint32_t)ext.width() << 16;
+      uint32_t v_range = (uint32_t)ext.height() << 16;
+      for (uint32_t i = 0; i < count; ++i) {
+        if ((uint32_t)(u - u_min) < u_range &&
+            (uint32_t)(v - v_min) < v_range) {
+          result[i] = read(ptr,
+                           ((u - u_min) >> 16) + ((v - v_min) >> 16) * w,
+                           color_mode);
         } else {
-          result[i] =
-              InterpolateColors(reader(ptr, offset, original_.color_mode()),
-                                reader(ptr, offset + w, original_.color_mode()),
-                                interpolation_fraction);
+          result[i] = color::Transparent;
         }
-        continue;
+        u += step_u_;
+        v += step_v_;
       }
-      if (yMin == yMax) {
-        int16_t interpolation_fraction = (uint16_t)(256 * (orig.x - xMin));
-        if (xMin < orig_extents.xMin()) {
-          result[i] =
-              InterpolateColors(color::Transparent,
-                                reader(ptr, offset + 1, original_.color_mode()),
-                                interpolation_fraction);
-        } else if (xMax > orig_extents.xMax()) {
-          result[i] =
-              InterpolateColors(reader(ptr, offset, original_.color_mode()),
-                                color::Transparent, interpolation_fraction);
-        } else {
+      return;
+    }
+    // Bi-linear. In the interior, all four samples are within the extents.
+    int32_t u_min = (int32_t)ext.xMin() << 16;
+    int32_t v_min = (int32_t)ext.yMin() << 16;
+    uint32_t u_range = (uint32_t)(ext.width() - 1) << 16;
+    uint32_t v_range = (uint32_t)(ext.height() - 1) << 16;
+    for (uint32_t i = 0; i < count; ++i) {
+      if ((uint32_t)(u - u_min) < u_range &&
+          (uint32_t)(v - v_min) < v_range) {
+        int32_t offset = ((u - u_min) >> 16) + ((v - v_min) >> 16) * w;
+        int16_t fx = (u >> 8) & 0xFF;
+        int16_t fy = (v >> 8) & 0xFF;
+        if ((u & 0xFFFF) == 0) {
           result[i] =
-              InterpolateColors(reader(ptr, offset, original_.color_mode()),
-                                reader(ptr, offset + 1, original_.color_mode()),
-                                interpolation_fraction);
-        }
-        continue;
-      }
-      // General case.
-      int16_t interpolation_fraction_x = (int16_t)(256 * (orig.x - xMin));
-      int16_t interpolation_fraction_y = (int16_t)(256 * (orig.y - yMin));
-
-      // Color a = color::Transparent;
-      // Color b = color::Transparent;
-      // Color c = color::Transparent;
-      // Color d = color::Transparent;
-
-      // if (xMin >= orig_extents.xMin()) {
-      //   if (yMin >= orig_extents.yMin()) {
-      //     a = reader(ptr, offset, original_.color_mode());
-      //   }
-      //   if (yMax <= orig_extents.yMax()) {
-      //     c = reader(ptr, offset + w, original_.color_mode());
-      //   }
-      // }
-      // if (xMax <= orig_extents.xMax()) {
-      //   if (yMin >= orig_extents.yMin()) {
-      //     b = reader(ptr, offset + 1, original_.color_mode());
-      //   }
-      //   if (yMax <= orig_extents.yMax()) {
-      //     d = reader(ptr, offset + w + 1, original_.color_mode());
-      //   }
-      // }
-      // result[i] =
-      //     InterpolateColors(InterpolateColors(a, b,
-      //     interpolation_fraction_x),
-      //                       InterpolateColors(c, d,
-      //                       interpolation_fraction_x),
-      //                       interpolation_fraction_y);
-
-      Color ab_mix = color::Transparent;
-      if (yMin >= orig_extents.yMin()) {
-        if (xMin < orig_extents.xMin()) {
-          // ab_mix = color::Olive;
-          ab_mix =
-              InterpolateColors(color::Transparent,
-                                reader(ptr, offset + 1, original_.color_mode()),
-                                interpolation_fraction_x);
-          // ab_mix = InterpolateColorWithTransparency(
-          //     reader(ptr, offset + 1, original_.color_mode())),
-          //     interpolation_fraction_x);
-        } else if (xMax > orig_extents.xMax()) {
-          // ab_mix = color::BlueViolet;
-          ab_mix =
-              InterpolateColors(reader(ptr, offset, original_.color_mode()),
-                                color::Transparent, interpolation_fraction_x);
-          // ab_mix = InterpolateColorWithTransparency(
-          //     reader(ptr, offset,original_.color_mode())), 256 -
-          //     interpolation_fraction_x);
-        } else {
-          // ab_mix =
-          //     interpolator(reader(ptr, offset, original_.color_mode()),
-          //     reader(ptr, offset + 1, original_.color_mode()),
-          //                  interpolation_fraction_x, original_.color_mode());
-          ab_mix =
-              InterpolateColors(reader(ptr, offset, original_.color_mode()),
-                                reader(ptr, offset + 1, original_.color_mode()),
-                                interpolation_fraction_x);
-        }
-      }
-      Color cd_mix = color::Transparent;
-      if (yMax <= orig_extents.yMax()) {
-        if (xMin < orig_extents.xMin()) {
-          // cd_mix = color::Red;
-          cd_mix = InterpolateColors(
-              color::Transparent,
-              reader(ptr, offset + w + 1, original_.color_mode()),
-              interpolation_fraction_x);
-          // cd_mix = InterpolateColorWithTransparency(
-          //     original_.color_mode().toArgbColor(reader(ptr, offset + w +
-          //     1, original_.color_mode())), interpolation_fraction_x);
-        } else if (xMax > orig_extents.xMax()) {
-          // cd_mix = color::Blue;
-          // cd_mix = InterpolateColorWithTransparency(
-          //     original_.color_mode().toArgbColor(reader(ptr, offset + w,
-          //     original_.color_mode())), 256 - interpolation_fraction_x);
-          cd_mix =
-              InterpolateColors(reader(ptr, offset + w, original_.color_mode()),
-                                color::Transparent, interpolation_fraction_x);
+              ((v & 0xFFFF) == 0)
+                  ? read(ptr, offset, color_mode)
+                  : InterpolateColors(read(ptr, offset, color_mode),
+                                      read(ptr, offset + w, color_mode), fy);
+        } else if ((v & 0xFFFF) == 0) {
+          result[i] = InterpolateColors(read(ptr, offset, color_mode),
+                                        read(ptr, offset + 1, color_mode), fx);
         } else {
-          // cd_mix =
-          //     interpolator(reader(ptr, offset + w, original_.color_mode()),
-          //     reader(ptr, offset + w + 1, original_.color_mode()),
-          //     interpolation_fraction_x, original_.color_mode());
-          //                  interpolation_fraction_x, original_.color_mode());
-          cd_mix = InterpolateColors(
-              reader(ptr, offset + w, original_.color_mode()),
-              reader(ptr, offset + w + 1, original_.color_mode()),
-              interpolation_fraction_x);
+          result[i] = InterpolateColors(
+              InterpolateColors(read(ptr, offset, color_mode),
+                                read(ptr, offset + 1, color_mode), fx),
+              InterpolateColors(read(ptr, offset + w, color_mode),
+                                read(ptr, offset + w + 1, color_mode), fx),
+              fy);
         }
+      } else {
+        result[i] = sampleBilinear(u, v);
       }
+      u += step_u_;
+      v += step_v_;
+    }
+  }
 
-      result[i] = InterpolateColors(ab_mix, cd_mix, interpolation_fraction_y);
+  // Samples the raster at the specified 16.16 fixed-point coordinates.
+  Color sample(int32_t u, int32_t v) const {
+    if (sampling_ == RasterSampling::kNearestNeighbor) {
+      Box ext = original_.extents();
+      int16_t x = (u + 0x8000) >> 16;
+      int16_t y = (v + 0x8000) >> 16;
+      if (!ext.contains(x, y)) return color::Transparent;
+      return Reader()(original_.buffer(),
+                      x - ext.xMin() + (y - ext.yMin()) * ext.width(),
+                      original_.color_mode());
     }
+    return sampleBilinear(u, v);
   }
 
-  Box extents() const override { return extents_; }
-  Box anchorExtents() const override { return anchor_extents_; }
+  // Bi-linear sample, with samples outside of the extents treated as
+  // transparent.
+  Color sampleBilinear(int32_t u, int32_t v) const {
+    Box ext = original_.extents();
+    int16_t xMin = u >> 16;
+    int16_t yMin = v >> 16;
+    int16_t xMax = xMin + ((u & 0xFFFF) != 0);
+    int16_t yMax = yMin + ((v & 0xFFFF) != 0);
+    if (xMax < ext.xMin() || xMin > ext.xMax() || yMax < ext.yMin() ||
+        yMin > ext.yMax()) {
+      return color::Transparent;
+    }
+    Reader read;
+    const auto ptr = original_.buffer();
+    const auto& color_mode = original_.color_mode();
+    uint16_t w = ext.width();
+    int32_t offset = xMin - ext.xMin() + (yMin - ext.yMin()) * w;
+    int16_t fx = (u >> 8) & 0xFF;
+    int16_t fy = (v >> 8) & 0xFF;
+    if (xMin == xMax && yMin == yMax) {
+      return read(ptr, offset, color_mode);
+    }
+    if (xMin == xMax) {
+      Color a = (yMin < ext.yMin()) ? color::Transparent
+                                    : read(ptr, offset, color_mode);
+      Color c = (yMax > ext.yMax()) ? color::Transparent
+                                    : read(ptr, offset + w, color_mode);
+      return InterpolateColors(a, c, fy);
+    }
+    if (yMin == yMax) {
+      Color a = (xMin < ext.xMin()) ? color::Transparent
+                                    : read(ptr, offset, color_mode);
+      Color b = (xMax > ext.xMax()) ? color::Transparent
+                                    : read(ptr, offset + 1, color_mode);
+      return InterpolateColors(a, b, fx);
+    }
+    Color ab_mix = color::Transparent;
+    if (yMin >= ext.yMin()) {
+      Color a = (xMin < ext.xMin()) ? color::Transparent
+                                    : read(ptr, offset, color_mode);
+      Color b = (xMax > ext.xMax()) ? color::Transparent
+                                    : read(ptr, offset + 1, color_mode);
+      ab_mix = InterpolateColors(a, b, fx);
+    }
+    Color cd_mix = color::Transparent;
+    if (yMax <= ext.yMax()) {
+      Color c = (xMin < ext.xMin()) ? color::Transparent
+                                    : read(ptr, offset + w, color_mode);
+      Color d = (xMax > ext.xMax()) ? color::Transparent
+                                    : read(ptr, offset + w + 1, color_mode);
+      cd_mix = InterpolateColors(c, d, fx);
+    }
+    return InterpolateColors(ab_mix, cd_mix, fy);
+  }
 
- private:
   RasterType& original_;
   TransformationType inverse_transformation_;
   Box extents_;
   Box anchor_extents_;
+  RasterSampling sampling_;
+
+  // Source coordinate increments per destination pixel along a row, in 16.16
+  // fixed point. Unused for non-affine transformations.
+  int32_t step_u_;
+  int32_t step_v_;
 };
 
 template <typename RasterType, typename TransformationType>
 TransformedRaster<RasterType, TransformationType> TransformRaster(
-    RasterType& original, TransformationType transformation) {
-  return TransformedRaster<RasterType, TransformationType>(original,
-                                                           transformation);
+    RasterType& original, TransformationType transformation,
+    RasterSampling sampling) {
+  return TransformedRaster<RasterType, TransformationType>(
+      original, transformation, sampling);
 }
 
 }  // namespace roo_display
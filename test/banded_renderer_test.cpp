@@ -0,0 +1,171 @@
+#include "roo_display/composition/banded_renderer.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include "roo_display/color/color.h"
+#include "roo_display/shape/basic.h"
+#include "testing.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+namespace {
+
+using TestRenderer =
+    BandedRenderer<Rgb565, ColorPixelOrder::kMsbFirst, roo_io::kNativeEndian>;
+
+void DrawScene(DrawingContext& dc) {
+  dc.draw(FilledRect(2, 1, 12, 9, color::Red));
+  dc.draw(Line(0, 0, 15, 10, color::Yellow));
+  dc.draw(FilledCircle::ByRadius(8, 6, 3, color::Blue));
+}
+
+// Simulates a device that transfers drawDirectRectAsync() data in the
+// background (e.g. by DMA): the data is only read when the transfer completes,
+// i.e. at the next drawing call, or at flush(). Verifies that the data does
+// not get modified in the meantime.
+class DeferredTransferDevice : public FakeOffscreen<Rgb565> {
+ public:
+  DeferredTransferDevice(int16_t width, int16_t height, Color background)
+      : FakeOffscreen<Rgb565>(width, height, background) {}
+
+  void drawDirectRectAsync(const roo::byte* data, size_t row_width_bytes,
+                           int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                           int16_t src_y1, int16_t dst_x0,
+                           int16_t dst_y0) override {
+    complete();
+    pending_ = data;
+    row_width_bytes_ = row_width_bytes;
+    src_ = Box(src_x0, src_y0, src_x1, src_y1);
+    dst_x0_ = dst_x0;
+    dst_y0_ = dst_y0;
+    snapshot_.assign(data, data + (src_y1 + 1) * row_width_bytes);
+    ++async_transfers_;
+  }
+
+  void flush() override { complete(); }
+
+  void setAddress(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                  BlendingMode mode) override {
+    complete();
+    FakeOffscreen<Rgb565>::setAddress(x0, y0, x1, y1, mode);
+  }
+
+  void fillRects(BlendingMode mode, Color color, int16_t* x0, int16_t* y0,
+                 int16_t* x1, int16_t* y1, uint16_t count) override {
+    complete();
+    FakeOffscreen<Rgb565>::fillRects(mode, color, x0, y0, x1, y1, count);
+  }
+
+  void writeRects(BlendingMode mode, Color* color, int16_t* x0, int16_t* y0,
+                  int16_t* x1, int16_t* y1, uint16_t count) override {
+    complete();
+    FakeOffscreen<Rgb565>::writeRects(mode, color, x0, y0, x1, y1, count);
+  }
+
+  void drawDirectRect(const roo::byte* data, size_t row_width_bytes,
+                      int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                      int16_t src_y1, int16_t dst_x0, int16_t dst_y0) override {
+    complete();
+    FakeOffscreen<Rgb565>::drawDirectRect(data, row_width_bytes, src_x0,
+                                          src_y0, src_x1, src_y1, dst_x0,
+                                          dst_y0);
+  }
+
+  bool transferPending() const { return pending_ != nullptr; }
+
+  int asyncTransfers() const { return async_transfers_; }
+
+ private:
+  void complete() {
+    if (pending_ == nullptr) return;
+    EXPECT_EQ(0, memcmp(snapshot_.data(), pending_, snapshot_.size()))
+        << "Buffer modified before its transfer completed";
+    FakeOffscreen<Rgb565>::drawDirectRect(pending_, row_width_bytes_,
+                                          src_.xMin(), src_.yMin(),
+                                          src_.xMax(), src_.yMax(), dst_x0_,
+                                          dst_y0_);
+    pending_ = nullptr;
+  }
+
+  const roo::byte* pending_ = nullptr;
+  size_t row_width_bytes_ = 0;
+  Box src_ = Box(0, 0, -1, -1);
+  int16_t dst_x0_ = 0;
+  int16_t dst_y0_ = 0;
+  std::vector<roo::byte> snapshot_;
+  int async_transfers_ = 0;
+};
+
+}  // namespace
+
+TEST(BandedRenderer, SameAsDirect) {
+  FakeOffscreen<Rgb565> expected(16, 11, color::Black);
+  {
+    Display display(expected);
+    display.setBackgroundColor(color::DarkGray);
+    DrawingContext dc(display);
+    dc.clear();
+    DrawScene(dc);
+  }
+  FakeOffscreen<Rgb565> actual(16, 11, color::Black);
+  Display display(actual);
+  display.setBackgroundColor(color::DarkGray);
+  TestRenderer renderer(16, 4);
+  int bands = 0;
+  renderer.draw(display, [&bands](DrawingContext& dc) {
+    ++bands;
+    DrawScene(dc);
+  });
+  // 11 rows, in bands of 4.
+  EXPECT_EQ(3, bands);
+  EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+}
+
+TEST(BandedRenderer, BuffersNotReusedBeforeTransferCompletes) {
+  FakeOffscreen<Rgb565> expected(16, 11, color::Black);
+  {
+    Display display(expected);
+    display.setBackgroundColor(color::DarkGray);
+    DrawingContext dc(display);
+    dc.clear();
+    DrawScene(dc);
+  }
+  DeferredTransferDevice actual(16, 11, color::Black);
+  Display display(actual);
+  display.setBackgroundColor(color::DarkGray);
+  // Bands of 2 rows, so that each of the two buffers gets reused several
+  // times.
+  TestRenderer renderer(16, 2);
+  renderer.draw(display, [](DrawingContext& dc) { DrawScene(dc); });
+  EXPECT_EQ(6, actual.asyncTransfers());
+  EXPECT_FALSE(actual.transferPending());
+  EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+}
+
+TEST(BandedRenderer, SubArea) {
+  FakeOffscreen<Rgb565> screen(16, 11, color::Black);
+  Display display(screen);
+  display.setBackgroundColor(color::White);
+  TestRenderer renderer(8, 2);
+  renderer.draw(display, Box(4, 3, 9, 7), [](DrawingContext& dc) {
+    dc.draw(FilledRect(0, 5, 15, 5, color::Black));
+  });
+  EXPECT_THAT(screen, MatchesContent(WhiteOnBlack(), 16, 11,
+                                     "                "
+                                     "                "
+                                     "                "
+                                     "    ******      "
+                                     "    ******      "
+                                     "                "
+                                     "    ******      "
+                                     "    ******      "
+                                     "                "
+                                     "                "
+                                     "                "));
+}
+
+}  // namespace roo_display
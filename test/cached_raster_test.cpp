@@ -0,0 +1,127 @@
+#include "roo_display/image/cached_raster.h"
+
+#include <random>
+
+#include "roo_display/color/color.h"
+#include "roo_display/color/color_modes.h"
+#include "roo_display/io/memory.h"
+#include "roo_io/memory/memory_iterable.h"
+#include "testing.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+namespace {
+
+roo_io::MemoryIterable Resource(const unsigned char* data, size_t size) {
+  return roo_io::MemoryIterable((const roo::byte*)data,
+                                (const roo::byte*)data + size);
+}
+
+void Draw(DisplayDevice& output, int16_t x, int16_t y, const Box& clip_box,
+          const Drawable& object) {
+  output.begin();
+  Surface s(output, x, y, clip_box, false, color::Transparent,
+            FillMode::kVisible, BlendingMode::kSourceOver);
+  s.drawObject(object);
+  output.end();
+}
+
+}  // namespace
+
+TEST(CachedRaster, Grayscale4OddWidth) {
+  // Rows are packed continuously; row 1 starts in the middle of a byte.
+  unsigned char data[] = {0xC1, 0x26, 0xE7};
+  CachedRaster<roo_io::MemoryIterable, Grayscale4> raster(
+      3, 2, Resource(data, sizeof(data)));
+  EXPECT_THAT(raster, MatchesContent(Grayscale4(), 3, 2,
+                                     "C12"
+                                     "6E7"));
+  EXPECT_THAT(ForcedStreamable(&raster), MatchesContent(Grayscale4(), 3, 2,
+                                                        "C12"
+                                                        "6E7"));
+  EXPECT_THAT(ForcedRasterizable(&raster), MatchesContent(Grayscale4(), 3, 2,
+                                                          "C12"
+                                                          "6E7"));
+}
+
+TEST(CachedRaster, MonochromeSharedBytes) {
+  // Two rows per byte.
+  unsigned char data[] = {0xC1, 0x26, 0xE7};
+  CachedRaster<roo_io::MemoryIterable, Monochrome> raster(
+      4, 6, Resource(data, sizeof(data)), WhiteOnBlack(), 4, 3);
+  FakeOffscreen<Rgb565> test_screen(4, 6, color::Black);
+  Draw(test_screen, 0, 0, test_screen.extents(), raster);
+  EXPECT_THAT(test_screen, MatchesContent(WhiteOnBlack(), 4, 6,
+                                          "**  "
+                                          "   *"
+                                          "  * "
+                                          " ** "
+                                          "*** "
+                                          " ***"));
+}
+
+TEST(CachedRaster, DrawClipped) {
+  unsigned char data[] = {0xC1, 0x26, 0xE7};
+  CachedRaster<roo_io::MemoryIterable, Monochrome> raster(
+      4, 6, Resource(data, sizeof(data)), WhiteOnBlack());
+  FakeOffscreen<Rgb565> test_screen(4, 6, color::Black);
+  Draw(test_screen, 0, 0, Box(1, 2, 3, 4), raster);
+  EXPECT_THAT(test_screen, MatchesContent(WhiteOnBlack(), 4, 6,
+                                          "    "
+                                          "    "
+                                          "  * "
+                                          " ** "
+                                          " ** "
+                                          "    "));
+}
+
+TEST(CachedRaster, SequentialDrawReadsAhead) {
+  unsigned char data[2 * 8 * 8];
+  for (size_t i = 0; i < sizeof(data); ++i) data[i] = i * 7;
+  CachedRaster<roo_io::MemoryIterable, Rgb565> raster(
+      8, 8, Resource(data, sizeof(data)), Rgb565(), 16, 4);
+  ConstDramRaster<Rgb565> expected(8, 8, (const roo::byte*)data);
+
+  FakeOffscreen<Rgb565> reference(8, 8, color::Black);
+  Draw(reference, 0, 0, reference.extents(), expected);
+
+  FakeOffscreen<Rgb565> test_screen(8, 8, color::Black);
+  Draw(test_screen, 0, 0, test_screen.extents(), raster);
+  EXPECT_THAT(RasterOf(test_screen), MatchesContent(RasterOf(reference)));
+  EXPECT_EQ(2, raster.stats().misses);
+  EXPECT_EQ(6, raster.stats().hits);
+  EXPECT_EQ(1, raster.stats().seeks);
+
+  // Everything is cached now.
+  raster.resetStats();
+  Draw(test_screen, 0, 0, test_screen.extents(), raster);
+  EXPECT_EQ(0, raster.stats().misses);
+  EXPECT_EQ(8, raster.stats().hits);
+  EXPECT_EQ(0, raster.stats().seeks);
+}
+
+TEST(CachedRaster, RandomAccessWithSmallCache) {
+  unsigned char data[(13 * 11 + 1) / 2];
+  std::mt19937 gen(12345);
+  for (size_t i = 0; i < sizeof(data); ++i) data[i] = gen();
+  CachedRaster<roo_io::MemoryIterable, Grayscale4> raster(
+      Box(5, 7, 17, 17), Resource(data, sizeof(data)), Grayscale4(), 2, 2);
+  ConstDramRaster<Grayscale4> expected(Box(5, 7, 17, 17),
+                                      (const roo::byte*)data);
+  std::uniform_int_distribution<int16_t> xdist(5, 17);
+  std::uniform_int_distribution<int16_t> ydist(7, 17);
+  for (int i = 0; i < 200; ++i) {
+    int16_t x = xdist(gen);
+    int16_t y = ydist(gen);
+    Color actual;
+    Color wanted;
+    raster.readColors(&x, &y, 1, &actual);
+    expected.readColors(&x, &y, 1, &wanted);
+    ASSERT_EQ(wanted, actual) << "at " << x << ", " << y;
+  }
+  EXPECT_GT(raster.stats().seeks, 1);
+}
+
+}  // namespace roo_display
@@ -3,6 +3,8 @@
 
 #include "roo_display.h"
 #include "roo_display/color/color.h"
+#include "roo_display/core/offscreen.h"
+#include "roo_display/shape/basic.h"
 #include "testing.h"
 #include "testing_display_device.h"
 
@@ -40,6 +42,30 @@ class SimpleRoundMask {
   }
 };
 
+static const uint8_t kLargeClipMaskData[] = {
+    0b00000000, 0b00000000, 0b00000000, 0b00000000,  // NOFORMAT
+    0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
+    0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
+    0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
+    0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
+    0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
+    0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
+    0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
+    0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
+    0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
+    0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
+    0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
+    0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
+    0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
+    0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
+    0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
+    0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
+    0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
+    0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
+    0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
+    0b00000000, 0b00000000, 0b00000000, 0b00000000,  // NOFORMAT
+};
+
 class LargeMask {
  public:
   LargeMask(Box extents) {}
@@ -75,30 +101,7 @@ class LargeMask {
   }
 
   static ClipMaskFilter* Create(DisplayOutput& output, Box extents) {
-    static const uint8_t clip_mask_data[] = {
-        0b00000000, 0b00000000, 0b00000000, 0b00000000,  // NOFORMAT
-        0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
-        0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
-        0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
-        0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
-        0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
-        0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
-        0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
-        0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
-        0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
-        0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
-        0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
-        0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
-        0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
-        0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
-        0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
-        0b01111111, 0b11111111, 0b11111111, 0b11110000,  // NOFORMAT
-        0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
-        0b00111111, 0b11111111, 0b11111111, 0b11100000,  // NOFORMAT
-        0b00011111, 0b11111111, 0b11111111, 0b11000000,  // NOFORMAT
-        0b00000000, 0b00000000, 0b00000000, 0b00000000,  // NOFORMAT
-    };
-    static ClipMask mask(clip_mask_data, Box(1, 2, 32, 22));
+    static ClipMask mask(kLargeClipMaskData, Box(1, 2, 32, 22));
     return new ClipMaskFilter(output, &mask);
   }
 };
@@ -172,6 +175,98 @@ TEST(ClipMask, SimpleLargeTests) {
       BlendingMode::kSource, Orientation());
 }
 
+class TiledLargeMask {
+ public:
+  static ClipMaskFilter* Create(DisplayOutput& output, Box extents) {
+    static TiledClipMask mask((const roo::byte*)kLargeClipMaskData,
+                              Box(1, 2, 32, 22));
+    return new ClipMaskFilter(output, &mask);
+  }
+};
+
+typedef FilteredOutput<Grayscale4, TiledLargeMask> TestDeviceTiledLarge;
+
+TEST(ClipMask, TiledLargeTests) {
+  TestFillRects<TestDeviceTiledLarge, RefDeviceLarge>(BlendingMode::kSource,
+                                                      Orientation());
+  TestFillHLines<TestDeviceTiledLarge, RefDeviceLarge>(BlendingMode::kSource,
+                                                       Orientation());
+  TestFillVLines<TestDeviceTiledLarge, RefDeviceLarge>(BlendingMode::kSource,
+                                                       Orientation());
+  TestFillPixels<TestDeviceTiledLarge, RefDeviceLarge>(BlendingMode::kSource,
+                                                       Orientation());
+  TestWriteRects<TestDeviceTiledLarge, RefDeviceLarge>(BlendingMode::kSource,
+                                                       Orientation());
+  TestWriteHLines<TestDeviceTiledLarge, RefDeviceLarge>(BlendingMode::kSource,
+                                                        Orientation());
+  TestWriteVLines<TestDeviceTiledLarge, RefDeviceLarge>(BlendingMode::kSource,
+                                                        Orientation());
+  TestWritePixels<TestDeviceTiledLarge, RefDeviceLarge>(BlendingMode::kSource,
+                                                        Orientation());
+  TestWritePixelsSnake<TestDeviceTiledLarge, RefDeviceLarge>(
+      BlendingMode::kSource, Orientation());
+  TestWriteRectWindowSimple<TestDeviceTiledLarge, RefDeviceLarge>(
+      BlendingMode::kSource, Orientation());
+  TestWriteRectWindowStress<TestDeviceTiledLarge, RefDeviceLarge>(
+      BlendingMode::kSource, Orientation());
+}
+
+TEST(ClipMask, TiledClipMaskSpans) {
+  TiledClipMask mask((const roo::byte*)kLargeClipMaskData, Box(1, 2, 32, 22));
+  ClipMask::Coverage coverage;
+  // Above the mask.
+  EXPECT_EQ(40, mask.span(0, 0, 39, coverage));
+  EXPECT_EQ(ClipMask::Coverage::kUnmasked, coverage);
+  // Left of the mask.
+  EXPECT_EQ(1, mask.span(0, 12, 39, coverage));
+  EXPECT_EQ(ClipMask::Coverage::kUnmasked, coverage);
+  // Mask rows 8-15 are set in bytes 1 and 2, and mixed in bytes 0 and 3.
+  EXPECT_EQ(8, mask.span(1, 12, 39, coverage));
+  EXPECT_EQ(ClipMask::Coverage::kMixed, coverage);
+  EXPECT_EQ(16, mask.span(9, 12, 39, coverage));
+  EXPECT_EQ(ClipMask::Coverage::kMasked, coverage);
+  EXPECT_EQ(13, mask.span(12, 12, 24, coverage));
+  EXPECT_EQ(ClipMask::Coverage::kMasked, coverage);
+  // Mask rows 16-20 are all partial.
+  EXPECT_EQ(32, mask.span(1, 20, 39, coverage));
+  EXPECT_EQ(ClipMask::Coverage::kMixed, coverage);
+  mask.setInverted(true);
+  EXPECT_EQ(16, mask.span(9, 12, 39, coverage));
+  EXPECT_EQ(ClipMask::Coverage::kUnmasked, coverage);
+  EXPECT_EQ(1, mask.span(0, 12, 39, coverage));
+  EXPECT_EQ(ClipMask::Coverage::kMasked, coverage);
+}
+
+TEST(ClipMask, TiledClipMaskFromBitMaskOffscreen) {
+  BitMaskOffscreen offscreen(36, 26, color::Transparent);
+  TiledClipMask tiled(offscreen);
+  ClipMask plain(offscreen.buffer(), offscreen.extents());
+  {
+    DrawingContext dc(offscreen);
+    dc.draw(FilledRect(4, 3, 29, 20, color::Black));
+    dc.draw(FilledCircle::ByRadius(20, 10, 8, color::Black));
+  }
+  // Only the tiles touched by the drawing need to be recomputed.
+  tiled.update(Box(4, 2, 29, 20));
+  for (bool inverted : {false, true}) {
+    tiled.setInverted(inverted);
+    plain.setInverted(inverted);
+    FakeOffscreen<Rgb565> expected(40, 30, color::Black);
+    FakeOffscreen<Rgb565> actual(40, 30, color::Black);
+    for (auto* screen : {&expected, &actual}) {
+      Display display(*screen);
+      DrawingContext dc(display);
+      dc.setClipMask(screen == &expected ? &plain : &tiled);
+      dc.draw(FilledRect(0, 0, 39, 29, color::White));
+      dc.draw(MakeTestStreamable(WhiteOnBlack(), Box(0, 0, 5, 1),
+                                 "* * * "
+                                 " * * *"),
+              9, 11);
+    }
+    EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+  }
+}
+
 TEST(ClipMask, ClipMaskWrite) {
   FakeOffscreen<Rgb565> test_screen(16, 7);
   Display display(test_screen);
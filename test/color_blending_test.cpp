@@ -1,4 +1,5 @@
 #include <cmath>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "roo_display/color/blending.h"
@@ -280,4 +281,96 @@ TEST(Color, BlendTransparentDstMatchesBlendWithZeroAlphaOpaqueSrc) {
   }
 }
 
-}  // namespace roo_display
\ No newline at end of file
+TEST(Color, SourceOverOpaqueSwarMatchesScalarExhaustive) {
+  BlendOp<BlendingMode::kSourceOverOpaque> op;
+  for (int a = 0; a < 256; ++a) {
+    for (int cs = 0; cs < 256; ++cs) {
+      for (int cd = 0; cd < 256; cd += 3) {
+        Color src(a, cs, (uint8_t)(255 - cs), (uint8_t)(cs ^ 0x5A));
+        Color dst(255, cd, (uint8_t)(cd ^ 0xA5), (uint8_t)(255 - cd));
+        ASSERT_EQ(op.blend(dst, src).asArgb(),
+                  internal::SourceOverOpaqueSwar(dst.asArgb(), src.asArgb()))
+            << dst << ", " << src;
+      }
+    }
+  }
+}
+
+namespace {
+
+std::vector<Color> TestPixels(uint32_t seed, int count) {
+  std::vector<Color> result;
+  for (int i = 0; i < count; ++i) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t argb = seed;
+    // Over-represent fully opaque and fully transparent pixels.
+    switch ((seed >> 16) % 4) {
+      case 0:
+        argb |= 0xFF000000;
+        break;
+      case 1:
+        argb &= 0x00FFFFFF;
+        break;
+      default:
+        break;
+    }
+    result.push_back(Color(argb));
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(Color, AlphaBlendSpanMatchesScalar) {
+  std::vector<Color> src = TestPixels(1, 1000);
+  std::vector<Color> dst = TestPixels(2, 1000);
+  std::vector<Color> actual = dst;
+  AlphaBlendSpan(&actual[0], &src[0], 1000);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(AlphaBlend(dst[i], src[i]), actual[i]) << dst[i] << ", " << src[i];
+  }
+}
+
+TEST(Color, AlphaBlendSpanOverOpaqueMatchesScalar) {
+  std::vector<Color> src = TestPixels(3, 1000);
+  std::vector<Color> dst = TestPixels(4, 1000);
+  for (Color& c : dst) c = c.toOpaque();
+  std::vector<Color> actual = dst;
+  AlphaBlendSpanOverOpaque(&actual[0], &src[0], 1000);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(AlphaBlendOverOpaque(dst[i], src[i]), actual[i])
+        << dst[i] << ", " << src[i];
+  }
+}
+
+TEST(Color, AlphaBlendSpanSingleSourceMatchesScalar) {
+  std::vector<Color> dst = TestPixels(5, 200);
+  for (Color src : TestPixels(6, 50)) {
+    std::vector<Color> actual = dst;
+    AlphaBlendSpan(&actual[0], src, 200);
+    for (int i = 0; i < 200; ++i) {
+      EXPECT_EQ(AlphaBlend(dst[i], src), actual[i]) << dst[i] << ", " << src;
+    }
+    std::vector<Color> opaque = dst;
+    for (Color& c : opaque) c = c.toOpaque();
+    actual = opaque;
+    AlphaBlendSpanOverOpaque(&actual[0], src, 200);
+    for (int i = 0; i < 200; ++i) {
+      EXPECT_EQ(AlphaBlendOverOpaque(opaque[i], src), actual[i])
+          << opaque[i] << ", " << src;
+    }
+  }
+}
+
+TEST(Color, AlphaBlendSpanOverBackgroundMatchesScalar) {
+  std::vector<Color> src = TestPixels(7, 200);
+  for (Color bg : TestPixels(8, 50)) {
+    std::vector<Color> actual = src;
+    AlphaBlendSpanOverBackground(bg, &actual[0], 200);
+    for (int i = 0; i < 200; ++i) {
+      EXPECT_EQ(AlphaBlend(bg, src[i]), actual[i]) << bg << ", " << src[i];
+    }
+  }
+}
+
+}  // namespace roo_display
@@ -0,0 +1,93 @@
+#include "roo_display/filter/counting_output.h"
+
+#include "gtest/gtest.h"
+#include "roo_display.h"
+#include "roo_display/color/color.h"
+#include "roo_display/shape/basic.h"
+#include "testing.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+namespace {
+
+void Draw(DisplayOutput& output, const Box& clip_box, const Drawable& object) {
+  output.begin();
+  Surface s(output, 0, 0, clip_box, false, color::Transparent,
+            FillMode::kVisible, BlendingMode::kSourceOver);
+  s.drawObject(object);
+  output.end();
+}
+
+}  // namespace
+
+TEST(CountingOutput, CountsAddressWindowsAndWrites) {
+  FakeOffscreen<Rgb565> screen(10, 10, color::Black);
+  CountingOutput counting(screen);
+  counting.setAddress(0, 0, 3, 1, BlendingMode::kSource);
+  Color colors[8];
+  FillColor(colors, 8, color::White);
+  counting.write(colors, 8);
+  EXPECT_EQ(1u, counting.counters().set_address_calls);
+  EXPECT_EQ(1u, counting.counters().write_calls);
+  EXPECT_EQ(1u, counting.counters().address_windows);
+  EXPECT_EQ(8u, counting.counters().pixels);
+  EXPECT_EQ(11u + 8 * 2, counting.counters().bus_bytes);
+  // The writes reach the underlying device.
+  EXPECT_THAT(screen, MatchesContent(WhiteOnBlack(), 10, 10,
+                                     "****      "
+                                     "****      "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "          "));
+}
+
+TEST(CountingOutput, CountsRects) {
+  FakeOffscreen<Rgb565> screen(10, 10, color::Black);
+  CountingOutput counting(screen, 0);
+  Draw(counting, Box(0, 0, 9, 9), FilledRect(1, 1, 4, 2, color::White));
+  EXPECT_EQ(1u, counting.counters().fill_rects_calls);
+  EXPECT_EQ(1u, counting.counters().address_windows);
+  EXPECT_EQ(8u, counting.counters().pixels);
+  EXPECT_EQ(16u, counting.counters().bus_bytes);
+  EXPECT_THAT(screen, MatchesContent(WhiteOnBlack(), 10, 10,
+                                     "          "
+                                     " ****     "
+                                     " ****     "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "          "));
+}
+
+TEST(CountingOutput, IndividualPixelsEachCostAnAddressWindow) {
+  FakeOffscreen<Rgb565> screen(10, 10, color::Black);
+  CountingOutput counting(screen, 10);
+  int16_t x[] = {1, 2, 3};
+  int16_t y[] = {1, 1, 1};
+  counting.fillPixels(BlendingMode::kSource, color::White, x, y, 3);
+  EXPECT_EQ(1u, counting.counters().fill_pixels_calls);
+  EXPECT_EQ(3u, counting.counters().address_windows);
+  EXPECT_EQ(3u, counting.counters().pixels);
+  EXPECT_EQ(3u * (10 + 2), counting.counters().bus_bytes);
+}
+
+TEST(CountingOutput, Reset) {
+  FakeOffscreen<Rgb565> screen(10, 10, color::Black);
+  CountingOutput counting(screen);
+  counting.fillRect(BlendingMode::kSource, Box(0, 0, 1, 1), color::White);
+  counting.reset();
+  EXPECT_EQ(0u, counting.counters().fill_rects_calls);
+  EXPECT_EQ(0u, counting.counters().bus_bytes);
+}
+
+}  // namespace roo_display
@@ -0,0 +1,289 @@
+#include "roo_display/filter/diffing_framebuffer_device.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_display.h"
+#include "roo_display/color/color.h"
+#include "testing.h"
+#include "testing_display_device.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+// Test device: Wraps FakeOffscreen with DiffingFramebufferDevice.
+class DiffedDevice : public DisplayDevice {
+ public:
+  DiffedDevice(int16_t width, int16_t height,
+               Color prefilled = color::Transparent)
+      : DisplayDevice(width, height),
+        prefilled_(prefilled),
+        device_(width, height, prefilled),
+        diffing_(device_) {
+    diffing_.setPrefilled(prefilled);
+  }
+
+  void orientationUpdated() override {
+    diffing_.setOrientation(orientation());
+    // The orientation change invalidates the shadow, but in these tests, the
+    // content hasn't been touched yet.
+    diffing_.setPrefilled(prefilled_);
+  }
+
+  void setBgColorHint(Color bgcolor) override {
+    diffing_.setBgColorHint(bgcolor);
+  }
+
+  void begin() override { diffing_.begin(); }
+
+  void end() override { diffing_.end(); }
+
+  void setAddress(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                  BlendingMode mode) override {
+    diffing_.setAddress(x0, y0, x1, y1, mode);
+  }
+
+  void write(Color* color, uint32_t pixel_count) override {
+    diffing_.write(color, pixel_count);
+    diffing_.flush();
+  }
+
+  void fill(Color color, uint32_t pixel_count) override {
+    diffing_.fill(color, pixel_count);
+    diffing_.flush();
+  }
+
+  void writePixels(BlendingMode mode, Color* color, int16_t* x, int16_t* y,
+                   uint16_t pixel_count) override {
+    diffing_.writePixels(mode, color, x, y, pixel_count);
+  }
+
+  void fillPixels(BlendingMode mode, Color color, int16_t* x, int16_t* y,
+                  uint16_t pixel_count) override {
+    diffing_.fillPixels(mode, color, x, y, pixel_count);
+  }
+
+  void writeRects(BlendingMode mode, Color* color, int16_t* x0, int16_t* y0,
+                  int16_t* x1, int16_t* y1, uint16_t count) override {
+    diffing_.writeRects(mode, color, x0, y0, x1, y1, count);
+    diffing_.flush();
+  }
+
+  void fillRects(BlendingMode mode, Color color, int16_t* x0, int16_t* y0,
+                 int16_t* x1, int16_t* y1, uint16_t count) override {
+    diffing_.fillRects(mode, color, x0, y0, x1, y1, count);
+    diffing_.flush();
+  }
+
+  void drawDirectRect(const roo::byte* data, size_t row_width_bytes,
+                      int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                      int16_t src_y1, int16_t dst_x0, int16_t dst_y0) override {
+    diffing_.drawDirectRect(data, row_width_bytes, src_x0, src_y0, src_x1,
+                            src_y1, dst_x0, dst_y0);
+    diffing_.flush();
+  }
+
+  void blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1, int16_t src_y1,
+                int16_t dst_x0, int16_t dst_y0) override {
+    diffing_.blitCopy(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+  }
+
+  const ColorFormat& getColorFormat() const override {
+    return diffing_.getColorFormat();
+  }
+
+  const Capabilities& getCapabilities() const override {
+    return diffing_.getCapabilities();
+  }
+
+  const FakeOffscreen<Rgb565>& device() const { return device_; }
+  FakeOffscreen<Rgb565>& device() { return device_; }
+  DiffingFramebufferDevice& diffing() { return diffing_; }
+
+ private:
+  Color prefilled_;
+  FakeOffscreen<Rgb565> device_;
+  DiffingFramebufferDevice diffing_;
+};
+
+TestColorStreamable<Rgb565> RasterOf(const DiffedDevice& device) {
+  return RasterOf(device.device());
+}
+
+using RefDevice = FakeOffscreen<Rgb565>;
+
+class DiffingFramebufferDeviceTest
+    : public testing::TestWithParam<std::tuple<BlendingMode, Orientation>> {};
+
+TEST_P(DiffingFramebufferDeviceTest, SimpleTests) {
+  BlendingMode mode = std::get<0>(GetParam());
+  Orientation orientation = std::get<1>(GetParam());
+  TestFillRects<DiffedDevice, RefDevice>(mode, orientation);
+  TestFillHLines<DiffedDevice, RefDevice>(mode, orientation);
+  TestFillVLines<DiffedDevice, RefDevice>(mode, orientation);
+  TestFillDegeneratePixels<DiffedDevice, RefDevice>(mode, orientation);
+  TestFillPixels<DiffedDevice, RefDevice>(mode, orientation);
+  TestWriteRects<DiffedDevice, RefDevice>(mode, orientation);
+  TestWriteHLines<DiffedDevice, RefDevice>(mode, orientation);
+  TestWriteVLines<DiffedDevice, RefDevice>(mode, orientation);
+  TestWriteDegeneratePixels<DiffedDevice, RefDevice>(mode, orientation);
+  TestWritePixels<DiffedDevice, RefDevice>(mode, orientation);
+  TestWritePixelsSnake<DiffedDevice, RefDevice>(mode, orientation);
+  TestWriteRectWindowSimple<DiffedDevice, RefDevice>(mode, orientation);
+  TestDrawDirectRect<DiffedDevice, RefDevice>(mode, orientation);
+}
+
+TEST_P(DiffingFramebufferDeviceTest, StressTests) {
+  BlendingMode mode = std::get<0>(GetParam());
+  Orientation orientation = std::get<1>(GetParam());
+  TestWritePixelsStress<DiffedDevice, RefDevice>(mode, orientation);
+  TestWriteRectWindowStress<DiffedDevice, RefDevice>(mode, orientation);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DiffingFramebufferDeviceTests, DiffingFramebufferDeviceTest,
+    testing::Combine(testing::Values(BlendingMode::kSource,
+                                     BlendingMode::kSourceOver),
+                     testing::Values(Orientation::RightDown(),
+                                     Orientation::DownLeft())));
+
+TEST(DiffingFramebufferDevice, RedundantFillIsSuppressed) {
+  DiffedDevice screen(20, 10, color::Black);
+  int16_t x0 = 2, y0 = 1, x1 = 15, y1 = 8;
+  screen.fillRects(BlendingMode::kSource, color::Red, &x0, &y0, &x1, &y1, 1);
+  EXPECT_EQ(14 * 8, screen.device().pixelDrawCount());
+  screen.device().resetPixelDrawCount();
+  screen.fillRects(BlendingMode::kSource, color::Red, &x0, &y0, &x1, &y1, 1);
+  EXPECT_EQ(0, screen.device().pixelDrawCount());
+  // Overlapping rect: only the new part gets sent.
+  x0 = 10;
+  x1 = 19;
+  screen.fillRects(BlendingMode::kSource, color::Red, &x0, &y0, &x1, &y1, 1);
+  EXPECT_EQ(4 * 8, screen.device().pixelDrawCount());
+}
+
+TEST(DiffingFramebufferDevice, OnlyChangedRunsAreForwarded) {
+  DiffedDevice screen(20, 3, color::Black);
+  Color row[20];
+  for (int i = 0; i < 20; ++i) row[i] = Color(0xFF000000 | (i * 0x0A0A0A));
+  screen.setAddress(0, 1, 19, 1, BlendingMode::kSource);
+  screen.write(row, 20);
+  // Pixel 0 is black, so it does not change.
+  EXPECT_EQ(19, screen.device().pixelDrawCount());
+  screen.device().resetPixelDrawCount();
+
+  // Redraw with two changes close to each other; they get coalesced along
+  // with the unchanged pixels in between.
+  row[3] = color::White;
+  row[6] = color::White;
+  screen.setAddress(0, 1, 19, 1, BlendingMode::kSource);
+  screen.write(row, 20);
+  EXPECT_EQ(4, screen.device().pixelDrawCount());
+  screen.device().resetPixelDrawCount();
+
+  // Changes far apart get sent separately.
+  row[3] = color::Red;
+  row[18] = color::Red;
+  screen.setAddress(0, 1, 19, 1, BlendingMode::kSource);
+  screen.write(row, 20);
+  EXPECT_EQ(2, screen.device().pixelDrawCount());
+}
+
+TEST(DiffingFramebufferDevice, UnknownPixelsAreForwarded) {
+  DiffedDevice screen(8, 8, color::Black);
+  screen.diffing().invalidateRect(Box(0, 0, 3, 7));
+  int16_t x0 = 0, y0 = 0, x1 = 7, y1 = 7;
+  screen.fillRects(BlendingMode::kSource, color::Black, &x0, &y0, &x1, &y1, 1);
+  EXPECT_EQ(4 * 8, screen.device().pixelDrawCount());
+  screen.device().resetPixelDrawCount();
+  screen.fillRects(BlendingMode::kSource, color::Black, &x0, &y0, &x1, &y1, 1);
+  EXPECT_EQ(0, screen.device().pixelDrawCount());
+}
+
+TEST(DiffingFramebufferDevice, BlendsAgainstShadow) {
+  DiffedDevice screen(4, 1, color::White);
+  int16_t x0 = 0, y0 = 0, x1 = 3, y1 = 0;
+  screen.fillRects(BlendingMode::kSourceOver, Color(0x80000000), &x0, &y0,
+                   &x1, &y1, 1);
+  EXPECT_THAT(screen.device(),
+              MatchesContent(Rgb565(), 4, 1, "TUT TUT TUT TUT"));
+}
+
+TEST(DiffingFramebufferDevice, BlitCopyUpdatesShadow) {
+  DiffedDevice screen(10, 4, color::Black);
+  int16_t x0 = 0, y0 = 0, x1 = 3, y1 = 1;
+  screen.fillRects(BlendingMode::kSource, color::Red, &x0, &y0, &x1, &y1, 1);
+  screen.blitCopy(0, 0, 3, 1, 5, 2);
+  screen.device().resetPixelDrawCount();
+  x0 = 5;
+  y0 = 2;
+  x1 = 8;
+  y1 = 3;
+  screen.fillRects(BlendingMode::kSource, color::Red, &x0, &y0, &x1, &y1, 1);
+  EXPECT_EQ(0, screen.device().pixelDrawCount());
+}
+
+// Records the transfers forwarded by DiffingFramebufferDevice.
+class RecordingDevice : public FakeOffscreen<Rgb565> {
+ public:
+  RecordingDevice(int16_t width, int16_t height, Color background)
+      : FakeOffscreen<Rgb565>(width, height, background) {}
+
+  void setAddress(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                  BlendingMode mode) override {
+    windows.push_back(Box(x0, y0, x1, y1));
+    FakeOffscreen<Rgb565>::setAddress(x0, y0, x1, y1, mode);
+  }
+
+  void fillRects(BlendingMode mode, Color color, int16_t* x0, int16_t* y0,
+                 int16_t* x1, int16_t* y1, uint16_t count) override {
+    for (uint16_t i = 0; i < count; ++i) {
+      fills.push_back(Box(x0[i], y0[i], x1[i], y1[i]));
+    }
+    FakeOffscreen<Rgb565>::fillRects(mode, color, x0, y0, x1, y1, count);
+  }
+
+  std::vector<Box> windows;
+  std::vector<Box> fills;
+};
+
+TEST(DiffingFramebufferDevice, CoalescesWritesBeforeFlush) {
+  RecordingDevice device(20, 10, color::Black);
+  DiffingFramebufferDevice diffing(device);
+  diffing.setPrefilled(color::Black);
+  RefDevice ref(20, 10, color::Black);
+  auto fill = [&](Color color, int16_t x0, int16_t y0, int16_t x1,
+                  int16_t y1) {
+    diffing.fillRects(BlendingMode::kSource, color, &x0, &y0, &x1, &y1, 1);
+    ref.fillRects(BlendingMode::kSource, color, &x0, &y0, &x1, &y1, 1);
+  };
+  Color row[20];
+  for (int i = 0; i < 20; ++i) row[i] = (i % 2 == 0) ? color::Red : color::Blue;
+
+  // Two vertically adjacent rects; they merge into one.
+  fill(color::Red, 2, 0, 9, 3);
+  fill(color::Red, 2, 4, 9, 5);
+  // Overlapping rect; only the part that is new gets forwarded.
+  fill(color::Red, 5, 2, 12, 3);
+  // A row written in two chunks; they form a single run.
+  diffing.setAddress(0, 7, 19, 7, BlendingMode::kSource);
+  diffing.write(row, 8);
+  diffing.write(row + 8, 12);
+  ref.setAddress(0, 7, 19, 7, BlendingMode::kSource);
+  ref.write(row, 20);
+  // Horizontally adjacent fills; they form a single run.
+  fill(color::Green, 0, 9, 3, 9);
+  fill(color::Green, 4, 9, 9, 9);
+  // The last run is still pending.
+  EXPECT_EQ(2u, device.fills.size());
+  diffing.flush();
+
+  EXPECT_THAT(device.fills,
+              ElementsAre(Box(2, 0, 9, 5), Box(10, 2, 12, 3), Box(0, 9, 9, 9)));
+  EXPECT_THAT(device.windows, ElementsAre(Box(0, 7, 19, 7)));
+  EXPECT_EQ(8 * 6 + 3 * 2 + 20 + 10, device.pixelDrawCount());
+  EXPECT_THAT(RasterOf(device), MatchesContent(RasterOf(ref)));
+}
+
+}  // namespace roo_display
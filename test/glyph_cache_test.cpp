@@ -0,0 +1,201 @@
+
+#include "roo_display/font/glyph_cache.h"
+
+#include "roo_display.h"
+#include "roo_display/color/color.h"
+#include "roo_display/font/smooth_font_v2.h"
+#include "roo_fonts/NotoSerif_Italic/12.h"
+#include "testing_drawable.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+namespace {
+
+const Font& font() { return font_NotoSerif_Italic_12(); }
+
+class Label : public Drawable {
+ public:
+  Label(const string& label) : label_(label) {}
+
+ private:
+  void drawTo(const Surface& s) const override {
+    font().drawHorizontalString(s, label_, color::White);
+  }
+
+  Box extents() const override {
+    return font().getHorizontalStringMetrics(label_).screen_extents();
+  }
+
+  std::string label_;
+};
+
+// Enables the glyph cache for the duration of the scope.
+class ScopedGlyphCache {
+ public:
+  ScopedGlyphCache(GlyphCache& cache) { SmoothFontV2::SetGlyphCache(&cache); }
+  ~ScopedGlyphCache() { SmoothFontV2::SetGlyphCache(nullptr); }
+};
+
+const int kKey1 = 1;
+const int kKey2 = 2;
+const int kKey3 = 3;
+
+}  // namespace
+
+TEST(GlyphCache, MissThenHit) {
+  GlyphCache cache(100);
+  EXPECT_EQ(nullptr, cache.get(&kKey1));
+  roo::byte* data = cache.put(&kKey1, 10);
+  ASSERT_NE(nullptr, data);
+  data[0] = roo::byte{42};
+  const roo::byte* cached = cache.get(&kKey1);
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(roo::byte{42}, cached[0]);
+  EXPECT_EQ(1u, cache.stats().hits);
+  EXPECT_EQ(1u, cache.stats().misses);
+  EXPECT_EQ(10u, cache.size_bytes());
+  EXPECT_EQ(1, cache.entry_count());
+}
+
+TEST(GlyphCache, EvictsLeastRecentlyUsedWhenOverBudget) {
+  GlyphCache cache(25);
+  cache.put(&kKey1, 10);
+  cache.put(&kKey2, 10);
+  // Touch key1, so that key2 becomes the least recently used.
+  EXPECT_NE(nullptr, cache.get(&kKey1));
+  cache.put(&kKey3, 10);
+  EXPECT_EQ(1u, cache.stats().evictions);
+  EXPECT_NE(nullptr, cache.get(&kKey1));
+  EXPECT_EQ(nullptr, cache.get(&kKey2));
+  EXPECT_NE(nullptr, cache.get(&kKey3));
+  EXPECT_EQ(20u, cache.size_bytes());
+}
+
+TEST(GlyphCache, EvictsWhenOutOfEntries) {
+  GlyphCache cache(1000, 2);
+  cache.put(&kKey1, 1);
+  cache.put(&kKey2, 1);
+  cache.put(&kKey3, 1);
+  EXPECT_EQ(2, cache.entry_count());
+  EXPECT_EQ(nullptr, cache.get(&kKey1));
+}
+
+TEST(GlyphCache, RejectsOversizedEntries) {
+  GlyphCache cache(10);
+  cache.put(&kKey1, 5);
+  EXPECT_EQ(nullptr, cache.put(&kKey2, 11));
+  EXPECT_NE(nullptr, cache.get(&kKey1));
+}
+
+TEST(GlyphCache, Clear) {
+  GlyphCache cache(100);
+  cache.put(&kKey1, 10);
+  cache.putGlyphIndex(&kKey2, 'a', 5);
+  cache.clear();
+  EXPECT_EQ(0u, cache.size_bytes());
+  EXPECT_EQ(nullptr, cache.get(&kKey1));
+  int index;
+  EXPECT_FALSE(cache.getGlyphIndex(&kKey2, 'a', index));
+}
+
+TEST(GlyphCache, GlyphIndex) {
+  GlyphCache cache(100);
+  int index;
+  EXPECT_FALSE(cache.getGlyphIndex(&kKey1, 'a', index));
+  cache.putGlyphIndex(&kKey1, 'a', 5);
+  ASSERT_TRUE(cache.getGlyphIndex(&kKey1, 'a', index));
+  EXPECT_EQ(5, index);
+  EXPECT_FALSE(cache.getGlyphIndex(&kKey2, 'a', index));
+  EXPECT_EQ(1u, cache.stats().index_hits);
+  EXPECT_EQ(2u, cache.stats().index_misses);
+}
+
+TEST(GlyphCache, CachedTextRendersIdentically) {
+  GlyphCache cache(4096);
+  ScopedGlyphCache scoped(cache);
+  for (int i = 0; i < 2; ++i) {
+    FakeScreen<Argb4444> screen(26, 18, color::Black);
+    screen.Draw(Label("Aftp"), 2, 14);
+    EXPECT_THAT(screen, MatchesContent(Grayscale4(), 26, 18,
+                                       "                          "
+                                       "                          "
+                                       "                          "
+                                       "                          "
+                                       "            2BD8          "
+                                       "      5E    B63922        "
+                                       "      A*1   *1 2D1        "
+                                       "     74E3 2BEB3CEB6EC5BC  "
+                                       "    1A C6  6B  6B  6D4 E4 "
+                                       "    92 A8  98  98  9A  D5 "
+                                       "   3D99CA  C5  C5  C5  *3 "
+                                       "   B1  5D  *1  *1  E1 5D  "
+                                       "  58   4* 3E  1*  2E 1D5  "
+                                       " 7*E4 4E*B6B   BC65DCC6   "
+                                       "          A7      97      "
+                                       "         1E2      C5      "
+                                       "        7C6       EE2     "
+                                       "                          "));
+  }
+  EXPECT_GT(cache.stats().hits, 0u);
+  EXPECT_GT(cache.stats().index_hits, 0u);
+}
+
+TEST(GlyphCache, CachedTextWithBackgroundRendersIdentically) {
+  GlyphCache cache(4096);
+  ScopedGlyphCache scoped(cache);
+  for (int i = 0; i < 2; ++i) {
+    FakeScreen<Argb4444> screen(26, 18, Color(0xFF111111));
+    screen.Draw(Label("Aftp"), 2, 14, color::Black, FillMode::kExtents);
+    EXPECT_THAT(screen, MatchesContent(Grayscale4(), 26, 18,
+                                       "11111111111111111111111111"
+                                       "11111111111111111111111111"
+                                       "11111111111111111111111111"
+                                       "11111111111111111111111111"
+                                       "1           2BD8         1"
+                                       "1     5E    B63922       1"
+                                       "1     A*1   *1 2D1       1"
+                                       "1    74E3 2BEB3CEB6EC5BC 1"
+                                       "1   1A C6  6B  6B  6D4 E41"
+                                       "1   92 A8  98  98  9A  D51"
+                                       "1  3D99CA  C5  C5  C5  *31"
+                                       "1  B1  5D  *1  *1  E1 5D 1"
+                                       "1 58   4* 3E  1*  2E 1D5 1"
+                                       "17*E4 4E*B6B   BC65DCC6  1"
+                                       "1         A7      97     1"
+                                       "1        1E2      C5     1"
+                                       "1       7C6       EE2    1"
+                                       "11111111111111111111111111"));
+  }
+  EXPECT_GT(cache.stats().hits, 0u);
+}
+
+TEST(GlyphCache, KernedPairsWithSingleEntryCache) {
+  // In the italic font, 'f' overlaps its neighbors, so that the pairs get
+  // drawn together. The cache has room for one glyph only, so decoding the
+  // right glyph of a pair evicts the left one.
+  Label label("ffjAVf");
+  FakeOffscreen<Argb4444> expected(48, 18, color::Black);
+  {
+    Display display(expected);
+    DrawingContext dc(display);
+    dc.setBackgroundColor(Color(0xFF111111));
+    dc.setFillMode(FillMode::kExtents);
+    dc.draw(label, 2, 14);
+  }
+  GlyphCache cache(4096, 1);
+  ScopedGlyphCache scoped(cache);
+  FakeOffscreen<Argb4444> actual(48, 18, color::Black);
+  {
+    Display display(actual);
+    DrawingContext dc(display);
+    dc.setBackgroundColor(Color(0xFF111111));
+    dc.setFillMode(FillMode::kExtents);
+    dc.draw(label, 2, 14);
+  }
+  EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+  EXPECT_GT(cache.stats().evictions, 0u);
+}
+
+}  // namespace roo_display
@@ -0,0 +1,197 @@
+#include "roo_display/color/gradient.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_display/color/color.h"
+
+namespace roo_display {
+
+namespace {
+
+// Returns the maximum absolute difference between the channels of a and b.
+int ChannelDiff(Color a, Color b) {
+  return std::max(std::max(std::abs(a.a() - b.a()), std::abs(a.r() - b.r())),
+                  std::max(std::abs(a.g() - b.g()), std::abs(a.b() - b.b())));
+}
+
+ColorGradient ThreeColors(ColorGradient::Boundary boundary,
+                          uint16_t lut_size) {
+  return ColorGradient(
+      {{10, color::Black}, {110, color::Red}, {210, color::Blue}}, boundary,
+      lut_size);
+}
+
+const ColorGradient::Boundary kBoundaries[] = {
+    ColorGradient::Boundary::kExtended, ColorGradient::Boundary::kTruncated,
+    ColorGradient::Boundary::kPeriodic};
+
+// Verifies that readColorRect() returns the same colors as readColors(), up
+// to the specified per-channel tolerance.
+void ExpectReadColorRectMatchesReadColors(const Rasterizable& r, Box box,
+                                          int tolerance) {
+  std::vector<Color> rect(box.area());
+  bool uniform =
+      r.readColorRect(box.xMin(), box.yMin(), box.xMax(), box.yMax(), &rect[0]);
+  std::vector<int16_t> x(box.area());
+  std::vector<int16_t> y(box.area());
+  std::vector<Color> colors(box.area());
+  size_t i = 0;
+  for (int16_t py = box.yMin(); py <= box.yMax(); ++py) {
+    for (int16_t px = box.xMin(); px <= box.xMax(); ++px) {
+      x[i] = px;
+      y[i] = py;
+      ++i;
+    }
+  }
+  r.readColors(&x[0], &y[0], box.area(), &colors[0]);
+  for (i = 0; i < colors.size(); ++i) {
+    Color actual = uniform ? rect[0] : rect[i];
+    ASSERT_LE(ChannelDiff(colors[i], actual), tolerance)
+        << "at (" << x[i] << ", " << y[i] << "), uniform: " << uniform;
+  }
+}
+
+}  // namespace
+
+TEST(ColorGradient, LookupWithoutLutIsExact) {
+  for (auto boundary : kBoundaries) {
+    ColorGradient gradient = ThreeColors(boundary, 0);
+    for (float v = -300; v < 500; v += 0.37f) {
+      EXPECT_EQ(gradient.getColor(v), gradient.lookupColor(v)) << v;
+    }
+  }
+}
+
+TEST(ColorGradient, LookupWithLutIsClose) {
+  for (auto boundary : kBoundaries) {
+    for (uint16_t lut_size : {256, 1024}) {
+      ColorGradient gradient = ThreeColors(boundary, lut_size);
+      for (float v = -300; v < 500; v += 0.37f) {
+        if (boundary == ColorGradient::Boundary::kPeriodic &&
+            std::abs(std::remainder(v - 10, 200)) < 1) {
+          // Close to the sharp transition between periods, which may shift
+          // by half an entry.
+          continue;
+        }
+        // Adjacent table entries differ by at most ~2 units per channel.
+        EXPECT_LE(ChannelDiff(gradient.getColor(v), gradient.lookupColor(v)),
+                  2)
+            << (int)boundary << ", " << lut_size << ", " << v;
+      }
+    }
+  }
+}
+
+TEST(ColorGradient, LookupWithLutKeepsBoundaries) {
+  ColorGradient gradient =
+      ThreeColors(ColorGradient::Boundary::kTruncated, 256);
+  EXPECT_EQ(color::Black, gradient.lookupColor(10));
+  EXPECT_EQ(color::Blue, gradient.lookupColor(210));
+  EXPECT_EQ(gradient.getColor(210.5f), gradient.lookupColor(210.5f));
+  EXPECT_EQ(color::Transparent, gradient.lookupColor(9));
+  EXPECT_EQ(color::Transparent, gradient.lookupColor(1000));
+}
+
+TEST(ColorGradient, LookupColorsMatchesLookupColor) {
+  for (auto boundary : kBoundaries) {
+    for (uint16_t lut_size : {0, 256}) {
+      ColorGradient gradient = ThreeColors(boundary, lut_size);
+      for (float step : {1.0f, -1.0f, 0.3f, -2.7f, 0.0f, 150.0f, 1000.0f}) {
+        Color result[320];
+        gradient.lookupColors(-50.5f, step, 320, result);
+        for (int i = 0; i < 320; ++i) {
+          // Fixed-point stepping may round to the neighboring entry.
+          EXPECT_LE(ChannelDiff(gradient.lookupColor(-50.5f + i * step),
+                                result[i]),
+                    2)
+              << (int)boundary << ", " << lut_size << ", " << step << ", " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(ColorGradient, UniformColor) {
+  ColorGradient extended = ThreeColors(ColorGradient::Boundary::kExtended, 0);
+  Color c;
+  EXPECT_TRUE(extended.getUniformColor(-100, 10, &c));
+  EXPECT_EQ(color::Black, c);
+  EXPECT_TRUE(extended.getUniformColor(210.5f, 1000, &c));
+  EXPECT_EQ(color::Blue, c);
+  EXPECT_FALSE(extended.getUniformColor(-100, 10.5f, &c));
+  EXPECT_FALSE(extended.getUniformColor(200, 1000, &c));
+
+  ColorGradient truncated =
+      ThreeColors(ColorGradient::Boundary::kTruncated, 0);
+  EXPECT_TRUE(truncated.getUniformColor(-100, 9, &c));
+  EXPECT_EQ(color::Transparent, c);
+  EXPECT_TRUE(truncated.getUniformColor(211, 1000, &c));
+  EXPECT_EQ(color::Transparent, c);
+  EXPECT_FALSE(truncated.getUniformColor(-100, 9.5f, &c));
+
+  ColorGradient periodic = ThreeColors(ColorGradient::Boundary::kPeriodic, 0);
+  EXPECT_FALSE(periodic.getUniformColor(-100, -90, &c));
+
+  // Flat interior region, with a sharp transition.
+  ColorGradient flat({{0, color::Black},
+                      {10, color::Red},
+                      {20, color::Red},
+                      {20, color::Blue},
+                      {30, color::White}});
+  EXPECT_TRUE(flat.getUniformColor(10.5f, 20, &c));
+  EXPECT_EQ(color::Red, c);
+  EXPECT_EQ(color::Red, flat.getColor(20));
+  EXPECT_FALSE(flat.getUniformColor(9.5f, 20, &c));
+  EXPECT_FALSE(flat.getUniformColor(10.5f, 20.5f, &c));
+}
+
+TEST(ColorGradient, ReadColorRectMatchesReadColors) {
+  for (auto boundary : kBoundaries) {
+    for (uint16_t lut_size : {0, 1024}) {
+      ColorGradient gradient = ThreeColors(boundary, lut_size);
+      LinearGradient horizontal({5, 0}, 1.5f, 0, gradient);
+      LinearGradient vertical({0, 5}, 0, 0.8f, gradient);
+      LinearGradient skewed({5, 5}, 0.7f, -1.3f, gradient);
+      RadialGradient radial({30.5f, 20.3f}, gradient);
+      AngularGradient angular({30.5f, 20.3f}, gradient);
+      ColorGradient squared({{100, color::Black},
+                             {1000, color::Red},
+                             {2000, color::Blue}},
+                            boundary, lut_size);
+      RadialGradientSq radial_sq({30, 20}, squared);
+      for (Box box : {Box(0, 0, 63, 47), Box(-200, -200, -150, -170),
+                      Box(25, 15, 35, 25), Box(200, 40, 220, 41)}) {
+        ExpectReadColorRectMatchesReadColors(horizontal, box, 2);
+        ExpectReadColorRectMatchesReadColors(vertical, box, 2);
+        ExpectReadColorRectMatchesReadColors(skewed, box, 2);
+        ExpectReadColorRectMatchesReadColors(radial, box, 0);
+        ExpectReadColorRectMatchesReadColors(angular, box, 0);
+        ExpectReadColorRectMatchesReadColors(radial_sq, box, 0);
+      }
+    }
+  }
+}
+
+TEST(ColorGradient, FlatRegionsAreUniform) {
+  ColorGradient gradient({{10, color::Red}, {20, color::Blue}},
+                         ColorGradient::Boundary::kExtended, 256);
+  RadialGradient radial({0, 0}, gradient);
+  Color c;
+  // Entirely within the inner disc, or entirely outside of the ring.
+  EXPECT_TRUE(radial.readUniformColorRect(-5, -5, 5, 5, &c));
+  EXPECT_EQ(color::Red, c);
+  EXPECT_TRUE(radial.readUniformColorRect(30, -5, 50, 5, &c));
+  EXPECT_EQ(color::Blue, c);
+  EXPECT_FALSE(radial.readUniformColorRect(0, 0, 15, 0, &c));
+
+  LinearGradient linear({0, 0}, 1, 0, gradient);
+  Color rect[40];
+  EXPECT_TRUE(linear.readColorRect(-20, 0, -11, 3, rect));
+  EXPECT_EQ(color::Red, rect[0]);
+  EXPECT_FALSE(linear.readColorRect(5, 0, 14, 3, rect));
+}
+
+}  // namespace roo_display
@@ -1,5 +1,7 @@
 #include "roo_display/image/image.h"
 
+#include <vector>
+
 #include "roo_display/color/color.h"
 #include "roo_display/color/color_modes.h"
 #include "roo_display/image/image_stream.h"
@@ -363,5 +365,185 @@ TEST(RleStream4bppxBiased, ReportsRunLengthOnlyForRunGroups) {
   }
 }
 
+TEST(RleStream4bppxBiased, ReadSpanReturnsRunsWithoutExpanding) {
+  // Run of 5 opaque pixels; 3 arbitrary values (3, 4, 5); run of 3
+  // transparent pixels.
+  uint8_t data[] = {0xD8, 0x13, 0x45, 0x30};
+  roo_io::MemoryIterable resource((const roo::byte*)data,
+                                  (const roo::byte*)(data + sizeof(data)));
+  Alpha4 color_mode(color::Black);
+  RleStream4bppxBiased<roo_io::MemoryIterable, Alpha4> stream(
+      resource.iterator(), color_mode);
+
+  Color buf[8];
+  bool is_run;
+  EXPECT_EQ(stream.readSpan(buf, 8, 100, is_run), 5u);
+  EXPECT_TRUE(is_run);
+  EXPECT_EQ(buf[0], color_mode.toArgbColor(0xF));
+
+  EXPECT_EQ(stream.readSpan(buf, 8, 100, is_run), 3u);
+  EXPECT_FALSE(is_run);
+  EXPECT_EQ(buf[0], color_mode.toArgbColor(0x3));
+  EXPECT_EQ(buf[1], color_mode.toArgbColor(0x4));
+  EXPECT_EQ(buf[2], color_mode.toArgbColor(0x5));
+
+  EXPECT_EQ(stream.readSpan(buf, 8, 2, is_run), 2u);
+  EXPECT_TRUE(is_run);
+  EXPECT_EQ(buf[0], color_mode.toArgbColor(0x0));
+  EXPECT_EQ(stream.readSpan(buf, 8, 100, is_run), 1u);
+  EXPECT_TRUE(is_run);
+}
+
+TEST(RleStreamUniform, ReadSpanAndSkip) {
+  // Run of 3 pixels 0x1234; 2 literal pixels 0x0001, 0x0002.
+  uint8_t data[] = {0x82, 0x12, 0x34, 0x01, 0x00, 0x01, 0x00, 0x02};
+  roo_io::MemoryIterable resource((const roo::byte*)data,
+                                  (const roo::byte*)(data + sizeof(data)));
+  Rgb565 color_mode;
+  {
+    RleStreamUniform<roo_io::MemoryIterable, Rgb565> stream(
+        resource.iterator(), color_mode);
+    Color buf[4];
+    bool is_run;
+    EXPECT_EQ(stream.readSpan(buf, 1, 100, is_run), 3u);
+    EXPECT_TRUE(is_run);
+    EXPECT_EQ(buf[0], color_mode.toArgbColor(0x1234));
+    EXPECT_EQ(stream.readSpan(buf, 1, 100, is_run), 1u);
+    EXPECT_FALSE(is_run);
+    EXPECT_EQ(buf[0], color_mode.toArgbColor(0x0001));
+    EXPECT_EQ(stream.readSpan(buf, 4, 100, is_run), 1u);
+    EXPECT_FALSE(is_run);
+    EXPECT_EQ(buf[0], color_mode.toArgbColor(0x0002));
+  }
+  {
+    RleStreamUniform<roo_io::MemoryIterable, Rgb565> stream(
+        resource.iterator(), color_mode);
+    stream.skip(4);
+    EXPECT_EQ(stream.next(), color_mode.toArgbColor(0x0002));
+  }
+}
+
+TEST(RleStreamUniform, ReadSpanReportsSubByteRunsOnlyForUniformPattern) {
+  // Run of 4 Alpha4 pixels with value 0x1; then run of 4 alternating pixels.
+  uint8_t data[] = {0x81, 0x11, 0x81, 0x12};
+  roo_io::MemoryIterable resource((const roo::byte*)data,
+                                  (const roo::byte*)(data + sizeof(data)));
+  Alpha4 color_mode(color::Black);
+  RleStreamUniform<roo_io::MemoryIterable, Alpha4> stream(resource.iterator(),
+                                                          color_mode);
+  Color buf[8];
+  bool is_run;
+  EXPECT_EQ(stream.readSpan(buf, 8, 100, is_run), 4u);
+  EXPECT_TRUE(is_run);
+  EXPECT_EQ(buf[0], color_mode.toArgbColor(0x1));
+  EXPECT_EQ(stream.readSpan(buf, 8, 100, is_run), 4u);
+  EXPECT_FALSE(is_run);
+  EXPECT_EQ(buf[0], color_mode.toArgbColor(0x1));
+  EXPECT_EQ(buf[1], color_mode.toArgbColor(0x2));
+  EXPECT_EQ(buf[2], color_mode.toArgbColor(0x1));
+  EXPECT_EQ(buf[3], color_mode.toArgbColor(0x2));
+}
+
+namespace {
+
+Color Rgb565WithAlpha(uint16_t rgb, uint8_t alpha) {
+  Color c = Rgb565().toArgbColor(rgb);
+  c.set_a(alpha);
+  return c;
+}
+
+// Mixes runs and literals, with all the alpha modes.
+const uint8_t kRgb565Alpha4Data[] = {
+    // Run of 5 opaque red pixels.
+    0xC5, 0xF8, 0x00,
+    // 4 literal pixels with distinct alpha.
+    0x02, 0x07, 0xE0, 0x3C, 0x00, 0x1F, 0xFF, 0xFF, 0xF0, 0xF8, 0x00,
+    // 2 blue pixels with distinct alpha.
+    0x81, 0x00, 0x1F, 0x5A,
+    // 3 literal pixels with uniform alpha 0x7; count in a varint.
+    0x27, 0x03, 0xF8, 0x00, 0x07, 0xE0, 0x00, 0x1F,
+    // Run of 20 transparent pixels; count in a varint.
+    0xF0, 0x14, 0xFF, 0xFF,
+    // 2 literal opaque pixels.
+    0x42, 0x07, 0xE0, 0xF8, 0x00};
+
+std::vector<Color> Rgb565Alpha4Expected() {
+  std::vector<Color> result;
+  for (int i = 0; i < 5; ++i) result.push_back(Rgb565WithAlpha(0xF800, 0xFF));
+  result.push_back(Rgb565WithAlpha(0x07E0, 0x33));
+  result.push_back(Rgb565WithAlpha(0x001F, 0xCC));
+  result.push_back(Rgb565WithAlpha(0xFFFF, 0xFF));
+  result.push_back(Rgb565WithAlpha(0xF800, 0x00));
+  result.push_back(Rgb565WithAlpha(0x001F, 0x55));
+  result.push_back(Rgb565WithAlpha(0x001F, 0xAA));
+  result.push_back(Rgb565WithAlpha(0xF800, 0x77));
+  result.push_back(Rgb565WithAlpha(0x07E0, 0x77));
+  result.push_back(Rgb565WithAlpha(0x001F, 0x77));
+  for (int i = 0; i < 20; ++i) result.push_back(Rgb565WithAlpha(0xFFFF, 0x00));
+  result.push_back(Rgb565WithAlpha(0x07E0, 0xFF));
+  result.push_back(Rgb565WithAlpha(0xF800, 0xFF));
+  return result;
+}
+
+}  // namespace
+
+TEST(RleStreamRgb565Alpha4, ReadSpan) {
+  roo_io::MemoryIterable resource(
+      (const roo::byte*)kRgb565Alpha4Data,
+      (const roo::byte*)(kRgb565Alpha4Data + sizeof(kRgb565Alpha4Data)));
+  std::vector<Color> expected = Rgb565Alpha4Expected();
+  // (buffer size, max count) combinations, splitting the groups in various
+  // places.
+  const uint16_t kLimits[][2] = {{1, 1}, {3, 2}, {2, 7}, {8, 100}};
+  for (const auto& limits : kLimits) {
+    RleStreamRgb565Alpha4<roo_io::MemoryIterable> stream(resource.iterator());
+    std::vector<Color> actual;
+    Color buf[8];
+    while (actual.size() < expected.size()) {
+      bool is_run;
+      uint32_t n = stream.readSpan(
+          buf, limits[0],
+          std::min<uint32_t>(limits[1], expected.size() - actual.size()),
+          is_run);
+      ASSERT_GT(n, 0u);
+      for (uint32_t i = 0; i < n; ++i) {
+        actual.push_back(is_run ? buf[0] : buf[i]);
+      }
+    }
+    EXPECT_EQ(expected, actual)
+        << "size: " << limits[0] << ", max_count: " << limits[1];
+  }
+  {
+    // The runs with uniform alpha are returned without expanding.
+    RleStreamRgb565Alpha4<roo_io::MemoryIterable> stream(resource.iterator());
+    Color buf[8];
+    bool is_run;
+    EXPECT_EQ(5u, stream.readSpan(buf, 8, 100, is_run));
+    EXPECT_TRUE(is_run);
+    EXPECT_EQ(expected[0], buf[0]);
+    stream.skip(6);
+    EXPECT_EQ(3u, stream.readSpan(buf, 8, 100, is_run));
+    EXPECT_FALSE(is_run);
+    EXPECT_EQ(20u, stream.readSpan(buf, 8, 100, is_run));
+    EXPECT_TRUE(is_run);
+    EXPECT_EQ(expected[14], buf[0]);
+  }
+}
+
+TEST(RleStreamRgb565Alpha4, Skip) {
+  roo_io::MemoryIterable resource(
+      (const roo::byte*)kRgb565Alpha4Data,
+      (const roo::byte*)(kRgb565Alpha4Data + sizeof(kRgb565Alpha4Data)));
+  std::vector<Color> expected = Rgb565Alpha4Expected();
+  for (size_t skipped = 0; skipped < expected.size(); ++skipped) {
+    RleStreamRgb565Alpha4<roo_io::MemoryIterable> stream(resource.iterator());
+    stream.skip(skipped);
+    for (size_t i = skipped; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i], stream.next())
+          << "skipped: " << skipped << ", pixel: " << i;
+    }
+  }
+}
+
 }  // namespace internal
 }  // namespace roo_display
@@ -5,6 +5,8 @@
 #include <string>
 
 #include "roo_display/color/color.h"
+#include "roo_display/composition/parallel_rasterizable.h"
+#include "roo_display/core/offscreen.h"
 #include "roo_display/core/streamable.h"
 #include "roo_io/fs/posix/posix_mount.h"
 #include "roo_io/memory/memory_resource.h"
@@ -114,6 +116,22 @@ void Draw(DisplayDevice& output, const Drawable& object,
   output.end();
 }
 
+void DrawClipped(DisplayDevice& output, const Drawable& object, int16_t dx,
+                 int16_t dy, Box clip_box, BlendingMode blending_mode) {
+  output.begin();
+  Surface s(output, dx, dy, clip_box, false, color::Transparent,
+            FillMode::kVisible, blending_mode);
+  s.drawObject(object);
+  output.end();
+}
+
+roo_io::MemoryResource<const roo::byte*> ColorBlocksResource() {
+  return roo_io::MemoryResource<const roo::byte*>(
+      reinterpret_cast<const roo::byte*>(kColorBlocks9x9Jpg),
+      reinterpret_cast<const roo::byte*>(kColorBlocks9x9Jpg) +
+          sizeof(kColorBlocks9x9Jpg));
+}
+
 }  // namespace
 
 TEST(Jpeg, ColorFile) {
@@ -215,4 +233,54 @@ TEST(Jpeg, ColorMemoryResource) {
                              "FF7E00FD FF007F7F FF01807F FF018080"));
 }
 
-}  // namespace roo_display
\ No newline at end of file
+TEST(Jpeg, WorkerPoolMatchesSingleThreaded) {
+  auto resource = ColorBlocksResource();
+  JpegDecoder decoder;
+  JpegImage image(decoder, resource);
+  RenderWorkerPool pool(2);
+  JpegDecoder pooled_decoder(&pool);
+  JpegImage pooled_image(pooled_decoder, resource);
+  // The resource is in memory, so the reads can overlap with the transfers.
+  JpegDecoder overlapping_decoder(&pool, false);
+  JpegImage overlapping_image(overlapping_decoder, resource);
+
+  for (BlendingMode mode : {BlendingMode::kSource, BlendingMode::kXor}) {
+    FakeOffscreen<Argb8888> expected(12, 12, color::Red);
+    DrawClipped(expected, image, 2, 1, Box(1, 0, 10, 10), mode);
+    FakeOffscreen<Argb8888> actual(12, 12, color::Red);
+    DrawClipped(actual, pooled_image, 2, 1, Box(1, 0, 10, 10), mode);
+    EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+    FakeOffscreen<Argb8888> overlapping(12, 12, color::Red);
+    DrawClipped(overlapping, overlapping_image, 2, 1, Box(1, 0, 10, 10), mode);
+    EXPECT_THAT(RasterOf(overlapping), MatchesContent(RasterOf(expected)));
+  }
+}
+
+TEST(Jpeg, DirectRgb565MatchesRaster) {
+  auto resource = ColorBlocksResource();
+  JpegDecoder decoder;
+  JpegImage image(decoder, resource);
+  // Decode via the regular (non-direct) path.
+  Offscreen<Argb8888> decoded(image.extents(), color::Transparent);
+  DrawClipped(decoded.output(), image, 0, 0, image.extents(),
+              BlendingMode::kSource);
+
+  RenderWorkerPool pool(1);
+  JpegDecoder pooled_decoder(&pool);
+  JpegImage pooled_image(pooled_decoder, resource);
+
+  for (Box clip_box : {Box(0, 0, 11, 11), Box(3, 2, 7, 9), Box(0, 9, 11, 11),
+                       Box(4, 0, 11, 4)}) {
+    FakeOffscreen<Rgb565> expected(12, 12, color::Black);
+    DrawClipped(expected, decoded, 1, 2, clip_box, BlendingMode::kSourceOver);
+    FakeOffscreen<Rgb565> actual(12, 12, color::Black);
+    DrawClipped(actual, image, 1, 2, clip_box, BlendingMode::kSourceOver);
+    EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+    FakeOffscreen<Rgb565> pooled(12, 12, color::Black);
+    DrawClipped(pooled, pooled_image, 1, 2, clip_box,
+                BlendingMode::kSourceOver);
+    EXPECT_THAT(RasterOf(pooled), MatchesContent(RasterOf(expected)));
+  }
+}
+
+}  // namespace roo_display
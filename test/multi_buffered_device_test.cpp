@@ -0,0 +1,202 @@
+#include "roo_display/core/multi_buffered_device.h"
+
+#include "gtest/gtest.h"
+#include "roo_display.h"
+#include "roo_display/color/color.h"
+#include "testing.h"
+#include "testing_display_device.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+using Buffered = MultiBufferedDevice<Rgb565>;
+
+// Test device: renders every operation as a separate frame, so that each
+// operation goes to a different buffer, and the results can only be correct
+// if the content gets properly carried forward across buffers.
+template <uint8_t buffer_count>
+class FramePerOpDevice : public DisplayDevice {
+ public:
+  FramePerOpDevice(int16_t width, int16_t height, Color bg)
+      : DisplayDevice(width, height), device_(width, height, buffer_count) {
+    // Before the first frame, drawing goes to the visible buffer.
+    device_.fillRect(0, 0, width - 1, height - 1, bg);
+  }
+
+  void orientationUpdated() override { device_.setOrientation(orientation()); }
+
+  void setAddress(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                  BlendingMode mode) override {
+    device_.beginFrame();
+    device_.setAddress(x0, y0, x1, y1, mode);
+  }
+
+  void write(Color* color, uint32_t pixel_count) override {
+    device_.write(color, pixel_count);
+    present();
+  }
+
+  void fill(Color color, uint32_t pixel_count) override {
+    device_.fill(color, pixel_count);
+    present();
+  }
+
+  void writePixels(BlendingMode mode, Color* color, int16_t* x, int16_t* y,
+                   uint16_t pixel_count) override {
+    device_.beginFrame();
+    device_.writePixels(mode, color, x, y, pixel_count);
+    present();
+  }
+
+  void fillPixels(BlendingMode mode, Color color, int16_t* x, int16_t* y,
+                  uint16_t pixel_count) override {
+    device_.beginFrame();
+    device_.fillPixels(mode, color, x, y, pixel_count);
+    present();
+  }
+
+  void writeRects(BlendingMode mode, Color* color, int16_t* x0, int16_t* y0,
+                  int16_t* x1, int16_t* y1, uint16_t count) override {
+    device_.beginFrame();
+    device_.writeRects(mode, color, x0, y0, x1, y1, count);
+    present();
+  }
+
+  void fillRects(BlendingMode mode, Color color, int16_t* x0, int16_t* y0,
+                 int16_t* x1, int16_t* y1, uint16_t count) override {
+    device_.beginFrame();
+    device_.fillRects(mode, color, x0, y0, x1, y1, count);
+    present();
+  }
+
+  void drawDirectRect(const roo::byte* data, size_t row_width_bytes,
+                      int16_t src_x0, int16_t src_y0, int16_t src_x1,
+                      int16_t src_y1, int16_t dst_x0, int16_t dst_y0) override {
+    device_.beginFrame();
+    device_.drawDirectRect(data, row_width_bytes, src_x0, src_y0, src_x1,
+                           src_y1, dst_x0, dst_y0);
+    present();
+  }
+
+  void blitCopy(int16_t src_x0, int16_t src_y0, int16_t src_x1, int16_t src_y1,
+                int16_t dst_x0, int16_t dst_y0) override {
+    device_.beginFrame();
+    device_.blitCopy(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0);
+    present();
+  }
+
+  const ColorFormat& getColorFormat() const override {
+    return device_.getColorFormat();
+  }
+
+  const Capabilities& getCapabilities() const override {
+    return device_.getCapabilities();
+  }
+
+  const Buffered& device() const { return device_; }
+
+ private:
+  void present() {
+    device_.presentFrame();
+    device_.awaitFrame();
+  }
+
+  Buffered device_;
+};
+
+template <uint8_t buffer_count>
+const ConstDramRaster<Rgb565> RasterOf(
+    const FramePerOpDevice<buffer_count>& device) {
+  return device.device().front().raster();
+}
+
+using RefDevice = FakeOffscreen<Rgb565, roo_io::kBigEndian>;
+
+template <uint8_t buffer_count>
+void RunConsistencyTests(BlendingMode mode, Orientation orientation) {
+  using Tested = FramePerOpDevice<buffer_count>;
+  TestFillRects<Tested, RefDevice>(mode, orientation);
+  TestFillHLines<Tested, RefDevice>(mode, orientation);
+  TestFillPixels<Tested, RefDevice>(mode, orientation);
+  TestWriteRects<Tested, RefDevice>(mode, orientation);
+  TestWriteVLines<Tested, RefDevice>(mode, orientation);
+  TestWritePixels<Tested, RefDevice>(mode, orientation);
+  TestWriteRectWindowSimple<Tested, RefDevice>(mode, orientation);
+  TestDrawDirectRect<Tested, RefDevice>(mode, orientation);
+  TestWritePixelsStress<Tested, RefDevice>(mode, orientation);
+  TestWriteRectWindowStress<Tested, RefDevice>(mode, orientation);
+}
+
+class MultiBufferedDeviceTest
+    : public testing::TestWithParam<std::tuple<BlendingMode, Orientation>> {};
+
+TEST_P(MultiBufferedDeviceTest, DoubleBuffered) {
+  RunConsistencyTests<2>(std::get<0>(GetParam()), std::get<1>(GetParam()));
+}
+
+TEST_P(MultiBufferedDeviceTest, TripleBuffered) {
+  RunConsistencyTests<3>(std::get<0>(GetParam()), std::get<1>(GetParam()));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    MultiBufferedDeviceTests, MultiBufferedDeviceTest,
+    testing::Combine(testing::Values(BlendingMode::kSource,
+                                     BlendingMode::kSourceOver),
+                     testing::Values(Orientation::RightDown(),
+                                     Orientation::DownLeft())));
+
+TEST(MultiBufferedDevice, DrawsToFrontBeforeFirstFrame) {
+  Buffered device(3, 1);
+  EXPECT_EQ(2, device.frameBufferCount());
+  device.fillRect(0, 0, 2, 0, color::White);
+  EXPECT_THAT(device.front().raster(),
+              MatchesContent(Rgb565(), 3, 1, "*** *** ***"));
+}
+
+TEST(MultiBufferedDevice, FrameShownOnlyWhenPresented) {
+  Buffered device(3, 1);
+  device.fillRect(0, 0, 2, 0, color::Black);
+  device.beginFrame();
+  device.fillRect(1, 0, 1, 0, color::White);
+  EXPECT_THAT(device.front().raster(),
+              MatchesContent(Rgb565(), 3, 1, "___ ___ ___"));
+  device.presentFrame();
+  device.awaitFrame();
+  EXPECT_THAT(device.front().raster(),
+              MatchesContent(Rgb565(), 3, 1, "___ *** ___"));
+}
+
+TEST(MultiBufferedDevice, ContentCarriedForward) {
+  Buffered device(4, 1);
+  device.fillRect(0, 0, 3, 0, color::Black);
+  device.beginFrame();
+  device.fillRect(0, 0, 0, 0, color::White);
+  device.presentFrame();
+  device.beginFrame();
+  // The back buffer has been brought up to date with the previous frame.
+  EXPECT_THAT(device.back().raster(),
+              MatchesContent(Rgb565(), 4, 1, "*** ___ ___ ___"));
+  device.fillRect(3, 0, 3, 0, color::White);
+  device.presentFrame();
+  device.awaitFrame();
+  EXPECT_THAT(device.front().raster(),
+              MatchesContent(Rgb565(), 4, 1, "*** ___ ___ ***"));
+}
+
+TEST(MultiBufferedDevice, BuffersCycle) {
+  Buffered device(1, 1, 3);
+  device.fillRect(0, 0, 0, 0, color::Black);
+  const roo::byte* buffers[4];
+  for (int i = 0; i < 4; ++i) {
+    device.beginFrame();
+    buffers[i] = device.back().raster().buffer();
+    device.presentFrame();
+  }
+  EXPECT_NE(buffers[0], buffers[1]);
+  EXPECT_NE(buffers[1], buffers[2]);
+  EXPECT_NE(buffers[2], buffers[0]);
+  EXPECT_EQ(buffers[0], buffers[3]);
+}
+
+}  // namespace roo_display
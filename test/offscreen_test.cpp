@@ -564,7 +564,7 @@ void TestWriter(ColorMode color_mode) {
 template <typename ColorMode>
 void TestWriter(ColorMode color_mode = ColorMode()) {
   TestWriter<ColorMode, ColorPixelOrder::kLsbFirst>(color_mode);
-  TestWriter<ColorMode, ColorPixelOrder::kLsbFirst>(color_mode);
+  TestWriter<ColorMode, ColorPixelOrder::kMsbFirst>(color_mode);
 }
 
 TEST(Writer, Grayscale4) { TestWriter<Grayscale4>(); }
@@ -629,7 +629,7 @@ void TestFiller(ColorMode color_mode = ColorMode()) {
 template <typename ColorMode>
 void TestFiller(ColorMode color_mode = ColorMode()) {
   TestFiller<ColorMode, ColorPixelOrder::kLsbFirst>(color_mode);
-  TestFiller<ColorMode, ColorPixelOrder::kLsbFirst>(color_mode);
+  TestFiller<ColorMode, ColorPixelOrder::kMsbFirst>(color_mode);
 }
 
 TEST(Filler, Grayscale4) { TestFiller<Grayscale4>(); }
@@ -839,6 +839,12 @@ TEST_P(OffscreenTest, WriteRectWindowStress) {
                                                     std::get<1>(GetParam()));
 }
 
+TEST_P(OffscreenTest, FillRectWindowStress) {
+  TestFillRectWindowStress<OffscreenDeviceForTest<Argb4444>,
+                           RefOffscreen<Argb4444>>(std::get<0>(GetParam()),
+                                                   std::get<1>(GetParam()));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     OffscreenTestsOrientations, OffscreenTest,
     testing::Combine(
@@ -1181,4 +1187,120 @@ TEST_F(OffscreenTest, BlitCopySubByteUnaligned) {
                                                  "    ACE "));
 }
 
+// ---------- copyFrom / scroll tests ----------
+
+TEST_F(OffscreenTest, CopyFromSubByteOddWidth) {
+  // Odd widths: rows are not byte-aligned.
+  Offscreen<Grayscale4> src(5, 2, color::Black);
+  DrawingContext dc(src);
+  dc.draw(SolidRect(0, 0, 4, 0, Color(0xFF444444)));
+  dc.draw(SolidRect(1, 1, 3, 1, Color(0xFF888888)));
+  Offscreen<Grayscale4> dst(5, 3, color::Black);
+  dst.copyFrom(src, Box(0, 0, 4, 1), 0, 1);
+  EXPECT_THAT(dst.raster(), MatchesContent(Grayscale4(), Box(0, 0, 4, 2),
+                                           "     "
+                                           "44444"
+                                           " 888 "));
+}
+
+TEST_F(OffscreenTest, CopyFromSubByteDifferentPhase) {
+  Offscreen<Grayscale4> src(5, 2, color::Black);
+  DrawingContext dc(src);
+  dc.draw(SolidRect(1, 0, 1, 0, Color(0xFF444444)));
+  dc.draw(SolidRect(2, 0, 2, 0, Color(0xFF666666)));
+  dc.draw(SolidRect(3, 1, 3, 1, Color(0xFFAAAAAA)));
+  Offscreen<Grayscale4> dst(6, 3, color::Black);
+  dst.copyFrom(src, Box(1, 0, 3, 1), 2, 1);
+  EXPECT_THAT(dst.raster(), MatchesContent(Grayscale4(), Box(0, 0, 5, 2),
+                                           "      "
+                                           "  46  "
+                                           "    A "));
+}
+
+TEST_F(OffscreenTest, CopyFromClipsToExtents) {
+  Offscreen<Argb4444> src(4, 4, color::Black);
+  DrawingContext dc(src);
+  dc.draw(SolidRect(0, 0, 3, 3, Color(0xFF888888)));
+  Offscreen<Argb4444> dst(Box(10, 10, 13, 13), color::Black);
+  // Only the bottom-right 2x2 corner of the destination is covered.
+  dst.copyFrom(src, Box(0, 0, 10, 10), 12, 12);
+  EXPECT_THAT(dst.raster(), MatchesContent(Grayscale4(), Box(10, 10, 13, 13),
+                                           "    "
+                                           "    "
+                                           "  88"
+                                           "  88"));
+}
+
+TEST_F(OffscreenTest, CopyFromHonorsDestinationOrientation) {
+  Offscreen<Grayscale4> src(3, 1, color::Black);
+  DrawingContext dc(src);
+  dc.draw(SolidRect(0, 0, 0, 0, Color(0xFF222222)));
+  dc.draw(SolidRect(1, 0, 1, 0, Color(0xFF444444)));
+  dc.draw(SolidRect(2, 0, 2, 0, Color(0xFF666666)));
+  Offscreen<Grayscale4> dst(5, 1, color::Black);
+  dst.output().setOrientation(Orientation::Default().flipHorizontally());
+  dst.output().copyRectFrom(src.output(), 0, 0, 2, 0, 0, 0);
+  EXPECT_THAT(dst.raster(),
+              MatchesContent(Grayscale4(), Box(0, 0, 4, 0), "  642"));
+}
+
+TEST_F(OffscreenTest, CopyFromAsync) {
+  Offscreen<Argb4444> src(4, 2, color::Black);
+  DrawingContext dc(src);
+  dc.draw(SolidRect(0, 0, 3, 0, Color(0xFF888888)));
+  dc.draw(SolidRect(0, 1, 3, 1, Color(0xFF444444)));
+  Offscreen<Argb4444> dst(4, 3, color::Black);
+  AsyncBlitToken token = dst.copyFromAsync(src, Box(0, 0, 3, 1), 0, 1);
+  async_blit_await(token);
+  EXPECT_TRUE(async_blit_done(token));
+  EXPECT_THAT(dst.raster(), MatchesContent(Grayscale4(), Box(0, 0, 3, 2),
+                                           "    "
+                                           "8888"
+                                           "4444"));
+}
+
+TEST_F(OffscreenTest, ScrollUp) {
+  Offscreen<Grayscale4> offscreen(3, 4, color::Black);
+  DrawingContext dc(offscreen);
+  dc.draw(SolidRect(0, 0, 2, 0, Color(0xFF222222)));
+  dc.draw(SolidRect(0, 1, 2, 1, Color(0xFF444444)));
+  dc.draw(SolidRect(0, 2, 2, 2, Color(0xFF666666)));
+  dc.draw(SolidRect(0, 3, 2, 3, Color(0xFF888888)));
+  EXPECT_TRUE(offscreen.scroll(Box(0, 0, 2, 3), 0, -1, Color(0xFFFFFFFF)));
+  EXPECT_THAT(offscreen.raster(), MatchesContent(Grayscale4(), Box(0, 0, 2, 3),
+                                                 "444"
+                                                 "666"
+                                                 "888"
+                                                 "FFF"));
+}
+
+TEST_F(OffscreenTest, ScrollDiagonalWithinSubRect) {
+  Offscreen<Grayscale4> offscreen(4, 4, color::Black);
+  DrawingContext dc(offscreen);
+  dc.draw(SolidRect(0, 0, 3, 3, Color(0xFF888888)));
+  dc.draw(SolidRect(1, 1, 1, 1, Color(0xFF444444)));
+  EXPECT_TRUE(offscreen.scroll(Box(1, 1, 3, 3), 1, 1, Color(0xFFFFFFFF)));
+  EXPECT_THAT(offscreen.raster(), MatchesContent(Grayscale4(), Box(0, 0, 3, 3),
+                                                 "8888"
+                                                 "8FFF"
+                                                 "8F48"
+                                                 "8F88"));
+}
+
+class NoBlitCopyOffscreen : public FakeOffscreen<Rgb565> {
+ public:
+  using FakeOffscreen<Rgb565>::FakeOffscreen;
+
+  const Capabilities& getCapabilities() const override {
+    static const Capabilities kCaps;
+    return kCaps;
+  }
+};
+
+TEST(DisplayOutput, ScrollRectRequiresBlitCopy) {
+  NoBlitCopyOffscreen output(4, 4, color::Black);
+  EXPECT_FALSE(output.scrollRect(Box(0, 0, 3, 3), 0, 1, color::White));
+  EXPECT_EQ(output.pixelDrawCount(), 0u);
+}
+
 }  // namespace roo_display
@@ -0,0 +1,103 @@
+#include "roo_display/composition/parallel_rasterizable.h"
+
+#include "roo_display/color/color.h"
+#include "roo_display/composition/rasterizable_stack.h"
+#include "testing.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+namespace {
+
+void Draw(DisplayDevice& output, int16_t x, int16_t y, const Box& clip_box,
+          const Drawable& object, FillMode fill_mode, Color bgcolor) {
+  output.begin();
+  Surface s(output, x, y, clip_box, false, bgcolor, fill_mode,
+            BlendingMode::kSourceOver);
+  s.drawObject(object);
+  output.end();
+}
+
+// Has uniform, transparent, and semi-transparent areas.
+Color Pattern(int16_t x, int16_t y) {
+  if (y < 10) return color::Red;
+  if (x < 12) return color::Transparent;
+  return Color((x * 7) & 0xFF, (y * 13) & 0xFF, (x * y) & 0xFF,
+               (x + y) & 0xFF);
+}
+
+// Draws the object directly and via ParallelRasterizable, and verifies that
+// the results are the same.
+void CheckSameAsSerial(const Rasterizable& object, RenderWorkerPool& pool,
+                       const Box& clip_box, FillMode fill_mode,
+                       Color bgcolor) {
+  FakeOffscreen<Argb8888> expected(70, 53, color::Navy);
+  FakeOffscreen<Argb8888> actual(70, 53, color::Navy);
+  Draw(expected, 3, 5, clip_box, object, fill_mode, bgcolor);
+  Draw(actual, 3, 5, clip_box, ParallelRasterizable(object, pool), fill_mode,
+       bgcolor);
+  EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+  EXPECT_EQ(expected.pixelDrawCount(), actual.pixelDrawCount());
+}
+
+void CheckAllModes(const Rasterizable& object, RenderWorkerPool& pool) {
+  for (FillMode fill_mode : {FillMode::kVisible, FillMode::kExtents}) {
+    for (Color bgcolor :
+         {color::Transparent, color::White, Color(0x80406080)}) {
+      CheckSameAsSerial(object, pool, Box(0, 0, 69, 52), fill_mode, bgcolor);
+      CheckSameAsSerial(object, pool, Box(5, 7, 60, 44), fill_mode, bgcolor);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(ParallelRasterizable, SameAsSerial) {
+  auto object =
+      MakeRasterizable(Box(0, 0, 61, 43), Pattern, TransparencyMode::kFull);
+  RenderWorkerPool pool(2);
+  CheckAllModes(object, pool);
+}
+
+TEST(ParallelRasterizable, OpaqueSameAsSerial) {
+  auto object = MakeRasterizable(
+      Box(0, 0, 61, 43),
+      [](int16_t x, int16_t y) { return Pattern(x, y).withA(0xFF); },
+      TransparencyMode::kNone);
+  RenderWorkerPool pool(1);
+  CheckAllModes(object, pool);
+}
+
+TEST(ParallelRasterizable, StackSameAsSerial) {
+  auto bottom = MakeRasterizable(
+      Box(0, 0, 61, 43),
+      [](int16_t x, int16_t y) { return Color(0xFF, x * 4, y * 5, 0); },
+      TransparencyMode::kNone);
+  auto top =
+      MakeRasterizable(Box(0, 0, 40, 30), Pattern, TransparencyMode::kFull);
+  RasterizableStack stack(Box(0, 0, 61, 43));
+  stack.addInput(&bottom);
+  stack.addInput(&top, 10, 6);
+  RenderWorkerPool pool(3);
+  CheckAllModes(stack, pool);
+}
+
+TEST(ParallelRasterizable, WithoutWorkers) {
+  auto object =
+      MakeRasterizable(Box(0, 0, 61, 43), Pattern, TransparencyMode::kFull);
+  RenderWorkerPool pool(0);
+  CheckAllModes(object, pool);
+}
+
+TEST(ParallelRasterizable, PoolIsReusable) {
+  auto object =
+      MakeRasterizable(Box(0, 0, 61, 43), Pattern, TransparencyMode::kFull);
+  RenderWorkerPool pool(2);
+  for (int i = 0; i < 20; ++i) {
+    CheckSameAsSerial(object, pool, Box(0, 0, 69, 52), FillMode::kVisible,
+                      color::Transparent);
+  }
+}
+
+}  // namespace roo_display
@@ -0,0 +1,171 @@
+
+#include "roo_display/composition/partial_refresh.h"
+
+#include "roo_display.h"
+#include "roo_display/color/color.h"
+#include "roo_display/composition/damage_tracker.h"
+#include "roo_display/shape/basic.h"
+#include "testing.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+TEST(DamageTracker, InitiallyClean) {
+  DamageTracker tracker(Box(0, 0, 99, 49), 4);
+  EXPECT_TRUE(tracker.empty());
+  EXPECT_EQ(7, tracker.tile_columns());
+  EXPECT_EQ(4, tracker.tile_rows());
+  std::vector<Box> regions;
+  tracker.getDirtyRegions(regions);
+  EXPECT_TRUE(regions.empty());
+}
+
+TEST(DamageTracker, SingleTile) {
+  DamageTracker tracker(Box(0, 0, 99, 49), 4);
+  tracker.invalidate(Box(20, 20, 21, 21));
+  EXPECT_EQ(1, tracker.dirtyTileCount());
+  std::vector<Box> regions;
+  tracker.getDirtyRegions(regions);
+  EXPECT_THAT(regions, ElementsAre(Box(16, 16, 31, 31)));
+}
+
+TEST(DamageTracker, ClippedToExtents) {
+  DamageTracker tracker(Box(0, 0, 99, 49), 4);
+  tracker.invalidate(Box(90, 40, 200, 200));
+  std::vector<Box> regions;
+  tracker.getDirtyRegions(regions);
+  EXPECT_THAT(regions, ElementsAre(Box(80, 32, 99, 49)));
+}
+
+TEST(DamageTracker, CoalescesVertically) {
+  DamageTracker tracker(Box(0, 0, 99, 49), 4);
+  tracker.invalidate(Box(0, 0, 20, 40));
+  EXPECT_EQ(6, tracker.dirtyTileCount());
+  std::vector<Box> regions;
+  tracker.getDirtyRegions(regions);
+  EXPECT_THAT(regions, ElementsAre(Box(0, 0, 31, 47)));
+}
+
+TEST(DamageTracker, OverlappingInvalidationsCountOnce) {
+  DamageTracker tracker(Box(0, 0, 99, 49), 4);
+  tracker.invalidate(Box(0, 0, 20, 20));
+  tracker.invalidate(Box(10, 10, 30, 30));
+  EXPECT_EQ(4, tracker.dirtyTileCount());
+}
+
+TEST(DamageTracker, DisjointRegions) {
+  DamageTracker tracker(Box(0, 0, 99, 49), 4);
+  tracker.invalidate(Box(0, 0, 5, 5));
+  tracker.invalidate(Box(70, 0, 75, 5));
+  tracker.invalidate(Box(0, 40, 5, 45));
+  std::vector<Box> regions;
+  tracker.getDirtyRegions(regions);
+  EXPECT_THAT(regions, ElementsAre(Box(0, 0, 15, 15), Box(64, 0, 79, 15),
+                                   Box(0, 32, 15, 47)));
+}
+
+TEST(DamageTracker, BoundedRegions) {
+  DamageTracker tracker(Box(0, 0, 99, 49), 4);
+  tracker.invalidate(Box(0, 0, 5, 5));
+  tracker.invalidate(Box(20, 0, 25, 5));
+  tracker.invalidate(Box(90, 40, 95, 45));
+  std::vector<Box> regions;
+  tracker.getDirtyRegions(regions, 2);
+  EXPECT_THAT(regions, ElementsAre(Box(0, 0, 31, 15), Box(80, 32, 95, 47)));
+}
+
+TEST(DamageTracker, Reset) {
+  DamageTracker tracker(Box(0, 0, 99, 49), 4);
+  tracker.invalidateAll();
+  EXPECT_EQ(28, tracker.dirtyTileCount());
+  tracker.reset();
+  EXPECT_TRUE(tracker.empty());
+}
+
+TEST(PartialRefresh, InitialRefreshDrawsEverything) {
+  FakeOffscreen<Argb4444> test_screen(8, 6, color::Black);
+  Display display(test_screen);
+  display.setBackgroundColor(color::Black);
+  PartialRefresh scene(display.extents(), 2);
+  FilledRect rect(1, 1, 2, 2, color::White);
+  scene.add(&rect);
+  scene.refresh(display);
+  EXPECT_THAT(test_screen, MatchesContent(Grayscale4(), 8, 6,
+                                          "        "
+                                          " **     "
+                                          " **     "
+                                          "        "
+                                          "        "
+                                          "        "));
+  EXPECT_FALSE(scene.isDirty());
+  EXPECT_EQ(1, scene.lastFrameStats().regions);
+  EXPECT_EQ(16, scene.lastFrameStats().refreshed_pixels);
+}
+
+TEST(PartialRefresh, RedrawsOnlyDirtyTiles) {
+  FakeOffscreen<Argb4444> test_screen(8, 6, color::Black);
+  Display display(test_screen);
+  display.setBackgroundColor(color::Black);
+  PartialRefresh scene(display.extents(), 2);
+  FilledRect left(0, 0, 1, 1, color::White);
+  FilledRect right(5, 0, 6, 1, color::White);
+  scene.add(&left);
+  scene.add(&right);
+  scene.refresh(display);
+  // Paint over the screen behind the scene's back; only the invalidated part
+  // should get restored.
+  {
+    DrawingContext dc(display);
+    dc.fill(color::Black);
+  }
+  scene.invalidate(&right);
+  const auto& stats = scene.refresh(display);
+  EXPECT_EQ(1, stats.dirty_tiles);
+  EXPECT_EQ(1, stats.regions);
+  EXPECT_EQ(1, stats.draw_calls);
+  EXPECT_EQ(16, stats.refreshed_pixels);
+  EXPECT_THAT(test_screen, MatchesContent(Grayscale4(), 8, 6,
+                                          "     ** "
+                                          "     ** "
+                                          "        "
+                                          "        "
+                                          "        "
+                                          "        "));
+}
+
+TEST(PartialRefresh, MoveInvalidatesOldAndNewPosition) {
+  FakeOffscreen<Argb4444> test_screen(8, 6, color::Black);
+  Display display(test_screen);
+  display.setBackgroundColor(color::Black);
+  PartialRefresh scene(display.extents(), 2);
+  FilledRect rect(0, 0, 1, 1, color::White);
+  scene.add(&rect);
+  scene.refresh(display);
+  scene.move(&rect, 4, 4);
+  scene.refresh(display);
+  EXPECT_EQ(2, scene.lastFrameStats().regions);
+  EXPECT_THAT(test_screen, MatchesContent(Grayscale4(), 8, 6,
+                                          "        "
+                                          "        "
+                                          "        "
+                                          "        "
+                                          "    **  "
+                                          "    **  "));
+}
+
+TEST(PartialRefresh, NothingDirty) {
+  FakeOffscreen<Argb4444> test_screen(8, 6, color::Black);
+  Display display(test_screen);
+  display.setBackgroundColor(color::Black);
+  PartialRefresh scene(display.extents(), 2);
+  FilledRect rect(0, 0, 1, 1, color::White);
+  scene.add(&rect);
+  scene.refresh(display);
+  const auto& stats = scene.refresh(display);
+  EXPECT_EQ(0, stats.dirty_tiles);
+  EXPECT_EQ(0, stats.regions);
+  EXPECT_EQ(0, stats.draw_calls);
+}
+
+}  // namespace roo_display
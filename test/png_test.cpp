@@ -59,6 +59,36 @@ const unsigned char kRgbaAlpha8x4Png[] = {
     0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
 };
 
+// Sub-byte grayscale images, 5x2. The odd width leaves the last byte of each
+// row partially used.
+const unsigned char kGray1_5x2Png[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+    0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x02,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0xb8, 0x11, 0x2b, 0xf0, 0x00, 0x00, 0x00,
+    0x0c, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0xd8, 0xc0, 0xe0, 0x01,
+    0x00, 0x02, 0x5c, 0x00, 0xf9, 0xa9, 0x91, 0x9a, 0x0a, 0x00, 0x00, 0x00,
+    0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+};
+
+const unsigned char kGray2_5x2Png[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+    0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x02,
+    0x02, 0x00, 0x00, 0x00, 0x00, 0xff, 0xb1, 0x51, 0x20, 0x00, 0x00, 0x00,
+    0x0e, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0x90, 0x66, 0x60, 0x78,
+    0x72, 0x00, 0x00, 0x03, 0x15, 0x01, 0xc0, 0x4d, 0x85, 0x16, 0x6e, 0x00,
+    0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+};
+
+const unsigned char kGray4_5x2Png[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+    0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x02,
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x70, 0xf1, 0xa4, 0x80, 0x00, 0x00, 0x00,
+    0x10, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0x60, 0x8c, 0xfa, 0xc0,
+    0xf0, 0xc3, 0x86, 0x01, 0x00, 0x0a, 0x3b, 0x02, 0x80, 0x53, 0x4c, 0x88,
+    0xbb, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60,
+    0x82,
+};
+
 std::string RunfilesRoot() {
   const char* test_srcdir = std::getenv("TEST_SRCDIR");
   const char* test_workspace = std::getenv("TEST_WORKSPACE");
@@ -101,8 +131,48 @@ void Draw(DisplayDevice& output, const Drawable& object,
   output.end();
 }
 
+// Draws the image with native-format bands, and via the Color path (which
+// blends), and checks that both produce the expected content.
+void ExpectGrayscale(const unsigned char* data, size_t size,
+                     const std::string& expected) {
+  roo_io::MemoryResource<const roo::byte*> resource(
+      reinterpret_cast<const roo::byte*>(data),
+      reinterpret_cast<const roo::byte*>(data) + size);
+  PngDecoder decoder;
+  PngImage image(decoder, resource);
+
+  FakeOffscreen<Argb8888> native_screen(5, 2, color::Transparent);
+  Draw(native_screen, image, FillMode::kVisible, BlendingMode::kSource);
+  EXPECT_THAT(native_screen, MatchesContent(Argb8888(), 5, 2, expected));
+
+  // Destination-over does not allow writing the pixels directly; over the
+  // transparent background, it leaves the image's colors intact.
+  FakeOffscreen<Argb8888> color_screen(5, 2, color::Transparent);
+  Draw(color_screen, image, FillMode::kVisible,
+       BlendingMode::kDestinationOver);
+  EXPECT_THAT(RasterOf(color_screen), MatchesContent(RasterOf(native_screen)));
+}
+
 }  // namespace
 
+TEST(Png, Grayscale1) {
+  ExpectGrayscale(kGray1_5x2Png, sizeof(kGray1_5x2Png),
+                  "FFFFFFFF FF000000 FFFFFFFF FFFFFFFF FF000000"
+                  "FF000000 FFFFFFFF FF000000 FF000000 FFFFFFFF");
+}
+
+TEST(Png, Grayscale2) {
+  ExpectGrayscale(kGray2_5x2Png, sizeof(kGray2_5x2Png),
+                  "FF000000 FF555555 FFAAAAAA FFFFFFFF FF000000"
+                  "FFFFFFFF FFAAAAAA FF555555 FF000000 FFFFFFFF");
+}
+
+TEST(Png, Grayscale4) {
+  ExpectGrayscale(kGray4_5x2Png, sizeof(kGray4_5x2Png),
+                  "FF000000 FF111111 FF555555 FFAAAAAA FFFFFFFF"
+                  "FFFFFFFF FF888888 FF333333 FFCCCCCC FF000000");
+}
+
 TEST(Png, PaletteOpaqueFile) {
   std::string runfiles_root = RunfilesRoot();
   ASSERT_FALSE(runfiles_root.empty());
@@ -172,4 +242,69 @@ TEST(Png, RgbaMemoryResource) {
                              "80FFFFFF 00000000 FFCC3366 80CC3366"));
 }
 
-}  // namespace roo_display
\ No newline at end of file
+TEST(Png, PaletteOpaqueFileScaled) {
+  std::string runfiles_root = RunfilesRoot();
+  ASSERT_FALSE(runfiles_root.empty());
+
+  PosixTestFilesystem fs(runfiles_root);
+  PngDecoder decoder;
+  PngFile half(decoder, fs, kPaletteImagePath, 1);
+  EXPECT_EQ(Box(0, 0, 3, 1), half.extents());
+
+  FakeOffscreen<Argb8888> test_screen(4, 2, color::Transparent);
+  Draw(test_screen, half, FillMode::kVisible, BlendingMode::kSource);
+
+  // Each pixel is the average of a 2x2 block.
+  EXPECT_THAT(test_screen,
+              MatchesContent(Argb8888(), 4, 2,
+                             "FFA07000 FF60A060 FFA060EF FF607080"
+                             "FF607080 FFA060EF FF60A060 FFA07000"));
+
+  PngFile quarter(decoder, fs, kPaletteImagePath, 2);
+  EXPECT_EQ(Box(0, 0, 1, 0), quarter.extents());
+}
+
+TEST(Png, RgbaMemoryResourceScaled) {
+  roo_io::MemoryResource<const roo::byte*> resource(
+      reinterpret_cast<const roo::byte*>(kRgbaAlpha8x4Png),
+      reinterpret_cast<const roo::byte*>(kRgbaAlpha8x4Png) +
+          sizeof(kRgbaAlpha8x4Png));
+  PngDecoder decoder;
+  PngImage image(decoder, resource, 1);
+
+  FakeOffscreen<Argb8888> test_screen(4, 2, color::Transparent);
+  Draw(test_screen, image, FillMode::kVisible, BlendingMode::kSource);
+
+  // The color channels are weighted by alpha.
+  EXPECT_THAT(test_screen,
+              MatchesContent(Argb8888(), 4, 2,
+                             "A04E361F 60665544 80119559 A0949EA9"
+                             "80303030 A09966CC 60FFDD55 80D9594C"));
+}
+
+TEST(Png, RgbaMemoryResourceClipped) {
+  roo_io::MemoryResource<const roo::byte*> resource(
+      reinterpret_cast<const roo::byte*>(kRgbaAlpha8x4Png),
+      reinterpret_cast<const roo::byte*>(kRgbaAlpha8x4Png) +
+          sizeof(kRgbaAlpha8x4Png));
+  PngDecoder decoder;
+  PngImage image(decoder, resource);
+
+  FakeOffscreen<Argb8888> test_screen(6, 3, color::Transparent);
+  test_screen.begin();
+  Surface s(test_screen, -1, -1, Box(1, 0, 4, 1), false, color::Transparent,
+            FillMode::kVisible, BlendingMode::kSource);
+  s.drawObject(image);
+  test_screen.end();
+
+  EXPECT_THAT(test_screen,
+              MatchesContent(Argb8888(), 6, 3,
+                             "00000000 80AA5500 00000000 FF00AA55 "
+                             "8000AA55 00000000"
+                             "00000000 FF5500AA 805500AA 00000000 "
+                             "FFFFCC00 00000000"
+                             "00000000 00000000 00000000 00000000 "
+                             "00000000 00000000"));
+}
+
+}  // namespace roo_display
@@ -6,6 +6,7 @@
 
 #include "roo_display/color/color.h"
 #include "roo_display/color/color_mode_indexed.h"
+#include "roo_display/filter/counting_output.h"
 #include "roo_display/io/memory.h"
 #include "testing.h"
 
@@ -427,4 +428,155 @@ TEST(Raster, OffsetExtents) {
                                           "   ***"));
 }
 
+// Fills the buffer with pseudo-random bytes.
+void FillRandom(unsigned char* data, size_t size) {
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<int> dist(0, 255);
+  for (size_t i = 0; i < size; ++i) data[i] = dist(gen);
+}
+
+// Draws the raster both directly (which may convert the pixels to the device
+// format), and as a plain streamable, and checks that the results are
+// identical. Returns the number of drawDirectRect() calls in the direct draw.
+template <typename Device>
+uint32_t DrawConvertedAndCompare(const Streamable& raster, int16_t width,
+                                 int16_t height, const Box& clip_box,
+                                 FillMode fill_mode, BlendingMode blending_mode,
+                                 Color bgcolor) {
+  Device converted(width, height, color::Blue);
+  Device streamed(width, height, color::Blue);
+  CountingOutput counting(converted);
+  counting.begin();
+  Surface s(counting, 1, 2, clip_box, false, bgcolor, fill_mode,
+            blending_mode);
+  s.drawObject(raster);
+  counting.end();
+  Draw(streamed, 1, 2, clip_box, ForcedStreamable(&raster), fill_mode,
+       blending_mode, bgcolor);
+  EXPECT_THAT(RasterOf(converted), MatchesContent(RasterOf(streamed)));
+  return counting.counters().draw_direct_rect_calls;
+}
+
+TEST(Raster, ConvertedGrayscale8ToRgb565) {
+  unsigned char data[40 * 9];
+  FillRandom(data, sizeof(data));
+  ConstDramRaster<Grayscale8> raster(40, 9, (const roo::byte*)data);
+  EXPECT_GT(DrawConvertedAndCompare<FakeOffscreen<Rgb565>>(
+                raster, 45, 12, Box(0, 0, 44, 11), FillMode::kVisible,
+                BlendingMode::kSourceOver, color::Transparent),
+            0u);
+}
+
+TEST(Raster, ConvertedSmallGrayscale8ToRgb888) {
+  unsigned char data[5 * 3];
+  FillRandom(data, sizeof(data));
+  ConstDramRaster<Grayscale8> raster(5, 3, (const roo::byte*)data);
+  EXPECT_GT(DrawConvertedAndCompare<FakeOffscreen<Rgb888>>(
+                raster, 8, 6, Box(0, 0, 7, 5), FillMode::kVisible,
+                BlendingMode::kSource, color::Transparent),
+            0u);
+}
+
+TEST(Raster, ConvertedRgb888ToRgb565) {
+  unsigned char data[30 * 5 * 3];
+  FillRandom(data, sizeof(data));
+  ConstDramRaster<Rgb888> raster(30, 5, (const roo::byte*)data);
+  EXPECT_GT(DrawConvertedAndCompare<FakeOffscreen<Rgb565>>(
+                raster, 32, 8, Box(0, 0, 31, 7), FillMode::kVisible,
+                BlendingMode::kSourceOver, color::Transparent),
+            0u);
+}
+
+TEST(Raster, ConvertedRgb888LittleEndianToRgb565BigEndian) {
+  unsigned char data[30 * 5 * 3];
+  FillRandom(data, sizeof(data));
+  ConstDramRasterLE<Rgb888> raster(30, 5, (const roo::byte*)data);
+  EXPECT_GT(
+      (DrawConvertedAndCompare<FakeOffscreen<Rgb565, roo_io::kBigEndian>>(
+          raster, 32, 8, Box(0, 0, 31, 7), FillMode::kVisible,
+          BlendingMode::kSourceOver, color::Transparent)),
+      0u);
+}
+
+TEST(Raster, ConvertedRgb565ToOppositeByteOrder) {
+  unsigned char data[20 * 4 * 2];
+  FillRandom(data, sizeof(data));
+  ConstDramRasterBE<Rgb565> raster(20, 4, (const roo::byte*)data);
+  EXPECT_GT(DrawConvertedAndCompare<FakeOffscreen<Rgb565>>(
+                raster, 22, 7, Box(0, 0, 21, 6), FillMode::kVisible,
+                BlendingMode::kSourceOver, color::Transparent),
+            0u);
+}
+
+TEST(Raster, ConvertedClipped) {
+  unsigned char data[30 * 10];
+  FillRandom(data, sizeof(data));
+  ConstDramRaster<Grayscale8> raster(30, 10, (const roo::byte*)data);
+  EXPECT_GT(DrawConvertedAndCompare<FakeOffscreen<Rgb565>>(
+                raster, 32, 13, Box(5, 4, 27, 9), FillMode::kVisible,
+                BlendingMode::kSourceOver, color::Transparent),
+            0u);
+}
+
+TEST(Raster, ConvertedWideRows) {
+  unsigned char data[300 * 3];
+  FillRandom(data, sizeof(data));
+  ConstDramRaster<Grayscale8> raster(300, 3, (const roo::byte*)data);
+  EXPECT_GT(DrawConvertedAndCompare<FakeOffscreen<Argb8888>>(
+                raster, 302, 5, Box(0, 0, 301, 4), FillMode::kVisible,
+                BlendingMode::kSourceOver, color::Transparent),
+            0u);
+}
+
+TEST(Raster, ConvertedAlpha4OverOpaqueBackground) {
+  unsigned char data[17 * 6 / 2];
+  FillRandom(data, sizeof(data));
+  ConstDramRaster<Alpha4> raster(17, 6, (const roo::byte*)data,
+                                 Alpha4(color::Red));
+  for (FillMode fill_mode : {FillMode::kVisible, FillMode::kExtents}) {
+    EXPECT_GT(DrawConvertedAndCompare<FakeOffscreen<Rgb565>>(
+                  raster, 20, 9, Box(0, 0, 19, 8), fill_mode,
+                  BlendingMode::kSourceOver, color::Yellow),
+              0u);
+  }
+}
+
+TEST(Raster, ConvertedIndexed4WithTransparencyOverOpaqueBackground) {
+  unsigned char data[13 * 5 / 2 + 1];
+  FillRandom(data, sizeof(data));
+  Color colors[16];
+  FillIndexedPalette(colors, 16);
+  Palette palette = Palette::ReadOnly(colors, 16);
+  ConstDramRaster<Indexed4, ColorPixelOrder::kLsbFirst> raster(
+      13, 5, (const roo::byte*)data, Indexed4(&palette));
+  for (FillMode fill_mode : {FillMode::kVisible, FillMode::kExtents}) {
+    EXPECT_GT(DrawConvertedAndCompare<FakeOffscreen<Rgb888>>(
+                  raster, 15, 8, Box(0, 0, 14, 7), fill_mode,
+                  BlendingMode::kSourceOver, color::Navy),
+              0u);
+  }
+}
+
+TEST(Raster, ConvertedArgb8888OverOpaqueBackground) {
+  unsigned char data[9 * 4 * 4];
+  FillRandom(data, sizeof(data));
+  ConstDramRaster<Argb8888> raster(9, 4, (const roo::byte*)data);
+  EXPECT_GT(DrawConvertedAndCompare<FakeOffscreen<Grayscale8>>(
+                raster, 11, 7, Box(0, 0, 10, 6), FillMode::kVisible,
+                BlendingMode::kSourceOverOpaque, color::White),
+            0u);
+}
+
+TEST(Raster, TranslucentOverTransparentBackgroundIsNotConverted) {
+  unsigned char data[17 * 6 / 2];
+  FillRandom(data, sizeof(data));
+  ConstDramRaster<Alpha4> raster(17, 6, (const roo::byte*)data,
+                                 Alpha4(color::Red));
+  // The pixels need to be blended with the device content.
+  EXPECT_EQ(DrawConvertedAndCompare<FakeOffscreen<Rgb565>>(
+                raster, 20, 9, Box(0, 0, 19, 8), FillMode::kVisible,
+                BlendingMode::kSourceOver, color::Transparent),
+            0u);
+}
+
 }  // namespace roo_display
@@ -0,0 +1,202 @@
+#include "roo_display/filter/rect_batching_output.h"
+
+#include <random>
+
+#include "gtest/gtest.h"
+#include "roo_display.h"
+#include "roo_display/color/color.h"
+#include "roo_display/filter/counting_output.h"
+#include "roo_display/shape/basic.h"
+#include "testing.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+namespace {
+
+// Draws a grid of `cols` x `rows` cells of the specified size, each cell
+// being a separate rectangle.
+void DrawGrid(DisplayOutput& output, int16_t cols, int16_t rows, int16_t size,
+              Color color) {
+  for (int16_t j = 0; j < rows; ++j) {
+    for (int16_t i = 0; i < cols; ++i) {
+      output.fillRect(BlendingMode::kSource, i * size, j * size,
+                      i * size + size - 1, j * size + size - 1, color);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(RectBatchingOutput, MergesGridIntoSingleRect) {
+  FakeOffscreen<Rgb565> screen(12, 8, color::Black);
+  CountingOutput counting(screen, 0);
+  RectBatchingOutput batching(counting);
+  batching.begin();
+  DrawGrid(batching, 6, 4, 2, color::White);
+  EXPECT_EQ(24u, batching.queued());
+  EXPECT_EQ(0u, counting.counters().address_windows);
+  batching.end();
+  EXPECT_EQ(0u, batching.queued());
+  EXPECT_EQ(1u, counting.counters().fill_rects_calls);
+  EXPECT_EQ(1u, counting.counters().address_windows);
+  EXPECT_EQ(96u, counting.counters().pixels);
+  EXPECT_THAT(screen, MatchesContent(WhiteOnBlack(), 12, 8,
+                                     "************"
+                                     "************"
+                                     "************"
+                                     "************"
+                                     "************"
+                                     "************"
+                                     "************"
+                                     "************"));
+}
+
+TEST(RectBatchingOutput, MergesAdjacentPixels) {
+  FakeOffscreen<Rgb565> screen(6, 3, color::Black);
+  CountingOutput counting(screen, 0);
+  RectBatchingOutput batching(counting);
+  batching.begin();
+  int16_t x[] = {4, 1, 2, 3, 1, 2, 3};
+  int16_t y[] = {2, 1, 1, 1, 2, 2, 2};
+  batching.fillPixels(BlendingMode::kSource, color::White, x, y, 7);
+  batching.end();
+  EXPECT_EQ(2u, counting.counters().address_windows);
+  EXPECT_THAT(screen, MatchesContent(WhiteOnBlack(), 6, 3,
+                                     "      "
+                                     " ***  "
+                                     " **** "));
+}
+
+TEST(RectBatchingOutput, CullsOverdrawnRects) {
+  FakeOffscreen<Rgb565> screen(8, 4, color::Black);
+  CountingOutput counting(screen, 0);
+  RectBatchingOutput batching(counting);
+  batching.begin();
+  batching.fillRect(BlendingMode::kSourceOver, Box(1, 1, 2, 2),
+                    color::White.withA(0x80));
+  batching.fillRect(BlendingMode::kSource, Box(3, 1, 4, 2), color::White);
+  batching.fillRect(BlendingMode::kSourceOver, Box(0, 0, 7, 3), color::Black);
+  batching.fillRect(BlendingMode::kSource, Box(5, 1, 6, 2), color::White);
+  batching.end();
+  EXPECT_EQ(2u, counting.counters().address_windows);
+  EXPECT_EQ(36u, counting.counters().pixels);
+  EXPECT_THAT(screen, MatchesContent(WhiteOnBlack(), 8, 4,
+                                     "        "
+                                     "     ** "
+                                     "     ** "
+                                     "        "));
+}
+
+TEST(RectBatchingOutput, DropsNoOps) {
+  FakeOffscreen<Rgb565> screen(4, 4, color::Black);
+  CountingOutput counting(screen, 0);
+  RectBatchingOutput batching(counting);
+  batching.begin();
+  batching.fillRect(BlendingMode::kSourceOver, Box(0, 0, 3, 3),
+                    color::Transparent);
+  batching.fillRect(BlendingMode::kDestination, Box(0, 0, 3, 3), color::White);
+  EXPECT_EQ(0u, batching.queued());
+  batching.end();
+  EXPECT_EQ(0u, counting.counters().address_windows);
+}
+
+TEST(RectBatchingOutput, DoesNotMergeOverlappingTranslucentRects) {
+  FakeOffscreen<Argb8888> expected(6, 2, color::Black);
+  FakeOffscreen<Argb8888> screen(6, 2, color::Black);
+  RectBatchingOutput batching(screen);
+  Color translucent = color::White.withA(0x80);
+  for (DisplayOutput* output : {(DisplayOutput*)&expected,
+                                (DisplayOutput*)&batching}) {
+    output->begin();
+    output->fillRect(BlendingMode::kSourceOver, Box(0, 0, 3, 1), translucent);
+    output->fillRect(BlendingMode::kSourceOver, Box(2, 0, 5, 1), translucent);
+    output->end();
+  }
+  EXPECT_THAT(RasterOf(screen), MatchesContent(RasterOf(expected)));
+}
+
+TEST(RectBatchingOutput, FlushesBeforeAddressWindowWrites) {
+  FakeOffscreen<Rgb565> screen(4, 1, color::Black);
+  RectBatchingOutput batching(screen);
+  batching.begin();
+  batching.fillRect(BlendingMode::kSource, Box(0, 0, 3, 0), color::White);
+  batching.setAddress(1, 0, 2, 0, BlendingMode::kSource);
+  EXPECT_EQ(0u, batching.queued());
+  batching.fill(color::Black, 2);
+  batching.end();
+  EXPECT_THAT(screen, MatchesContent(WhiteOnBlack(), 4, 1, "*  *"));
+}
+
+// Sends the same random mix of (possibly overlapping, possibly translucent)
+// rectangles and pixels directly, and via the batching filter (with a small
+// queue, so that it fills up and flushes several times), and verifies that the
+// results are the same.
+TEST(RectBatchingOutput, RandomizedSameAsDirect) {
+  const Color palette[] = {color::White,           color::Red,
+                           color::Blue,            color::Red.withA(0x80),
+                           color::Green.withA(0x40), color::Transparent};
+  const BlendingMode modes[] = {BlendingMode::kSource,
+                                BlendingMode::kSourceOver,
+                                BlendingMode::kSourceAtop};
+  std::mt19937 rng(0x3A7C4u);
+  std::uniform_int_distribution<int> color_dist(0, 5);
+  std::uniform_int_distribution<int> mode_dist(0, 2);
+  std::uniform_int_distribution<int16_t> pos_dist(0, 29);
+  std::uniform_int_distribution<int16_t> size_dist(0, 6);
+  std::uniform_int_distribution<int> kind_dist(0, 3);
+
+  for (uint16_t capacity : {7, 64, 1000}) {
+    FakeOffscreen<Argb8888> expected(36, 36, color::Black);
+    FakeOffscreen<Argb8888> screen(36, 36, color::Black);
+    RectBatchingOutput batching(screen, capacity);
+    expected.begin();
+    batching.begin();
+    for (int iter = 0; iter < 600; ++iter) {
+      Color color = palette[color_dist(rng)];
+      BlendingMode mode = modes[mode_dist(rng)];
+      int16_t x0 = pos_dist(rng);
+      int16_t y0 = pos_dist(rng);
+      switch (kind_dist(rng)) {
+        case 0: {
+          // Snap some of the rects to a grid, so that they abut.
+          x0 &= ~3;
+          y0 &= ~3;
+          expected.fillRect(mode, Box(x0, y0, x0 + 3, y0 + 3), color);
+          batching.fillRect(mode, Box(x0, y0, x0 + 3, y0 + 3), color);
+          break;
+        }
+        case 1: {
+          int16_t x1 = x0 + size_dist(rng);
+          int16_t y1 = y0 + size_dist(rng);
+          expected.fillRect(mode, Box(x0, y0, x1, y1), color);
+          batching.fillRect(mode, Box(x0, y0, x1, y1), color);
+          break;
+        }
+        case 2: {
+          int16_t x[] = {x0, (int16_t)(x0 + 1), x0};
+          int16_t y[] = {y0, y0, (int16_t)(y0 + 1)};
+          expected.fillPixels(mode, color, x, y, 3);
+          batching.fillPixels(mode, color, x, y, 3);
+          break;
+        }
+        default: {
+          Color colors[] = {color, palette[color_dist(rng)]};
+          int16_t rx0[] = {x0, (int16_t)(x0 + 1)};
+          int16_t ry0[] = {y0, y0};
+          int16_t rx1[] = {x0, (int16_t)(x0 + 4)};
+          int16_t ry1[] = {(int16_t)(y0 + 5), (int16_t)(y0 + 5)};
+          expected.writeRects(mode, colors, rx0, ry0, rx1, ry1, 2);
+          batching.writeRects(mode, colors, rx0, ry0, rx1, ry1, 2);
+          break;
+        }
+      }
+    }
+    expected.end();
+    batching.end();
+    EXPECT_THAT(RasterOf(screen), MatchesContent(RasterOf(expected)));
+  }
+}
+
+}  // namespace roo_display
@@ -0,0 +1,151 @@
+#include "roo_display/composition/render_queue.h"
+
+#include <string>
+#include <vector>
+
+#include "roo_display/color/color.h"
+#include "roo_display/shape/basic.h"
+#include "roo_display/ui/text_label.h"
+#include "roo_fonts/NotoSerif_Italic/12.h"
+#include "testing.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+TEST(RenderQueue, ExecutesInOrder) {
+  FakeOffscreen<Grayscale4> screen(4, 3, color::Black);
+  Display display(screen);
+  RenderQueue queue(8);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_TRUE(queue.fillRect(Box(0, 0, 3, 2), Grayscale4().toArgbColor(3)));
+  EXPECT_TRUE(queue.fillRect(Box(1, 1, 2, 1), Grayscale4().toArgbColor(9)));
+  FilledRect rect(Box(0, 0, 3, 0), Grayscale4().toArgbColor(0xF));
+  EXPECT_TRUE(queue.draw(rect, 0, 2, Box(2, 0, 3, 2)));
+  EXPECT_FALSE(queue.empty());
+  {
+    DrawingContext dc(display);
+    EXPECT_EQ(3, queue.drain(dc));
+  }
+  EXPECT_TRUE(queue.empty());
+  EXPECT_THAT(screen, MatchesContent(Grayscale4(), 4, 3,
+                                     "3333"
+                                     "3993"
+                                     "33FF"));
+  RenderQueue::Stats stats = queue.stats();
+  EXPECT_EQ(3, stats.enqueued);
+  EXPECT_EQ(3, stats.executed);
+  EXPECT_EQ(0, stats.rejected);
+  EXPECT_EQ(3, stats.max_depth);
+}
+
+TEST(RenderQueue, RejectsWhenFull) {
+  FakeOffscreen<Grayscale4> screen(4, 1, color::Black);
+  Display display(screen);
+  RenderQueue queue(3);
+  ASSERT_EQ(4, queue.capacity());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(
+        queue.fillRect(Box(i, 0, i, 0), Grayscale4().toArgbColor(i + 1)));
+  }
+  EXPECT_FALSE(queue.fillRect(Box(0, 0, 3, 0), color::White));
+  {
+    DrawingContext dc(display);
+    EXPECT_EQ(2, queue.drain(dc, 2));
+  }
+  // Freed up some slots.
+  EXPECT_TRUE(queue.fillRect(Box(0, 0, 0, 0), Grayscale4().toArgbColor(7)));
+  {
+    DrawingContext dc(display);
+    EXPECT_EQ(3, queue.drain(dc));
+  }
+  EXPECT_THAT(screen, MatchesContent(Grayscale4(), 4, 1, "7234"));
+  RenderQueue::Stats stats = queue.stats();
+  EXPECT_EQ(5, stats.enqueued);
+  EXPECT_EQ(1, stats.rejected);
+  EXPECT_EQ(5, stats.executed);
+  EXPECT_EQ(4, stats.max_depth);
+}
+
+TEST(RenderQueue, CapacityIsCapped) {
+  EXPECT_EQ(1, RenderQueue(0).capacity());
+  EXPECT_EQ(RenderQueue::kMaxCapacity, RenderQueue(0x8000).capacity());
+  EXPECT_EQ(RenderQueue::kMaxCapacity, RenderQueue(40000).capacity());
+  EXPECT_EQ(RenderQueue::kMaxCapacity, RenderQueue(0xFFFF).capacity());
+}
+
+TEST(RenderQueue, DrawText) {
+  const Font& font = font_NotoSerif_Italic_12();
+  FakeOffscreen<Argb8888> expected(60, 20, color::Black);
+  {
+    Display display(expected);
+    DrawingContext dc(display);
+    dc.draw(StringViewLabel("Hello", font, color::White), 2, 14);
+  }
+  FakeOffscreen<Argb8888> actual(60, 20, color::Black);
+  Display display(actual);
+  RenderQueue queue;
+  EXPECT_TRUE(queue.drawText("Hello", font, color::White, 2, 14));
+  std::string too_long(RenderQueue::kMaxTextLength + 1, 'x');
+  EXPECT_FALSE(queue.drawText(too_long, font, color::White, 2, 14));
+  {
+    DrawingContext dc(display);
+    EXPECT_EQ(1, queue.drain(dc));
+  }
+  EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+}
+
+TEST(RenderQueue, ConcurrentProducers) {
+  static constexpr int kProducers = 4;
+  static constexpr int kWidth = 32;
+  static constexpr int kHeight = 16;
+  FakeOffscreen<Rgb565> screen(kWidth, kHeight * kProducers, color::Black);
+  Display display(screen);
+  RenderQueue queue(16);
+  std::vector<roo::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, p]() {
+      // Each producer paints its own horizontal band, pixel by pixel, retrying
+      // when the queue is full.
+      for (int i = 0; i < kWidth * kHeight; ++i) {
+        int16_t x = i % kWidth;
+        int16_t y = p * kHeight + i / kWidth;
+        while (!queue.fillRect(Box(x, y, x, y), color::White)) {
+          roo::this_thread::sleep_for(roo_time::Micros(100));
+        }
+      }
+    });
+  }
+  uint32_t total = kProducers * kWidth * kHeight;
+  uint32_t executed = 0;
+  while (executed < total) {
+    DrawingContext dc(display);
+    executed += queue.drain(dc);
+  }
+  for (auto& producer : producers) producer.join();
+  EXPECT_TRUE(queue.empty());
+  RenderQueue::Stats stats = queue.stats();
+  EXPECT_EQ(total, stats.enqueued);
+  EXPECT_EQ(total, stats.executed);
+  EXPECT_LE(stats.max_depth, 16);
+  EXPECT_THAT(screen, MatchesContent(SolidRect(0, 0, kWidth - 1,
+                                               kHeight * kProducers - 1,
+                                               color::White)));
+}
+
+TEST(RenderTask, DrainsInBackground) {
+  FakeOffscreen<Grayscale4> screen(4, 1, color::Black);
+  Display display(screen);
+  RenderQueue queue(8);
+  {
+    RenderTask task(display, queue, roo_time::Millis(1));
+    EXPECT_TRUE(queue.fillRect(Box(0, 0, 1, 0), Grayscale4().toArgbColor(5)));
+    EXPECT_TRUE(queue.fillRect(Box(2, 0, 3, 0), Grayscale4().toArgbColor(6)));
+    while (queue.stats().executed < 2) {
+      roo::this_thread::sleep_for(roo_time::Millis(1));
+    }
+  }
+  EXPECT_THAT(screen, MatchesContent(Grayscale4(), 4, 1, "5566"));
+}
+
+}  // namespace roo_display
@@ -331,6 +331,34 @@ float NormalizedRmse(const FakeOffscreen<Argb8888>& actual,
               (pixel_count * 4.0 * 255.0 * 255.0));
 }
 
+// Draws the shape using the scanline and the tiled rasterization, and
+// verifies that the results are the same.
+void ExpectScanlineMatchesTiled(SmoothShape shape) {
+  const Box extents = shape.extents();
+  const Box clips[] = {
+      extents,
+      Box(extents.xMin() + 3, extents.yMin() + 2, extents.xMax() - 5,
+          extents.yMax() - 1),
+      Box(extents.xMin(), extents.yMin() + extents.height() / 2,
+          extents.xMin() + extents.width() / 3, extents.yMax()),
+  };
+  for (const Box& clip : clips) {
+    for (FillMode fill_mode : {FillMode::kVisible, FillMode::kExtents}) {
+      for (Color bgcolor : {color::Transparent, Color(0xFF102030)}) {
+        shape.setRasterization(SmoothShape::Rasterization::kTiled);
+        const FakeOffscreen<Argb8888> expected = CoercedToClipped<Argb8888>(
+            shape, clip, Argb8888(), color::Transparent, fill_mode,
+            BlendingMode::kSourceOver, bgcolor);
+        shape.setRasterization(SmoothShape::Rasterization::kScanline);
+        const FakeOffscreen<Argb8888> actual = CoercedToClipped<Argb8888>(
+            shape, clip, Argb8888(), color::Transparent, fill_mode,
+            BlendingMode::kSourceOver, bgcolor);
+        EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+      }
+    }
+  }
+}
+
 }  // namespace
 
 // Verifies ordered centerline bounds normalize to the rounded-inner case.
@@ -1247,4 +1275,61 @@ TEST(SmoothShapes,
   }
 }
 
+TEST(SmoothShapes, ScanlineRoundRectsMatchTiled) {
+  ExpectScanlineMatchesTiled(
+      SmoothFilledRoundRect(2.5f, 3.5f, 60.5f, 40.5f, 8, color::Navy));
+  ExpectScanlineMatchesTiled(
+      SmoothFilledRoundRect(2.2f, 3.7f, 60.1f, 40.9f, 7.3f, Color(0x80FF8040)));
+  ExpectScanlineMatchesTiled(SmoothThickRoundRect(
+      0.5f, 0.5f, 50.5f, 30.5f, 6.0f, 3.0f, color::Black, Color(0xFFF3EFE7)));
+  // Rectangular inner boundary.
+  ExpectScanlineMatchesTiled(SmoothThickRoundRect(
+      0.5f, 0.5f, 40.5f, 24.5f, 2.0f, 5.0f, color::Black, Color(0x80F3EFE7)));
+  ExpectScanlineMatchesTiled(
+      SmoothThickRoundRect(1.0f, 2.0f, 44.0f, 30.0f,
+                           RoundRectRadii{9.0f, 2.0f, 4.0f, 6.0f}, 2.0f,
+                           color::Black.withA(0x95), Color(0x80F3EFE7)));
+  ExpectScanlineMatchesTiled(
+      SmoothFilledCircle({30.3f, 25.6f}, 20.2f, Color(0xC0FF4040)));
+}
+
+TEST(SmoothShapes, ScanlineArcsMatchTiled) {
+  // Wider than 180 degrees, with round endings.
+  ExpectScanlineMatchesTiled(
+      SmoothThickArc({40, 35}, 30, 8, -2.5f, 2.5f, color::Orange));
+  // Narrower than 180 degrees, with flat endings.
+  ExpectScanlineMatchesTiled(SmoothThickArc({40.3f, 35.6f}, 30, 9, 0.3f, 1.9f,
+                                            color::Orange, ENDING_FLAT));
+  ExpectScanlineMatchesTiled(SmoothThickArc({40.5f, 35.5f}, 30, 9, -2.9f,
+                                            2.1f, color::Orange, ENDING_FLAT));
+  ExpectScanlineMatchesTiled(SmoothThickArcWithBackground(
+      {36.2f, 33.9f}, 28.5f, 11.0f, -0.9f, 1.8f, color::Red, color::Gray,
+      Color(0x80FFFFFF)));
+  ExpectScanlineMatchesTiled(SmoothThickArcWithBackground(
+      {36.0f, 34.0f}, 28.0f, 6.0f, 1.2f, 5.1f, color::Red, Color(0x40404040),
+      color::Transparent, ENDING_FLAT));
+  ExpectScanlineMatchesTiled(
+      SmoothArc({30.7f, 30.2f}, 25.0f, -1.0f, 3.0f, color::White));
+  ExpectScanlineMatchesTiled(
+      SmoothPie({30.0f, 30.0f}, 25.0f, 0.5f, 2.0f, Color(0xC000FF00)));
+  ExpectScanlineMatchesTiled(
+      SmoothPie({30.5f, 30.5f}, 25.0f, -2.0f, 3.5f, Color(0xC000FF00)));
+}
+
+TEST(SmoothShapes, ArcStreamMatchesDrawing) {
+  const SmoothShape arcs[] = {
+      SmoothThickArc({40, 35}, 30, 8, -2.5f, 2.5f, color::Orange),
+      SmoothThickArc({40.3f, 35.6f}, 30, 9, 0.3f, 1.9f, color::Orange,
+                     ENDING_FLAT),
+      SmoothThickArcWithBackground({36.2f, 33.9f}, 28.5f, 11.0f, -0.9f, 1.8f,
+                                   color::Red, color::Gray, Color(0x80FFFFFF)),
+  };
+  for (SmoothShape arc : arcs) {
+    arc.setRasterization(SmoothShape::Rasterization::kTiled);
+    EXPECT_THAT(RasterOf(StreamShapeArgb8888(arc)),
+                MatchesContent(RasterOf(RenderShapeArgb8888(arc))));
+    ExpectRunLengthTracksExactSolidSegmentRemainder(arc);
+  }
+}
+
 }  // namespace roo_display
@@ -1,6 +1,12 @@
 #include "roo_display/shape/smooth_transformation.h"
 
+#include <stdlib.h>
+
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "roo_display/color/color_modes.h"
+#include "roo_display/core/raster.h"
 
 namespace roo_display {
 
@@ -14,6 +20,54 @@ void ExpectPointNear(FpPoint p, float x, float y) {
   EXPECT_NEAR(p.y, y, kEps);
 }
 
+// 4x3 raster with distinct, partially translucent pixels.
+const uint32_t kPixels[] = {
+    0xFF000000, 0xFF402000, 0xFF804000, 0xFFC06000,  //
+    0xFF002040, 0x80406040, 0xFF80A040, 0xFFC0E040,  //
+    0xFF004080, 0xFF40C080, 0xFF804080, 0x40C0C080,  //
+};
+
+class TestRaster {
+ public:
+  TestRaster() {
+    for (int i = 0; i < 12; ++i) {
+      data_[4 * i + 0] = (roo::byte)(kPixels[i] >> 24);
+      data_[4 * i + 1] = (roo::byte)(kPixels[i] >> 16);
+      data_[4 * i + 2] = (roo::byte)(kPixels[i] >> 8);
+      data_[4 * i + 3] = (roo::byte)(kPixels[i]);
+    }
+  }
+
+  ConstDramRaster<Argb8888> raster() const {
+    return ConstDramRaster<Argb8888>(Box(3, 5, 6, 7), data_);
+  }
+
+ private:
+  roo::byte data_[48];
+};
+
+// Reads the rectangle using readColorRect() (which walks the rows), and
+// pixel by pixel, in reverse order (so that each pixel is computed from
+// scratch), and checks that the results are (nearly) the same.
+template <typename Transformed>
+void ExpectRowWalkMatchesPerPixel(const Transformed& t, int max_diff) {
+  Box box = t.extents();
+  std::vector<Color> rect(box.area());
+  t.readColorRect(box.xMin(), box.yMin(), box.xMax(), box.yMax(),
+                  &rect[0]);
+  for (int16_t y = box.yMax(); y >= box.yMin(); --y) {
+    for (int16_t x = box.xMax(); x >= box.xMin(); --x) {
+      Color c;
+      t.readColors(&x, &y, 1, &c);
+      Color r = rect[(y - box.yMin()) * box.width() + x - box.xMin()];
+      EXPECT_LE(abs(c.a() - r.a()), max_diff) << x << ", " << y;
+      EXPECT_LE(abs(c.r() - r.r()), max_diff) << x << ", " << y;
+      EXPECT_LE(abs(c.g() - r.g()), max_diff) << x << ", " << y;
+      EXPECT_LE(abs(c.b() - r.b()), max_diff) << x << ", " << y;
+    }
+  }
+}
+
 }  // namespace
 
 TEST(SmoothTransformation, IdentityApply) {
@@ -150,4 +204,63 @@ TEST(SmoothTransformation, ProjectiveInversionRoundTrip) {
   ExpectPointNear(round_trip, point.x, point.y);
 }
 
+TEST(TransformedRaster, NearestNeighborRotation) {
+  TestRaster data;
+  auto raster = data.raster();
+  auto t =
+      TransformRaster(raster, RotateRight(), RasterSampling::kNearestNeighbor);
+  // (x, y) -> (-y, x).
+  Box extents = t.extents();
+  EXPECT_EQ(Box(-7, 3, -5, 6), extents);
+  for (int16_t y = 3; y <= 6; ++y) {
+    for (int16_t x = -7; x <= -5; ++x) {
+      Color c;
+      t.readColors(&x, &y, 1, &c);
+      EXPECT_EQ(raster.get(y, -x), c) << x << ", " << y;
+    }
+  }
+  ExpectRowWalkMatchesPerPixel(t, 0);
+}
+
+TEST(TransformedRaster, IntegerPositionsAreExact) {
+  TestRaster data;
+  auto raster = data.raster();
+  auto t = TransformRaster(raster, Translate(10, -2));
+  std::vector<Color> rect(12);
+  EXPECT_FALSE(t.readColorRect(13, 3, 16, 5, &rect[0]));
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_EQ(Color(kPixels[i]), rect[i]) << i;
+  }
+}
+
+TEST(TransformedRaster, BilinearScaling) {
+  TestRaster data;
+  auto raster = data.raster();
+  auto t = TransformRaster(raster, Scale(2.0f, 2.0f));
+  // Halfway between (3, 5) and (4, 5).
+  int16_t x = 7;
+  int16_t y = 10;
+  Color c;
+  t.readColors(&x, &y, 1, &c);
+  EXPECT_EQ(InterpolateColors(Color(kPixels[0]), Color(kPixels[1]), 128), c);
+  // The steps are exact, so the results are identical.
+  ExpectRowWalkMatchesPerPixel(t, 0);
+}
+
+TEST(TransformedRaster, BilinearRotationRowWalk) {
+  TestRaster data;
+  auto raster = data.raster();
+  auto t = TransformRaster(
+      raster, RotateRightAbout(0.5f, FpPoint{4.5f, 6.0f}).then(Scale(3, 3)));
+  // The fixed-point steps may differ in the last bits of the fractions.
+  ExpectRowWalkMatchesPerPixel(t, 3);
+}
+
+TEST(TransformedRaster, ProjectiveMatchesPerPixel) {
+  TestRaster data;
+  auto raster = data.raster();
+  auto t = TransformRaster(raster, Scale(4, 4).then(Perspective(0.01f, 0.0f)));
+  ExpectRowWalkMatchesPerPixel(t, 0);
+}
+
 }  // namespace roo_display
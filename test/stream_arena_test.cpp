@@ -0,0 +1,209 @@
+#include "roo_display/core/stream_arena.h"
+
+#include "roo_display.h"
+#include "roo_display/color/color.h"
+#include "roo_display/composition/streamable_stack.h"
+#include "roo_threads.h"
+#include "roo_threads/thread.h"
+#include "testing.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+namespace {
+
+// Stream that does not fit in the default arena.
+class LargeStream : public PixelStream {
+ public:
+  LargeStream(Color color) : color_(color) {}
+
+  void read(Color* buf, uint16_t size, uint32_t& run_length) override {
+    for (uint16_t i = 0; i < size; ++i) buf[i] = color_;
+    run_length = 0;
+  }
+
+ private:
+  Color color_;
+  roo::byte padding_[ROO_DISPLAY_STREAM_ARENA_SIZE];
+};
+
+class LargeStreamable : public Streamable {
+ public:
+  LargeStreamable(Box extents, Color color)
+      : extents_(extents), color_(color) {}
+
+  Box extents() const override { return extents_; }
+
+  std::unique_ptr<PixelStream> createStream() const override {
+    return std::unique_ptr<PixelStream>(new LargeStream(color_));
+  }
+
+  std::unique_ptr<PixelStream> createStream(const Box& bounds) const override {
+    return std::unique_ptr<PixelStream>(new LargeStream(color_));
+  }
+
+ private:
+  Box extents_;
+  Color color_;
+};
+
+}  // namespace
+
+TEST(StreamArena, ReclaimsWhenAllReleased) {
+  StreamArenaWithStorage<256> arena;
+  StreamArena::Scope scope(arena);
+  void* a = StreamArena::Allocate(10);
+  void* b = StreamArena::Allocate(20);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(0u, (uintptr_t)b % StreamArena::kAlignment);
+  EXPECT_EQ(2u, arena.stats().arena_allocations);
+  size_t used = arena.used();
+  EXPECT_GE(used, 30u);
+  StreamArena::Deallocate(a);
+  EXPECT_EQ(used, arena.used());
+  StreamArena::Deallocate(b);
+  EXPECT_EQ(0u, arena.used());
+  EXPECT_EQ(used, arena.stats().peak_bytes);
+  EXPECT_EQ(0u, arena.stats().heap_allocations);
+}
+
+TEST(StreamArena, FallsBackToHeap) {
+  StreamArenaWithStorage<64> arena;
+  StreamArena::Scope scope(arena);
+  void* a = StreamArena::Allocate(100);
+  EXPECT_EQ(0u, arena.used());
+  EXPECT_EQ(1u, arena.stats().heap_allocations);
+  StreamArena::Deallocate(a);
+}
+
+TEST(StreamArena, NestedScopes) {
+  StreamArenaWithStorage<64> outer;
+  StreamArenaWithStorage<64> inner;
+  StreamArena::Scope outer_scope(outer);
+  void* a = StreamArena::Allocate(8);
+  {
+    StreamArena::Scope inner_scope(inner);
+    void* b = StreamArena::Allocate(8);
+    EXPECT_EQ(1u, inner.stats().arena_allocations);
+    // Released to the outer arena.
+    StreamArena::Deallocate(a);
+    EXPECT_EQ(0u, outer.used());
+    StreamArena::Deallocate(b);
+  }
+  EXPECT_EQ(1u, outer.stats().arena_allocations);
+}
+
+TEST(StreamArena, ReentrantScopeIsNoOp) {
+  StreamArenaWithStorage<128> arena;
+  StreamArena::Scope scope(arena);
+  void* a = StreamArena::Allocate(8);
+  {
+    StreamArena::Scope nested(arena);
+    void* b = StreamArena::Allocate(8);
+    StreamArena::Deallocate(b);
+  }
+  // Still allocating from the arena.
+  void* c = StreamArena::Allocate(8);
+  EXPECT_EQ(3u, arena.stats().arena_allocations);
+  StreamArena::Deallocate(a);
+  StreamArena::Deallocate(c);
+  EXPECT_EQ(0u, arena.used());
+}
+
+TEST(StreamArena, ReleasedAfterScope) {
+  StreamArenaWithStorage<128> arena;
+  void* a;
+  {
+    StreamArena::Scope scope(arena);
+    a = StreamArena::Allocate(8);
+  }
+  // No arena is active anymore, but the allocation is still returned to its
+  // owner.
+  EXPECT_GT(arena.used(), 0u);
+  StreamArena::Deallocate(a);
+  EXPECT_EQ(0u, arena.used());
+}
+
+TEST(StreamArena, ReleasedOnAnotherThread) {
+  StreamArenaWithStorage<128> arena;
+  StreamArena::Scope scope(arena);
+  void* a = StreamArena::Allocate(8);
+  void* b = StreamArena::Allocate(100);
+  EXPECT_EQ(1u, arena.stats().heap_allocations);
+  roo::thread t([a, b]() {
+    StreamArena::Deallocate(a);
+    StreamArena::Deallocate(b);
+  });
+  t.join();
+  EXPECT_EQ(0u, arena.used());
+}
+
+TEST(StreamArena, CountsHeapAllocationsPerDraw) {
+  StreamArenaWithStorage<64> arena;
+  {
+    StreamArena::Scope scope(arena);
+    StreamArena::Deallocate(StreamArena::Allocate(100));
+    StreamArena::Deallocate(StreamArena::Allocate(100));
+  }
+  EXPECT_EQ(2u, arena.stats().last_draw_heap_allocations);
+  {
+    StreamArena::Scope scope(arena);
+    StreamArena::Deallocate(StreamArena::Allocate(8));
+  }
+  EXPECT_EQ(0u, arena.stats().last_draw_heap_allocations);
+  EXPECT_EQ(2u, arena.stats().heap_allocations);
+}
+
+TEST(StreamArena, DrawingAllocatesFromArena) {
+  auto input1 = MakeTestStreamable(Grayscale4(), Box(0, 0, 1, 1),
+                                   "77"
+                                   "77");
+  auto input2 = MakeTestStreamable(Alpha4(color::White), Box(0, 0, 1, 1),
+                                   "F "
+                                   " F");
+  StreamableStack stack(Box(0, 0, 4, 2));
+  stack.addInput(&input1, 1, 0);
+  stack.addInput(&input2, 2, 1);
+  FakeOffscreen<Argb4444> test_screen(5, 3, color::Black);
+  Display display(test_screen);
+  {
+    DrawingContext dc(display);
+    dc.draw(stack);
+    EXPECT_GT(dc.streamStats().arena_allocations, 0u);
+    EXPECT_EQ(0u, dc.streamStats().heap_allocations);
+  }
+  EXPECT_THAT(test_screen, MatchesContent(Grayscale4(), 5, 3,
+                                          " 77  "
+                                          " 7F  "
+                                          "   F "));
+}
+
+TEST(StreamArena, DrawingOversizedStream) {
+  LargeStreamable large(Box(1, 1, 2, 2), color::White);
+  FakeOffscreen<Rgb565> test_screen(4, 4, color::Black);
+  Display display(test_screen);
+  {
+    DrawingContext dc(display);
+    dc.draw(large);
+    EXPECT_EQ(1u, dc.streamStats().heap_allocations);
+    EXPECT_EQ(1u, dc.streamStats().last_draw_heap_allocations);
+    dc.resetStreamStats();
+    EXPECT_EQ(0u, dc.streamStats().heap_allocations);
+  }
+  EXPECT_THAT(test_screen, MatchesContent(WhiteOnBlack(), 4, 4,
+                                          "    "
+                                          " ** "
+                                          " ** "
+                                          "    "));
+}
+
+TEST(StreamArena, StreamsOutsideOfDrawUseHeap) {
+  LargeStreamable large(Box(0, 0, 0, 0), color::White);
+  auto stream = large.createStream();
+  Color c;
+  stream->read(&c, 1);
+  EXPECT_EQ(color::White, c);
+}
+
+}  // namespace roo_display
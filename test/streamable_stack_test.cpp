@@ -444,4 +444,101 @@ TEST(StreamableStack, StreamReportsRunLengthForDisjointSingleInputSpans) {
   EXPECT_EQ(pixel[0], color::Green);
 }
 
+namespace {
+
+void DrawStack(DisplayDevice& output, int16_t x, int16_t y,
+               const StreamableStack& stack, FillMode fill_mode) {
+  output.begin();
+  Surface s(output, x, y, Box(0, 0, output.raw_width() - 1,
+                              output.raw_height() - 1),
+            false, color::Transparent, fill_mode, BlendingMode::kSourceOver);
+  s.drawObject(stack);
+  output.end();
+}
+
+// Draws the stack, and an equivalent freshly constructed stack (i.e. without
+// a cached program), and verifies that the results are the same.
+void ExpectSameAsFresh(const StreamableStack& stack,
+                       const StreamableStack& fresh, int16_t x, int16_t y) {
+  for (FillMode fill_mode : {FillMode::kVisible, FillMode::kExtents}) {
+    FakeOffscreen<Argb4444> actual(14, 12, color::Black);
+    FakeOffscreen<Argb4444> expected(14, 12, color::Black);
+    DrawStack(actual, x, y, stack, fill_mode);
+    DrawStack(expected, x, y, fresh, fill_mode);
+    EXPECT_THAT(RasterOf(actual), MatchesContent(RasterOf(expected)));
+  }
+  std::unique_ptr<PixelStream> actual = stack.createStream();
+  std::unique_ptr<PixelStream> expected = fresh.createStream();
+  Color actual_buf[1], expected_buf[1];
+  for (uint32_t i = 0; i < fresh.extents().area(); ++i) {
+    actual->read(actual_buf, 1);
+    expected->read(expected_buf, 1);
+    EXPECT_EQ(actual_buf[0], expected_buf[0]) << "at pixel " << i;
+  }
+}
+
+}  // namespace
+
+TEST(StreamableStack, RepeatedDrawsReuseProgram) {
+  auto bottom = MakeTestStreamable(Grayscale4(), Box(0, 0, 3, 3),
+                                   "1234"
+                                   "2345"
+                                   "3456"
+                                   "4567");
+  auto top = MakeTestStreamable(Alpha4(color::White), Box(0, 0, 2, 1),
+                                "F8F"
+                                "8F8");
+  StreamableStack stack(Box(0, 0, 9, 7));
+  stack.addInput(&bottom, 1, 1);
+  stack.addInput(&top, 3, 2);
+  StreamableStack fresh(Box(0, 0, 9, 7));
+  fresh.addInput(&bottom, 1, 1);
+  fresh.addInput(&top, 3, 2);
+  for (int i = 0; i < 3; ++i) {
+    ExpectSameAsFresh(stack, fresh, 2, 1);
+  }
+  // Different offsets on the surface are OK as well.
+  ExpectSameAsFresh(stack, fresh, 0, 0);
+  ExpectSameAsFresh(stack, fresh, 4, 3);
+}
+
+TEST(StreamableStack, MovingInputRecompiles) {
+  auto bottom = MakeTestStreamable(Grayscale4(), Box(0, 0, 3, 3),
+                                   "1234"
+                                   "2345"
+                                   "3456"
+                                   "4567");
+  auto middle = MakeTestStreamable(Grayscale4(), Box(0, 0, 1, 1),
+                                   "99"
+                                   "99");
+  auto top = MakeTestStreamable(Alpha4(color::White), Box(0, 0, 2, 1),
+                                "F8F"
+                                "8F8");
+  StreamableStack stack(Box(0, 0, 9, 7));
+  // Moves the middle input around, and then the top input.
+  const int16_t moves[][4] = {{1, 1, 3, 2},   {2, 1, 3, 2},  {-1, 5, 3, 2},
+                              {4, 4, 3, 2},   {4, 4, 0, 0},  {4, 4, 7, 6},
+                              {4, 4, 20, 20}, {4, 4, -2, 5}, {8, 2, -2, 5}};
+  for (const auto& move : moves) {
+    stack.clearInputs();
+    stack.addInput(&bottom, 1, 1);
+    stack.addInput(&middle, move[0], move[1]);
+    stack.addInput(&top, move[2], move[3]).withMode(BlendingMode::kSourceOver);
+    StreamableStack fresh(Box(0, 0, 9, 7));
+    fresh.addInput(&bottom, 1, 1);
+    fresh.addInput(&middle, move[0], move[1]);
+    fresh.addInput(&top, move[2], move[3]);
+    ExpectSameAsFresh(stack, fresh, 2, 1);
+  }
+  // Removing and adding inputs.
+  stack.clearInputs();
+  stack.addInput(&bottom, 1, 1);
+  StreamableStack fresh(Box(0, 0, 9, 7));
+  fresh.addInput(&bottom, 1, 1);
+  ExpectSameAsFresh(stack, fresh, 2, 1);
+  stack.addInput(&top, 2, 2).withMode(BlendingMode::kSource);
+  fresh.addInput(&top, 2, 2).withMode(BlendingMode::kSource);
+  ExpectSameAsFresh(stack, fresh, 2, 1);
+}
+
 }  // namespace roo_display
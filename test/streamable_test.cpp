@@ -1,6 +1,7 @@
 
 #include "roo_display/core/streamable.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "roo_display/color/color.h"
@@ -52,6 +53,65 @@ class ScriptedRunStream : public PixelStream {
   uint32_t skipped_pixels_ = 0;
 };
 
+// Stream that returns a predefined sequence of spans from readSpan().
+class ScriptedSpanStream : public PixelStream {
+ public:
+  using PixelStream::read;
+
+  struct Span {
+    bool is_run;
+    std::vector<Color> pixels;  // For runs: the color, and then nothing.
+    uint32_t count;
+  };
+
+  static Span Run(Color color, uint32_t count) {
+    return Span{true, {color}, count};
+  }
+
+  static Span Literal(std::vector<Color> pixels) {
+    uint32_t count = pixels.size();
+    return Span{false, std::move(pixels), count};
+  }
+
+  ScriptedSpanStream(std::vector<Span> spans) : spans_(std::move(spans)) {}
+
+  uint32_t readSpan(Color* buf, uint16_t size, uint32_t max_count,
+                    bool& is_run) override {
+    EXPECT_LT(idx_, spans_.size());
+    const Span& span = spans_[idx_];
+    uint32_t n = std::min(span.count - offset_, max_count);
+    is_run = span.is_run;
+    if (is_run) {
+      buf[0] = span.pixels[0];
+    } else {
+      n = std::min<uint32_t>(n, size);
+      memcpy(buf, span.pixels.data() + offset_, n * sizeof(Color));
+    }
+    offset_ += n;
+    if (offset_ == span.count) {
+      ++idx_;
+      offset_ = 0;
+    }
+    return n;
+  }
+
+  void read(Color* buf, uint16_t size, uint32_t& run_length) override {
+    run_length = 0;
+    while (size > 0) {
+      bool is_run;
+      uint32_t n = readSpan(buf, size, size, is_run);
+      if (is_run) FillColor(buf, n, buf[0]);
+      buf += n;
+      size -= n;
+    }
+  }
+
+ private:
+  std::vector<Span> spans_;
+  size_t idx_ = 0;
+  uint32_t offset_ = 0;
+};
+
 class CountingOffscreen : public FakeOffscreen<Argb8888> {
  public:
   using Base = FakeOffscreen<Argb8888>;
@@ -381,4 +441,68 @@ TEST(Streamable, SubRectangleStreamPreservesDelegateZeroRunMetadata) {
   EXPECT_EQ(run_length, 0u);
 }
 
+TEST(Streamable, FillReplaceRectMergesShortRunsAndFillsLongRuns) {
+  Color a(0xFF102030);
+  Color b(0xFF405060);
+  std::vector<Color> literal1 = {Color(0xFF000001), Color(0xFF000002),
+                                 Color(0xFF000003)};
+  std::vector<Color> literal2 = {Color(0xFF000004), Color(0xFF000005)};
+  ScriptedSpanStream stream({ScriptedSpanStream::Run(a, 5),
+                             ScriptedSpanStream::Literal(literal1),
+                             ScriptedSpanStream::Run(b, 40),
+                             ScriptedSpanStream::Literal(literal2)});
+  CountingOffscreen output(50, 1, color::Transparent);
+
+  internal::fillReplaceRect(output, Box(0, 0, 49, 0), &stream,
+                            BlendingMode::kSource);
+
+  // The short run is merged with the literals; the long one is filled.
+  ASSERT_EQ(output.fill_calls(), 1u);
+  EXPECT_EQ(output.fill_lengths()[0], 40u);
+  EXPECT_EQ(output.fill_colors()[0], b);
+  std::vector<Color> expected(5, a);
+  expected.insert(expected.end(), literal1.begin(), literal1.end());
+  expected.insert(expected.end(), 40, b);
+  expected.insert(expected.end(), literal2.begin(), literal2.end());
+  ExpectBufferEquals(output, expected);
+}
+
+TEST(Streamable, DefaultReadSpanReportsRunsFromReadMetadata) {
+  std::vector<Color> source(100, Color(0xFF336699));
+  for (int i = 70; i < 100; ++i) {
+    source[i] = Color(0xFF550000 + i);
+  }
+  ScriptedRunStream stream(source, {70, 0});
+
+  Color buf[20];
+  bool is_run;
+  EXPECT_EQ(stream.readSpan(buf, 20, 100, is_run), 70u);
+  EXPECT_TRUE(is_run);
+  EXPECT_EQ(buf[0], source[0]);
+  EXPECT_EQ(stream.skipped_pixels(), 50u);
+  EXPECT_EQ(stream.readSpan(buf, 20, 30, is_run), 20u);
+  EXPECT_FALSE(is_run);
+  EXPECT_EQ(buf[19], source[89]);
+}
+
+TEST(Streamable, WriteRectVisibleSkipsTransparentRunsAndFillsVisibleRuns) {
+  Color red = color::Red;
+  std::vector<Color> literal = {Color(0xFF000001), color::Transparent,
+                                Color(0xFF000003)};
+  ScriptedSpanStream stream({ScriptedSpanStream::Run(color::Transparent, 12),
+                             ScriptedSpanStream::Run(red, 15),
+                             ScriptedSpanStream::Literal(literal)});
+  CountingOffscreen output(10, 3, color::Blue);
+
+  internal::writeRectVisible(output, Box(0, 0, 9, 2), &stream,
+                             BlendingMode::kSource);
+
+  std::vector<Color> expected(12, color::Blue);
+  expected.insert(expected.end(), 15, red);
+  expected.push_back(literal[0]);
+  expected.push_back(color::Blue);
+  expected.push_back(literal[2]);
+  ExpectBufferEquals(output, expected);
+}
+
 }  // namespace roo_display
@@ -46,6 +46,11 @@ class TestDisplayDevice : public DisplayDevice {
     test_.write(color, pixel_count);
   }
 
+  void fill(Color color, uint32_t pixel_count) override {
+    refc_.fill(color, pixel_count);
+    test_.fill(color, pixel_count);
+  }
+
   void writePixels(BlendingMode mode, Color* color, int16_t* x, int16_t* y,
                    uint16_t pixel_count) override {
     refc_.writePixels(mode, color, x, y, pixel_count);
@@ -474,6 +479,40 @@ void TestWriteRectWindowStress(BlendingMode blending_mode,
   EXPECT_CONSISTENT(screen);
 }
 
+template <typename TestedDevice, typename ReferenceDevice>
+void TestFillRectWindowStress(BlendingMode blending_mode,
+                              Orientation orientation) {
+  TestDisplayDevice<TestedDevice, ReferenceDevice> screen(50, 90,
+                                                          Color(0x12345678));
+  screen.setOrientation(orientation);
+  std::uniform_int_distribution<uint16_t> x_distribution(
+      0, screen.effective_width() - 1);
+  std::uniform_int_distribution<uint16_t> y_distribution(
+      0, screen.effective_height() - 1);
+  std::uniform_int_distribution<uint16_t> len_distribution(1, 128);
+  const Color colors[] = {Color(0xFF101050), Color(0x77145456),
+                          Color(0x00000000), Color(0xC0F0E0D0)};
+  std::uniform_int_distribution<int> color_distribution(0, 3);
+  for (int i = 0; i < 200; i++) {
+    int16_t x0 = x_distribution(generator);
+    int16_t x1 = x_distribution(generator);
+    if (x1 < x0) std::swap(x0, x1);
+    int16_t y0 = y_distribution(generator);
+    int16_t y1 = y_distribution(generator);
+    if (y1 < y0) std::swap(y0, y1);
+    screen.setAddress(x0, y0, x1, y1, blending_mode);
+    uint32_t remaining = (x1 - x0 + 1) * (y1 - y0 + 1);
+    // Fills in batches that start and end mid-row.
+    while (remaining > 0) {
+      uint32_t batch = len_distribution(generator);
+      if (batch > remaining) batch = remaining;
+      screen.fill(colors[color_distribution(generator)], batch);
+      remaining -= batch;
+    }
+  }
+  EXPECT_CONSISTENT(screen);
+}
+
 std::ostream& operator<<(std::ostream& os,
                          const std::tuple<BlendingMode, Orientation>& pair) {
   os << (int)std::get<0>(pair) << ", " << std::get<1>(pair);
@@ -0,0 +1,127 @@
+#include "roo_display/filter/tracing_output.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "roo_display.h"
+#include "roo_display/color/color.h"
+#include "testing.h"
+
+using namespace testing;
+
+namespace roo_display {
+
+namespace {
+
+uint32_t fake_now = 0;
+
+// Every reading advances the time by 5 us, so each call takes 5 us.
+uint32_t FakeClock() { return fake_now += 5; }
+
+}  // namespace
+
+TEST(TracingOutput, CollectsPerCallStats) {
+  FakeOffscreen<Rgb565> screen(10, 10, color::Black);
+  TracingOutput tracing(screen, 0, &FakeClock);
+  tracing.setAddress(0, 0, 3, 1, BlendingMode::kSource);
+  Color colors[8];
+  FillColor(colors, 8, color::White);
+  tracing.write(colors, 8);
+  int16_t x0[] = {5, 0};
+  int16_t y0[] = {5, 9};
+  int16_t x1[] = {6, 9};
+  int16_t y1[] = {6, 9};
+  tracing.fillRects(BlendingMode::kSource, color::White, x0, y0, x1, y1, 2);
+
+  const TracingOutput::CallStats& set_address =
+      tracing.stats(TracingOutput::kSetAddress);
+  EXPECT_EQ(1u, set_address.calls);
+  EXPECT_EQ(0u, set_address.pixels);
+
+  const TracingOutput::CallStats& write = tracing.stats(TracingOutput::kWrite);
+  EXPECT_EQ(1u, write.calls);
+  EXPECT_EQ(8u, write.pixels);
+  EXPECT_EQ(0u, write.rects);
+  EXPECT_EQ(5u, write.total_us);
+  EXPECT_EQ(5u, write.max_us);
+  // 5 us falls into [4, 8).
+  EXPECT_EQ(1u, write.histogram[3]);
+
+  const TracingOutput::CallStats& fill_rects =
+      tracing.stats(TracingOutput::kFillRects);
+  EXPECT_EQ(1u, fill_rects.calls);
+  EXPECT_EQ(2u, fill_rects.rects);
+  EXPECT_EQ(14u, fill_rects.pixels);
+
+  EXPECT_EQ(0u, tracing.stats(TracingOutput::kFill).calls);
+
+  // The calls reach the underlying device.
+  EXPECT_THAT(screen, MatchesContent(WhiteOnBlack(), 10, 10,
+                                     "****      "
+                                     "****      "
+                                     "          "
+                                     "          "
+                                     "          "
+                                     "     **   "
+                                     "     **   "
+                                     "          "
+                                     "          "
+                                     "**********"));
+}
+
+TEST(TracingOutput, DisabledForwardsOnly) {
+  FakeOffscreen<Rgb565> screen(4, 4, color::Black);
+  TracingOutput tracing(screen, 8, &FakeClock);
+  tracing.setEnabled(false);
+  uint32_t before = fake_now;
+  tracing.setAddress(0, 0, 3, 3, BlendingMode::kSource);
+  tracing.fill(color::White, 16);
+  EXPECT_EQ(before, fake_now);
+  EXPECT_EQ(0u, tracing.stats(TracingOutput::kFill).calls);
+  EXPECT_EQ(0, tracing.event_count());
+  EXPECT_THAT(screen, MatchesContent(SolidRect(0, 0, 3, 3, color::White)));
+}
+
+TEST(TracingOutput, RingBufferKeepsMostRecentEvents) {
+  FakeOffscreen<Rgb565> screen(4, 4, color::Black);
+  TracingOutput tracing(screen, 3, &FakeClock);
+  tracing.setAddress(0, 0, 3, 3, BlendingMode::kSource);
+  tracing.fill(color::White, 1);
+  tracing.fill(color::White, 2);
+  tracing.fill(color::White, 3);
+  ASSERT_EQ(3, tracing.event_count());
+  EXPECT_EQ(TracingOutput::kFill, tracing.event(0).call);
+  EXPECT_EQ(1u, tracing.event(0).pixels);
+  EXPECT_EQ(3u, tracing.event(2).pixels);
+  EXPECT_EQ(3u, tracing.stats(TracingOutput::kFill).calls);
+  tracing.reset();
+  EXPECT_EQ(0, tracing.event_count());
+  EXPECT_EQ(0u, tracing.stats(TracingOutput::kFill).calls);
+}
+
+TEST(TracingOutput, ChromeTrace) {
+  FakeOffscreen<Rgb565> screen(4, 4, color::Black);
+  fake_now = 0;
+  TracingOutput tracing(screen, 8, &FakeClock);
+  {
+    TracingOutput::Span span(tracing, "button");
+    tracing.setAddress(0, 0, 3, 3, BlendingMode::kSource);
+    tracing.fill(color::White, 16);
+  }
+  std::string json;
+  tracing.writeChromeTrace([&json](roo::string_view chunk) {
+    json.append(chunk.data(), chunk.size());
+  });
+  EXPECT_EQ(
+      "{\"traceEvents\":["
+      "{\"name\":\"button\",\"ph\":\"B\",\"ts\":5,\"pid\":0,\"tid\":0},"
+      "{\"name\":\"setAddress\",\"ph\":\"X\",\"ts\":10,\"dur\":5,"
+      "\"pid\":0,\"tid\":0,\"args\":{\"pixels\":0}},"
+      "{\"name\":\"fill\",\"ph\":\"X\",\"ts\":20,\"dur\":5,"
+      "\"pid\":0,\"tid\":0,\"args\":{\"pixels\":16}},"
+      "{\"ph\":\"E\",\"ts\":30,\"pid\":0,\"tid\":0}"
+      "]}",
+      json);
+}
+
+}  // namespace roo_display